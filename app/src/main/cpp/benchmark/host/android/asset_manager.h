@@ -0,0 +1,24 @@
+#pragma once
+
+#include <sys/types.h>
+#include <cstddef>
+
+/**
+ * Host stand-in for the NDK asset API. There is no APK on the host, so every
+ * open fails; host tools load IR files with IRLoader::loadFromBuffer().
+ */
+struct AAssetManager;
+struct AAsset;
+
+enum {
+    AASSET_MODE_UNKNOWN = 0,
+    AASSET_MODE_RANDOM = 1,
+    AASSET_MODE_STREAMING = 2,
+    AASSET_MODE_BUFFER = 3
+};
+
+inline AAsset* AAssetManager_open(AAssetManager*, const char*, int) { return nullptr; }
+inline off_t AAsset_getLength(AAsset*) { return 0; }
+inline int AAsset_read(AAsset*, void*, size_t) { return -1; }
+inline const void* AAsset_getBuffer(AAsset*) { return nullptr; }
+inline void AAsset_close(AAsset*) {}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Host stand-in for the NDK logging API, so the native sources build
+ * unchanged outside Android. Warnings and errors go to stderr; lower levels
+ * are dropped to keep benchmark timings free of console I/O.
+ */
+enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+};
+
+inline int __android_log_vprint(int priority, const char* tag, const char* format, va_list args) {
+    if (priority < ANDROID_LOG_WARN) {
+        return 0;
+    }
+    int written = std::fprintf(stderr, "%c/%s: ", priority >= ANDROID_LOG_ERROR ? 'E' : 'W', tag);
+    written += std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    return written + 1;
+}
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const int written = __android_log_vprint(priority, tag, format, args);
+    va_end(args);
+    return written;
+}
+
+[[noreturn]] inline void __android_log_assert(const char* condition, const char* tag, const char* format, ...) {
+    std::fprintf(stderr, "F/%s: assertion failed: %s: ", tag, condition ? condition : "");
+    if (format) {
+        va_list args;
+        va_start(args, format);
+        std::vfprintf(stderr, format, args);
+        va_end(args);
+    }
+    std::fputc('\n', stderr);
+    std::abort();
+}
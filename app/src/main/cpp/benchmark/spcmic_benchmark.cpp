@@ -0,0 +1,728 @@
+/**
+ * Native benchmark for the DSP and I/O cores: FFT, convolver, 24-bit
+ * converters, ring buffer and WAV reader/writer. Builds for the host (with
+ * the stand-in NDK headers under host/) and for the device (real NDK
+ * logging), and prints one JSON document so runs can be diffed or gated
+ * against a saved baseline with --baseline.
+ */
+#include "lock_free_ring_buffer.h"
+#include "pcm24.h"
+#include "wav_writer.h"
+#include "wav_file_reader.h"
+#include "matrix_convolver/fft_engine.h"
+#include "matrix_convolver/ir_loader.h"
+#include "matrix_convolver/matrix_convolver.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef SPCMIC_BENCHMARK_IR_DIR
+#define SPCMIC_BENCHMARK_IR_DIR ""
+#endif
+
+#ifndef SPCMIC_BENCHMARK_TMP_DIR
+#define SPCMIC_BENCHMARK_TMP_DIR "/tmp"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kChannels = 84;
+constexpr int kBytesPerSample = 3;
+constexpr size_t kFrameBytes = static_cast<size_t>(kChannels) * kBytesPerSample;
+constexpr int kPlaybackBlockFrames = 2048;   // PlaybackEngine::BUFFER_FRAMES
+constexpr int kLowLatencyHeadFrames = 128;   // monitor convolver head/tail partitions
+constexpr int kLowLatencyTailFrames = 512;
+constexpr int kMaxConvolverThreads = 4;
+constexpr int kRepetitions = 5;              // timings report the best repetition
+constexpr int kSchemaVersion = 1;
+
+struct Options {
+    bool quick = false;
+    std::string filter;
+    std::string irDir = SPCMIC_BENCHMARK_IR_DIR;
+    std::string tmpDir = SPCMIC_BENCHMARK_TMP_DIR;
+    std::string outputPath;
+    std::string baselinePath;
+    double tolerance = 0.10;
+    double convolverSeconds = 10.0;   // audio rendered per convolver case
+    double wavSeconds = 20.0;         // audio written per WAV case
+    double minTimingSeconds = 0.2;    // per repetition, micro benchmarks
+};
+
+struct Result {
+    std::string name;
+    double value;
+    std::string unit;
+    bool higherIsBetter;
+};
+
+class Report {
+public:
+    void add(const std::string& name, double value, const char* unit, bool higherIsBetter) {
+        if (!std::isfinite(value)) {
+            std::fprintf(stderr, "skipping %s: no valid measurement\n", name.c_str());
+            return;
+        }
+        results_.push_back({name, value, unit, higherIsBetter});
+        std::fprintf(stderr, "  %-44s %14.3f %s\n", name.c_str(), value, unit);
+    }
+
+    void note(const std::string& key, const std::string& value) { notes_[key] = value; }
+
+    const std::vector<Result>& results() const { return results_; }
+
+    /** One result per line, so a baseline can be read back without a JSON parser. */
+    void write(FILE* out) const {
+        std::fprintf(out, "{\n  \"schema\": %d,\n  \"benchmark\": \"spcmic_benchmark\",\n", kSchemaVersion);
+        std::fprintf(out, "  \"context\": {");
+        bool first = true;
+        for (const auto& entry : notes_) {
+            std::fprintf(out, "%s\"%s\": \"%s\"", first ? "" : ", ", entry.first.c_str(), entry.second.c_str());
+            first = false;
+        }
+        std::fprintf(out, "},\n  \"results\": [\n");
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const Result& r = results_[i];
+            std::fprintf(out, "    {\"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\"}%s\n",
+                         r.name.c_str(), r.value, r.unit.c_str(), r.higherIsBetter ? "higher" : "lower",
+                         i + 1 < results_.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+
+private:
+    std::vector<Result> results_;
+    std::map<std::string, std::string> notes_;
+};
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Best time per call of @p fn over kRepetitions runs. Each run repeats the
+ * call until it lasts @p minSeconds, so short kernels are not timer bound.
+ */
+double bestSecondsPerCall(const std::function<void()>& fn, double minSeconds) {
+    fn();  // warm caches and lazily built state
+    size_t calls = 1;
+    for (;;) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < calls; ++i) {
+            fn();
+        }
+        const double elapsed = secondsSince(start);
+        if (elapsed >= minSeconds / 4 || calls >= (size_t{1} << 30)) {
+            calls = std::max<size_t>(1, static_cast<size_t>(calls * (minSeconds / std::max(elapsed, 1e-9))));
+            break;
+        }
+        calls *= 4;
+    }
+
+    double best = INFINITY;
+    for (int rep = 0; rep < kRepetitions; ++rep) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < calls; ++i) {
+            fn();
+        }
+        best = std::min(best, secondsSince(start) / static_cast<double>(calls));
+    }
+    return best;
+}
+
+/** Deterministic xorshift noise in [-1, 1). */
+struct Noise {
+    uint32_t state = 0x12345678u;
+
+    float next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<float>(static_cast<int32_t>(state)) * (1.0f / 2147483648.0f);
+    }
+};
+
+/** Capsule-like test signal: a tone per channel over low-level noise, so the lossless codec sees realistic data. */
+std::vector<float> makeSignal(int frames, int sampleRate) {
+    std::vector<float> signal(static_cast<size_t>(frames) * kChannels);
+    Noise noise;
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int ch = 0; ch < kChannels; ++ch) {
+            const double hz = 110.0 * (1.0 + ch * 0.37);
+            const double phase = 2.0 * M_PI * hz * frame / sampleRate;
+            signal[static_cast<size_t>(frame) * kChannels + ch] =
+                0.1f * static_cast<float>(std::sin(phase)) + 0.003f * noise.next();
+        }
+    }
+    return signal;
+}
+
+void removeFile(const std::string& path) {
+    ::unlink(path.c_str());
+    ::unlink((path + ".tmp").c_str());
+}
+
+// ---------------------------------------------------------------------------
+// FFT
+
+void benchmarkFft(const Options& options, Report& report) {
+    std::fprintf(stderr, "fft\n");
+    const size_t sizes[] = {256, 1024, 4096, 8192, 16384};
+    for (const size_t size : sizes) {
+        spcmic::FftEngine fft;
+        if (!fft.initialize(size)) {
+            continue;
+        }
+        std::vector<float> real(size);
+        Noise noise;
+        for (float& sample : real) {
+            sample = noise.next();
+        }
+        std::vector<std::complex<float>> spectrum(size / 2 + 1);
+        std::vector<std::complex<float>> complexData(size);
+        std::vector<std::complex<float>> complexOut(size);
+        for (auto& value : complexData) {
+            value = {noise.next(), noise.next()};
+        }
+
+        const std::string suffix = "." + std::to_string(size);
+        const double rfft = bestSecondsPerCall([&]() { fft.rfft(real.data(), spectrum.data()); },
+                                               options.minTimingSeconds);
+        const double irfft = bestSecondsPerCall([&]() { fft.irfft(spectrum.data(), real.data()); },
+                                                options.minTimingSeconds);
+        const double complexForward = bestSecondsPerCall([&]() { fft.forward(complexData.data(), complexOut.data()); },
+                                                         options.minTimingSeconds);
+        report.add("fft.rfft" + suffix, rfft * 1e9, "ns", false);
+        report.add("fft.irfft" + suffix, irfft * 1e9, "ns", false);
+        report.add("fft.complex" + suffix, complexForward * 1e9, "ns", false);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 24-bit converters
+
+void benchmarkPcm24(const Options& options, Report& report) {
+    std::fprintf(stderr, "pcm24\n");
+    const size_t samples = static_cast<size_t>(kPlaybackBlockFrames) * kChannels;
+    std::vector<float> floats = makeSignal(kPlaybackBlockFrames, 48000);
+    std::vector<int32_t> ints(samples);
+    std::vector<uint8_t> packed(samples * kBytesPerSample);
+    pcm24::fromFloat(floats.data(), packed.data(), samples);
+    pcm24::Dither dither;
+
+    const double toFloat = bestSecondsPerCall([&]() { pcm24::toFloat(packed.data(), floats.data(), samples); },
+                                              options.minTimingSeconds);
+    const double toInt32 = bestSecondsPerCall([&]() { pcm24::toInt32(packed.data(), ints.data(), samples); },
+                                              options.minTimingSeconds);
+    const double fromFloat = bestSecondsPerCall([&]() { pcm24::fromFloat(floats.data(), packed.data(), samples); },
+                                                options.minTimingSeconds);
+    const double fromFloatDither = bestSecondsPerCall(
+        [&]() { pcm24::fromFloat(floats.data(), packed.data(), samples, &dither); }, options.minTimingSeconds);
+    const double applyGain = bestSecondsPerCall(
+        [&]() { pcm24::applyGain(packed.data(), kPlaybackBlockFrames, kChannels, 1.0001f, 1.0001f); },
+        options.minTimingSeconds);
+
+    const double msamples = static_cast<double>(samples) / 1e6;
+    report.add("pcm24.to_float", msamples / toFloat, "Msamples/s", true);
+    report.add("pcm24.to_int32", msamples / toInt32, "Msamples/s", true);
+    report.add("pcm24.from_float", msamples / fromFloat, "Msamples/s", true);
+    report.add("pcm24.from_float_dither", msamples / fromFloatDither, "Msamples/s", true);
+    report.add("pcm24.apply_gain", msamples / applyGain, "Msamples/s", true);
+}
+
+// ---------------------------------------------------------------------------
+// Ring buffer
+
+/**
+ * One producer and one consumer thread streaming @p totalBytes through the
+ * ring, copying with write()/read() or, with @p inPlace, filling and
+ * draining spans from reserveWrite()/peekRead().
+ */
+double ringThroughput(size_t capacity, size_t writeChunk, size_t readChunk, size_t totalBytes, bool inPlace) {
+    LockFreeRingBuffer ring(capacity);
+    std::vector<uint8_t> source(writeChunk, 0x5A);
+    std::atomic<bool> failed(false);
+
+    const auto start = Clock::now();
+    std::thread producer([&]() {
+        size_t sent = 0;
+        while (sent < totalBytes) {
+            const size_t wanted = std::min(writeChunk, totalBytes - sent);
+            size_t written = 0;
+            if (inPlace) {
+                const LockFreeRingBuffer::WriteRegion region = ring.reserveWrite(wanted);
+                if (region.firstSize > 0) {
+                    memset(region.first, 0x5A, region.firstSize);
+                }
+                if (region.secondSize > 0) {
+                    memset(region.second, 0x5A, region.secondSize);
+                }
+                written = region.size();
+                ring.commitWrite(written);
+            } else {
+                written = ring.write(source.data(), wanted);
+            }
+            if (written == 0) {
+                std::this_thread::yield();
+            }
+            sent += written;
+        }
+    });
+
+    std::vector<uint8_t> sink(readChunk);
+    size_t received = 0;
+    while (received < totalBytes) {
+        size_t read = 0;
+        uint8_t first = 0x5A;
+        if (inPlace) {
+            const LockFreeRingBuffer::ReadRegion region = ring.peekRead(readChunk);
+            read = region.size();
+            if (read > 0) {
+                first = region.first[0];
+                sink[0] ^= region.first[region.firstSize - 1];  // touch the span like a consumer would
+                ring.consumeRead(read);
+            }
+        } else {
+            read = ring.read(sink.data(), readChunk);
+            first = sink[0];
+        }
+        if (read == 0) {
+            std::this_thread::yield();
+        } else if (first != 0x5A) {
+            failed.store(true);
+        }
+        received += read;
+    }
+    producer.join();
+    const double elapsed = secondsSince(start);
+    return failed.load() ? NAN : static_cast<double>(totalBytes) / elapsed / 1e6;
+}
+
+void benchmarkRing(const Options& options, Report& report) {
+    std::fprintf(stderr, "ring\n");
+    const size_t totalBytes = (options.quick ? 256u : 1024u) * 1024u * 1024u;
+    // Capture path: 1 ms USB chunks into a 4 MB ring, drained in disk-sized reads.
+    const size_t usbChunk = kFrameBytes * 48;
+    // Playback path: prefetch blocks into a small ring, drained in device bursts.
+    const size_t blockBytes = static_cast<size_t>(kPlaybackBlockFrames) * 2 * sizeof(float);
+    for (const bool inPlace : {false, true}) {
+        const char* suffix = inPlace ? "_in_place" : "";
+        double best = 0.0;
+        for (int rep = 0; rep < 3; ++rep) {
+            best = std::max(best, ringThroughput(4 * 1024 * 1024, usbChunk, 256 * 1024, totalBytes, inPlace));
+        }
+        report.add(std::string("ring.capture_path") + suffix, best, "MB/s", true);
+
+        best = 0.0;
+        for (int rep = 0; rep < 3; ++rep) {
+            best = std::max(best, ringThroughput(blockBytes * 6, blockBytes, 192 * 2 * sizeof(float),
+                                                 totalBytes / 4, inPlace));
+        }
+        report.add(std::string("ring.playback_path") + suffix, best, "MB/s", true);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Convolver
+
+struct PresetInfo {
+    spcmic::IRPreset preset;
+    const char* name;
+    int outputs;   // shape of the shipped IRs, used when an asset is missing
+};
+
+const PresetInfo kPresets[] = {
+    {spcmic::IRPreset::Binaural, "binaural", 2},
+    {spcmic::IRPreset::Ortf, "ortf", 2},
+    {spcmic::IRPreset::Xy, "xy", 2},
+    {spcmic::IRPreset::ThirdOrderAmbisonic, "3oa", 16},
+};
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const std::streamsize size = file.tellg();
+    if (size <= 0) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), size));
+}
+
+/** Shipped IR from --ir-dir, or decaying noise of the same shape (4096 taps at 48 kHz). */
+bool loadImpulseResponse(const Options& options, const PresetInfo& preset, int sampleRate,
+                         spcmic::MatrixImpulseResponse& ir, bool& synthetic) {
+    synthetic = false;
+    if (!options.irDir.empty()) {
+        const std::string name = std::string(preset.name) + (sampleRate >= 96000 ? "_96k" : "_48k") + ".wav";
+        std::vector<uint8_t> file;
+        if (readFile(options.irDir + "/" + name, file)) {
+            spcmic::IRLoader loader;
+            return loader.loadFromBuffer(name, file.data(), file.size(), sampleRate, ir);
+        }
+    }
+
+    synthetic = true;
+    ir = spcmic::MatrixImpulseResponse();
+    ir.sampleRate = sampleRate;
+    ir.irLength = sampleRate >= 96000 ? 8192 : 4096;
+    ir.numInputChannels = kChannels;
+    ir.numOutputChannels = preset.outputs;
+    ir.impulseData.resize(static_cast<size_t>(ir.numOutputChannels) * kChannels * ir.irLength);
+    Noise noise;
+    for (size_t i = 0; i < ir.impulseData.size(); ++i) {
+        const int tap = static_cast<int>(i % static_cast<size_t>(ir.irLength));
+        ir.impulseData[i] = 0.05f * noise.next() * std::exp(-6.0f * tap / ir.irLength);
+    }
+    return true;
+}
+
+/** Audio seconds rendered per wall second. */
+double realtimeFactor(spcmic::MatrixConvolver& convolver, int sampleRate, double audioSeconds) {
+    const int blockFrames = convolver.blockSize();
+    const int blocks = std::max(1, static_cast<int>(audioSeconds * sampleRate / blockFrames));
+    std::vector<float> input(static_cast<size_t>(blockFrames) * kChannels);
+    Noise noise;
+    for (float& sample : input) {
+        sample = 0.1f * noise.next();
+    }
+    std::vector<float> output(static_cast<size_t>(blockFrames) * convolver.numOutputChannels());
+
+    // Fill the frequency-domain delay line before timing.
+    const int warmup = std::min(blocks, convolver.tailBlockCount() + 2);
+    for (int i = 0; i < warmup; ++i) {
+        convolver.process(input.data(), output.data(), blockFrames);
+    }
+    const auto start = Clock::now();
+    for (int i = 0; i < blocks; ++i) {
+        convolver.process(input.data(), output.data(), blockFrames);
+    }
+    const double elapsed = secondsSince(start);
+    return (static_cast<double>(blocks) * blockFrames / sampleRate) / elapsed;
+}
+
+void benchmarkConvolver(const Options& options, Report& report) {
+    std::fprintf(stderr, "convolver\n");
+    const int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const int parallelThreads = std::min(hardwareThreads, kMaxConvolverThreads);
+    const int rates[] = {48000, 96000};
+
+    for (const PresetInfo& preset : kPresets) {
+        for (const int rate : rates) {
+            spcmic::MatrixImpulseResponse ir;
+            bool synthetic = false;
+            if (!loadImpulseResponse(options, preset, rate, ir, synthetic)) {
+                std::fprintf(stderr, "failed to load the %s IR at %d Hz\n", preset.name, rate);
+                continue;
+            }
+            const std::string base = std::string("convolver.") + preset.name + "_" + std::to_string(rate / 1000) + "k";
+            report.note(base.substr(10) + "_ir", synthetic ? "synthetic" : "asset");
+
+            spcmic::MatrixConvolver convolver;
+            const auto configureStart = Clock::now();
+            if (!convolver.configure(&ir, kPlaybackBlockFrames)) {
+                std::fprintf(stderr, "convolver configuration failed for %s\n", base.c_str());
+                continue;
+            }
+            report.add(base + ".configure", secondsSince(configureStart) * 1e3, "ms", false);
+
+            const double rtf = realtimeFactor(convolver, rate, options.convolverSeconds);
+            report.add(base + ".uniform.rtf", rtf, "x realtime", true);
+
+            // Spectral MAC rate: the block's time less its FFTs, against 8 flops per complex MAC.
+            spcmic::FftEngine fft;
+            if (fft.initialize(static_cast<size_t>(kPlaybackBlockFrames) * 2)) {
+                std::vector<float> real(fft.size());
+                std::vector<std::complex<float>> spectrum(fft.size() / 2 + 1);
+                const double rfft = bestSecondsPerCall([&]() { fft.rfft(real.data(), spectrum.data()); }, 0.05);
+                const double blockSeconds = kPlaybackBlockFrames / (rtf * rate);
+                const double macSeconds = blockSeconds - rfft * (kChannels + ir.numOutputChannels);
+                const double partitions = std::ceil(static_cast<double>(ir.irLength) / kPlaybackBlockFrames);
+                const double flops = 8.0 * ir.numOutputChannels * kChannels * partitions * spectrum.size();
+                if (macSeconds > 0.0) {
+                    report.add(base + ".mac", flops / macSeconds / 1e9, "GFLOP/s", true);
+                }
+            }
+
+            if (parallelThreads > 1) {
+                convolver.setThreadCount(parallelThreads);
+                convolver.reset();
+                report.add(base + ".uniform_mt" + std::to_string(parallelThreads) + ".rtf",
+                           realtimeFactor(convolver, rate, options.convolverSeconds), "x realtime", true);
+            }
+
+            spcmic::MatrixConvolver monitor;
+            if (monitor.configureLowLatency(&ir, kLowLatencyHeadFrames, kLowLatencyTailFrames)) {
+                report.add(base + ".low_latency.rtf",
+                           realtimeFactor(monitor, rate, options.convolverSeconds), "x realtime", true);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// WAV writer and reader
+
+/** PCM MB/s through WAVWriter, close() included; @p ratio gets file size over PCM size. */
+double writeWav(const std::string& path, bool lossless, const std::vector<uint8_t>& chunk,
+                size_t totalBytes, int sampleRate, double& ratio) {
+    removeFile(path);
+    WAVWriter writer;
+    writer.setLossless(lossless);
+    const auto start = Clock::now();
+    if (!writer.open(path, sampleRate, kChannels, kBytesPerSample * 8)) {
+        return NAN;
+    }
+    for (size_t written = 0; written < totalBytes; written += chunk.size()) {
+        if (!writer.writeData(chunk.data(), std::min(chunk.size(), totalBytes - written))) {
+            writer.close();
+            return NAN;
+        }
+    }
+    writer.close();
+    const double elapsed = secondsSince(start);
+
+    struct stat info {};
+    ratio = ::stat(path.c_str(), &info) == 0 ? static_cast<double>(info.st_size) / totalBytes : NAN;
+    return static_cast<double>(totalBytes) / elapsed / 1e6;
+}
+
+/** Decoded PCM MB/s through WavFileReader::read() in playback-sized blocks. */
+double readWav(const std::string& path, int64_t expectedFrames) {
+    spcmic::WavFileReader reader;
+    if (!reader.open(path)) {
+        return NAN;
+    }
+    std::vector<float> buffer(static_cast<size_t>(kPlaybackBlockFrames) * reader.getNumChannels());
+    double best = 0.0;
+    for (int rep = 0; rep < 3; ++rep) {
+        reader.seek(0);
+        int64_t frames = 0;
+        const auto start = Clock::now();
+        for (;;) {
+            const int32_t read = reader.read(buffer.data(), kPlaybackBlockFrames);
+            if (read <= 0) {
+                break;
+            }
+            frames += read;
+        }
+        const double elapsed = secondsSince(start);
+        if (frames != expectedFrames) {
+            std::fprintf(stderr, "%s: read %lld of %lld frames\n", path.c_str(),
+                         static_cast<long long>(frames), static_cast<long long>(expectedFrames));
+            return NAN;
+        }
+        best = std::max(best, static_cast<double>(frames) * kFrameBytes / elapsed / 1e6);
+    }
+    return best;
+}
+
+void benchmarkWav(const Options& options, Report& report) {
+    std::fprintf(stderr, "wav\n");
+    constexpr int kSampleRate = 48000;
+    constexpr int kChunkFrames = 1024;  // about one disk-thread ring read
+    const int64_t totalFrames = static_cast<int64_t>(options.wavSeconds * kSampleRate) / kChunkFrames * kChunkFrames;
+    const size_t totalBytes = static_cast<size_t>(totalFrames) * kFrameBytes;
+
+    const std::vector<float> signal = makeSignal(kChunkFrames, kSampleRate);
+    std::vector<uint8_t> chunk(static_cast<size_t>(kChunkFrames) * kFrameBytes);
+    pcm24::Dither dither;
+    pcm24::fromFloat(signal.data(), chunk.data(), signal.size(), &dither);
+
+    const std::string pid = std::to_string(static_cast<long long>(::getpid()));
+    for (const bool lossless : {false, true}) {
+        const char* kind = lossless ? "lossless" : "pcm";
+        const std::string path = options.tmpDir + "/spcmic_benchmark_" + pid + "_" + kind + ".wav";
+        double ratio = NAN;
+        report.add(std::string("wav.writer.") + kind, writeWav(path, lossless, chunk, totalBytes, kSampleRate, ratio),
+                   "MB/s", true);
+        if (lossless) {
+            report.add("wav.lossless.size_ratio", ratio, "ratio", false);
+        }
+        report.add(std::string("wav.reader.") + kind, readWav(path, totalFrames), "MB/s", true);
+        removeFile(path);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Baseline comparison
+
+/** name -> value from a previous run's output. */
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> values;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t nameKey = line.find("\"name\": \"");
+        const size_t valueKey = line.find("\"value\": ");
+        if (nameKey == std::string::npos || valueKey == std::string::npos) {
+            continue;
+        }
+        const size_t nameStart = nameKey + 9;
+        const size_t nameEnd = line.find('"', nameStart);
+        if (nameEnd == std::string::npos) {
+            continue;
+        }
+        values[line.substr(nameStart, nameEnd - nameStart)] = std::strtod(line.c_str() + valueKey + 9, nullptr);
+    }
+    return values;
+}
+
+/** Number of results worse than the baseline by more than the tolerance. */
+int compareWithBaseline(const Options& options, const Report& report) {
+    const std::map<std::string, double> baseline = readBaseline(options.baselinePath);
+    if (baseline.empty()) {
+        std::fprintf(stderr, "baseline %s has no results\n", options.baselinePath.c_str());
+        return 1;
+    }
+    int regressions = 0;
+    for (const Result& result : report.results()) {
+        const auto found = baseline.find(result.name);
+        if (found == baseline.end() || found->second <= 0.0) {
+            continue;
+        }
+        const double change = result.value / found->second - 1.0;
+        const bool regressed = result.higherIsBetter ? change < -options.tolerance : change > options.tolerance;
+        if (regressed) {
+            std::fprintf(stderr, "REGRESSION %s: %.3f -> %.3f %s (%+.1f%%)\n", result.name.c_str(),
+                         found->second, result.value, result.unit.c_str(), change * 100.0);
+            ++regressions;
+        }
+    }
+    std::fprintf(stderr, "%d regression(s) beyond %.0f%% against %s\n", regressions, options.tolerance * 100.0,
+                 options.baselinePath.c_str());
+    return regressions;
+}
+
+// ---------------------------------------------------------------------------
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --quick             short runs, for smoke tests\n"
+                 "  --filter SUITE      run suites whose name contains SUITE (fft, pcm24, ring, convolver, wav)\n"
+                 "  --ir-dir DIR        directory holding the shipped IR WAVs (default: %s)\n"
+                 "  --tmp-dir DIR       scratch directory for WAV files (default: %s)\n"
+                 "  --output FILE       write the JSON report to FILE instead of stdout\n"
+                 "  --baseline FILE     compare against a previous report; exit 2 on regressions\n"
+                 "  --tolerance F       allowed relative slowdown against the baseline (default 0.10)\n",
+                 program, SPCMIC_BENCHMARK_IR_DIR[0] ? SPCMIC_BENCHMARK_IR_DIR : "none, synthetic IRs",
+                 SPCMIC_BENCHMARK_TMP_DIR);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--ir-dir" && hasValue) {
+            options.irDir = argv[++i];
+        } else if (arg == "--tmp-dir" && hasValue) {
+            options.tmpDir = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            options.tolerance = std::strtod(argv[++i], nullptr);
+        } else {
+            return false;
+        }
+    }
+    if (options.quick) {
+        options.convolverSeconds = 1.0;
+        options.wavSeconds = 3.0;
+        options.minTimingSeconds = 0.02;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Report report;
+#if defined(__aarch64__)
+    report.note("arch", "arm64");
+#elif defined(__arm__)
+    report.note("arch", "arm");
+#elif defined(__x86_64__)
+    report.note("arch", "x86_64");
+#else
+    report.note("arch", "other");
+#endif
+#if defined(__ARM_NEON)
+    report.note("simd", "neon");
+#else
+    report.note("simd", "scalar");
+#endif
+#if defined(__ANDROID__)
+    report.note("os", "android");
+#else
+    report.note("os", "host");
+#endif
+    report.note("hardware_threads", std::to_string(std::thread::hardware_concurrency()));
+    report.note("mode", options.quick ? "quick" : "full");
+
+    const struct {
+        const char* name;
+        void (*run)(const Options&, Report&);
+    } suites[] = {
+        {"fft", benchmarkFft},
+        {"pcm24", benchmarkPcm24},
+        {"ring", benchmarkRing},
+        {"convolver", benchmarkConvolver},
+        {"wav", benchmarkWav},
+    };
+    for (const auto& suite : suites) {
+        if (options.filter.empty() || std::strstr(suite.name, options.filter.c_str())) {
+            suite.run(options, report);
+        }
+    }
+
+    FILE* out = stdout;
+    if (!options.outputPath.empty()) {
+        out = std::fopen(options.outputPath.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "cannot write %s\n", options.outputPath.c_str());
+            return 1;
+        }
+    }
+    report.write(out);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+
+    if (!options.baselinePath.empty() && compareWithBaseline(options, report) > 0) {
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * Multi-phase stress check for WorkerPool: alternates an 84-task phase and a
+ * 4-task phase, like the convolver's forward and accumulate passes, and
+ * verifies that every task of every phase runs exactly once, under the
+ * right task function, without the pool hanging. Built with
+ * SPCMIC_WORKER_POOL_WAKE_DELAY_US so helpers routinely pick up a phase late.
+ */
+#include "matrix_convolver/worker_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kForwardTasks = 84;
+constexpr int kAccumulateTasks = 4;
+constexpr int kThreads = 4;
+constexpr int kDefaultIterations = 20000;
+constexpr int kTimeoutSeconds = 60;
+
+struct Phase {
+    int id;
+    std::vector<std::atomic<int>> hits;
+
+    Phase(int id, int tasks) : id(id), hits(tasks) {}
+
+    void clear() {
+        for (auto& hit : hits) {
+            hit.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+std::atomic<int> g_activePhase(0);
+std::atomic<bool> g_yieldInTasks(false);
+std::atomic<long> g_errors(0);
+
+void runTask(void* context, int taskIndex) {
+    Phase* phase = static_cast<Phase*>(context);
+    if (g_activePhase.load(std::memory_order_relaxed) != phase->id) {
+        g_errors.fetch_add(1, std::memory_order_relaxed);  // stale task from a finished phase
+    }
+    phase->hits[taskIndex].fetch_add(1, std::memory_order_relaxed);
+    if (g_yieldInTasks.load(std::memory_order_relaxed) && (taskIndex & 7) == 0) {
+        std::this_thread::yield();  // let helpers in on a single core
+    }
+}
+
+void forwardTask(void* context, int taskIndex) { runTask(context, taskIndex); }
+void accumulateTask(void* context, int taskIndex) { runTask(context, taskIndex); }
+
+void checkPhase(const Phase& phase) {
+    for (const auto& hit : phase.hits) {
+        if (hit.load(std::memory_order_relaxed) != 1) {
+            g_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : kDefaultIterations;
+
+    std::atomic<bool> finished(false);
+    std::thread watchdog([&finished]() {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(kTimeoutSeconds);
+        while (!finished.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!finished.load()) {
+            std::fprintf(stderr, "worker pool hung after %d s\n", kTimeoutSeconds);
+            std::fflush(stderr);
+            std::_Exit(2);
+        }
+    });
+
+    spcmic::WorkerPool pool;
+    if (!pool.start(kThreads)) {
+        std::fprintf(stderr, "failed to start the worker pool\n");
+        return 1;
+    }
+
+    Phase forward(1, kForwardTasks);
+    Phase accumulate(2, kAccumulateTasks);
+    for (int i = 0; i < iterations; ++i) {
+        // Alternate helpers taking part in every phase with the caller
+        // finishing phases alone and the helpers waking up afterwards.
+        g_yieldInTasks.store(i % 3 == 0, std::memory_order_relaxed);
+        forward.clear();
+        accumulate.clear();
+
+        g_activePhase.store(forward.id, std::memory_order_relaxed);
+        pool.run(kForwardTasks, forwardTask, &forward);
+        checkPhase(forward);
+        std::this_thread::yield();
+
+        g_activePhase.store(accumulate.id, std::memory_order_relaxed);
+        pool.run(kAccumulateTasks, accumulateTask, &accumulate);
+        checkPhase(accumulate);
+        g_activePhase.store(0, std::memory_order_relaxed);
+    }
+
+    pool.stop();
+    finished.store(true);
+    watchdog.join();
+
+    const long errors = g_errors.load();
+    std::printf("%d iterations, %ld errors\n", iterations, errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,446 @@
+#include "elastic_ring_buffer.h"
+#include "thread_config.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG_TAG "ElasticRingBuffer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+ElasticRingBuffer::ElasticRingBuffer(const Config& config)
+    : m_config(config)
+    , m_writeSegment(nullptr)
+    , m_writeOffset(0)
+    , m_nextSegment(nullptr)
+    , m_readSegment(nullptr)
+    , m_readOffset(0)
+    , m_spoolFd(-1)
+    , m_spoolReadPos(0)
+    , m_spoolWritePos(0)
+    , m_spoolFailed(false)
+    , m_shrinking(false)
+    , m_memoryLow(false)
+    , m_lockWarningLogged(false)
+    , m_lastBacklog(std::chrono::steady_clock::now())
+    , m_lastMemoryCheck()
+    , m_freeHead(0)
+    , m_freeTail(0)
+    , m_bytesWritten(0)
+    , m_bytesRead(0)
+    , m_spooledPending(0)
+    , m_spooledTotal(0)
+    , m_segmentCount(0)
+    , m_stopMaintenance(false) {
+
+    const long pageSizeValue = sysconf(_SC_PAGESIZE);
+    const size_t pageSize = pageSizeValue > 0 ? static_cast<size_t>(pageSizeValue) : 4096;
+    m_config.segmentBytes = std::max(pageSize, (m_config.segmentBytes + pageSize - 1) / pageSize * pageSize);
+    m_config.initialSegments = std::max<size_t>(2, m_config.initialSegments);
+    m_config.maxSegments = std::max(m_config.initialSegments, m_config.maxSegments);
+
+    // One slot more than can ever be free, so a full list is distinguishable from an empty one.
+    m_freeSlots.assign(m_config.maxSegments + 1, nullptr);
+
+    for (size_t i = 0; i < m_config.initialSegments; ++i) {
+        Segment* segment = mapSegment();
+        if (!segment) {
+            break;
+        }
+        if (!m_writeSegment) {
+            m_writeSegment = segment;
+            m_readSegment = segment;
+        } else {
+            pushFree(segment);
+        }
+    }
+
+    if (!m_writeSegment) {
+        LOGE("Failed to map any ring segments");
+        return;
+    }
+
+    LOGI("Ring ready: %zu x %zu KB segments (ceiling %zu), spool %s",
+         m_segmentCount.load(), m_config.segmentBytes / 1024, m_config.maxSegments,
+         m_config.spoolPath.empty() ? "disabled" : m_config.spoolPath.c_str());
+
+    m_maintenanceThread = std::thread(&ElasticRingBuffer::maintenanceLoop, this);
+}
+
+ElasticRingBuffer::~ElasticRingBuffer() {
+    {
+        std::lock_guard<std::mutex> lock(m_maintenanceMutex);
+        m_stopMaintenance = true;
+    }
+    m_maintenanceCV.notify_one();
+    if (m_maintenanceThread.joinable()) {
+        m_maintenanceThread.join();
+    }
+
+    // Live segments form a chain from the read head through the write segment.
+    Segment* segment = m_readSegment;
+    while (segment) {
+        Segment* next = segment->next.load(std::memory_order_relaxed);
+        unmapSegment(segment);
+        segment = next;
+    }
+    if (m_nextSegment) {
+        unmapSegment(m_nextSegment);
+    }
+    while (Segment* free = popFree()) {
+        unmapSegment(free);
+    }
+
+    if (m_spoolFd >= 0) {
+        ::close(m_spoolFd);
+        unlink(m_config.spoolPath.c_str());
+    }
+
+    if (m_spooledTotal.load() > 0) {
+        LOGI("Spool file carried %" PRIu64 " bytes during the session", m_spooledTotal.load());
+    }
+}
+
+ElasticRingBuffer::WriteRegion ElasticRingBuffer::reserveWrite(size_t size) {
+    WriteRegion region;
+    if (!m_writeSegment || size == 0) {
+        return region;
+    }
+
+    const size_t segmentBytes = m_config.segmentBytes;
+    if (m_writeOffset == segmentBytes) {
+        // Current segment is full: link the next one before handing out space.
+        Segment* next = m_nextSegment ? m_nextSegment : popFree();
+        if (!next) {
+            return region;
+        }
+        m_nextSegment = nullptr;
+        m_writeSegment->next.store(next, std::memory_order_release);
+        m_writeSegment = next;
+        m_writeOffset = 0;
+    }
+
+    region.first = m_writeSegment->data + m_writeOffset;
+    region.firstSize = std::min(size, segmentBytes - m_writeOffset);
+    if (region.firstSize < size) {
+        if (!m_nextSegment) {
+            m_nextSegment = popFree();
+        }
+        if (m_nextSegment) {
+            region.second = m_nextSegment->data;
+            region.secondSize = std::min(size - region.firstSize, segmentBytes);
+        }
+    }
+    return region;
+}
+
+void ElasticRingBuffer::commitWrite(size_t size) {
+    if (!m_writeSegment || size == 0) {
+        return;
+    }
+
+    const size_t first = std::min(size, m_config.segmentBytes - m_writeOffset);
+    m_writeOffset += first;
+    m_writeSegment->committed.store(m_writeOffset, std::memory_order_release);
+
+    size_t published = first;
+    const size_t second = size - first;
+    if (second > 0 && m_nextSegment) {
+        Segment* next = m_nextSegment;
+        m_nextSegment = nullptr;
+        // Publish the new segment's fill before linking it.
+        next->committed.store(second, std::memory_order_release);
+        m_writeSegment->next.store(next, std::memory_order_release);
+        m_writeSegment = next;
+        m_writeOffset = second;
+        published += second;
+    }
+
+    const uint64_t written = m_bytesWritten.load(std::memory_order_relaxed);
+    m_bytesWritten.store(written + published, std::memory_order_release);
+}
+
+size_t ElasticRingBuffer::read(uint8_t* data, size_t size) {
+    if (!data || size == 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_consumerMutex);
+    if (!m_readSegment) {
+        return 0;
+    }
+    // Spooled bytes are always older than anything still in RAM.
+    if (m_spoolReadPos < m_spoolWritePos) {
+        return readSpool(data, size);
+    }
+    return readRing(data, size);
+}
+
+size_t ElasticRingBuffer::readSpool(uint8_t* data, size_t size) {
+    const size_t toRead = static_cast<size_t>(std::min<uint64_t>(size, m_spoolWritePos - m_spoolReadPos));
+    size_t done = 0;
+    while (done < toRead) {
+        ssize_t got = pread(m_spoolFd, data + done, toRead - done, static_cast<off_t>(m_spoolReadPos + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            // Nothing sensible to retry; drop the rest of the spool so the drain terminates.
+            const uint64_t lost = m_spoolWritePos - m_spoolReadPos - done;
+            LOGE("Spool read failed (%s), dropping %" PRIu64 " bytes", got < 0 ? strerror(errno) : "EOF", lost);
+            m_spooledPending.fetch_sub(m_spoolWritePos - m_spoolReadPos, std::memory_order_acq_rel);
+            m_spoolReadPos = m_spoolWritePos;
+            break;
+        }
+        done += static_cast<size_t>(got);
+    }
+
+    if (m_spoolReadPos < m_spoolWritePos) {
+        m_spoolReadPos += done;
+        m_spooledPending.fetch_sub(done, std::memory_order_acq_rel);
+    }
+
+    if (m_spoolReadPos == m_spoolWritePos) {
+        // Fully merged back into the stream: give the space back.
+        if (ftruncate(m_spoolFd, 0) != 0) {
+            LOGW("Failed to truncate spool file: %s", strerror(errno));
+        }
+        m_spoolReadPos = 0;
+        m_spoolWritePos = 0;
+    }
+    return done;
+}
+
+size_t ElasticRingBuffer::readRing(uint8_t* data, size_t size) {
+    const size_t segmentBytes = m_config.segmentBytes;
+    size_t copied = 0;
+
+    while (copied < size) {
+        const size_t committed = m_readSegment->committed.load(std::memory_order_acquire);
+        if (m_readOffset < committed) {
+            const size_t chunk = std::min(size - copied, committed - m_readOffset);
+            memcpy(data + copied, m_readSegment->data + m_readOffset, chunk);
+            m_readOffset += chunk;
+            copied += chunk;
+            continue;
+        }
+        if (m_readOffset < segmentBytes) {
+            break;  // producer is still filling this segment
+        }
+        Segment* next = m_readSegment->next.load(std::memory_order_acquire);
+        if (!next) {
+            break;  // full, but the producer has not moved on yet
+        }
+        recycle(m_readSegment);
+        m_readSegment = next;
+        m_readOffset = 0;
+    }
+
+    if (copied > 0) {
+        m_bytesRead.fetch_add(copied, std::memory_order_acq_rel);
+    }
+    return copied;
+}
+
+void ElasticRingBuffer::recycle(Segment* segment) {
+    segment->committed.store(0, std::memory_order_relaxed);
+    segment->next.store(nullptr, std::memory_order_relaxed);
+
+    const bool release = (m_shrinking || m_memoryLow) &&
+                         m_segmentCount.load(std::memory_order_relaxed) > m_config.initialSegments;
+    if (release || !pushFree(segment)) {
+        unmapSegment(segment);
+    }
+}
+
+bool ElasticRingBuffer::spillHeadSegment() {
+    Segment* next = m_readSegment->next.load(std::memory_order_acquire);
+    if (!next) {
+        return false;  // only sealed segments are spilled; the producer may still own the head
+    }
+
+    if (m_spoolFd < 0) {
+        m_spoolFd = ::open(m_config.spoolPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (m_spoolFd < 0) {
+            LOGE("Failed to create spool file %s: %s", m_config.spoolPath.c_str(), strerror(errno));
+            m_spoolFailed = true;
+            return false;
+        }
+        LOGW("Ring at capacity, spilling to %s", m_config.spoolPath.c_str());
+    }
+
+    const uint8_t* src = m_readSegment->data + m_readOffset;
+    const size_t bytes = m_config.segmentBytes - m_readOffset;
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t written = pwrite(m_spoolFd, src + done, bytes - done, static_cast<off_t>(m_spoolWritePos + done));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            // Typically ENOSPC. Stop spilling; the ring will overflow and report drops.
+            LOGE("Spool write failed after %" PRIu64 " bytes: %s",
+                 m_spoolWritePos, written < 0 ? strerror(errno) : "short write");
+            m_spoolFailed = true;
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+
+    m_spoolWritePos += bytes;
+    m_spooledPending.fetch_add(bytes, std::memory_order_acq_rel);
+    m_spooledTotal.fetch_add(bytes, std::memory_order_relaxed);
+    m_bytesRead.fetch_add(bytes, std::memory_order_acq_rel);
+
+    recycle(m_readSegment);
+    m_readSegment = next;
+    m_readOffset = 0;
+    return true;
+}
+
+bool ElasticRingBuffer::memoryAvailable() {
+    FILE* meminfo = fopen("/proc/meminfo", "re");
+    if (!meminfo) {
+        return true;
+    }
+
+    unsigned long long availableKb = 0;
+    bool found = false;
+    char line[128];
+    while (fgets(line, sizeof(line), meminfo)) {
+        if (sscanf(line, "MemAvailable: %llu kB", &availableKb) == 1) {
+            found = true;
+            break;
+        }
+    }
+    fclose(meminfo);
+    return !found || availableKb * 1024ull >= MIN_AVAILABLE_MEMORY;
+}
+
+void ElasticRingBuffer::maintenanceLoop() {
+    thread_config::configureCurrentThread(thread_config::Role::Background);
+    std::unique_lock<std::mutex> lock(m_maintenanceMutex);
+    while (!m_stopMaintenance) {
+        lock.unlock();
+        maintain();
+        lock.lock();
+        m_maintenanceCV.wait_for(lock, std::chrono::milliseconds(MAINTENANCE_INTERVAL_MS),
+                                 [this]() { return m_stopMaintenance; });
+    }
+}
+
+void ElasticRingBuffer::maintain() {
+    std::lock_guard<std::mutex> lock(m_consumerMutex);
+    const auto now = std::chrono::steady_clock::now();
+    const size_t segmentBytes = m_config.segmentBytes;
+
+    // Shrink only after the backlog has stayed under one segment for a while.
+    if (getRingBytes() > segmentBytes) {
+        m_lastBacklog = now;
+        m_shrinking = false;
+    } else if (!m_shrinking && now - m_lastBacklog > std::chrono::milliseconds(SHRINK_AFTER_IDLE_MS) &&
+               m_segmentCount.load(std::memory_order_relaxed) > m_config.initialSegments) {
+        LOGI("Backlog cleared, shrinking ring from %zu segments", m_segmentCount.load());
+        m_shrinking = true;
+    }
+
+    if (now - m_lastMemoryCheck > std::chrono::milliseconds(MEMORY_CHECK_INTERVAL_MS)) {
+        m_lastMemoryCheck = now;
+        const bool low = !memoryAvailable();
+        if (low != m_memoryLow) {
+            LOGW("Available memory %s, ring growth %s", low ? "low" : "recovered", low ? "paused" : "resumed");
+            m_memoryLow = low;
+        }
+    }
+
+    // Keep spare segments ahead of the producer, proportional to the backlog.
+    const size_t total = m_segmentCount.load(std::memory_order_relaxed);
+    const size_t spare = freeCount();
+    const size_t inUse = total > spare ? total - spare : 0;
+    const size_t spareTarget = std::max(MIN_SPARE_SEGMENTS, inUse / 2);
+    while (freeCount() < spareTarget && !m_memoryLow &&
+           m_segmentCount.load(std::memory_order_relaxed) < m_config.maxSegments) {
+        Segment* segment = mapSegment();
+        if (!segment) {
+            break;
+        }
+        m_shrinking = false;
+        if (!pushFree(segment)) {
+            unmapSegment(segment);
+            break;
+        }
+    }
+
+    // Out of RAM headroom: move the oldest sealed segments to the spool file.
+    const bool atCeiling = m_memoryLow ||
+                           m_segmentCount.load(std::memory_order_relaxed) >= m_config.maxSegments;
+    while (atCeiling && freeCount() < MIN_SPARE_SEGMENTS && !m_spoolFailed && !m_config.spoolPath.empty()) {
+        if (!spillHeadSegment()) {
+            break;
+        }
+    }
+}
+
+ElasticRingBuffer::Segment* ElasticRingBuffer::mapSegment() {
+    void* memory = mmap(nullptr, m_config.segmentBytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (memory == MAP_FAILED) {
+        LOGE("Failed to map %zu byte ring segment: %s", m_config.segmentBytes, strerror(errno));
+        return nullptr;
+    }
+
+    // Best effort: apps usually have a small RLIMIT_MEMLOCK. MAP_POPULATE has
+    // already faulted the pages in, so the producer never takes a page fault.
+    if (mlock(memory, m_config.segmentBytes) != 0 && !m_lockWarningLogged) {
+        LOGW("mlock of ring segment failed (%s); pages stay resident but unlocked", strerror(errno));
+        m_lockWarningLogged = true;
+    }
+
+    Segment* segment = new Segment();
+    segment->data = static_cast<uint8_t*>(memory);
+    m_segmentCount.fetch_add(1, std::memory_order_relaxed);
+    return segment;
+}
+
+void ElasticRingBuffer::unmapSegment(Segment* segment) {
+    munmap(segment->data, m_config.segmentBytes);
+    delete segment;
+    m_segmentCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool ElasticRingBuffer::pushFree(Segment* segment) {
+    const size_t slots = m_freeSlots.size();
+    const size_t tail = m_freeTail.load(std::memory_order_relaxed);
+    const size_t nextTail = (tail + 1) % slots;
+    if (nextTail == m_freeHead.load(std::memory_order_acquire)) {
+        return false;
+    }
+    m_freeSlots[tail] = segment;
+    m_freeTail.store(nextTail, std::memory_order_release);
+    return true;
+}
+
+ElasticRingBuffer::Segment* ElasticRingBuffer::popFree() {
+    const size_t head = m_freeHead.load(std::memory_order_relaxed);
+    if (head == m_freeTail.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    Segment* segment = m_freeSlots[head];
+    m_freeHead.store((head + 1) % m_freeSlots.size(), std::memory_order_release);
+    return segment;
+}
+
+size_t ElasticRingBuffer::freeCount() const {
+    const size_t slots = m_freeSlots.size();
+    const size_t head = m_freeHead.load(std::memory_order_acquire);
+    const size_t tail = m_freeTail.load(std::memory_order_acquire);
+    return (tail + slots - head) % slots;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Single-producer, single-consumer byte queue built from a pool of
+ * page-aligned, mlocked segments, for the recorder's USB -> disk path.
+ *
+ * The producer side (reserveWrite/commitWrite) is lock-free and never
+ * allocates: it only takes segments from a preallocated free list. A
+ * maintenance thread grows the pool towards a ceiling when the consumer
+ * falls behind, and lets it shrink back once the backlog is gone. When the
+ * ceiling is reached, or when available memory runs low, the oldest full
+ * segments are moved to a spool file on internal storage. read() returns
+ * spooled data before ring data, so the stream stays in order.
+ */
+class ElasticRingBuffer {
+public:
+    struct Config {
+        size_t segmentBytes = 1024 * 1024;
+        size_t initialSegments = 4;      // pool size at start, and the floor when shrinking
+        size_t maxSegments = 32;         // RAM ceiling
+        std::string spoolPath;           // empty disables spilling
+    };
+
+    /** Same shape as LockFreeRingBuffer::WriteRegion. */
+    struct WriteRegion {
+        uint8_t* first = nullptr;
+        size_t firstSize = 0;
+        uint8_t* second = nullptr;
+        size_t secondSize = 0;
+
+        size_t size() const { return firstSize + secondSize; }
+    };
+
+    explicit ElasticRingBuffer(const Config& config);
+    ~ElasticRingBuffer();
+
+    ElasticRingBuffer(const ElasticRingBuffer&) = delete;
+    ElasticRingBuffer& operator=(const ElasticRingBuffer&) = delete;
+
+    /** False if not even the initial segments could be mapped. */
+    bool isValid() const { return m_writeSegment != nullptr; }
+
+    /**
+     * Reserve up to @p size bytes for the producer to fill in place. The
+     * region spans at most two segments. Nothing becomes visible to the
+     * consumer until commitWrite().
+     */
+    WriteRegion reserveWrite(size_t size);
+
+    /** Publish @p size bytes of the last reservation (producer thread). */
+    void commitWrite(size_t size);
+
+    /** Copy out up to @p size bytes, spooled data first (consumer thread). */
+    size_t read(uint8_t* data, size_t size);
+
+    /** Bytes waiting for the consumer, in RAM and in the spool file. */
+    size_t getAvailableBytes() const {
+        return getRingBytes() + static_cast<size_t>(m_spooledPending.load(std::memory_order_acquire));
+    }
+
+    /** Bytes waiting in RAM segments only. */
+    size_t getRingBytes() const {
+        const uint64_t written = m_bytesWritten.load(std::memory_order_acquire);
+        const uint64_t read = m_bytesRead.load(std::memory_order_acquire);
+        return static_cast<size_t>(written - read);
+    }
+
+    /** Current RAM capacity (mapped segments). */
+    size_t getCapacity() const {
+        return m_segmentCount.load(std::memory_order_relaxed) * m_config.segmentBytes;
+    }
+
+    /** Total bytes moved through the spool file since construction. */
+    uint64_t getSpooledBytes() const { return m_spooledTotal.load(std::memory_order_relaxed); }
+
+private:
+    struct Segment {
+        uint8_t* data = nullptr;
+        std::atomic<size_t> committed{0};     // bytes published by the producer
+        std::atomic<Segment*> next{nullptr};  // set once the producer moves on
+    };
+
+    static constexpr int MAINTENANCE_INTERVAL_MS = 10;
+    static constexpr int MEMORY_CHECK_INTERVAL_MS = 250;
+    static constexpr int SHRINK_AFTER_IDLE_MS = 5000;
+    static constexpr size_t MIN_SPARE_SEGMENTS = 2;
+    static constexpr uint64_t MIN_AVAILABLE_MEMORY = 192ull * 1024 * 1024;
+
+    Segment* mapSegment();
+    void unmapSegment(Segment* segment);
+
+    // Free list: filled by the consumer side (under m_consumerMutex), drained by the producer.
+    bool pushFree(Segment* segment);
+    Segment* popFree();
+    size_t freeCount() const;
+
+    // Consumer side, m_consumerMutex held
+    size_t readSpool(uint8_t* data, size_t size);
+    size_t readRing(uint8_t* data, size_t size);
+    void recycle(Segment* segment);
+    bool spillHeadSegment();
+    bool memoryAvailable();
+
+    void maintenanceLoop();
+    void maintain();
+
+    Config m_config;
+
+    // Producer-owned
+    Segment* m_writeSegment;
+    size_t m_writeOffset;
+    Segment* m_nextSegment;   // taken by reserveWrite() for a region that crosses segments
+
+    // Consumer-owned (m_consumerMutex)
+    std::mutex m_consumerMutex;
+    Segment* m_readSegment;
+    size_t m_readOffset;
+    int m_spoolFd;
+    uint64_t m_spoolReadPos;
+    uint64_t m_spoolWritePos;
+    bool m_spoolFailed;
+    bool m_shrinking;
+    bool m_memoryLow;
+    bool m_lockWarningLogged;
+    std::chrono::steady_clock::time_point m_lastBacklog;
+    std::chrono::steady_clock::time_point m_lastMemoryCheck;
+
+    std::vector<Segment*> m_freeSlots;
+    std::atomic<size_t> m_freeHead;   // producer
+    std::atomic<size_t> m_freeTail;   // consumer side
+
+    // Producer and consumer counters on separate cache lines
+    alignas(64) std::atomic<uint64_t> m_bytesWritten;
+    alignas(64) std::atomic<uint64_t> m_bytesRead;   // ring bytes consumed or spooled
+    std::atomic<uint64_t> m_spooledPending;
+    std::atomic<uint64_t> m_spooledTotal;
+    std::atomic<size_t> m_segmentCount;
+
+    std::thread m_maintenanceThread;
+    std::mutex m_maintenanceMutex;
+    std::condition_variable m_maintenanceCV;
+    bool m_stopMaintenance;
+};
@@ -1,9 +1,11 @@
 #include <jni.h>
 #include <string>
+#include <vector>
 #include <android/log.h>
 #include <android/asset_manager_jni.h>
 #include "playback/playback_engine.h"
 #include "../jni_probe.h"
+#include "../thread_config.h"
 
 #define LOG_TAG "PlaybackJNI"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
@@ -15,6 +17,25 @@ using namespace spcmic;
 // Global playback engine instance
 static PlaybackEngine* g_playbackEngine = nullptr;
 
+static bool PresetFromId(jint presetId, IRPreset& preset) {
+    switch (presetId) {
+        case static_cast<jint>(IRPreset::Binaural):
+            preset = IRPreset::Binaural;
+            return true;
+        case static_cast<jint>(IRPreset::Ortf):
+            preset = IRPreset::Ortf;
+            return true;
+        case static_cast<jint>(IRPreset::Xy):
+            preset = IRPreset::Xy;
+            return true;
+        case static_cast<jint>(IRPreset::ThirdOrderAmbisonic):
+            preset = IRPreset::ThirdOrderAmbisonic;
+            return true;
+        default:
+            return false;
+    }
+}
+
 extern "C" {
 
 JNIEXPORT jlong JNICALL
@@ -81,6 +102,56 @@ Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeSetCacheDirectory(
     engine->setPreRenderCacheDirectory(dir);
 }
 
+JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeSetOverviewDirectory(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle,
+    jstring overviewDirectory) {
+    LogJniProbe(env, "nativeSetOverviewDirectory-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    if (!engine) {
+        LOGE("Invalid engine handle in setOverviewDirectory");
+        return;
+    }
+
+    const char* dirChars = env->GetStringUTFChars(overviewDirectory, nullptr);
+    std::string dir(dirChars);
+    env->ReleaseStringUTFChars(overviewDirectory, dirChars);
+
+    engine->setOverviewDirectory(dir);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeGetOverview(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle,
+    jdouble startSeconds,
+    jdouble endSeconds,
+    jint columns) {
+    LogJniProbe(env, "nativeGetOverview-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    if (!engine || columns <= 0) {
+        return nullptr;
+    }
+
+    std::vector<float> values(static_cast<size_t>(columns) * 3);
+    const int filled = engine->getOverview(startSeconds, endSeconds, columns, values.data());
+    if (filled <= 0) {
+        return nullptr;
+    }
+
+    jfloatArray result = env->NewFloatArray(static_cast<jsize>(filled * 3));
+    if (!result) {
+        return nullptr;
+    }
+    env->SetFloatArrayRegion(result, 0, static_cast<jsize>(filled * 3), values.data());
+    return result;
+}
+
 JNIEXPORT void JNICALL
 Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeConfigureExportPreset(
     JNIEnv* env,
@@ -98,23 +169,9 @@ Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeConfigureExportPres
     }
 
     IRPreset preset = IRPreset::Binaural;
-    switch (presetId) {
-        case static_cast<jint>(IRPreset::Binaural):
-            preset = IRPreset::Binaural;
-            break;
-        case static_cast<jint>(IRPreset::Ortf):
-            preset = IRPreset::Ortf;
-            break;
-        case static_cast<jint>(IRPreset::Xy):
-            preset = IRPreset::Xy;
-            break;
-        case static_cast<jint>(IRPreset::ThirdOrderAmbisonic):
-            preset = IRPreset::ThirdOrderAmbisonic;
-            break;
-        default:
-            LOGW("Unknown preset id %d, defaulting to binaural", presetId);
-            preset = IRPreset::Binaural;
-            break;
+    if (!PresetFromId(presetId, preset)) {
+        LOGW("Unknown preset id %d, defaulting to binaural", presetId);
+        preset = IRPreset::Binaural;
     }
 
     std::string cacheName;
@@ -306,6 +363,31 @@ Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeGetPreRenderProgres
     return static_cast<jint>(engine->getPreRenderProgress());
 }
 
+JNIEXPORT jlongArray JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeGetPreRenderStallStats(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle) {
+    LogJniProbe(env, "nativeGetPreRenderStallStats-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    if (!engine) {
+        return nullptr;
+    }
+
+    constexpr size_t kValues = static_cast<size_t>(RenderStallCounters::kStageCount) * 2;
+    int64_t values[kValues] = {};
+    const size_t count = engine->getPreRenderStallStats(values, kValues);
+
+    jlongArray result = env->NewLongArray(static_cast<jsize>(count));
+    if (!result) {
+        return nullptr;
+    }
+    static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64-bit");
+    env->SetLongArrayRegion(result, 0, static_cast<jsize>(count), reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
 JNIEXPORT void JNICALL
 Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeSetPlaybackGain(
     JNIEnv* env,
@@ -424,6 +506,54 @@ Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeExportPreRendered(
     return success ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeExportPresets(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle,
+    jintArray presetIds,
+    jobjectArray destinationPaths) {
+    LogJniProbe(env, "nativeExportPresets-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    if (!engine) {
+        LOGE("Invalid engine handle in exportPresets");
+        return JNI_FALSE;
+    }
+    if (!presetIds || !destinationPaths ||
+        env->GetArrayLength(presetIds) != env->GetArrayLength(destinationPaths)) {
+        LOGE("exportPresets needs one destination per preset");
+        return JNI_FALSE;
+    }
+
+    const jsize count = env->GetArrayLength(presetIds);
+    std::vector<jint> ids(static_cast<size_t>(count));
+    env->GetIntArrayRegion(presetIds, 0, count, ids.data());
+
+    std::vector<IRPreset> presets;
+    std::vector<std::string> paths;
+    for (jsize i = 0; i < count; ++i) {
+        IRPreset preset = IRPreset::Binaural;
+        if (!PresetFromId(ids[static_cast<size_t>(i)], preset)) {
+            LOGE("Unknown preset id %d in exportPresets", ids[static_cast<size_t>(i)]);
+            return JNI_FALSE;
+        }
+        auto path = static_cast<jstring>(env->GetObjectArrayElement(destinationPaths, i));
+        if (!path) {
+            LOGE("Null destination path in exportPresets");
+            return JNI_FALSE;
+        }
+        const char* chars = env->GetStringUTFChars(path, nullptr);
+        paths.emplace_back(chars ? chars : "");
+        env->ReleaseStringUTFChars(path, chars);
+        env->DeleteLocalRef(path);
+        presets.push_back(preset);
+    }
+
+    bool success = engine->exportPresets(presets, paths);
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jdouble JNICALL
 Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeGetPosition(
     JNIEnv* env,
@@ -484,4 +614,68 @@ Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeIsFileLoaded(
     return engine->isFileLoaded() ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeSetConvolverThreadCount(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle,
+    jint threads) {
+    LogJniProbe(env, "nativeSetConvolverThreadCount-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    if (!engine) {
+        LOGE("Invalid engine handle in setConvolverThreadCount");
+        return;
+    }
+
+    engine->setConvolverThreadCount(static_cast<int>(threads));
+}
+
+JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeSetLowLatencyConvolution(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle,
+    jint presetId,
+    jboolean enabled) {
+    LogJniProbe(env, "nativeSetLowLatencyConvolution-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    if (!engine) {
+        LOGE("Invalid engine handle in setLowLatencyConvolution");
+        return;
+    }
+
+    IRPreset preset = IRPreset::Binaural;
+    if (!PresetFromId(presetId, preset)) {
+        LOGW("Unknown preset id %d in setLowLatencyConvolution", presetId);
+        return;
+    }
+    engine->setLowLatencyConvolution(preset, enabled == JNI_TRUE);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeIsLowLatencyConvolution(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong engineHandle,
+    jint presetId) {
+    LogJniProbe(env, "nativeIsLowLatencyConvolution-entry", "PlaybackJNI");
+
+    PlaybackEngine* engine = reinterpret_cast<PlaybackEngine*>(engineHandle);
+    IRPreset preset = IRPreset::Binaural;
+    if (!engine || !PresetFromId(presetId, preset)) {
+        return JNI_FALSE;
+    }
+
+    return engine->isLowLatencyConvolution(preset) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_spcmic_recorder_playback_NativePlaybackEngine_nativeGetThreadPolicies(
+    JNIEnv* env,
+    jobject /* this */) {
+    return env->NewStringUTF(thread_config::describeGrantedPolicies().c_str());
+}
+
 } // extern "C"
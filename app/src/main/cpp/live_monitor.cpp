@@ -0,0 +1,239 @@
+#include "live_monitor.h"
+#include "pcm24.h"
+#include "thread_config.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <system_error>
+
+#define LOG_TAG "LiveMonitor"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr int kChannels = 84;
+constexpr int kBytesPerSample = 3;
+constexpr size_t kFrameBytes = static_cast<size_t>(kChannels) * kBytesPerSample;
+
+constexpr int kLowLatencyHeadFrames = 128;
+constexpr int kLowLatencyTailFrames = 512;
+constexpr int kUniformBlockFrames = 2048;
+
+constexpr int kTapBlocks = 8;            // tap capacity, in convolver blocks
+constexpr int kMaxBacklogBlocks = 4;     // queued input before skipping ahead
+constexpr int kOutputBlocks = 8;         // output ring capacity
+constexpr int kMaxQueuedOutputBlocks = 4;
+constexpr int kTapMinimumMs = 50;        // covers the USB reap interval for small blocks
+constexpr int kWakeTimeoutMs = 20;       // safety net only; push() wakes the thread
+
+}  // namespace
+
+LiveMonitor::LiveMonitor()
+    : m_active(false)
+    , m_pushing(false)
+    , m_audioOutput(std::make_unique<spcmic::AudioOutput>())
+    , m_stopRequested(false)
+    , m_blockFrames(0)
+    , m_maxBacklogBytes(0)
+    , m_maxQueuedOutputBytes(0)
+    , m_droppedFrames(0)
+    , m_outputOverflowFrames(0) {
+}
+
+LiveMonitor::~LiveMonitor() {
+    stop();
+    m_audioOutput->shutdown();
+}
+
+bool LiveMonitor::start(AAssetManager* assets, spcmic::IRPreset preset, int sampleRate, bool lowLatency) {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (m_active.load(std::memory_order_acquire)) {
+        LOGE("Live monitor already running");
+        return false;
+    }
+    if (!assets) {
+        LOGE("No asset manager; cannot load the monitor IR");
+        return false;
+    }
+
+    m_irLoader.setAssetManager(assets);
+    m_convolver.setSpectraCache(&spcmic::IRSpectraCache::shared());
+    auto configure = [this, lowLatency]() {
+        return lowLatency
+            ? m_convolver.configureLowLatency(&m_impulseResponse, kLowLatencyHeadFrames, kLowLatencyTailFrames)
+            : m_convolver.configure(&m_impulseResponse, kUniformBlockFrames);
+    };
+
+    // Cached spectra only need the IR header; decode the samples on a miss.
+    bool configured = false;
+    for (const bool includeSamples : {false, true}) {
+        spcmic::MatrixImpulseResponse ir;
+        if (!m_irLoader.loadPreset(preset, sampleRate, ir, includeSamples) || ir.numInputChannels != kChannels) {
+            LOGE("Failed to load monitor IR for preset %d at %d Hz", static_cast<int>(preset), sampleRate);
+            return false;
+        }
+        m_impulseResponse = std::move(ir);
+        configured = configure();
+        if (configured) {
+            break;
+        }
+    }
+    std::vector<float>().swap(m_impulseResponse.impulseData);
+    if (!configured) {
+        LOGE("Monitor convolver configuration failed");
+        return false;
+    }
+    // Same levels as convolved playback: stereo IRs 12 dB up, ambisonics unity.
+    const float gainDb = (m_impulseResponse.numOutputChannels == 2) ? 12.0f : 0.0f;
+    m_convolver.setOutputGain(std::pow(10.0f, gainDb / 20.0f));
+
+    m_blockFrames = m_convolver.blockSize();
+    const size_t blockBytes = static_cast<size_t>(m_blockFrames) * kFrameBytes;
+    const size_t tapFrames = std::max(static_cast<size_t>(m_blockFrames) * kTapBlocks,
+                                      static_cast<size_t>(sampleRate) * kTapMinimumMs / 1000);
+    const size_t tapBytes = tapFrames * kFrameBytes;
+    if (!m_tap || m_tap->getCapacity() != tapBytes) {
+        m_tap = std::make_unique<LockFreeRingBuffer>(tapBytes);
+    } else {
+        m_tap->reset();
+    }
+    m_maxBacklogBytes = std::max(blockBytes * kMaxBacklogBlocks, tapBytes / 2);
+
+    const size_t stereoBlockBytes = static_cast<size_t>(m_blockFrames) * 2 * sizeof(float);
+    if (!m_output || m_output->getCapacity() != stereoBlockBytes * kOutputBlocks) {
+        m_output = std::make_unique<LockFreeRingBuffer>(stereoBlockBytes * kOutputBlocks);
+    } else {
+        m_output->reset();
+    }
+    m_maxQueuedOutputBytes = stereoBlockBytes * kMaxQueuedOutputBlocks;
+
+    m_packed.assign(blockBytes, 0);
+    m_input.assign(static_cast<size_t>(m_blockFrames) * kChannels, 0.0f);
+    m_convolved.assign(static_cast<size_t>(m_blockFrames) * m_convolver.numOutputChannels(), 0.0f);
+    m_stereo.assign(static_cast<size_t>(m_blockFrames) * 2, 0.0f);
+    m_droppedFrames.store(0, std::memory_order_relaxed);
+    m_outputOverflowFrames.store(0, std::memory_order_relaxed);
+
+    auto callback = [this](float* buffer, int32_t numFrames) {
+        outputCallback(buffer, numFrames);
+    };
+    if (!m_audioOutput->initialize(sampleRate, m_blockFrames, callback) || !m_audioOutput->start()) {
+        LOGE("Failed to open the monitor output");
+        m_audioOutput->shutdown();
+        m_convolver.configure(nullptr, 0);
+        return false;
+    }
+
+    m_stopRequested.store(false, std::memory_order_release);
+    try {
+        m_monitorThread = std::thread(&LiveMonitor::monitorLoop, this);
+    } catch (const std::system_error& e) {
+        LOGE("Failed to start the monitor thread: %s", e.what());
+        m_audioOutput->shutdown();
+        m_convolver.configure(nullptr, 0);
+        return false;
+    }
+
+    // The rings are in place; from here on the USB thread may push.
+    m_active.store(true, std::memory_order_seq_cst);
+    LOGI("Live monitor started: preset %d, %d Hz, %d-frame blocks (%s), %d outputs",
+         static_cast<int>(preset), sampleRate, m_blockFrames, lowLatency ? "low latency" : "uniform",
+         m_convolver.numOutputChannels());
+    return true;
+}
+
+void LiveMonitor::stop() {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (!m_monitorThread.joinable()) {
+        return;
+    }
+
+    // Pairs with push(): either it sees m_active cleared, or we see it inside.
+    m_active.store(false, std::memory_order_seq_cst);
+    while (m_pushing.load(std::memory_order_seq_cst)) {
+        std::this_thread::yield();
+    }
+
+    m_stopRequested.store(true, std::memory_order_seq_cst);
+    m_tapData.post();
+    m_monitorThread.join();
+
+    m_audioOutput->shutdown();
+    m_convolver.configure(nullptr, 0);
+    LOGI("Live monitor stopped (%llu input frames dropped, %llu output frames dropped)",
+         static_cast<unsigned long long>(m_droppedFrames.load(std::memory_order_relaxed)),
+         static_cast<unsigned long long>(m_outputOverflowFrames.load(std::memory_order_relaxed)));
+}
+
+void LiveMonitor::push(const uint8_t* frames, size_t bytes) {
+    m_pushing.store(true, std::memory_order_seq_cst);
+    if (m_active.load(std::memory_order_seq_cst) && frames) {
+        const size_t whole = bytes - bytes % kFrameBytes;
+        // Only this thread writes, so free space can only grow after the check.
+        if (whole > 0 && m_tap->getAvailableSpace() >= whole) {
+            m_tap->write(frames, whole);
+            m_tapData.post();
+        } else if (whole > 0) {
+            m_droppedFrames.fetch_add(whole / kFrameBytes, std::memory_order_relaxed);
+        }
+    }
+    m_pushing.store(false, std::memory_order_release);
+}
+
+void LiveMonitor::monitorLoop() {
+    thread_config::configureCurrentThread(thread_config::Role::Convolver);
+
+    const size_t blockBytes = static_cast<size_t>(m_blockFrames) * kFrameBytes;
+    const size_t stereoBytes = static_cast<size_t>(m_blockFrames) * 2 * sizeof(float);
+    const int outputs = m_convolver.numOutputChannels();
+
+    while (!m_stopRequested.load(std::memory_order_acquire)) {
+        if (m_tap->getAvailableBytes() < blockBytes) {
+            m_tapData.arm();
+            if (m_tap->getAvailableBytes() < blockBytes &&
+                !m_stopRequested.load(std::memory_order_seq_cst)) {
+                m_tapData.wait(kWakeTimeoutMs);
+            }
+            continue;
+        }
+
+        // After a stall, drop the backlog instead of monitoring late from then on.
+        size_t queued = m_tap->getAvailableBytes();
+        if (queued > m_maxBacklogBytes) {
+            uint64_t skipped = 0;
+            while (queued >= 2 * blockBytes) {
+                m_tap->read(m_packed.data(), blockBytes);
+                queued -= blockBytes;
+                skipped += static_cast<uint64_t>(m_blockFrames);
+            }
+            m_droppedFrames.fetch_add(skipped, std::memory_order_relaxed);
+        }
+
+        m_tap->read(m_packed.data(), blockBytes);
+        pcm24::toFloat(m_packed.data(), m_input.data(), m_input.size());
+        m_convolver.process(m_input.data(), m_convolved.data(), m_blockFrames);
+
+        for (int frame = 0; frame < m_blockFrames; ++frame) {
+            const float* source = m_convolved.data() + static_cast<size_t>(frame) * outputs;
+            m_stereo[frame * 2] = source[0];
+            m_stereo[frame * 2 + 1] = outputs > 1 ? source[1] : source[0];
+        }
+
+        // The USB and DAC clocks drift apart; a full queue sheds one block.
+        if (m_output->getAvailableBytes() + stereoBytes > m_maxQueuedOutputBytes) {
+            m_outputOverflowFrames.fetch_add(static_cast<uint64_t>(m_blockFrames), std::memory_order_relaxed);
+            continue;
+        }
+        m_output->write(reinterpret_cast<const uint8_t*>(m_stereo.data()), stereoBytes);
+    }
+}
+
+void LiveMonitor::outputCallback(float* output, int32_t numFrames) {
+    const size_t bytesNeeded = static_cast<size_t>(numFrames) * 2 * sizeof(float);
+    const size_t bytesRead = m_output->read(reinterpret_cast<uint8_t*>(output), bytesNeeded);
+    if (bytesRead < bytesNeeded) {
+        std::fill(output + bytesRead / sizeof(float), output + numFrames * 2, 0.0f);
+    }
+}
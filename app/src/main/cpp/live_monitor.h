@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "lock_free_ring_buffer.h"
+#include "playback/audio_output.h"
+#include "playback/wake_semaphore.h"
+#include "matrix_convolver/ir_data.h"
+#include "matrix_convolver/ir_loader.h"
+#include "matrix_convolver/matrix_convolver.h"
+
+struct AAssetManager;
+
+/**
+ * Headphone monitor for the capture path. The USB thread pushes a copy of
+ * every post-gain packet into a lock-free tap; a convolver thread renders it
+ * through the selected IR preset and an AudioOutput plays the result. The tap
+ * never blocks: when the convolver falls behind, packets are dropped and
+ * counted, so the disk path is never held up by the monitor.
+ */
+class LiveMonitor {
+public:
+    LiveMonitor();
+    ~LiveMonitor();
+
+    LiveMonitor(const LiveMonitor&) = delete;
+    LiveMonitor& operator=(const LiveMonitor&) = delete;
+
+    /**
+     * Load the IR for @p preset at @p sampleRate, open the output and start
+     * the convolver thread. @p lowLatency selects 128-frame head partitions
+     * instead of 2048-frame uniform blocks.
+     */
+    bool start(AAssetManager* assets, spcmic::IRPreset preset, int sampleRate, bool lowLatency);
+    void stop();
+    bool isActive() const { return m_active.load(std::memory_order_acquire); }
+
+    /**
+     * USB thread: queue packed 24-bit frames of all input channels. Wait-free;
+     * the packet is dropped when the tap is full.
+     */
+    void push(const uint8_t* frames, size_t bytes);
+
+    /** Input frames dropped at the tap or skipped to catch up since start(). */
+    uint64_t getDroppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+    /** Rendered frames dropped because the output could not keep up (clock drift). */
+    uint64_t getOutputOverflowFrames() const { return m_outputOverflowFrames.load(std::memory_order_relaxed); }
+
+private:
+    void monitorLoop();
+    void outputCallback(float* output, int32_t numFrames);
+
+    std::mutex m_controlMutex;      // start/stop
+    std::atomic<bool> m_active;     // the USB thread may push
+    std::atomic<bool> m_pushing;    // the USB thread is inside push()
+
+    std::unique_ptr<LockFreeRingBuffer> m_tap;     // packed 24-bit frames, USB -> convolver
+    std::unique_ptr<LockFreeRingBuffer> m_output;  // stereo float, convolver -> output callback
+    spcmic::WakeSemaphore m_tapData;               // posted by push() after queuing frames
+
+    spcmic::IRLoader m_irLoader;
+    spcmic::MatrixImpulseResponse m_impulseResponse;
+    spcmic::MatrixConvolver m_convolver;
+    std::unique_ptr<spcmic::AudioOutput> m_audioOutput;
+
+    std::thread m_monitorThread;
+    std::atomic<bool> m_stopRequested;
+    int m_blockFrames;
+    size_t m_maxBacklogBytes;       // beyond this the convolver skips ahead to stay live
+    size_t m_maxQueuedOutputBytes;  // beyond this rendered blocks are dropped
+
+    // Convolver thread buffers, sized in start()
+    std::vector<uint8_t> m_packed;
+    std::vector<float> m_input;
+    std::vector<float> m_convolved;
+    std::vector<float> m_stereo;
+
+    std::atomic<uint64_t> m_droppedFrames;
+    std::atomic<uint64_t> m_outputOverflowFrames;
+};
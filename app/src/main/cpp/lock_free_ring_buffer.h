@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <algorithm>
@@ -9,30 +10,136 @@
  * Lock-free single-producer, single-consumer ring buffer for audio data.
  * Thread-safe for one writer thread and one reader thread.
  * Uses atomic operations to avoid locks and prevent priority inversion.
+ *
+ * The indices are free-running byte counts, each on its own cache line next
+ * to the owning side's cached copy of the other index, so the producer and
+ * consumer only touch each other's line when their cached view runs out.
+ * Storage is rounded up to a power of two and indexed by masking; the fill
+ * level is still bounded by the capacity passed to the constructor.
  */
 class LockFreeRingBuffer {
 public:
     /**
      * Constructor
-     * @param capacity Size of the ring buffer in bytes (should be power of 2 for best performance)
+     * @param capacity Maximum number of bytes held at once (storage is rounded up to a power of 2)
      */
     explicit LockFreeRingBuffer(size_t capacity)
         : m_capacity(capacity)
+        , m_mask(storageSize(capacity) - 1)
         , m_writeIndex(0)
-        , m_readIndex(0) {
-        
-        m_buffer = new uint8_t[capacity];
-        memset(m_buffer, 0, capacity);
+        , m_cachedReadIndex(0)
+        , m_readIndex(0)
+        , m_cachedWriteIndex(0) {
+
+        m_buffer = new uint8_t[m_mask + 1];
+        memset(m_buffer, 0, m_mask + 1);
     }
-    
+
     ~LockFreeRingBuffer() {
         delete[] m_buffer;
     }
-    
+
     // Disable copy and move
     LockFreeRingBuffer(const LockFreeRingBuffer&) = delete;
     LockFreeRingBuffer& operator=(const LockFreeRingBuffer&) = delete;
-    
+
+    /**
+     * Free space handed out by reserveWrite(): up to two spans, the second
+     * one non-empty only when the reservation wraps around the end.
+     */
+    struct WriteRegion {
+        uint8_t* first = nullptr;
+        size_t firstSize = 0;
+        uint8_t* second = nullptr;
+        size_t secondSize = 0;
+
+        size_t size() const { return firstSize + secondSize; }
+    };
+
+    /** Queued data handed out by peekRead(), split like WriteRegion. */
+    struct ReadRegion {
+        const uint8_t* first = nullptr;
+        size_t firstSize = 0;
+        const uint8_t* second = nullptr;
+        size_t secondSize = 0;
+
+        size_t size() const { return firstSize + secondSize; }
+    };
+
+    /**
+     * Reserve up to @p size bytes of free space for the producer to fill in
+     * place. Nothing becomes visible to the consumer until commitWrite().
+     */
+    WriteRegion reserveWrite(size_t size) {
+        WriteRegion region;
+        const size_t writeIdx = m_writeIndex.load(std::memory_order_relaxed);
+        size_t available = m_capacity - (writeIdx - m_cachedReadIndex);
+        if (available < size) {
+            m_cachedReadIndex = m_readIndex.load(std::memory_order_acquire);
+            available = m_capacity - (writeIdx - m_cachedReadIndex);
+        }
+        const size_t toWrite = std::min(size, available);
+        if (toWrite == 0) {
+            return region;
+        }
+
+        const size_t offset = writeIdx & m_mask;
+        region.first = m_buffer + offset;
+        region.firstSize = std::min(toWrite, m_mask + 1 - offset);
+        if (region.firstSize < toWrite) {
+            region.second = m_buffer;
+            region.secondSize = toWrite - region.firstSize;
+        }
+        return region;
+    }
+
+    /**
+     * Publish @p size bytes of the last reservation (producer thread).
+     * @p size must not exceed what reserveWrite() returned.
+     */
+    void commitWrite(size_t size) {
+        const size_t writeIdx = m_writeIndex.load(std::memory_order_relaxed);
+        // Release semantics ensures data is visible before index update
+        m_writeIndex.store(writeIdx + size, std::memory_order_release);
+    }
+
+    /**
+     * Look at up to @p size queued bytes in place (consumer thread). They stay
+     * queued, and the producer cannot overwrite them, until consumeRead().
+     */
+    ReadRegion peekRead(size_t size) {
+        ReadRegion region;
+        const size_t readIdx = m_readIndex.load(std::memory_order_relaxed);
+        size_t available = m_cachedWriteIndex - readIdx;
+        if (available < size) {
+            m_cachedWriteIndex = m_writeIndex.load(std::memory_order_acquire);
+            available = m_cachedWriteIndex - readIdx;
+        }
+        const size_t toRead = std::min(size, available);
+        if (toRead == 0) {
+            return region;
+        }
+
+        const size_t offset = readIdx & m_mask;
+        region.first = m_buffer + offset;
+        region.firstSize = std::min(toRead, m_mask + 1 - offset);
+        if (region.firstSize < toRead) {
+            region.second = m_buffer;
+            region.secondSize = toRead - region.firstSize;
+        }
+        return region;
+    }
+
+    /**
+     * Release @p size bytes of the last peekRead() to the producer.
+     * @p size must not exceed what peekRead() returned.
+     */
+    void consumeRead(size_t size) {
+        const size_t readIdx = m_readIndex.load(std::memory_order_relaxed);
+        // Release semantics: the bytes have been read before the producer may reuse them
+        m_readIndex.store(readIdx + size, std::memory_order_release);
+    }
+
     /**
      * Write data to the ring buffer (producer thread)
      * @param data Pointer to data to write
@@ -43,35 +150,22 @@ public:
         if (!data || size == 0) {
             return 0;
         }
-        
-        const size_t writeIdx = m_writeIndex.load(std::memory_order_relaxed);
-        const size_t readIdx = m_readIndex.load(std::memory_order_acquire);
-        
-        // Calculate available space for writing
-        const size_t available = getAvailableWrite(writeIdx, readIdx);
-        const size_t toWrite = std::min(size, available);
-        
-        if (toWrite == 0) {
+
+        const WriteRegion region = reserveWrite(size);
+        if (region.size() == 0) {
             return 0; // Buffer is full
         }
-        
+
         // Write in up to two chunks (handle wrap-around)
-        const size_t firstChunk = std::min(toWrite, m_capacity - writeIdx);
-        memcpy(m_buffer + writeIdx, data, firstChunk);
-        
-        if (firstChunk < toWrite) {
-            // Wrap around to beginning
-            const size_t secondChunk = toWrite - firstChunk;
-            memcpy(m_buffer, data + firstChunk, secondChunk);
+        memcpy(region.first, data, region.firstSize);
+        if (region.secondSize > 0) {
+            memcpy(region.second, data + region.firstSize, region.secondSize);
         }
-        
-        // Update write index (release semantics ensures data is visible before index update)
-        const size_t newWriteIdx = (writeIdx + toWrite) % m_capacity;
-        m_writeIndex.store(newWriteIdx, std::memory_order_release);
-        
-        return toWrite;
-    }
-    
+
+        commitWrite(region.size());
+        return region.size();
+    }
+
     /**
      * Read data from the ring buffer (consumer thread)
      * @param data Pointer to destination buffer
@@ -82,107 +176,107 @@ public:
         if (!data || size == 0) {
             return 0;
         }
-        
-        const size_t readIdx = m_readIndex.load(std::memory_order_relaxed);
-        const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
-        
-        // Calculate available data for reading
-        const size_t available = getAvailableRead(writeIdx, readIdx);
-        const size_t toRead = std::min(size, available);
-        
-        if (toRead == 0) {
+
+        const ReadRegion region = peekRead(size);
+        if (region.size() == 0) {
             return 0; // Buffer is empty
         }
-        
+
         // Read in up to two chunks (handle wrap-around)
-        const size_t firstChunk = std::min(toRead, m_capacity - readIdx);
-        memcpy(data, m_buffer + readIdx, firstChunk);
-        
-        if (firstChunk < toRead) {
-            // Wrap around to beginning
-            const size_t secondChunk = toRead - firstChunk;
-            memcpy(data + firstChunk, m_buffer, secondChunk);
+        memcpy(data, region.first, region.firstSize);
+        if (region.secondSize > 0) {
+            memcpy(data + region.firstSize, region.second, region.secondSize);
         }
-        
-        // Update read index (release semantics)
-        const size_t newReadIdx = (readIdx + toRead) % m_capacity;
-        m_readIndex.store(newReadIdx, std::memory_order_release);
-        
-        return toRead;
-    }
-    
+
+        consumeRead(region.size());
+        return region.size();
+    }
+
+    /**
+     * Drop everything queued so far (consumer thread). Unlike reset(), this
+     * is safe while the producer keeps writing.
+     * @return Number of bytes dropped
+     */
+    size_t discard() {
+        const size_t readIdx = m_readIndex.load(std::memory_order_relaxed);
+        m_cachedWriteIndex = m_writeIndex.load(std::memory_order_acquire);
+        m_readIndex.store(m_cachedWriteIndex, std::memory_order_release);
+        return m_cachedWriteIndex - readIdx;
+    }
+
     /**
      * Get the number of bytes currently available to read
      */
     size_t getAvailableBytes() const {
-        const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
+        // Read index first, so it cannot pass the write index loaded after it. A
+        // third thread may see the writer run ahead past a full ring meanwhile.
         const size_t readIdx = m_readIndex.load(std::memory_order_acquire);
-        return getAvailableRead(writeIdx, readIdx);
+        const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
+        return std::min(writeIdx - readIdx, m_capacity);
     }
-    
+
     /**
      * Get the number of bytes of free space available for writing
      */
     size_t getAvailableSpace() const {
-        const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
-        const size_t readIdx = m_readIndex.load(std::memory_order_acquire);
-        return getAvailableWrite(writeIdx, readIdx);
+        return m_capacity - getAvailableBytes();
     }
-    
+
     /**
      * Check if the buffer is empty
      */
     bool isEmpty() const {
         return getAvailableBytes() == 0;
     }
-    
+
     /**
      * Check if the buffer is full
      */
     bool isFull() const {
         return getAvailableSpace() == 0;
     }
-    
+
     /**
      * Get the total capacity of the buffer
      */
     size_t getCapacity() const {
         return m_capacity;
     }
-    
+
     /**
-     * Reset the buffer (not thread-safe - should only be called when no reading/writing is happening)
+     * Reset the buffer (not thread-safe - should only be called when no reading/writing is happening;
+     * a running consumer can use discard() instead)
      */
     void reset() {
         m_writeIndex.store(0, std::memory_order_release);
         m_readIndex.store(0, std::memory_order_release);
+        m_cachedReadIndex = 0;
+        m_cachedWriteIndex = 0;
     }
-    
+
 private:
-    uint8_t* m_buffer;
-    const size_t m_capacity;
-    
-    // Atomic indices for lock-free operation
-    std::atomic<size_t> m_writeIndex;
-    std::atomic<size_t> m_readIndex;
-    
-    /**
-     * Calculate available bytes for reading
-     */
-    size_t getAvailableRead(size_t writeIdx, size_t readIdx) const {
-        if (writeIdx >= readIdx) {
-            return writeIdx - readIdx;
-        } else {
-            return m_capacity - readIdx + writeIdx;
+    // Fixed at 64 bytes rather than std::hardware_destructive_interference_size,
+    // which not every NDK libc++ provides; it matches the ARM cores we target.
+    static constexpr size_t CACHE_LINE_BYTES = 64;
+
+    static size_t storageSize(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
         }
+        return size;
     }
-    
-    /**
-     * Calculate available space for writing
-     * We reserve 1 byte to distinguish full from empty
-     */
-    size_t getAvailableWrite(size_t writeIdx, size_t readIdx) const {
-        const size_t used = getAvailableRead(writeIdx, readIdx);
-        return m_capacity - used - 1; // Reserve 1 byte to distinguish full from empty
-    }
+
+    // Shared, read-only after construction
+    uint8_t* m_buffer;
+    const size_t m_capacity;
+    const size_t m_mask;
+
+    // Producer line: its index and its last view of the consumer's
+    alignas(CACHE_LINE_BYTES) std::atomic<size_t> m_writeIndex;
+    size_t m_cachedReadIndex;
+
+    // Consumer line: its index and its last view of the producer's
+    alignas(CACHE_LINE_BYTES) std::atomic<size_t> m_readIndex;
+    size_t m_cachedWriteIndex;
 };
@@ -0,0 +1,393 @@
+#include "lossless_codec.h"
+#include "pcm24.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace lossless {
+
+namespace {
+
+constexpr uint8_t kSync[4] = {'S', 'P', 'C', 'B'};
+
+// Subframe types (2 bits)
+constexpr uint32_t kConstant = 0;
+constexpr uint32_t kVerbatim = 1;
+constexpr uint32_t kFixed = 2;
+
+constexpr int kMaxOrder = 4;
+constexpr uint32_t kPartitionSamples = 256;
+constexpr uint32_t kMaxRiceParameter = 28;
+constexpr uint32_t kEscapeZeros = 24;   // this many zeros introduce a raw 32-bit residual
+constexpr int kSampleBits = 24;
+
+inline uint32_t ZigZag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t UnZigZag(uint32_t value) {
+    return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1u)));
+}
+
+inline int32_t SignExtend24(uint32_t value) {
+    return static_cast<int32_t>(value << 8) >> 8;
+}
+
+void PutLittleEndian(uint8_t* dst, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        dst[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t GetLittleEndian(const uint8_t* src, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint32_t>(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+/** MSB-first bit packer; the caller guarantees room for everything it writes. */
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* out) : m_out(out), m_start(out), m_acc(0), m_bits(0) {}
+
+    void put(uint32_t value, uint32_t count) {  // count <= 32
+        if (count == 0) {
+            return;
+        }
+        m_acc = (m_acc << count) | (static_cast<uint64_t>(value) & ((uint64_t{1} << count) - 1));
+        m_bits += count;
+        while (m_bits >= 8) {
+            m_bits -= 8;
+            *m_out++ = static_cast<uint8_t>(m_acc >> m_bits);
+        }
+    }
+
+    /** Pad to a whole byte and return the bytes written. */
+    size_t finish() {
+        if (m_bits > 0) {
+            *m_out++ = static_cast<uint8_t>(m_acc << (8 - m_bits));
+            m_bits = 0;
+        }
+        return static_cast<size_t>(m_out - m_start);
+    }
+
+private:
+    uint8_t* m_out;
+    uint8_t* m_start;
+    uint64_t m_acc;
+    uint32_t m_bits;
+};
+
+/** MSB-first bit reader; reads past the end yield zeros and are reported by overrun(). */
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t bytes)
+        : m_next(data), m_end(data + bytes), m_acc(0), m_bits(0), m_padBytes(0) {}
+
+    uint32_t get(uint32_t count) {  // 1 <= count <= 32
+        refill();
+        const uint32_t value = static_cast<uint32_t>(m_acc >> (64 - count));
+        m_acc <<= count;
+        m_bits -= count;
+        return value;
+    }
+
+    /** Zeros before the next one bit, consuming both; stops (without a one) at @p limit zeros. */
+    uint32_t unary(uint32_t limit) {
+        refill();
+        const uint32_t zeros = m_acc ? static_cast<uint32_t>(__builtin_clzll(m_acc)) : 64u;
+        if (zeros >= limit) {
+            m_acc <<= limit;
+            m_bits -= limit;
+            return limit;
+        }
+        m_acc <<= zeros + 1;
+        m_bits -= zeros + 1;
+        return zeros;
+    }
+
+    bool overrun() const { return m_padBytes * 8 > m_bits; }
+
+private:
+    void refill() {
+        while (m_bits <= 56) {
+            uint64_t byte = 0;
+            if (m_next < m_end) {
+                byte = *m_next++;
+            } else {
+                ++m_padBytes;
+            }
+            m_acc |= byte << (56 - m_bits);
+            m_bits += 8;
+        }
+    }
+
+    const uint8_t* m_next;
+    const uint8_t* m_end;
+    uint64_t m_acc;      // unread bits, left aligned
+    uint32_t m_bits;
+    uint32_t m_padBytes;
+};
+
+uint32_t RiceParameter(uint64_t sum, uint32_t count) {
+    const uint64_t mean = sum / count;
+    uint32_t k = 0;
+    while (k < kMaxRiceParameter && (uint64_t{2} << k) <= mean) {
+        ++k;
+    }
+    return k;
+}
+
+uint64_t RiceBits(const uint32_t* residual, uint32_t count, uint32_t k) {
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t q = residual[i] >> k;
+        bits += (q < kEscapeZeros) ? q + 1 + k : kEscapeZeros + 32;
+    }
+    return bits;
+}
+
+/** Sums of |residual| for every fixed order over samples [kMaxOrder, n); plain loops the compiler can vectorise. */
+int BestFixedOrder(const int32_t* x, uint32_t n) {
+    uint64_t sums[kMaxOrder + 1] = {};
+    for (uint32_t i = kMaxOrder; i < n; ++i) {
+        const int64_t e0 = x[i];
+        const int64_t e1 = e0 - x[i - 1];
+        const int64_t e2 = e0 - 2 * static_cast<int64_t>(x[i - 1]) + x[i - 2];
+        const int64_t e3 = e0 - 3 * static_cast<int64_t>(x[i - 1]) + 3 * static_cast<int64_t>(x[i - 2]) - x[i - 3];
+        const int64_t e4 = e0 - 4 * static_cast<int64_t>(x[i - 1]) + 6 * static_cast<int64_t>(x[i - 2]) -
+                           4 * static_cast<int64_t>(x[i - 3]) + x[i - 4];
+        sums[0] += static_cast<uint64_t>(std::llabs(e0));
+        sums[1] += static_cast<uint64_t>(std::llabs(e1));
+        sums[2] += static_cast<uint64_t>(std::llabs(e2));
+        sums[3] += static_cast<uint64_t>(std::llabs(e3));
+        sums[4] += static_cast<uint64_t>(std::llabs(e4));
+    }
+    return static_cast<int>(std::min_element(sums, sums + kMaxOrder + 1) - sums);
+}
+
+void FixedResidual(const int32_t* x, uint32_t n, int order, uint32_t* residual) {
+    switch (order) {
+        case 0:
+            for (uint32_t i = 0; i < n; ++i) {
+                residual[i] = ZigZag(x[i]);
+            }
+            break;
+        case 1:
+            for (uint32_t i = 1; i < n; ++i) {
+                residual[i] = ZigZag(x[i] - x[i - 1]);
+            }
+            break;
+        case 2:
+            for (uint32_t i = 2; i < n; ++i) {
+                residual[i] = ZigZag(x[i] - 2 * x[i - 1] + x[i - 2]);
+            }
+            break;
+        case 3:
+            for (uint32_t i = 3; i < n; ++i) {
+                residual[i] = ZigZag(x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]);
+            }
+            break;
+        default:
+            for (uint32_t i = 4; i < n; ++i) {
+                residual[i] = ZigZag(x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]);
+            }
+            break;
+    }
+}
+
+/** Partition p covers samples [p * 256, (p + 1) * 256), minus the warm-up samples. */
+template <typename Visit>
+void ForEachPartition(uint32_t n, int order, Visit&& visit) {
+    for (uint32_t start = 0; start < n; start += kPartitionSamples) {
+        const uint32_t first = std::max(start, static_cast<uint32_t>(order));
+        const uint32_t end = std::min(n, start + kPartitionSamples);
+        if (first < end) {
+            visit(first, end - first);
+        }
+    }
+}
+
+} // namespace
+
+size_t maxBlockBytes(uint32_t frames, uint32_t channels) {
+    const uint64_t bits = static_cast<uint64_t>(channels) * (2 + static_cast<uint64_t>(kSampleBits) * frames);
+    return kBlockHeaderBytes + static_cast<size_t>((bits + 7) / 8);
+}
+
+bool readBlockHeader(const uint8_t* data, size_t bytes, BlockHeader& header) {
+    if (bytes < kBlockHeaderBytes || std::memcmp(data, kSync, sizeof(kSync)) != 0) {
+        return false;
+    }
+    header.payloadBytes = GetLittleEndian(data + 4, 4);
+    header.frames = GetLittleEndian(data + 8, 4);
+    header.channels = GetLittleEndian(data + 12, 2);
+    return header.frames > 0 && header.frames <= kMaxBlockFrames && header.channels > 0 &&
+           static_cast<uint64_t>(header.payloadBytes) + kBlockHeaderBytes <=
+               maxBlockBytes(header.frames, header.channels);
+}
+
+size_t Encoder::encode(const uint8_t* pcm, uint32_t frames, uint32_t channels, uint8_t* out) {
+    const size_t total = static_cast<size_t>(frames) * channels;
+    if (m_samples.size() < total) {
+        m_samples.resize(total);
+    }
+    if (m_channel.size() < frames) {
+        m_channel.resize(frames);
+        m_residual.resize(frames);
+    }
+    pcm24::toInt32(pcm, m_samples.data(), total);
+
+    BitWriter writer(out + kBlockHeaderBytes);
+    int32_t* x = m_channel.data();
+    uint32_t* residual = m_residual.data();
+    const uint64_t verbatimBits = static_cast<uint64_t>(kSampleBits) * frames;
+
+    for (uint32_t c = 0; c < channels; ++c) {
+        const int32_t* src = m_samples.data() + c;
+        bool constant = true;
+        for (uint32_t i = 0; i < frames; ++i) {
+            x[i] = src[static_cast<size_t>(i) * channels];
+            constant = constant && x[i] == x[0];
+        }
+
+        if (constant) {
+            writer.put(kConstant, 2);
+            writer.put(static_cast<uint32_t>(x[0]), kSampleBits);
+            continue;
+        }
+
+        if (frames > static_cast<uint32_t>(kMaxOrder)) {
+            const int order = BestFixedOrder(x, frames);
+            FixedResidual(x, frames, order, residual);
+
+            uint64_t bits = 3 + static_cast<uint64_t>(kSampleBits) * order;
+            ForEachPartition(frames, order, [&](uint32_t first, uint32_t count) {
+                uint64_t sum = 0;
+                for (uint32_t i = first; i < first + count; ++i) {
+                    sum += residual[i];
+                }
+                bits += 5 + RiceBits(residual + first, count, RiceParameter(sum, count));
+            });
+
+            if (bits < verbatimBits) {
+                writer.put(kFixed, 2);
+                writer.put(static_cast<uint32_t>(order), 3);
+                for (int i = 0; i < order; ++i) {
+                    writer.put(static_cast<uint32_t>(x[i]), kSampleBits);
+                }
+                ForEachPartition(frames, order, [&](uint32_t first, uint32_t count) {
+                    uint64_t sum = 0;
+                    for (uint32_t i = first; i < first + count; ++i) {
+                        sum += residual[i];
+                    }
+                    const uint32_t k = RiceParameter(sum, count);
+                    writer.put(k, 5);
+                    for (uint32_t i = first; i < first + count; ++i) {
+                        const uint32_t q = residual[i] >> k;
+                        if (q < kEscapeZeros) {
+                            writer.put(1, q + 1);
+                            writer.put(residual[i], k);
+                        } else {
+                            writer.put(0, kEscapeZeros);
+                            writer.put(residual[i], 32);
+                        }
+                    }
+                });
+                continue;
+            }
+        }
+
+        writer.put(kVerbatim, 2);
+        for (uint32_t i = 0; i < frames; ++i) {
+            writer.put(static_cast<uint32_t>(x[i]), kSampleBits);
+        }
+    }
+
+    const size_t payload = writer.finish();
+    std::memcpy(out, kSync, sizeof(kSync));
+    PutLittleEndian(out + 4, static_cast<uint32_t>(payload), 4);
+    PutLittleEndian(out + 8, frames, 4);
+    PutLittleEndian(out + 12, channels, 2);
+    PutLittleEndian(out + 14, 0, 2);
+    return kBlockHeaderBytes + payload;
+}
+
+bool Decoder::decode(const uint8_t* data, size_t bytes, int32_t* out) {
+    BlockHeader header;
+    if (!readBlockHeader(data, bytes, header) ||
+        kBlockHeaderBytes + static_cast<uint64_t>(header.payloadBytes) > bytes) {
+        return false;
+    }
+
+    const uint32_t frames = header.frames;
+    const uint32_t channels = header.channels;
+    if (m_channel.size() < frames) {
+        m_channel.resize(frames);
+    }
+    int32_t* x = m_channel.data();
+    BitReader reader(data + kBlockHeaderBytes, header.payloadBytes);
+
+    for (uint32_t c = 0; c < channels; ++c) {
+        const uint32_t type = reader.get(2);
+        if (type == kConstant) {
+            std::fill(x, x + frames, SignExtend24(reader.get(kSampleBits)));
+        } else if (type == kVerbatim) {
+            for (uint32_t i = 0; i < frames; ++i) {
+                x[i] = SignExtend24(reader.get(kSampleBits));
+            }
+        } else if (type == kFixed) {
+            const int order = static_cast<int>(reader.get(3));
+            if (order > kMaxOrder || frames <= static_cast<uint32_t>(kMaxOrder)) {
+                return false;
+            }
+            for (int i = 0; i < order; ++i) {
+                x[i] = SignExtend24(reader.get(kSampleBits));
+            }
+            ForEachPartition(frames, order, [&](uint32_t first, uint32_t count) {
+                const uint32_t k = reader.get(5);
+                for (uint32_t i = first; i < first + count; ++i) {
+                    const uint32_t q = reader.unary(kEscapeZeros);
+                    const uint32_t value = (q < kEscapeZeros)
+                        ? (q << k) | (k > 0 ? reader.get(k) : 0u)
+                        : reader.get(32);
+                    x[i] = UnZigZag(value);
+                }
+            });
+
+            // Integrate the residual back; wide arithmetic keeps corrupt input well defined.
+            for (uint32_t i = static_cast<uint32_t>(order); i < frames; ++i) {
+                int64_t prediction = 0;
+                switch (order) {
+                    case 1: prediction = x[i - 1]; break;
+                    case 2: prediction = 2 * static_cast<int64_t>(x[i - 1]) - x[i - 2]; break;
+                    case 3:
+                        prediction = 3 * static_cast<int64_t>(x[i - 1]) - 3 * static_cast<int64_t>(x[i - 2]) + x[i - 3];
+                        break;
+                    case 4:
+                        prediction = 4 * static_cast<int64_t>(x[i - 1]) - 6 * static_cast<int64_t>(x[i - 2]) +
+                                     4 * static_cast<int64_t>(x[i - 3]) - x[i - 4];
+                        break;
+                    default: break;
+                }
+                x[i] = static_cast<int32_t>(prediction + x[i]);
+            }
+        } else {
+            return false;
+        }
+
+        if (reader.overrun()) {
+            return false;
+        }
+        int32_t* dst = out + c;
+        for (uint32_t i = 0; i < frames; ++i) {
+            dst[static_cast<size_t>(i) * channels] = x[i];
+        }
+    }
+    return true;
+}
+
+} // namespace lossless
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Lossless block codec for packed 24-bit multichannel PCM, in the spirit of
+ * FLAC: each channel of a block is predicted with the best of the fixed
+ * polynomial predictors (orders 0-4) and the residual is Rice coded in
+ * 256-sample partitions. Constant channels collapse to one sample and
+ * channels that would not shrink are stored verbatim, so a block never
+ * grows by more than its header.
+ *
+ * A block is a 16-byte header ("SPCB", payload bytes, frames, channels)
+ * followed by an MSB-first bitstream padded to a whole byte. Blocks are
+ * independent, so a reader can start decoding at any block boundary.
+ */
+namespace lossless {
+
+constexpr uint16_t kFormatTag = 0x5343;   // WAVE fmt audio format of compressed spcmic data
+constexpr uint32_t kBlockFrames = 4096;   // frames per block; only the last block may be shorter
+constexpr uint32_t kMaxBlockFrames = 65536;
+constexpr size_t kBlockHeaderBytes = 16;
+
+struct BlockHeader {
+    uint32_t payloadBytes = 0;
+    uint32_t frames = 0;
+    uint32_t channels = 0;
+};
+
+/** Largest possible block of @p frames x @p channels, header included. */
+size_t maxBlockBytes(uint32_t frames, uint32_t channels);
+
+/** Parse the header at @p data; false if @p bytes do not start with a plausible block header. */
+bool readBlockHeader(const uint8_t* data, size_t bytes, BlockHeader& header);
+
+/** Encoder scratch is kept between blocks, so encode() does not allocate once warmed up. */
+class Encoder {
+public:
+    /**
+     * Encode @p frames interleaved packed frames of @p channels into @p out,
+     * which must hold maxBlockBytes(frames, channels). Returns the block size.
+     */
+    size_t encode(const uint8_t* pcm, uint32_t frames, uint32_t channels, uint8_t* out);
+
+private:
+    std::vector<int32_t> m_samples;    // interleaved, sign extended
+    std::vector<int32_t> m_channel;    // one channel, contiguous
+    std::vector<uint32_t> m_residual;  // zigzag residual of the chosen predictor
+};
+
+class Decoder {
+public:
+    /**
+     * Decode the block at @p data (@p bytes available) into interleaved
+     * samples in [-2^23, 2^23); @p out holds frames x channels of the
+     * block header. False if the block is truncated or corrupt.
+     */
+    bool decode(const uint8_t* data, size_t bytes, int32_t* out);
+
+private:
+    std::vector<int32_t> m_channel;
+};
+
+} // namespace lossless
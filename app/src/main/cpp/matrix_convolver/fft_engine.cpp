@@ -3,129 +3,348 @@
 #include <cmath>
 #include <cstddef>
 #include <cstring>
-#include <mutex>
-#include <unordered_map>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace spcmic {
 
 namespace {
-constexpr float kPi = 3.14159265358979323846f;
+constexpr double kPi = 3.14159265358979323846;
 
-struct StagePlan {
-    size_t length;
-    std::vector<std::complex<float>> twiddles; // Forward twiddles for this stage
-};
+inline std::complex<float> unitRoot(size_t k, size_t n, double sign) {
+    const double angle = sign * 2.0 * kPi * static_cast<double>(k) / static_cast<double>(n);
+    return {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+}
+
+inline std::complex<float> cmul(float re, float im, const std::complex<float>& a) {
+    return {a.real() * re - a.imag() * im, a.real() * im + a.imag() * re};
+}
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+inline float32x4x2_t cmulNeon(float32x4x2_t a, float32x4_t wr, float32x4_t wi) {
+    float32x4x2_t result;
+    result.val[0] = vmlsq_f32(vmulq_f32(a.val[0], wr), a.val[1], wi);
+    result.val[1] = vmlaq_f32(vmulq_f32(a.val[0], wi), a.val[1], wr);
+    return result;
+}
+#endif
+
+// One radix-4 decimation-in-time butterfly group (two fused radix-2 stages).
+// Inputs a0..a3 sit at offsets 0, h, 2h, 3h; W^k scales a2, W^2k scales a1 and
+// W^3k scales a3. The forward transform rotates the odd difference by -i.
+template <bool Inverse>
+void radix4Group(std::complex<float>* x, size_t h,
+                 const float* re1, const float* im1,
+                 const float* re2, const float* im2,
+                 const float* re3, const float* im3) {
+    size_t k = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; k + 3 < h; k += 4) {
+        float* p0 = reinterpret_cast<float*>(x + k);
+        float* p1 = reinterpret_cast<float*>(x + k + h);
+        float* p2 = reinterpret_cast<float*>(x + k + 2 * h);
+        float* p3 = reinterpret_cast<float*>(x + k + 3 * h);
+
+        const float32x4x2_t a0 = vld2q_f32(p0);
+        const float32x4x2_t t1 = cmulNeon(vld2q_f32(p1), vld1q_f32(re2 + k), vld1q_f32(im2 + k));
+        const float32x4x2_t t2 = cmulNeon(vld2q_f32(p2), vld1q_f32(re1 + k), vld1q_f32(im1 + k));
+        const float32x4x2_t t3 = cmulNeon(vld2q_f32(p3), vld1q_f32(re3 + k), vld1q_f32(im3 + k));
+
+        const float32x4_t s0r = vaddq_f32(a0.val[0], t1.val[0]);
+        const float32x4_t s0i = vaddq_f32(a0.val[1], t1.val[1]);
+        const float32x4_t d0r = vsubq_f32(a0.val[0], t1.val[0]);
+        const float32x4_t d0i = vsubq_f32(a0.val[1], t1.val[1]);
+        const float32x4_t s1r = vaddq_f32(t2.val[0], t3.val[0]);
+        const float32x4_t s1i = vaddq_f32(t2.val[1], t3.val[1]);
+        const float32x4_t d1r = vsubq_f32(t2.val[0], t3.val[0]);
+        const float32x4_t d1i = vsubq_f32(t2.val[1], t3.val[1]);
+
+        // rot = -i * d1 (forward) or +i * d1 (inverse)
+        const float32x4_t rotr = Inverse ? vnegq_f32(d1i) : d1i;
+        const float32x4_t roti = Inverse ? d1r : vnegq_f32(d1r);
+
+        float32x4x2_t out;
+        out.val[0] = vaddq_f32(s0r, s1r);
+        out.val[1] = vaddq_f32(s0i, s1i);
+        vst2q_f32(p0, out);
+        out.val[0] = vsubq_f32(s0r, s1r);
+        out.val[1] = vsubq_f32(s0i, s1i);
+        vst2q_f32(p2, out);
+        out.val[0] = vaddq_f32(d0r, rotr);
+        out.val[1] = vaddq_f32(d0i, roti);
+        vst2q_f32(p1, out);
+        out.val[0] = vsubq_f32(d0r, rotr);
+        out.val[1] = vsubq_f32(d0i, roti);
+        vst2q_f32(p3, out);
+    }
+#endif
+    for (; k < h; ++k) {
+        const std::complex<float> a0 = x[k];
+        const std::complex<float> t1 = cmul(re2[k], im2[k], x[k + h]);
+        const std::complex<float> t2 = cmul(re1[k], im1[k], x[k + 2 * h]);
+        const std::complex<float> t3 = cmul(re3[k], im3[k], x[k + 3 * h]);
 
-struct FftPlan {
-    size_t size;
-    std::vector<int> bitReverse;
-    std::vector<StagePlan> stages;
-};
+        const std::complex<float> s0 = a0 + t1;
+        const std::complex<float> d0 = a0 - t1;
+        const std::complex<float> s1 = t2 + t3;
+        const std::complex<float> d1 = t2 - t3;
+        const std::complex<float> rot = Inverse ? std::complex<float>(-d1.imag(), d1.real())
+                                                : std::complex<float>(d1.imag(), -d1.real());
+
+        x[k] = s0 + s1;
+        x[k + 2 * h] = s0 - s1;
+        x[k + h] = d0 + rot;
+        x[k + 3 * h] = d0 - rot;
+    }
+}
+
+void scale(std::complex<float>* data, size_t n, float factor) {
+    float* values = reinterpret_cast<float*>(data);
+    const size_t count = n * 2;
+    size_t i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t factorVec = vdupq_n_f32(factor);
+    for (; i + 3 < count; i += 4) {
+        vst1q_f32(values + i, vmulq_f32(vld1q_f32(values + i), factorVec));
+    }
+#endif
+    for (; i < count; ++i) {
+        values[i] *= factor;
+    }
+}
+} // namespace
+
+FftEngine::FftEngine()
+    : size_(0) {
+}
 
-FftPlan buildPlan(size_t n) {
-    FftPlan plan{};
+bool FftEngine::isPowerOfTwo(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+bool FftEngine::initialize(size_t size) {
+    size_ = 0;
+    if (!isPowerOfTwo(size) || size < 4) {
+        return false;
+    }
+
+    if (!buildComplexPlan(size, full_) || !buildComplexPlan(size / 2, half_)) {
+        return false;
+    }
+
+    realTwiddles_.resize(size / 2);
+    for (size_t k = 0; k < size / 2; ++k) {
+        realTwiddles_[k] = unitRoot(k, size, -1.0);
+    }
+
+    size_ = size;
+    return true;
+}
+
+bool FftEngine::buildComplexPlan(size_t n, ComplexPlan& plan) {
+    plan = ComplexPlan{};
+    if (!isPowerOfTwo(n) || n < 2) {
+        return false;
+    }
     plan.size = n;
-    plan.bitReverse.resize(n);
 
     unsigned int bits = 0;
-    size_t temp = n;
-    while (temp > 1) {
+    while ((static_cast<size_t>(1) << bits) < n) {
         ++bits;
-        temp >>= 1;
     }
+
+    plan.bitReverse.resize(n);
     for (size_t i = 0; i < n; ++i) {
-        unsigned int reversed = 0;
-        unsigned int value = static_cast<unsigned int>(i);
+        uint32_t reversed = 0;
+        uint32_t value = static_cast<uint32_t>(i);
         for (unsigned int b = 0; b < bits; ++b) {
             reversed = (reversed << 1u) | (value & 1u);
             value >>= 1u;
         }
-        plan.bitReverse[i] = static_cast<int>(reversed);
-    }
-
-    for (size_t len = 2; len <= n; len <<= 1) {
-        StagePlan stage{};
-        stage.length = len;
-        const size_t halfLen = len >> 1;
-        stage.twiddles.resize(halfLen);
-        const float baseAngle = -2.0f * kPi / static_cast<float>(len);
-        for (size_t k = 0; k < halfLen; ++k) {
-            const float angle = baseAngle * static_cast<float>(k);
-            stage.twiddles[k] = std::complex<float>(std::cos(angle), std::sin(angle));
+        plan.bitReverse[i] = reversed;
+        if (i < reversed) {
+            plan.swapPairs.push_back(static_cast<uint32_t>(i));
+            plan.swapPairs.push_back(reversed);
+        }
+    }
+
+    // Odd log2 sizes start with a twiddle-free radix-2 pass; the remaining
+    // passes fuse pairs of radix-2 stages into radix-4 butterflies.
+    plan.leadingRadix2 = (bits % 2) != 0;
+    for (size_t quarter = plan.leadingRadix2 ? 2 : 1; quarter * 4 <= n; quarter *= 4) {
+        Radix4Stage stage{};
+        stage.quarter = quarter;
+        const size_t span = quarter * 4;
+        TwiddleTable* tables[2] = {&stage.forward, &stage.inverse};
+        for (int direction = 0; direction < 2; ++direction) {
+            TwiddleTable& table = *tables[direction];
+            const double sign = direction == 0 ? -1.0 : 1.0;
+            table.re1.resize(quarter);
+            table.im1.resize(quarter);
+            table.re2.resize(quarter);
+            table.im2.resize(quarter);
+            table.re3.resize(quarter);
+            table.im3.resize(quarter);
+            for (size_t k = 0; k < quarter; ++k) {
+                const std::complex<float> w1 = unitRoot(k, span, sign);
+                const std::complex<float> w2 = unitRoot(2 * k, span, sign);
+                const std::complex<float> w3 = unitRoot(3 * k, span, sign);
+                table.re1[k] = w1.real();
+                table.im1[k] = w1.imag();
+                table.re2[k] = w2.real();
+                table.im2[k] = w2.imag();
+                table.re3[k] = w3.real();
+                table.im3[k] = w3.imag();
+            }
         }
         plan.stages.emplace_back(std::move(stage));
     }
 
-    return plan;
+    return true;
+}
+
+void FftEngine::permuteInPlace(const ComplexPlan& plan, std::complex<float>* data) {
+    const uint32_t* pairs = plan.swapPairs.data();
+    const size_t count = plan.swapPairs.size();
+    for (size_t i = 0; i < count; i += 2) {
+        std::swap(data[pairs[i]], data[pairs[i + 1]]);
+    }
+}
+
+void FftEngine::permuteCopy(const ComplexPlan& plan, const std::complex<float>* input,
+                            std::complex<float>* output) {
+    const uint32_t* reverse = plan.bitReverse.data();
+    for (size_t i = 0; i < plan.size; ++i) {
+        output[i] = input[reverse[i]];
+    }
 }
 
-FftPlan& getPlan(size_t n) {
-    static std::mutex mutex;
-    static std::unordered_map<size_t, FftPlan> plans;
-    std::lock_guard<std::mutex> lock(mutex);
+void FftEngine::runStages(const ComplexPlan& plan, std::complex<float>* data, bool inverse) {
+    const size_t n = plan.size;
 
-    auto it = plans.find(n);
-    if (it != plans.end()) {
-        return it->second;
+    if (plan.leadingRadix2) {
+        for (size_t i = 0; i < n; i += 2) {
+            const std::complex<float> a = data[i];
+            const std::complex<float> b = data[i + 1];
+            data[i] = a + b;
+            data[i + 1] = a - b;
+        }
     }
 
-    auto [insertIt, _] = plans.emplace(n, buildPlan(n));
-    return insertIt->second;
+    for (const auto& stage : plan.stages) {
+        const size_t h = stage.quarter;
+        const TwiddleTable& tw = inverse ? stage.inverse : stage.forward;
+        for (size_t group = 0; group < n; group += 4 * h) {
+            if (inverse) {
+                radix4Group<true>(data + group, h, tw.re1.data(), tw.im1.data(),
+                                  tw.re2.data(), tw.im2.data(), tw.re3.data(), tw.im3.data());
+            } else {
+                radix4Group<false>(data + group, h, tw.re1.data(), tw.im1.data(),
+                                   tw.re2.data(), tw.im2.data(), tw.re3.data(), tw.im3.data());
+            }
+        }
+    }
 }
-} // namespace
 
-bool FftEngine::isPowerOfTwo(size_t n) {
-    return n != 0 && (n & (n - 1)) == 0;
+void FftEngine::forward(std::complex<float>* data) const {
+    if (!data || size_ == 0) {
+        return;
+    }
+    permuteInPlace(full_, data);
+    runStages(full_, data, false);
 }
 
-void FftEngine::forward(std::vector<std::complex<float>>& data) {
-    transform(data, false);
+void FftEngine::inverse(std::complex<float>* data) const {
+    if (!data || size_ == 0) {
+        return;
+    }
+    permuteInPlace(full_, data);
+    runStages(full_, data, true);
+    scale(data, size_, 1.0f / static_cast<float>(size_));
 }
 
-void FftEngine::inverse(std::vector<std::complex<float>>& data) {
-    transform(data, true);
+void FftEngine::forward(const std::complex<float>* input, std::complex<float>* output) const {
+    if (!input || !output || size_ == 0) {
+        return;
+    }
+    permuteCopy(full_, input, output);
+    runStages(full_, output, false);
 }
 
-void FftEngine::transform(std::vector<std::complex<float>>& data, bool inverse) {
-    const size_t n = data.size();
-    if (!isPowerOfTwo(n) || n < 2) {
+void FftEngine::inverse(const std::complex<float>* input, std::complex<float>* output) const {
+    if (!input || !output || size_ == 0) {
         return;
     }
+    permuteCopy(full_, input, output);
+    runStages(full_, output, true);
+    scale(output, size_, 1.0f / static_cast<float>(size_));
+}
 
-    auto& plan = getPlan(n);
+void FftEngine::rfft(const float* input, std::complex<float>* output) const {
+    if (!input || !output || size_ == 0) {
+        return;
+    }
 
-    thread_local std::unordered_map<size_t, std::vector<std::complex<float>>> localBuffers;
-    auto& buffer = localBuffers[n];
-    if (buffer.size() != n) {
-        buffer.assign(n, std::complex<float>(0.0f, 0.0f));
+    // Treat even/odd samples as one size/2-point complex sequence and transform it.
+    const size_t half = size_ / 2;
+    const auto* packed = reinterpret_cast<const std::complex<float>*>(input);
+    if (reinterpret_cast<const void*>(input) == reinterpret_cast<const void*>(output)) {
+        permuteInPlace(half_, output);
+    } else {
+        permuteCopy(half_, packed, output);
     }
+    runStages(half_, output, false);
 
-    for (size_t i = 0; i < n; ++i) {
-        buffer[i] = data[plan.bitReverse[i]];
+    const std::complex<float> z0 = output[0];
+    output[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+    output[half] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+
+    for (size_t k = 1; k <= half / 2; ++k) {
+        const size_t mirror = half - k;
+        const std::complex<float> zk = output[k];
+        const std::complex<float> zm = std::conj(output[mirror]);
+
+        const std::complex<float> evenK = 0.5f * (zk + zm);
+        const std::complex<float> oddK = std::complex<float>(0.0f, -0.5f) * (zk - zm);
+        const std::complex<float> evenM = std::conj(evenK);
+        const std::complex<float> oddM = std::conj(oddK);
+
+        output[k] = evenK + realTwiddles_[k] * oddK;
+        output[mirror] = evenM + realTwiddles_[mirror] * oddM;
     }
+}
 
-    for (const auto& stage : plan.stages) {
-        const size_t len = stage.length;
-        const size_t halfLen = len >> 1;
-        for (size_t i = 0; i < n; i += len) {
-            for (size_t k = 0; k < halfLen; ++k) {
-                const auto& w = inverse ? std::conj(stage.twiddles[k]) : stage.twiddles[k];
-                const std::complex<float> u = buffer[i + k];
-                const std::complex<float> v = buffer[i + k + halfLen] * w;
-                buffer[i + k] = u + v;
-                buffer[i + k + halfLen] = u - v;
-            }
-        }
+void FftEngine::irfft(const std::complex<float>* input, float* output) const {
+    if (!input || !output || size_ == 0) {
+        return;
     }
 
-    if (inverse) {
-        const float invN = 1.0f / static_cast<float>(n);
-        for (size_t i = 0; i < n; ++i) {
-            data[i] = buffer[i] * invN;
+    // Rebuild the packed size/2-point spectrum in the output storage, then
+    // invert it. The 1/size normalisation is folded into the merge.
+    const size_t half = size_ / 2;
+    auto* packed = reinterpret_cast<std::complex<float>*>(output);
+    const float norm = 1.0f / static_cast<float>(half);
+    const float halfNorm = 0.5f * norm;
+
+    for (size_t k = 0; k <= half / 2; ++k) {
+        const size_t mirror = half - k;
+        const std::complex<float> xk = input[k];
+        const std::complex<float> xm = std::conj(input[mirror]);
+
+        const std::complex<float> evenK = halfNorm * (xk + xm);
+        const std::complex<float> oddK = halfNorm * (xk - xm) * std::conj(realTwiddles_[k]);
+        packed[k] = evenK + std::complex<float>(-oddK.imag(), oddK.real());
+
+        if (mirror != k && mirror < half) {
+            const std::complex<float> evenM = std::conj(evenK);
+            const std::complex<float> oddM = std::conj(oddK);
+            packed[mirror] = evenM + std::complex<float>(-oddM.imag(), oddM.real());
         }
-    } else {
-        std::memcpy(data.data(), buffer.data(), n * sizeof(std::complex<float>));
     }
+
+    permuteInPlace(half_, packed);
+    runStages(half_, packed, true);
 }
 
 } // namespace spcmic
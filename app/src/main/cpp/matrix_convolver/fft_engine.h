@@ -2,19 +2,85 @@
 #define SPCMIC_FFT_ENGINE_H
 
 #include <complex>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace spcmic {
 
+/**
+ * Precomputed FFT plan for one power-of-two size. Create it once with
+ * initialize() and reuse it; the transform methods are const, take no locks
+ * and allocate nothing, so one plan may be shared by several threads.
+ *
+ * Stages are radix-4 (with one leading radix-2 stage for odd log2 sizes),
+ * NEON-vectorised where available with a scalar fallback for other ABIs.
+ */
 class FftEngine {
 public:
+    FftEngine();
+
+    /** Build tables for transforms of @p size points (power of two, >= 4). */
+    bool initialize(size_t size);
+
+    [[nodiscard]] bool isReady() const { return size_ != 0; }
+    [[nodiscard]] size_t size() const { return size_; }
+
     static bool isPowerOfTwo(size_t n);
 
-    static void forward(std::vector<std::complex<float>>& data);
-    static void inverse(std::vector<std::complex<float>>& data);
+    /** In-place complex transforms of size() points; inverse scales by 1/size(). */
+    void forward(std::complex<float>* data) const;
+    void inverse(std::complex<float>* data) const;
+
+    /** Out-of-place complex transforms; @p input and @p output must not overlap. */
+    void forward(const std::complex<float>* input, std::complex<float>* output) const;
+    void inverse(const std::complex<float>* input, std::complex<float>* output) const;
+
+    /**
+     * Real-to-complex transform of size() real samples. Writes the size()/2 + 1
+     * non-redundant bins to @p output. @p input and @p output may alias.
+     */
+    void rfft(const float* input, std::complex<float>* output) const;
+
+    /**
+     * Complex-to-real inverse of rfft(): consumes size()/2 + 1 bins and writes
+     * size() samples scaled by 1/size(). @p input and @p output may alias (the
+     * half spectrum holds size() + 2 floats); otherwise @p input is untouched.
+     */
+    void irfft(const std::complex<float>* input, float* output) const;
 
 private:
-    static void transform(std::vector<std::complex<float>>& data, bool inverse);
+    /** Twiddles for one radix-4 stage, split into real/imag arrays for NEON loads. */
+    struct TwiddleTable {
+        std::vector<float> re1, im1; // W^k
+        std::vector<float> re2, im2; // W^2k
+        std::vector<float> re3, im3; // W^3k
+    };
+
+    struct Radix4Stage {
+        size_t quarter; // butterfly span; each group covers 4 * quarter points
+        TwiddleTable forward;
+        TwiddleTable inverse;
+    };
+
+    struct ComplexPlan {
+        size_t size = 0;
+        bool leadingRadix2 = false;
+        std::vector<uint32_t> bitReverse;
+        std::vector<uint32_t> swapPairs; // (i, rev(i)) pairs with i < rev(i)
+        std::vector<Radix4Stage> stages;
+    };
+
+    static bool buildComplexPlan(size_t n, ComplexPlan& plan);
+    static void runStages(const ComplexPlan& plan, std::complex<float>* data, bool inverse);
+    static void permuteInPlace(const ComplexPlan& plan, std::complex<float>* data);
+    static void permuteCopy(const ComplexPlan& plan, const std::complex<float>* input,
+                            std::complex<float>* output);
+
+    size_t size_;
+    ComplexPlan full_;  // size_-point complex transforms
+    ComplexPlan half_;  // size_/2-point transform backing the real transforms
+    std::vector<std::complex<float>> realTwiddles_; // exp(-2*pi*i*k/size_), k < size_/2
 };
 
 } // namespace spcmic
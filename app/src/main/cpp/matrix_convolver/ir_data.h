@@ -1,6 +1,8 @@
 #ifndef SPCMIC_MATRIX_IR_DATA_H
 #define SPCMIC_MATRIX_IR_DATA_H
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 namespace spcmic {
@@ -11,7 +13,9 @@ struct MatrixImpulseResponse {
     int numInputChannels = 0;      // Typically 84 microphones
 
     int numOutputChannels = 0;     // Output channel count (e.g. 2 for stereo, 16 for 3OA)
-    std::vector<float> impulseData; // Size: numOutputChannels * numInputChannels * irLength
+    std::vector<float> impulseData; // Size: numOutputChannels * numInputChannels * irLength; may be empty when cached spectra suffice
+    std::string cacheKey;           // Identifies the source IR for cached spectra (empty = not cacheable)
+    uint64_t contentHash = 0;       // Hash of the WAV data chunk the samples come from
 
     [[nodiscard]] const float* impulseFor(int outputChannel, int inputChannel) const {
         const size_t offset = (static_cast<size_t>(outputChannel) * static_cast<size_t>(numInputChannels) +
@@ -19,13 +23,17 @@ struct MatrixImpulseResponse {
         return impulseData.data() + offset;
     }
 
+    /** Dimensions are known; the samples may not have been loaded. */
+    [[nodiscard]] bool hasShape() const {
+        return sampleRate > 0 && irLength > 0 &&
+               numInputChannels > 0 && numOutputChannels > 0;
+    }
+
     [[nodiscard]] bool isValid() const {
         const size_t expectedSize = static_cast<size_t>(numOutputChannels) *
                                     static_cast<size_t>(numInputChannels) *
                                     static_cast<size_t>(irLength);
-        return sampleRate > 0 && irLength > 0 &&
-               numInputChannels > 0 && numOutputChannels > 0 &&
-               impulseData.size() == expectedSize;
+        return hasShape() && impulseData.size() == expectedSize;
     }
 };
 
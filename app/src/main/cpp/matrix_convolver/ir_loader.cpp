@@ -1,7 +1,9 @@
 #include "matrix_convolver/ir_loader.h"
 #include <android/asset_manager.h>
 #include <android/log.h>
+#include <cstdio>
 #include <cstring>
+#include <string>
 #include <vector>
 #include <algorithm>
 
@@ -13,6 +15,8 @@
 namespace {
 
 constexpr int kNumInputChannels = 84;
+constexpr size_t kHeaderProbeBytes = 4096; // covers fmt/smpl/LIST ahead of the data chunk
+constexpr size_t kHashReadBytes = 64 * 1024;
 
 inline uint16_t ReadLE16(const uint8_t* data) {
     return static_cast<uint16_t>(data[0] | (data[1] << 8));
@@ -22,6 +26,58 @@ inline uint32_t ReadLE32(const uint8_t* data) {
     return static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
 }
 
+/**
+ * FNV-1a over 64-bit words with a final mix, fed in pieces of any size. It
+ * only has to tell IR files apart, so a replaced IR never reuses old spectra.
+ */
+class ContentHash {
+public:
+    void update(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            if (pendingBytes_ == 0 && size >= sizeof(uint64_t)) {
+                const size_t words = size / sizeof(uint64_t);
+                for (size_t word = 0; word < words; ++word) {
+                    uint64_t value;
+                    std::memcpy(&value, data + word * sizeof(uint64_t), sizeof(value));
+                    mix(value);
+                }
+                data += words * sizeof(uint64_t);
+                size -= words * sizeof(uint64_t);
+                continue;
+            }
+            pending_ |= static_cast<uint64_t>(*data++) << (8 * pendingBytes_);
+            --size;
+            if (++pendingBytes_ == sizeof(uint64_t)) {
+                mix(pending_);
+                pending_ = 0;
+                pendingBytes_ = 0;
+            }
+        }
+    }
+
+    uint64_t finish() {
+        if (pendingBytes_ > 0) {
+            mix(pending_ ^ (static_cast<uint64_t>(pendingBytes_) << 56));
+            pending_ = 0;
+            pendingBytes_ = 0;
+        }
+        // Word-wise FNV leaves low bits untouched by high ones; spread every bit over the key.
+        uint64_t value = state_;
+        value = (value ^ (value >> 33)) * 0xff51afd7ed558ccdull;
+        value = (value ^ (value >> 33)) * 0xc4ceb9fe1a85ec53ull;
+        return value ^ (value >> 33);
+    }
+
+private:
+    void mix(uint64_t value) {
+        state_ = (state_ ^ value) * 1099511628211ull;
+    }
+
+    uint64_t state_ = 14695981039346656037ull;
+    uint64_t pending_ = 0;
+    size_t pendingBytes_ = 0;
+};
+
 } // namespace
 
 namespace spcmic {
@@ -62,27 +118,30 @@ std::string IRLoader::buildAssetName(IRPreset preset, int sampleRateHz) {
     return assetName;
 }
 
-bool IRLoader::loadPreset(IRPreset preset, int sampleRateHz, MatrixImpulseResponse& outIR) {
+bool IRLoader::loadPreset(IRPreset preset, int sampleRateHz, MatrixImpulseResponse& outIR,
+                          bool includeSamples) {
     if (!assetManager_) {
         LOGW("Asset manager not set. Cannot load IR.");
         return false;
     }
 
     const std::string assetName = buildAssetName(preset, sampleRateHz);
-    if (!loadFromAsset(assetName, sampleRateHz, outIR)) {
+    if (!loadFromAsset(assetName, sampleRateHz, outIR, includeSamples)) {
         LOGE("Failed to load IR asset: %s", assetName.c_str());
         return false;
     }
 
-    LOGD("Loaded IR: %s (IR length=%d, inputs=%d, outputs=%d)",
+    LOGD("Loaded IR%s: %s (IR length=%d, inputs=%d, outputs=%d)", includeSamples ? "" : " header",
          assetName.c_str(), outIR.irLength, outIR.numInputChannels, outIR.numOutputChannels);
     return true;
 }
 
 bool IRLoader::loadFromAsset(const std::string& assetName,
                              int expectedSampleRate,
-                             MatrixImpulseResponse& outIR) {
-    AAsset* asset = AAssetManager_open(assetManager_, assetName.c_str(), AASSET_MODE_BUFFER);
+                             MatrixImpulseResponse& outIR,
+                             bool includeSamples) {
+    AAsset* asset = AAssetManager_open(assetManager_, assetName.c_str(),
+                                       includeSamples ? AASSET_MODE_BUFFER : AASSET_MODE_STREAMING);
     if (!asset) {
         LOGE("Unable to open asset: %s", assetName.c_str());
         return false;
@@ -95,29 +154,100 @@ bool IRLoader::loadFromAsset(const std::string& assetName,
         return false;
     }
 
-    std::vector<uint8_t> buffer(static_cast<size_t>(assetLength));
-    int64_t totalRead = 0;
-    while (totalRead < assetLength) {
-        const int64_t read = AAsset_read(asset,
-                                         buffer.data() + totalRead,
-                                         static_cast<size_t>(assetLength - totalRead));
-        if (read <= 0) {
-            LOGE("Failed to read asset %s (read=%lld, total=%lld)", assetName.c_str(),
-                 static_cast<long long>(read), static_cast<long long>(totalRead));
-            AAsset_close(asset);
-            return false;
+    // Uncompressed assets are mapped in place; otherwise read what is needed:
+    // the whole file, or just enough for the header chunks.
+    const uint8_t* data = includeSamples ? static_cast<const uint8_t*>(AAsset_getBuffer(asset)) : nullptr;
+    size_t dataLength = static_cast<size_t>(assetLength);
+    std::vector<uint8_t> buffer;
+    if (!data) {
+        const size_t wanted = includeSamples ? dataLength : std::min(dataLength, kHeaderProbeBytes);
+        buffer.resize(wanted);
+        size_t totalRead = 0;
+        while (totalRead < wanted) {
+            const int read = AAsset_read(asset, buffer.data() + totalRead, wanted - totalRead);
+            if (read <= 0) {
+                LOGE("Failed to read asset %s (read=%d, total=%zu)", assetName.c_str(), read, totalRead);
+                AAsset_close(asset);
+                return false;
+            }
+            totalRead += static_cast<size_t>(read);
         }
-        totalRead += read;
+        data = buffer.data();
+        dataLength = buffer.size();
+    }
+
+    size_t dataChunkOffset = 0;
+    size_t dataChunkSize = 0;
+    if (!parseWav(assetName, data, dataLength, static_cast<size_t>(assetLength),
+                  expectedSampleRate, outIR, includeSamples, dataChunkOffset, dataChunkSize)) {
+        AAsset_close(asset);
+        return false;
     }
 
+    ContentHash hash;
+    const size_t probedDataBytes = std::min(dataChunkSize, dataLength - dataChunkOffset);
+    hash.update(data + dataChunkOffset, probedDataBytes);
+    // Header-only: hash the rest of the data chunk straight from the stream.
+    size_t remaining = dataChunkSize - probedDataBytes;
+    if (remaining > 0) {
+        buffer.resize(kHashReadBytes);
+        while (remaining > 0) {
+            const int read = AAsset_read(asset, buffer.data(), std::min(remaining, buffer.size()));
+            if (read <= 0) {
+                LOGE("Failed to read asset %s data chunk (read=%d, left=%zu)", assetName.c_str(), read, remaining);
+                AAsset_close(asset);
+                return false;
+            }
+            hash.update(buffer.data(), static_cast<size_t>(read));
+            remaining -= static_cast<size_t>(read);
+        }
+    }
     AAsset_close(asset);
 
-    if (buffer.size() < 44) {
+    outIR.contentHash = hash.finish();
+    outIR.cacheKey = buildCacheKey(assetName, static_cast<size_t>(assetLength), outIR.contentHash);
+    return includeSamples ? outIR.isValid() : outIR.hasShape();
+}
+
+bool IRLoader::loadFromBuffer(const std::string& name, const uint8_t* data, size_t length,
+                              int expectedSampleRate, MatrixImpulseResponse& outIR) {
+    size_t dataChunkOffset = 0;
+    size_t dataChunkSize = 0;
+    if (!data || !parseWav(name, data, length, length, expectedSampleRate, outIR, true,
+                           dataChunkOffset, dataChunkSize)) {
+        return false;
+    }
+    ContentHash hash;
+    hash.update(data + dataChunkOffset, dataChunkSize);
+    outIR.contentHash = hash.finish();
+    outIR.cacheKey = buildCacheKey(name, length, outIR.contentHash);
+    return outIR.isValid();
+}
+
+std::string IRLoader::buildCacheKey(const std::string& assetName, size_t fileLength, uint64_t contentHash) {
+    // A replaced IR of the same shape keeps the name and length, so the
+    // samples themselves have to be part of the key.
+    std::string base = assetName.substr(assetName.rfind('/') + 1);
+    base = base.substr(0, base.rfind('.'));
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(contentHash));
+    return base + "_" + std::to_string(static_cast<long long>(fileLength)) + "_" + hash;
+}
+
+bool IRLoader::parseWav(const std::string& assetName,
+                        const uint8_t* data,
+                        size_t length,
+                        size_t fileLength,
+                        int expectedSampleRate,
+                        MatrixImpulseResponse& outIR,
+                        bool includeSamples,
+                        size_t& dataChunkOffset,
+                        size_t& dataChunkSize) {
+    if (length < 44) {
         LOGE("Asset %s too small to be a valid WAV file", assetName.c_str());
         return false;
     }
 
-    const uint8_t* data = buffer.data();
     if (std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
         LOGE("Asset %s is not a RIFF/WAVE file", assetName.c_str());
         return false;
@@ -131,13 +261,13 @@ bool IRLoader::loadFromAsset(const std::string& assetName,
     uint32_t dataSize = 0;
     size_t dataOffset = 0;
 
-    while (offset + 8 <= buffer.size()) {
+    while (offset + 8 <= length) {
         const char* chunkId = reinterpret_cast<const char*>(data + offset);
         const uint32_t chunkSize = ReadLE32(data + offset + 4);
         offset += 8;
 
         if (std::memcmp(chunkId, "fmt ", 4) == 0) {
-            if (chunkSize < 16 || offset + chunkSize > buffer.size()) {
+            if (chunkSize < 16 || offset + chunkSize > length) {
                 LOGE("Invalid fmt chunk in asset %s", assetName.c_str());
                 return false;
             }
@@ -182,7 +312,9 @@ bool IRLoader::loadFromAsset(const std::string& assetName,
         return false;
     }
 
-    if (dataSize == 0 || dataOffset + dataSize > buffer.size()) {
+    // Header-only parses see a prefix of the file; check against the full length.
+    if (dataSize == 0 || dataOffset == 0 || dataOffset + dataSize > fileLength ||
+        (includeSamples && dataOffset + dataSize > length)) {
         LOGE("Invalid data chunk in asset %s", assetName.c_str());
         return false;
     }
@@ -201,25 +333,39 @@ bool IRLoader::loadFromAsset(const std::string& assetName,
     }
 
     const size_t irLength = totalFrames / kNumInputChannels;
-    const uint8_t* samples = data + dataOffset;
+    dataChunkOffset = dataOffset;
+    dataChunkSize = dataSize;
+    outIR.sampleRate = static_cast<int>(sampleRate);
+    outIR.irLength = static_cast<int>(irLength);
+    outIR.numInputChannels = kNumInputChannels;
+    outIR.numOutputChannels = numChannels;
+    outIR.impulseData.clear();
+    if (!includeSamples) {
+        outIR.impulseData.shrink_to_fit();
+        return true;
+    }
 
-    std::vector<std::vector<float>> channelData(numChannels, std::vector<float>(totalFrames));
+    // The file holds the 84 responses back to back in time, so output
+    // channel ch is one contiguous [input][irLength] run of impulseData:
+    // de-interleave straight into it.
+    outIR.impulseData.resize(static_cast<size_t>(numChannels) * totalFrames);
+    float* dest = outIR.impulseData.data();
+    const uint8_t* samples = data + dataOffset;
+    const size_t frameStride = static_cast<size_t>(numChannels) * bytesPerSample;
 
     if (bitsPerSample == 32 && audioFormat == 3) {
-        const size_t frameStride = static_cast<size_t>(numChannels) * bytesPerSample;
         for (size_t frame = 0; frame < totalFrames; ++frame) {
             const size_t base = frame * frameStride;
             for (uint16_t ch = 0; ch < numChannels; ++ch) {
                 float value;
                 std::memcpy(&value, samples + base + ch * bytesPerSample, sizeof(float));
-                channelData[ch][frame] = value;
+                dest[static_cast<size_t>(ch) * totalFrames + frame] = value;
             }
         }
     } else {
         const float scale = (bitsPerSample == 32) ? (1.0f / 2147483648.0f)
                                                  : (bitsPerSample == 24 ? (1.0f / 8388608.0f)
                                                                        : (1.0f / 32768.0f));
-        const size_t frameStride = static_cast<size_t>(numChannels) * bytesPerSample;
         for (size_t frame = 0; frame < totalFrames; ++frame) {
             const size_t base = frame * frameStride;
             for (uint16_t ch = 0; ch < numChannels; ++ch) {
@@ -235,28 +381,12 @@ bool IRLoader::loadFromAsset(const std::string& assetName,
                 } else { // 16-bit
                     value = static_cast<int16_t>(samplePtr[0] | (samplePtr[1] << 8));
                 }
-                channelData[ch][frame] = static_cast<float>(value) * scale;
+                dest[static_cast<size_t>(ch) * totalFrames + frame] = static_cast<float>(value) * scale;
             }
         }
     }
 
-    outIR.sampleRate = static_cast<int>(sampleRate);
-    outIR.irLength = static_cast<int>(irLength);
-    outIR.numInputChannels = kNumInputChannels;
-    outIR.numOutputChannels = numChannels;
-    outIR.impulseData.resize(static_cast<size_t>(numChannels) * kNumInputChannels * irLength);
-
-    for (uint16_t outChannel = 0; outChannel < numChannels; ++outChannel) {
-        const auto& channelVector = channelData[outChannel];
-        for (int inChannel = 0; inChannel < kNumInputChannels; ++inChannel) {
-            const size_t srcOffset = static_cast<size_t>(inChannel) * irLength;
-            const size_t dstOffset = (static_cast<size_t>(outChannel) * kNumInputChannels +
-                                      static_cast<size_t>(inChannel)) * irLength;
-            std::copy_n(channelVector.begin() + srcOffset, irLength, outIR.impulseData.begin() + dstOffset);
-        }
-    }
-
-    return outIR.isValid();
+    return true;
 }
 
 } // namespace spcmic
@@ -1,6 +1,8 @@
 #ifndef SPCMIC_IR_LOADER_H
 #define SPCMIC_IR_LOADER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <android/asset_manager.h>
 #include "matrix_convolver/ir_data.h"
@@ -23,15 +25,40 @@ public:
     /**
      * Load the impulse response matching the requested preset and sample rate.
      * Supported sample rates: 48000 Hz, 96000 Hz.
+     * With @p includeSamples false only the WAV header is parsed: the result
+     * carries dimensions and cacheKey but no impulseData, which is enough to
+     * configure a convolver from cached spectra. The data chunk is still
+     * streamed through the content hash the cache key is built from.
      */
-    bool loadPreset(IRPreset preset, int sampleRateHz, MatrixImpulseResponse& outIR);
+    bool loadPreset(IRPreset preset, int sampleRateHz, MatrixImpulseResponse& outIR,
+                    bool includeSamples = true);
+
+    /**
+     * Parse a complete IR WAV file already in memory (e.g. read from disk by
+     * a host tool). @p name labels log messages and the cache key, like an
+     * asset name does.
+     */
+    bool loadFromBuffer(const std::string& name, const uint8_t* data, size_t length,
+                        int expectedSampleRate, MatrixImpulseResponse& outIR);
 
 private:
     bool loadFromAsset(const std::string& assetName,
                        int expectedSampleRate,
-                       MatrixImpulseResponse& outIR);
+                       MatrixImpulseResponse& outIR,
+                       bool includeSamples);
+
+    static bool parseWav(const std::string& assetName,
+                         const uint8_t* data,
+                         size_t length,
+                         size_t fileLength,
+                         int expectedSampleRate,
+                         MatrixImpulseResponse& outIR,
+                         bool includeSamples,
+                         size_t& dataChunkOffset,
+                         size_t& dataChunkSize);
 
     static std::string buildAssetName(IRPreset preset, int sampleRateHz);
+    static std::string buildCacheKey(const std::string& assetName, size_t fileLength, uint64_t contentHash);
 
     AAssetManager* assetManager_;
 };
@@ -0,0 +1,327 @@
+#include "matrix_convolver/ir_spectra_cache.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#define LOG_TAG "IRSpectraCache"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'P', 'C', 'I', 'R', 'S', 'P', '\0'};
+constexpr uint32_t kFormatVersion = 2;   // bump whenever the spectra layout or FFT scaling changes
+constexpr size_t kDefaultResidentBytes = 128u * 1024u * 1024u;
+constexpr off_t kMaxDirectoryBytes = 384LL * 1024 * 1024;
+constexpr const char* kFileSuffix = ".irspec";
+
+/** 72-byte file header; the spectra follow, so they stay 8-byte aligned when mapped. */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    int32_t layout[9];
+    uint32_t reserved;
+    uint64_t dataBytes;
+    uint64_t sourceHash;
+};
+static_assert(sizeof(FileHeader) == 72, "IR spectra file header must stay 72 bytes");
+
+void PackLayout(const spcmic::IRSpectra::Layout& layout, int32_t* fields) {
+    fields[0] = layout.sampleRate;
+    fields[1] = layout.numInputChannels;
+    fields[2] = layout.numOutputChannels;
+    fields[3] = layout.irLength;
+    fields[4] = layout.blockSize;
+    fields[5] = layout.irOffset;
+    fields[6] = layout.irSpan;
+    fields[7] = layout.numPartitions;
+    fields[8] = layout.spectrumBins;
+}
+
+std::string JoinPath(const std::string& dir, const std::string& file) {
+    if (dir.empty() || dir.back() == '/') {
+        return dir + file;
+    }
+    return dir + "/" + file;
+}
+
+bool HasSuffix(const std::string& name, const char* suffix) {
+    const size_t length = std::strlen(suffix);
+    return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+}
+
+/** Delete the least recently used cache files until the directory fits its budget. */
+void PruneDirectory(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+
+    struct CacheFile {
+        std::string path;
+        off_t size;
+        time_t used;
+    };
+    std::vector<CacheFile> files;
+    off_t totalBytes = 0;
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (!HasSuffix(name, kFileSuffix)) {
+            continue;
+        }
+        const std::string path = JoinPath(directory, name);
+        struct stat info {};
+        if (stat(path.c_str(), &info) == 0) {
+            files.push_back({path, info.st_size, std::max(info.st_atime, info.st_mtime)});
+            totalBytes += info.st_size;
+        }
+    }
+    closedir(dir);
+
+    if (totalBytes <= kMaxDirectoryBytes) {
+        return;
+    }
+    std::sort(files.begin(), files.end(),
+              [](const CacheFile& a, const CacheFile& b) { return a.used < b.used; });
+    for (const CacheFile& file : files) {
+        if (totalBytes <= kMaxDirectoryBytes) {
+            break;
+        }
+        if (unlink(file.path.c_str()) == 0) {
+            totalBytes -= file.size;
+            LOGD("Pruned IR spectra cache file %s", file.path.c_str());
+        }
+    }
+}
+
+} // namespace
+
+namespace spcmic {
+
+size_t IRSpectra::Layout::complexCount() const {
+    return static_cast<size_t>(numPartitions) * static_cast<size_t>(numOutputChannels) *
+           static_cast<size_t>(numInputChannels) * static_cast<size_t>(spectrumBins);
+}
+
+bool IRSpectra::Layout::operator==(const Layout& other) const {
+    return sampleRate == other.sampleRate &&
+           numInputChannels == other.numInputChannels &&
+           numOutputChannels == other.numOutputChannels &&
+           irLength == other.irLength &&
+           blockSize == other.blockSize &&
+           irOffset == other.irOffset &&
+           irSpan == other.irSpan &&
+           numPartitions == other.numPartitions &&
+           spectrumBins == other.spectrumBins &&
+           sourceHash == other.sourceHash;
+}
+
+IRSpectra::IRSpectra(const Layout& layout, std::vector<std::complex<float>>&& data)
+    : layout_(layout)
+    , storage_(std::move(data))
+    , mapping_(nullptr)
+    , mappingBytes_(0)
+    , data_(storage_.data()) {
+}
+
+IRSpectra::IRSpectra(const Layout& layout, void* mapping, size_t mappingBytes)
+    : layout_(layout)
+    , mapping_(mapping)
+    , mappingBytes_(mappingBytes)
+    , data_(reinterpret_cast<const std::complex<float>*>(static_cast<const uint8_t*>(mapping) +
+                                                         sizeof(FileHeader))) {
+}
+
+IRSpectra::~IRSpectra() {
+    if (mapping_) {
+        munmap(mapping_, mappingBytes_);
+    }
+}
+
+std::shared_ptr<const IRSpectra> IRSpectra::mapFile(const std::string& path, const Layout& layout) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    const size_t dataBytes = layout.complexCount() * sizeof(std::complex<float>);
+    const size_t fileBytes = sizeof(FileHeader) + dataBytes;
+    struct stat info {};
+    FileHeader header {};
+    int32_t expected[9];
+    PackLayout(layout, expected);
+    const bool matches = fstat(fd, &info) == 0 &&
+                         static_cast<size_t>(info.st_size) == fileBytes &&
+                         pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                         std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                         header.version == kFormatVersion &&
+                         header.headerBytes == sizeof(FileHeader) &&
+                         header.dataBytes == dataBytes &&
+                         header.sourceHash == layout.sourceHash &&
+                         std::memcmp(header.layout, expected, sizeof(expected)) == 0;
+    if (!matches) {
+        close(fd);
+        LOGW("Discarding stale IR spectra cache file %s", path.c_str());
+        unlink(path.c_str());
+        return nullptr;
+    }
+
+    void* mapping = mmap(nullptr, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOGE("Failed to map %s: %s", path.c_str(), std::strerror(errno));
+        return nullptr;
+    }
+    // Mark the file as recently used for directory pruning.
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    return std::shared_ptr<const IRSpectra>(new IRSpectra(layout, mapping, fileBytes));
+}
+
+bool IRSpectra::writeFile(const std::string& path) const {
+    FileHeader header {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.headerBytes = sizeof(FileHeader);
+    PackLayout(layout_, header.layout);
+    header.dataBytes = byteSize();
+    header.sourceHash = layout_.sourceHash;
+
+    // Unique temporary name, so concurrent writers of one entry never share a file.
+    std::string tempPath = path + ".XXXXXX";
+    const int fd = mkstemp(&tempPath[0]);
+    FILE* file = (fd >= 0) ? fdopen(fd, "wb") : nullptr;
+    if (!file) {
+        LOGW("Cannot create a temporary file for %s: %s", path.c_str(), std::strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+            unlink(tempPath.c_str());
+        }
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(data_, 1, byteSize(), file) == byteSize();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGW("Failed to write %s", path.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+IRSpectraCache::IRSpectraCache(size_t maxResidentBytes)
+    : residentBytes_(0)
+    , maxResidentBytes_(maxResidentBytes) {
+}
+
+IRSpectraCache& IRSpectraCache::shared() {
+    static IRSpectraCache cache(kDefaultResidentBytes);
+    return cache;
+}
+
+void IRSpectraCache::setDirectory(const std::string& directory) {
+    if (!directory.empty() && mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOGW("Cannot create IR spectra cache directory %s: %s", directory.c_str(), std::strerror(errno));
+        std::lock_guard<std::mutex> lock(mutex_);
+        directory_.clear();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = directory;
+}
+
+std::string IRSpectraCache::entryKey(const std::string& sourceKey, const IRSpectra::Layout& layout) {
+    return sourceKey + "_b" + std::to_string(layout.blockSize) +
+           "_o" + std::to_string(layout.irOffset) +
+           "_n" + std::to_string(layout.irSpan);
+}
+
+void IRSpectraCache::touch(std::list<Entry>::iterator entry) {
+    entries_.splice(entries_.begin(), entries_, entry);
+}
+
+void IRSpectraCache::addResident(const std::string& key, const std::shared_ptr<const IRSpectra>& spectra) {
+    entries_.push_front({key, spectra});
+    residentBytes_ += spectra->byteSize();
+    // Keep at least the newest entry, whatever its size.
+    while (residentBytes_ > maxResidentBytes_ && entries_.size() > 1) {
+        residentBytes_ -= entries_.back().spectra->byteSize();
+        entries_.pop_back();
+    }
+}
+
+std::shared_ptr<const IRSpectra> IRSpectraCache::acquire(const std::string& sourceKey,
+                                                         const IRSpectra::Layout& layout) {
+    if (sourceKey.empty()) {
+        return nullptr;
+    }
+    const std::string key = entryKey(sourceKey, layout);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->key == key) {
+            if (!(it->spectra->layout() == layout)) {
+                break;
+            }
+            touch(it);
+            return it->spectra;
+        }
+    }
+
+    if (directory_.empty()) {
+        return nullptr;
+    }
+    auto spectra = IRSpectra::mapFile(JoinPath(directory_, key + kFileSuffix), layout);
+    if (spectra) {
+        addResident(key, spectra);
+        LOGD("Mapped cached IR spectra %s (%zu bytes)", key.c_str(), spectra->byteSize());
+    }
+    return spectra;
+}
+
+void IRSpectraCache::insert(const std::string& sourceKey, const std::shared_ptr<const IRSpectra>& spectra) {
+    if (sourceKey.empty() || !spectra) {
+        return;
+    }
+    const std::string key = entryKey(sourceKey, spectra->layout());
+
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->key == key) {
+                residentBytes_ -= it->spectra->byteSize();
+                entries_.erase(it);
+                break;
+            }
+        }
+        addResident(key, spectra);
+        directory = directory_;
+    }
+
+    // Written outside the lock; mapping a partly written file is prevented by the rename.
+    if (!directory.empty() && spectra->writeFile(JoinPath(directory, key + kFileSuffix))) {
+        LOGD("Stored IR spectra %s (%zu bytes)", key.c_str(), spectra->byteSize());
+        PruneDirectory(directory);
+    }
+}
+
+void IRSpectraCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    residentBytes_ = 0;
+}
+
+} // namespace spcmic
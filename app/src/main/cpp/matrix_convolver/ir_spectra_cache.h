@@ -0,0 +1,111 @@
+#ifndef SPCMIC_IR_SPECTRA_CACHE_H
+#define SPCMIC_IR_SPECTRA_CACHE_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spcmic {
+
+/**
+ * Partition spectra of one convolver stage, laid out
+ * [partition][output][input][bin]. Either built in memory or mapped
+ * read-only from a cache file; immutable either way.
+ */
+class IRSpectra {
+public:
+    struct Layout {
+        int32_t sampleRate = 0;
+        int32_t numInputChannels = 0;
+        int32_t numOutputChannels = 0;
+        int32_t irLength = 0;      // full IR length the stage was cut from
+        int32_t blockSize = 0;
+        int32_t irOffset = 0;      // first IR frame covered by the stage
+        int32_t irSpan = 0;        // IR frames covered by the stage
+        int32_t numPartitions = 0;
+        int32_t spectrumBins = 0;
+        uint64_t sourceHash = 0;   // content hash of the IR the stage was cut from
+
+        [[nodiscard]] size_t complexCount() const;
+        bool operator==(const Layout& other) const;
+    };
+
+    IRSpectra(const Layout& layout, std::vector<std::complex<float>>&& data);
+    ~IRSpectra();
+
+    IRSpectra(const IRSpectra&) = delete;
+    IRSpectra& operator=(const IRSpectra&) = delete;
+
+    /** Map a cache file written by writeFile(); null if missing or not matching @p layout. */
+    static std::shared_ptr<const IRSpectra> mapFile(const std::string& path, const Layout& layout);
+
+    /** Write atomically (temporary file + rename). */
+    bool writeFile(const std::string& path) const;
+
+    [[nodiscard]] const Layout& layout() const { return layout_; }
+    [[nodiscard]] const std::complex<float>* data() const { return data_; }
+    [[nodiscard]] size_t byteSize() const { return layout_.complexCount() * sizeof(std::complex<float>); }
+    [[nodiscard]] bool isMapped() const { return mapping_ != nullptr; }
+
+private:
+    IRSpectra(const Layout& layout, void* mapping, size_t mappingBytes);
+
+    Layout layout_;
+    std::vector<std::complex<float>> storage_; // built spectra
+    void* mapping_;                            // mapped cache file
+    size_t mappingBytes_;
+    const std::complex<float>* data_;
+};
+
+/**
+ * Spectra shared across convolver configurations: an LRU of recently used
+ * stages kept resident up to a byte budget, backed by versioned files in a
+ * cache directory that are mapped back in on a miss. Entries evicted from
+ * the LRU stay alive while a convolver still holds them.
+ */
+class IRSpectraCache {
+public:
+    explicit IRSpectraCache(size_t maxResidentBytes);
+
+    /** Process-wide cache used by the playback engine and the live monitor. */
+    static IRSpectraCache& shared();
+
+    /** Directory for cache files; empty keeps the cache in memory only. */
+    void setDirectory(const std::string& directory);
+
+    /**
+     * Spectra for IR @p sourceKey cut as @p layout: resident, else mapped from
+     * the cache directory, else null.
+     */
+    std::shared_ptr<const IRSpectra> acquire(const std::string& sourceKey, const IRSpectra::Layout& layout);
+
+    /** Keep freshly built spectra resident and persist them to the cache directory. */
+    void insert(const std::string& sourceKey, const std::shared_ptr<const IRSpectra>& spectra);
+
+    void clear();
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const IRSpectra> spectra;
+    };
+
+    static std::string entryKey(const std::string& sourceKey, const IRSpectra::Layout& layout);
+    void touch(std::list<Entry>::iterator entry);
+    void addResident(const std::string& key, const std::shared_ptr<const IRSpectra>& spectra);
+
+    std::mutex mutex_;
+    std::list<Entry> entries_; // most recently used first
+    size_t residentBytes_;
+    size_t maxResidentBytes_;
+    std::string directory_;
+};
+
+} // namespace spcmic
+
+#endif // SPCMIC_IR_SPECTRA_CACHE_H
@@ -1,10 +1,11 @@
 #include "matrix_convolver/matrix_convolver.h"
-#include "matrix_convolver/fft_engine.h"
 
 #include <algorithm>
 #include <android/log.h>
 #include <chrono>
 #include <mutex>
+#include <system_error>
+#include "thread_config.h"
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
 #include <arm_neon.h>
 #endif
@@ -16,6 +17,7 @@
 
 namespace {
 constexpr int kNumChannels = 84;
+constexpr int kMaxConvolverThreads = 8;
 constexpr std::complex<float> kZeroComplex{0.0f, 0.0f};
 #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
 using Clock = std::chrono::steady_clock;
@@ -63,13 +65,13 @@ inline void recordAccumulation(long long) {}
 #define SPCMIC_VECTORIZE
 #endif
 
-inline void accumulatePartition(const std::vector<std::complex<float>>& inputSpectrum,
-                                const std::vector<std::complex<float>>& irSpectrum,
-                                std::vector<std::complex<float>>& accumulator) {
-    const int bins = static_cast<int>(accumulator.size());
-    const float* input = reinterpret_cast<const float*>(inputSpectrum.data());
-    const float* ir = reinterpret_cast<const float*>(irSpectrum.data());
-    float* acc = reinterpret_cast<float*>(accumulator.data());
+inline void accumulatePartition(const std::complex<float>* inputSpectrum,
+                                const std::complex<float>* irSpectrum,
+                                std::complex<float>* accumulator,
+                                int bins) {
+    const float* input = reinterpret_cast<const float*>(inputSpectrum);
+    const float* ir = reinterpret_cast<const float*>(irSpectrum);
+    float* acc = reinterpret_cast<float*>(accumulator);
 
 #if defined(__ARM_NEON__) || defined(__ARM_NEON)
     int bin = 0;
@@ -123,32 +125,101 @@ MatrixConvolver::MatrixConvolver()
     : impulseResponse_(nullptr)
     , blockSize_(0)
     , ready_(false)
+    , mode_(Mode::Uniform)
+    , irOffset_(0)
+    , irSpan_(0)
     , fftSize_(0)
+    , spectrumBins_(0)
     , numPartitions_(0)
+    , numInputChannels_(0)
     , numOutputChannels_(0)
     , historyWritePos_(0)
+    , spectraCache_(nullptr)
+    , threadCount_(1)
+    , binSplits_(1)
+    , pendingInput_(nullptr)
+    , pendingOutput_(nullptr)
     , outputGain_(1.0f)
-    , singlePartition_(false) {
+    , tailBlockSize_(0)
+    , tailSlot_(0)
+    , tailFill_(0)
+    , tailPending_(false)
+    , tailPlayout_(false)
+    , tailJobQueued_(false)
+    , tailJobBusy_(false)
+    , tailJobSlot_(0)
+    , tailStopRequested_(false)
+    , tailLateLogged_(false) {
+}
+
+MatrixConvolver::~MatrixConvolver() {
+    stopTailStage();
 }
 
 bool MatrixConvolver::configure(const MatrixImpulseResponse* ir, int blockSizeFrames) {
-    if (!ir || !ir->isValid() || blockSizeFrames <= 0) {
-        impulseResponse_ = nullptr;
-        blockSize_ = 0;
-        ready_ = false;
-        channelStates_.clear();
-        channelIRs_.clear();
-        freqAccum_.clear();
-        overlap_.clear();
-        fftSize_ = 0;
-        numPartitions_ = 0;
-        numOutputChannels_ = 0;
-        historyWritePos_ = 0;
+    if (!ir || !ir->hasShape() || blockSizeFrames <= 0) {
+        clearConfiguration();
+        return false;
+    }
+
+    stopTailStage();
+    tail_.reset();
+    mode_ = Mode::Uniform;
+    return configureSpan(ir, blockSizeFrames, 0, ir->irLength);
+}
+
+bool MatrixConvolver::configureLowLatency(const MatrixImpulseResponse* ir,
+                                          int headBlockFrames,
+                                          int tailBlockFrames) {
+    if (!ir || !ir->hasShape() || headBlockFrames <= 0 || tailBlockFrames <= headBlockFrames ||
+        !FftEngine::isPowerOfTwo(static_cast<size_t>(headBlockFrames)) ||
+        !FftEngine::isPowerOfTwo(static_cast<size_t>(tailBlockFrames))) {
+        LOGE("Invalid low-latency partitioning: head=%d, tail=%d", headBlockFrames, tailBlockFrames);
+        clearConfiguration();
         return false;
     }
 
+    stopTailStage();
+    tail_.reset();
+
+    // The head covers two tail blocks: one while the tail input is collected
+    // and one while the helper convolves it.
+    const int headSpan = std::min(ir->irLength, 2 * tailBlockFrames);
+    if (!configureSpan(ir, headBlockFrames, 0, headSpan)) {
+        return false;
+    }
+    mode_ = Mode::LowLatency;
+
+    if (ir->irLength > headSpan) {
+        auto tail = std::make_unique<MatrixConvolver>();
+        tail->spectraCache_ = spectraCache_;
+        if (!tail->configureSpan(ir, tailBlockFrames, headSpan, ir->irLength - headSpan)) {
+            clearConfiguration();
+            return false;
+        }
+        tail->outputGain_ = outputGain_;
+        tail_ = std::move(tail);
+        if (!startTailStage()) {
+            clearConfiguration();
+            return false;
+        }
+    }
+
+    LOGD("MatrixConvolver low-latency mode: head %d x %d frames, tail %d x %d frames",
+         numPartitions_, blockSize_,
+         tail_ ? tail_->numPartitions_ : 0, tailBlockFrames);
+    return ready_;
+}
+
+bool MatrixConvolver::configureSpan(const MatrixImpulseResponse* ir,
+                                    int blockSizeFrames,
+                                    int irOffset,
+                                    int irSpan) {
     impulseResponse_ = ir;
     blockSize_ = blockSizeFrames;
+    irOffset_ = irOffset;
+    irSpan_ = irSpan;
+    numInputChannels_ = impulseResponse_->numInputChannels;
     numOutputChannels_ = impulseResponse_->numOutputChannels;
 
     if (numOutputChannels_ <= 0) {
@@ -164,7 +235,8 @@ bool MatrixConvolver::configure(const MatrixImpulseResponse* ir, int blockSizeFr
     }
 
     fftSize_ = blockSize_ * 2;
-    numPartitions_ = (impulseResponse_->irLength + blockSize_ - 1) / blockSize_;
+    spectrumBins_ = fftSize_ / 2 + 1;
+    numPartitions_ = (irSpan_ + blockSize_ - 1) / blockSize_;
 
     if (numPartitions_ <= 0) {
         LOGE("Invalid partition count");
@@ -172,64 +244,183 @@ bool MatrixConvolver::configure(const MatrixImpulseResponse* ir, int blockSizeFr
         return false;
     }
 
-    singlePartition_ = (numPartitions_ == 1);
+    if (!fft_.initialize(static_cast<size_t>(fftSize_))) {
+        LOGE("Failed to build FFT plan for size %d", fftSize_);
+        ready_ = false;
+        return false;
+    }
+
+    IRSpectra::Layout layout;
+    layout.sampleRate = impulseResponse_->sampleRate;
+    layout.numInputChannels = numInputChannels_;
+    layout.numOutputChannels = numOutputChannels_;
+    layout.irLength = impulseResponse_->irLength;
+    layout.blockSize = blockSize_;
+    layout.irOffset = irOffset_;
+    layout.irSpan = irSpan_;
+    layout.numPartitions = numPartitions_;
+    layout.spectrumBins = spectrumBins_;
+    layout.sourceHash = impulseResponse_->contentHash;
+
+    std::shared_ptr<const IRSpectra> cached;
+    if (spectraCache_) {
+        cached = spectraCache_->acquire(impulseResponse_->cacheKey, layout);
+    }
+    if (cached) {
+        irSpectra_ = std::move(cached);
+    } else if (!buildSpectra(layout)) {
+        ready_ = false;
+        return false;
+    }
+
+    allocateStreamingState();
+
+    LOGD("MatrixConvolver configured: sampleRate=%d, irFrames=%d+%d, partitions=%d, fftSize=%d, bins=%d%s",
+         impulseResponse_->sampleRate,
+         irOffset_,
+         irSpan_,
+         numPartitions_,
+         fftSize_,
+         spectrumBins_,
+         irSpectra_->isMapped() ? " (mapped spectra)" : "");
 
-    channelIRs_.assign(impulseResponse_->numInputChannels, ChannelIR{});
-    channelStates_.assign(impulseResponse_->numInputChannels, ChannelState{});
+    return ready_;
+}
 
-    for (auto& state : channelStates_) {
-        state.history.assign(numPartitions_, std::vector<std::complex<float>>(fftSize_, kZeroComplex));
+bool MatrixConvolver::buildSpectra(const IRSpectra::Layout& layout) {
+    if (!impulseResponse_->isValid()) {
+        // Only the IR header was loaded and the spectra are not cached.
+        LOGD("IR samples required for %d-frame partitions at offset %d", blockSize_, irOffset_);
+        return false;
     }
 
-    for (int ch = 0; ch < impulseResponse_->numInputChannels; ++ch) {
-        ChannelIR& channelIR = channelIRs_[ch];
-        channelIR.partitions.assign(static_cast<size_t>(numOutputChannels_) * numPartitions_,
-                                    std::vector<std::complex<float>>(fftSize_, kZeroComplex));
+    const size_t bins = static_cast<size_t>(spectrumBins_);
+    const size_t irLength = static_cast<size_t>(irSpan_);
+
+    std::vector<std::complex<float>> spectra(layout.complexCount(), kZeroComplex);
 
+    for (int p = 0; p < numPartitions_; ++p) {
+        const size_t partitionStart = static_cast<size_t>(p) * blockSize_;
+        const size_t partitionLength = std::min(static_cast<size_t>(blockSize_), irLength - partitionStart);
         for (int outCh = 0; outCh < numOutputChannels_; ++outCh) {
-            const size_t impulseOffset = (static_cast<size_t>(outCh) * impulseResponse_->numInputChannels +
-                                          static_cast<size_t>(ch)) * static_cast<size_t>(impulseResponse_->irLength);
-            for (int p = 0; p < numPartitions_; ++p) {
-                auto& partition = channelIR.partitions[static_cast<size_t>(outCh) * numPartitions_ + p];
-                for (int n = 0; n < blockSize_; ++n) {
-                    const size_t irIndex = impulseOffset + static_cast<size_t>(p) * blockSize_ + static_cast<size_t>(n);
-                    if (irIndex < impulseOffset + static_cast<size_t>(impulseResponse_->irLength)) {
-                        const float sample = impulseResponse_->impulseData[irIndex];
-                        partition[n] = std::complex<float>(sample, 0.0f);
-                    }
-                }
-                FftEngine::forward(partition);
+            for (int ch = 0; ch < numInputChannels_; ++ch) {
+                const float* impulse = impulseResponse_->impulseFor(outCh, ch) + irOffset_ + partitionStart;
+                std::complex<float>* spectrum = spectra.data() +
+                    ((static_cast<size_t>(p) * numOutputChannels_ + outCh) * numInputChannels_ + ch) * bins;
+                // Each slot holds fftSize_ + 2 floats, so the real transform can run in place.
+                float* samples = reinterpret_cast<float*>(spectrum);
+                std::copy_n(impulse, partitionLength, samples);
+                fft_.rfft(samples, spectrum);
             }
         }
     }
+    irSpectra_ = std::make_shared<const IRSpectra>(layout, std::move(spectra));
+    if (spectraCache_) {
+        spectraCache_->insert(impulseResponse_->cacheKey, irSpectra_);
+    }
+    return true;
+}
+
+bool MatrixConvolver::configureFrom(const MatrixConvolver& source) {
+    if (&source == this) {
+        return ready_;
+    }
+    if (!source.ready_ || !source.irSpectra_) {
+        clearConfiguration();
+        return false;
+    }
+
+    stopTailStage();
+    tail_.reset();
+
+    impulseResponse_ = source.impulseResponse_;
+    blockSize_ = source.blockSize_;
+    mode_ = source.mode_;
+    irOffset_ = source.irOffset_;
+    irSpan_ = source.irSpan_;
+    fftSize_ = source.fftSize_;
+    spectrumBins_ = source.spectrumBins_;
+    numPartitions_ = source.numPartitions_;
+    numInputChannels_ = source.numInputChannels_;
+    numOutputChannels_ = source.numOutputChannels_;
+    outputGain_ = source.outputGain_;
+    fft_ = source.fft_;
+    irSpectra_ = source.irSpectra_;
+
+    allocateStreamingState();
+
+    if (source.tail_) {
+        auto tail = std::make_unique<MatrixConvolver>();
+        if (!tail->configureFrom(*source.tail_)) {
+            clearConfiguration();
+            return false;
+        }
+        tail_ = std::move(tail);
+        if (!startTailStage()) {
+            clearConfiguration();
+            return false;
+        }
+    }
+    return ready_;
+}
 
-    freqAccum_.assign(numOutputChannels_, std::vector<std::complex<float>>(fftSize_, kZeroComplex));
-    overlap_.assign(numOutputChannels_, std::vector<float>(blockSize_, 0.0f));
+void MatrixConvolver::clearConfiguration() {
+    stopTailStage();
+    tail_.reset();
+    impulseResponse_ = nullptr;
+    blockSize_ = 0;
+    ready_ = false;
+    mode_ = Mode::Uniform;
+    irOffset_ = 0;
+    irSpan_ = 0;
+    inputHistory_.clear();
+    irSpectra_.reset();
+    freqAccum_.clear();
+    overlap_.clear();
+    fftSize_ = 0;
+    spectrumBins_ = 0;
+    numPartitions_ = 0;
+    numInputChannels_ = 0;
+    numOutputChannels_ = 0;
     historyWritePos_ = 0;
+}
 
+void MatrixConvolver::allocateStreamingState() {
+    const size_t bins = static_cast<size_t>(spectrumBins_);
+    inputHistory_.assign(static_cast<size_t>(numInputChannels_) * numPartitions_ * bins, kZeroComplex);
+    freqAccum_.assign(static_cast<size_t>(numOutputChannels_) * bins, kZeroComplex);
+    overlap_.assign(static_cast<size_t>(numOutputChannels_) * blockSize_, 0.0f);
+    historyWritePos_ = 0;
+    updateBinSplits();
     ready_ = true;
+}
 
-    LOGD("MatrixConvolver configured: sampleRate=%d, irLength=%d, partitions=%d, fftSize=%d",
-         impulseResponse_->sampleRate,
-         impulseResponse_->irLength,
-         numPartitions_,
-         fftSize_);
+void MatrixConvolver::reset() {
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    std::fill(inputHistory_.begin(), inputHistory_.end(), kZeroComplex);
+    historyWritePos_ = 0;
+    resetTailStage();
+}
 
-    reset();
-    return ready_;
+void MatrixConvolver::setOutputGain(float gain) {
+    outputGain_ = gain;
+    if (tail_) {
+        tail_->setOutputGain(gain);
+    }
 }
 
-void MatrixConvolver::reset() {
-    for (auto& overlapChannel : overlap_) {
-        std::fill(overlapChannel.begin(), overlapChannel.end(), 0.0f);
+void MatrixConvolver::setSpectraCache(IRSpectraCache* cache) {
+    spectraCache_ = cache;
+    if (tail_) {
+        tail_->setSpectraCache(cache);
     }
-    historyWritePos_ = 0;
+}
 
-    for (auto& state : channelStates_) {
-        for (auto& block : state.history) {
-            std::fill(block.begin(), block.end(), kZeroComplex);
-        }
+int MatrixConvolver::tailBlockCount() const {
+    if (mode_ == Mode::LowLatency && impulseResponse_ && blockSize_ > 0) {
+        return (impulseResponse_->irLength + blockSize_ - 1) / blockSize_;
     }
+    return numPartitions_;
 }
 
 void MatrixConvolver::process(const float* input, float* output, int numFrames) {
@@ -244,92 +435,276 @@ void MatrixConvolver::process(const float* input, float* output, int numFrames)
         return;
     }
 
-    for (auto& accum : freqAccum_) {
-        std::fill(accum.begin(), accum.end(), kZeroComplex);
-    }
+    pendingInput_ = input;
+    pendingOutput_ = output;
 
-    const int numChannels = impulseResponse_->numInputChannels;
+    // Phase 1: transform the new block of every input into its delay-line slot.
+    runTasks(numInputChannels_, &MatrixConvolver::forwardTask);
 
     #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
-    long long accumulateMicros = 0;
+    const auto accumStart = Clock::now();
     #endif
 
-    if (singlePartition_) {
-        for (int ch = 0; ch < numChannels; ++ch) {
-            auto& spectrum = channelStates_[ch].history[0];
+    // Phase 2: one multiply-accumulate pass per output (or output bin range)
+    // across every partition and input. Each accumulator has a single writer.
+    runTasks(numOutputChannels_ * binSplits_, &MatrixConvolver::accumulateTask);
 
-            for (int frame = 0; frame < blockSize_; ++frame) {
-                spectrum[frame] = std::complex<float>(input[frame * numChannels + ch], 0.0f);
-            }
-            std::fill(spectrum.begin() + blockSize_, spectrum.end(), kZeroComplex);
+    #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
+    recordAccumulation(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - accumStart).count());
+    #endif
 
-            FftEngine::forward(spectrum);
+    // Phase 3: inverse FFT and overlap-add per output.
+    runTasks(numOutputChannels_, &MatrixConvolver::synthesizeTask);
 
-            #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
-            const auto accumStart = Clock::now();
-            #endif
-            for (int outCh = 0; outCh < numOutputChannels_; ++outCh) {
-                const auto& irPartition = channelIRs_[ch].partitions[static_cast<size_t>(outCh) * numPartitions_];
-                accumulatePartition(spectrum, irPartition, freqAccum_[outCh]);
-            }
-            #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
-            accumulateMicros += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - accumStart).count();
-            #endif
+    historyWritePos_ = (historyWritePos_ + 1) % numPartitions_;
+    pendingInput_ = nullptr;
+    pendingOutput_ = nullptr;
+
+    if (tail_) {
+        processTailStage(input, output);
+    }
+}
+
+bool MatrixConvolver::startTailStage() {
+    tailBlockSize_ = tail_->blockSize_;
+    tailInput_.assign(static_cast<size_t>(2) * tailBlockSize_ * numInputChannels_, 0.0f);
+    tailOutput_.assign(static_cast<size_t>(2) * tailBlockSize_ * numOutputChannels_, 0.0f);
+    tailSlot_ = 0;
+    tailFill_ = 0;
+    tailPending_ = false;
+    tailPlayout_ = false;
+    tailJobQueued_ = false;
+    tailJobBusy_ = false;
+    tailStopRequested_ = false;
+    tailLateLogged_ = false;
+
+    try {
+        tailThread_ = std::thread(&MatrixConvolver::tailLoop, this);
+    } catch (const std::system_error& e) {
+        LOGE("Failed to start tail convolution thread: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+void MatrixConvolver::stopTailStage() {
+    if (!tailThread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(tailMutex_);
+        tailStopRequested_ = true;
+    }
+    tailCv_.notify_all();
+    tailThread_.join();
+
+    tailStopRequested_ = false;
+    tailJobQueued_ = false;
+    tailJobBusy_ = false;
+    tailPending_ = false;
+    tailPlayout_ = false;
+}
+
+void MatrixConvolver::resetTailStage() {
+    if (!tail_) {
+        return;
+    }
+    if (tailPending_) {
+        waitForTailJob();
+    }
+    tail_->reset();
+    tailSlot_ = 0;
+    tailFill_ = 0;
+    tailPending_ = false;
+    tailPlayout_ = false;
+}
+
+void MatrixConvolver::tailLoop() {
+    thread_config::configureCurrentThread(thread_config::Role::Convolver);
+
+    const size_t inputStride = static_cast<size_t>(tailBlockSize_) * numInputChannels_;
+    const size_t outputStride = static_cast<size_t>(tailBlockSize_) * numOutputChannels_;
+
+    std::unique_lock<std::mutex> lock(tailMutex_);
+    while (true) {
+        tailCv_.wait(lock, [this]() { return tailStopRequested_ || tailJobQueued_; });
+        if (tailStopRequested_) {
+            break;
         }
-    } else {
-        for (int ch = 0; ch < numChannels; ++ch) {
-            auto& historyBlocks = channelStates_[ch].history;
-            auto& spectrum = historyBlocks[historyWritePos_];
+        tailJobQueued_ = false;
+        const size_t slot = static_cast<size_t>(tailJobSlot_);
+        lock.unlock();
 
-            for (int frame = 0; frame < blockSize_; ++frame) {
-                spectrum[frame] = std::complex<float>(input[frame * numChannels + ch], 0.0f);
-            }
-            std::fill(spectrum.begin() + blockSize_, spectrum.end(), kZeroComplex);
-
-            FftEngine::forward(spectrum);
-
-            const ChannelIR& channelIR = channelIRs_[ch];
-
-            #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
-            const auto accumStart = Clock::now();
-            #endif
-            for (int p = 0; p < numPartitions_; ++p) {
-                const int histIndex = (historyWritePos_ - p + numPartitions_) % numPartitions_;
-                const auto& inputSpectrum = historyBlocks[histIndex];
-                for (int outCh = 0; outCh < numOutputChannels_; ++outCh) {
-                    const auto& irSpectrum = channelIR.partitions[static_cast<size_t>(outCh) * numPartitions_ + p];
-                    accumulatePartition(inputSpectrum, irSpectrum, freqAccum_[outCh]);
-                }
-            }
-            #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
-            accumulateMicros += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - accumStart).count();
-            #endif
+        tail_->process(tailInput_.data() + slot * inputStride,
+                       tailOutput_.data() + slot * outputStride,
+                       tailBlockSize_);
+
+        lock.lock();
+        tailJobBusy_ = false;
+        tailDoneCv_.notify_all();
+    }
+}
+
+void MatrixConvolver::waitForTailJob() {
+    std::unique_lock<std::mutex> lock(tailMutex_);
+    if (tailJobBusy_ && !tailLateLogged_) {
+        // The job had a whole tail block of time; the head now waits for it.
+        LOGW("Tail convolution missed its deadline (tail block %d frames)", tailBlockSize_);
+        tailLateLogged_ = true;
+    }
+    tailDoneCv_.wait(lock, [this]() { return !tailJobBusy_; });
+}
+
+void MatrixConvolver::processTailStage(const float* input, float* output) {
+    const int numInputs = numInputChannels_;
+    const int numOutputs = numOutputChannels_;
+    const size_t slotOffset = static_cast<size_t>(tailSlot_) * tailBlockSize_ + tailFill_;
+
+    if (tailPlayout_) {
+        const float* playout = tailOutput_.data() + slotOffset * numOutputs;
+        const size_t samples = static_cast<size_t>(blockSize_) * numOutputs;
+        for (size_t i = 0; i < samples; ++i) {
+            output[i] += playout[i];
         }
+    }
 
-        historyWritePos_ = (historyWritePos_ + 1) % numPartitions_;
+    std::copy_n(input, static_cast<size_t>(blockSize_) * numInputs, tailInput_.data() + slotOffset * numInputs);
+    tailFill_ += blockSize_;
+    if (tailFill_ < tailBlockSize_) {
+        return;
     }
 
-    // Inverse FFT to obtain time-domain output
-    for (int outCh = 0; outCh < numOutputChannels_; ++outCh) {
-        FftEngine::inverse(freqAccum_[outCh]);
+    // The job handed over one tail block ago covers the next tail block of output.
+    const bool hadPending = tailPending_;
+    if (hadPending) {
+        waitForTailJob();
+    }
+    {
+        std::lock_guard<std::mutex> lock(tailMutex_);
+        tailJobSlot_ = tailSlot_;
+        tailJobQueued_ = true;
+        tailJobBusy_ = true;
     }
+    tailCv_.notify_one();
 
-    for (int frame = 0; frame < blockSize_; ++frame) {
-        for (int outCh = 0; outCh < numOutputChannels_; ++outCh) {
-            const float value = (freqAccum_[outCh][frame].real() + overlap_[outCh][frame]) * outputGain_;
-            output[frame * numOutputChannels_ + outCh] = value;
+    tailPending_ = true;
+    tailPlayout_ = hadPending;
+    tailSlot_ ^= 1;
+    tailFill_ = 0;
+}
+
+void MatrixConvolver::setThreadCount(int threads) {
+    const int requested = std::max(1, std::min(threads, kMaxConvolverThreads));
+    if (requested == threadCount_) {
+        return;
+    }
+
+    workerPool_.reset();
+    threadCount_ = 1;
+    if (requested > 1) {
+        auto pool = std::make_unique<WorkerPool>();
+        if (pool->start(requested)) {
+            workerPool_ = std::move(pool);
+            threadCount_ = requested;
+        } else {
+            LOGW("Falling back to single-threaded convolution");
         }
     }
+    updateBinSplits();
+    LOGD("MatrixConvolver using %d thread(s), %d bin split(s) per output", threadCount_, binSplits_);
+}
 
-    for (int frame = 0; frame < blockSize_; ++frame) {
-        for (int outCh = 0; outCh < numOutputChannels_; ++outCh) {
-            overlap_[outCh][frame] = freqAccum_[outCh][frame + blockSize_].real();
+void MatrixConvolver::updateBinSplits() {
+    binSplits_ = 1;
+    if (threadCount_ > 1 && numOutputChannels_ > 0 && numOutputChannels_ < threadCount_) {
+        // Few outputs (stereo): also split each accumulator by bin range.
+        binSplits_ = (threadCount_ + numOutputChannels_ - 1) / numOutputChannels_;
+    }
+}
+
+void MatrixConvolver::runTasks(int taskCount, void (*task)(void*, int)) {
+    if (workerPool_) {
+        workerPool_->run(taskCount, task, this);
+        return;
+    }
+    for (int i = 0; i < taskCount; ++i) {
+        task(this, i);
+    }
+}
+
+void MatrixConvolver::forwardTask(void* context, int ch) {
+    auto* self = static_cast<MatrixConvolver*>(context);
+    const size_t bins = static_cast<size_t>(self->spectrumBins_);
+    const size_t historyStride = static_cast<size_t>(self->numPartitions_) * bins;
+    const int numChannels = self->numInputChannels_;
+    const float* input = self->pendingInput_;
+
+    std::complex<float>* spectrum = self->inputHistory_.data() + ch * historyStride +
+                                    static_cast<size_t>(self->historyWritePos_) * bins;
+    float* samples = reinterpret_cast<float*>(spectrum);
+    for (int frame = 0; frame < self->blockSize_; ++frame) {
+        samples[frame] = input[frame * numChannels + ch];
+    }
+    std::fill(samples + self->blockSize_, samples + self->fftSize_, 0.0f);
+    self->fft_.rfft(samples, spectrum);
+}
+
+void MatrixConvolver::accumulateTask(void* context, int taskIndex) {
+    auto* self = static_cast<MatrixConvolver*>(context);
+    const int outCh = taskIndex / self->binSplits_;
+    const int split = taskIndex % self->binSplits_;
+    const int bins = self->spectrumBins_;
+    const size_t historyStride = static_cast<size_t>(self->numPartitions_) * bins;
+    const int numChannels = self->numInputChannels_;
+    const int numPartitions = self->numPartitions_;
+
+    // Split points are multiples of four so every bin goes through the same
+    // (vector or scalar) arithmetic regardless of thread count.
+    const int chunk = ((bins + self->binSplits_ - 1) / self->binSplits_ + 3) & ~3;
+    const int binStart = std::min(bins, split * chunk);
+    const int binEnd = std::min(bins, binStart + chunk);
+    if (binStart >= binEnd) {
+        return;
+    }
+    const int count = binEnd - binStart;
+
+    std::complex<float>* accum = self->freqAccum_.data() + static_cast<size_t>(outCh) * bins + binStart;
+    std::fill(accum, accum + count, kZeroComplex);
+    for (int p = 0; p < numPartitions; ++p) {
+        int slot = self->historyWritePos_ - p;
+        if (slot < 0) {
+            slot += numPartitions;
+        }
+        const std::complex<float>* history = self->inputHistory_.data() + static_cast<size_t>(slot) * bins + binStart;
+        const std::complex<float>* irSpectrum = self->irSpectra_->data() +
+            (static_cast<size_t>(p) * self->numOutputChannels_ + outCh) * numChannels * bins + binStart;
+        for (int ch = 0; ch < numChannels; ++ch) {
+            accumulatePartition(history + ch * historyStride,
+                                irSpectrum + static_cast<size_t>(ch) * bins,
+                                accum,
+                                count);
         }
     }
+}
 
-    #if defined(SPCMIC_ENABLE_ACCUM_TIMING)
-    recordAccumulation(accumulateMicros);
-    #endif
+void MatrixConvolver::synthesizeTask(void* context, int outCh) {
+    auto* self = static_cast<MatrixConvolver*>(context);
+    const size_t bins = static_cast<size_t>(self->spectrumBins_);
+    const int numOutputs = self->numOutputChannels_;
+    const int blockSize = self->blockSize_;
+    const float gain = self->outputGain_;
+    float* output = self->pendingOutput_;
+
+    // irfft runs in place; the accumulator then holds fftSize_ time-domain samples.
+    std::complex<float>* accum = self->freqAccum_.data() + static_cast<size_t>(outCh) * bins;
+    float* timeDomain = reinterpret_cast<float*>(accum);
+    self->fft_.irfft(accum, timeDomain);
+
+    float* overlap = self->overlap_.data() + static_cast<size_t>(outCh) * blockSize;
+    for (int frame = 0; frame < blockSize; ++frame) {
+        output[frame * numOutputs + outCh] = (timeDomain[frame] + overlap[frame]) * gain;
+        overlap[frame] = timeDomain[frame + blockSize];
+    }
 }
 
 void MatrixConvolver::fallbackDownmix(const float* input, float* output, int numFrames) const {
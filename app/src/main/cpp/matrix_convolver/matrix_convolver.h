@@ -1,28 +1,72 @@
 #ifndef SPCMIC_MATRIX_CONVOLVER_H
 #define SPCMIC_MATRIX_CONVOLVER_H
 
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <complex>
+#include "matrix_convolver/fft_engine.h"
 #include "matrix_convolver/ir_data.h"
+#include "matrix_convolver/ir_spectra_cache.h"
+#include "matrix_convolver/worker_pool.h"
 
 namespace spcmic {
 
 class MatrixConvolver {
 public:
+    enum class Mode {
+        Uniform,    // one partition size; latency = block size
+        LowLatency  // small head partitions inline, large tail partitions on a background thread
+    };
+
     MatrixConvolver();
+    ~MatrixConvolver();
+
+    MatrixConvolver(const MatrixConvolver&) = delete;
+    MatrixConvolver& operator=(const MatrixConvolver&) = delete;
 
     /**
      * Configure the convolver with the impulse response data and block size.
-     * The impulse response object must outlive the convolver.
+     * The impulse response object must outlive the convolver. With a spectra
+     * cache set, an IR without samples is enough when its spectra are cached;
+     * otherwise configuration fails and the caller loads the samples and retries.
      */
     bool configure(const MatrixImpulseResponse* ir, int blockSizeFrames);
 
+    /**
+     * Configure the two-stage low-latency mode. The first 2 * tailBlockFrames
+     * of the IR run in headBlockFrames partitions inside process(); the rest
+     * runs in tailBlockFrames partitions on a helper thread, which has one
+     * tail block of time per job. process() then takes headBlockFrames and
+     * the output is the same convolution as the uniform mode.
+     */
+    bool configureLowLatency(const MatrixImpulseResponse* ir, int headBlockFrames, int tailBlockFrames);
+
+    /**
+     * Configure with the same IR and block size as @p source, sharing its
+     * precomputed IR spectra (read-only) and allocating fresh streaming state.
+     */
+    bool configureFrom(const MatrixConvolver& source);
+
     void reset();
 
     [[nodiscard]] bool isReady() const { return ready_; }
 
-    void setOutputGain(float gain) { outputGain_ = gain; }
+    void setOutputGain(float gain);
+
+    /** Look up and store partition spectra in @p cache (null disables caching). */
+    void setSpectraCache(IRSpectraCache* cache);
+
+    /**
+     * Number of threads used by process(), including the caller. 1 (the
+     * default) keeps everything on the calling thread. Output is identical
+     * for every thread count. Must not be called concurrently with process().
+     */
+    void setThreadCount(int threads);
+    [[nodiscard]] int threadCount() const { return threadCount_; }
 
     /**
      * Process a block of multichannel input.
@@ -32,34 +76,92 @@ public:
      */
     void process(const float* input, float* output, int numFrames);
 
-private:
-    struct ChannelState {
-        std::vector<std::vector<std::complex<float>>> history; // [partition][fftBin]
-    };
+    /** Number of blocks needed after the last input block to flush the IR tail. */
+    [[nodiscard]] int tailBlockCount() const;
 
-    struct ChannelIR {
-        std::vector<std::vector<std::complex<float>>> partitions; // [outputIndex * numPartitions_ + partition]
-    };
+    [[nodiscard]] Mode mode() const { return mode_; }
+    [[nodiscard]] int blockSize() const { return blockSize_; }
+    [[nodiscard]] int numOutputChannels() const { return numOutputChannels_; }
 
+private:
     void fallbackDownmix(const float* input, float* output, int numFrames) const;
+    bool configureSpan(const MatrixImpulseResponse* ir, int blockSizeFrames, int irOffset, int irSpan);
+    bool buildSpectra(const IRSpectra::Layout& layout);
+    void clearConfiguration();
+    void allocateStreamingState();
+    void updateBinSplits();
+    void runTasks(int taskCount, void (*task)(void*, int));
+
+    static void forwardTask(void* context, int channel);
+    static void accumulateTask(void* context, int taskIndex);
+    static void synthesizeTask(void* context, int outputChannel);
+
+    // Low-latency tail stage
+    bool startTailStage();
+    void stopTailStage();
+    void resetTailStage();
+    void tailLoop();
+    void waitForTailJob();
+    void processTailStage(const float* input, float* output);
 
     const MatrixImpulseResponse* impulseResponse_;
     int blockSize_;
     bool ready_;
+    Mode mode_;
+    int irOffset_; // IR frames [irOffset_, irOffset_ + irSpan_) are handled by this stage
+    int irSpan_;
 
     int fftSize_;
+    int spectrumBins_; // fftSize_ / 2 + 1 (real-input half spectrum)
     int numPartitions_;
+    int numInputChannels_;
     int numOutputChannels_;
     int historyWritePos_;
 
-    std::vector<ChannelState> channelStates_;
-    std::vector<ChannelIR> channelIRs_;
+    FftEngine fft_; // fftSize_-point plan, built once per configure()
+
+    // Frequency-domain delay line: [input][slot][bin], one contiguous ring of
+    // numPartitions_ spectra per input channel.
+    std::vector<std::complex<float>> inputHistory_;
+    // IR spectra stored partition-major: [partition][output][input][bin], so one
+    // output's accumulation walks memory linearly for each partition. Immutable
+    // once built, so convolvers created with configureFrom() and the spectra
+    // cache share it.
+    std::shared_ptr<const IRSpectra> irSpectra_;
+    IRSpectraCache* spectraCache_;
 
-    std::vector<std::vector<std::complex<float>>> freqAccum_;
-    std::vector<std::vector<float>> overlap_;
+    std::vector<std::complex<float>> freqAccum_; // [output][bin]
+    std::vector<float> overlap_;                 // [output][blockSize]
+
+    std::unique_ptr<WorkerPool> workerPool_;
+    int threadCount_;
+    int binSplits_; // accumulation tasks per output
+    const float* pendingInput_;
+    float* pendingOutput_;
 
     float outputGain_;
-    bool singlePartition_;
+
+    // Low-latency mode: tail_ convolves IR[2 * tailBlock, end) one tail block
+    // behind. While job k runs on the helper in one slot, input block k + 1 is
+    // collected in the other slot and job k - 1's output is played out of it.
+    std::unique_ptr<MatrixConvolver> tail_;
+    int tailBlockSize_;
+    std::vector<float> tailInput_;  // [slot][frame][input]
+    std::vector<float> tailOutput_; // [slot][frame][output]
+    int tailSlot_;                  // slot being filled and played out
+    int tailFill_;                  // frames collected in that slot
+    bool tailPending_;              // a job was handed to the helper and not yet collected
+    bool tailPlayout_;              // tailOutput_[tailSlot_] holds the current tail block
+
+    std::thread tailThread_;
+    std::mutex tailMutex_;
+    std::condition_variable tailCv_;
+    std::condition_variable tailDoneCv_;
+    bool tailJobQueued_;
+    bool tailJobBusy_;
+    int tailJobSlot_;
+    bool tailStopRequested_;
+    bool tailLateLogged_;
 };
 
 } // namespace spcmic
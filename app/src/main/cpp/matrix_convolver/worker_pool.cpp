@@ -0,0 +1,176 @@
+#include "matrix_convolver/worker_pool.h"
+
+#include "thread_config.h"
+
+#include <android/log.h>
+#include <system_error>
+#ifdef SPCMIC_WORKER_POOL_WAKE_DELAY_US
+#include <chrono>
+#endif
+
+#define LOG_TAG "WorkerPool"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr uint64_t kTaskIndexMask = 0xFFFFFFFFull;
+
+inline uint64_t generationTag(uint64_t generation) {
+    return (generation & kTaskIndexMask) << 32;
+}
+
+} // namespace
+
+namespace spcmic {
+
+WorkerPool::WorkerPool()
+    : generation_(0)
+    , stopRequested_(false)
+    , taskFn_(nullptr)
+    , taskContext_(nullptr)
+    , taskCount_(0)
+    , nextTask_(0)
+    , pendingTasks_(0) {
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::start(int threadCount) {
+    stop();
+
+    if (threadCount <= 1) {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = false;
+    }
+
+    try {
+        workers_.reserve(static_cast<size_t>(threadCount - 1));
+        for (int i = 0; i < threadCount - 1; ++i) {
+            workers_.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    } catch (const std::system_error& e) {
+        LOGE("Failed to start worker thread: %s", e.what());
+        stop();
+        return false;
+    }
+
+    LOGD("Worker pool started with %d threads", threadCount);
+    return true;
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    workCv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+void WorkerPool::run(int taskCount, TaskFn fn, void* context) {
+    if (taskCount <= 0 || !fn) {
+        return;
+    }
+
+    if (workers_.empty() || taskCount == 1) {
+        for (int i = 0; i < taskCount; ++i) {
+            fn(context, i);
+        }
+        return;
+    }
+
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation = ++generation_;
+        taskFn_ = fn;
+        taskContext_ = context;
+        taskCount_ = taskCount;
+        pendingTasks_.store(taskCount, std::memory_order_relaxed);
+        nextTask_.store(generationTag(generation), std::memory_order_relaxed);
+    }
+    workCv_.notify_all();
+
+    drainTasks(generation, fn, context, taskCount);
+
+    // Only claims tagged with this generation count down pendingTasks_, so a
+    // helper still holding an older generation can neither delay nor end the wait.
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this]() {
+        return pendingTasks_.load(std::memory_order_acquire) == 0;
+    });
+}
+
+bool WorkerPool::claimTask(uint64_t generation, int taskCount, int& index) {
+    const uint64_t tag = generationTag(generation);
+    uint64_t current = nextTask_.load(std::memory_order_relaxed);
+    while ((current & ~kTaskIndexMask) == tag && (current & kTaskIndexMask) < static_cast<uint64_t>(taskCount)) {
+        if (nextTask_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+            index = static_cast<int>(current & kTaskIndexMask);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::drainTasks(uint64_t generation, TaskFn fn, void* context, int taskCount) {
+    int index = 0;
+    while (claimTask(generation, taskCount, index)) {
+        fn(context, index);
+        if (pendingTasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            doneCv_.notify_all();
+        }
+    }
+}
+
+void WorkerPool::workerLoop() {
+    // Helpers run the convolver's partitions, so they must not sit below it
+    thread_config::configureCurrentThread(thread_config::Role::Convolver);
+
+    uint64_t seenGeneration = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seenGeneration = generation_;
+    }
+
+    while (true) {
+        TaskFn fn = nullptr;
+        void* context = nullptr;
+        int taskCount = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workCv_.wait(lock, [this, seenGeneration]() {
+                return stopRequested_ || generation_ != seenGeneration;
+            });
+            if (stopRequested_) {
+                return;
+            }
+            seenGeneration = generation_;
+            fn = taskFn_;
+            context = taskContext_;
+            taskCount = taskCount_;
+        }
+
+#ifdef SPCMIC_WORKER_POOL_WAKE_DELAY_US
+        // Stress builds only: widen the gap between picking up a phase and claiming its tasks.
+        std::this_thread::sleep_for(std::chrono::microseconds(SPCMIC_WORKER_POOL_WAKE_DELAY_US));
+#endif
+        drainTasks(seenGeneration, fn, context, taskCount);
+    }
+}
+
+} // namespace spcmic
@@ -0,0 +1,64 @@
+#ifndef SPCMIC_WORKER_POOL_H
+#define SPCMIC_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace spcmic {
+
+/**
+ * Small fork/join pool for per-block parallel work. run() hands out task
+ * indices to the helper threads and the calling thread, and returns once
+ * every task has finished, which doubles as the per-phase barrier.
+ *
+ * Task indices are claimed from a counter tagged with the generation of the
+ * run() that published them, so a helper that wakes late for a finished
+ * phase cannot claim work from the next one with the old task function.
+ */
+class WorkerPool {
+public:
+    using TaskFn = void (*)(void* context, int taskIndex);
+
+    WorkerPool();
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /** Start @p threadCount - 1 helper threads; the caller of run() is the last one. */
+    bool start(int threadCount);
+    void stop();
+
+    /** Total participating threads, including the caller. */
+    [[nodiscard]] int threadCount() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /** Execute fn(context, i) for every i in [0, taskCount) and wait for all of them. */
+    void run(int taskCount, TaskFn fn, void* context);
+
+private:
+    void workerLoop();
+    void drainTasks(uint64_t generation, TaskFn fn, void* context, int taskCount);
+    bool claimTask(uint64_t generation, int taskCount, int& index);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable workCv_;
+    std::condition_variable doneCv_;
+    uint64_t generation_;
+    bool stopRequested_;
+
+    TaskFn taskFn_;
+    void* taskContext_;
+    int taskCount_;
+    std::atomic<uint64_t> nextTask_;  // generation in the high 32 bits, next task index in the low 32
+    std::atomic<int> pendingTasks_;
+};
+
+} // namespace spcmic
+
+#endif // SPCMIC_WORKER_POOL_H
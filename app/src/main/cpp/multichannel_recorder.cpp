@@ -1,8 +1,12 @@
 #include "multichannel_recorder.h"
+#include "pcm24.h"
+#include "thread_config.h"
 #include <android/log.h>
 #include <chrono>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 
 #define LOG_TAG "MultichannelRecorder"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -17,6 +21,10 @@
 MultichannelRecorder::MultichannelRecorder(USBAudioInterface* audioInterface)
     : m_audioInterface(audioInterface)
     , m_wavWriter(nullptr)
+    , m_segmentMaxSeconds(0.0f)
+    , m_segmentMaxBytes(0)
+    , m_lastSegmentIndex(0)
+    , m_losslessCompression(false)
     , m_isMonitoring(false)
     , m_isRecording(false)
     , m_totalSamples(0)
@@ -28,12 +36,22 @@ MultichannelRecorder::MultichannelRecorder(USBAudioInterface* audioInterface)
     , m_peakLevel(0.0f)
     , m_gainLinear(1.0f)
     , m_targetGainLinear(1.0f)
-    , m_gainSmoothingCoeff(0.0f) {
+    , m_gainSmoothingCoeff(0.0f)
+    , m_packCarryBytes(0)
+    , m_meterFrames(0)
+    , m_meterSequence(0)
+    , m_preRollSeconds(0.0f)
+    , m_preRollWritePos(0)
+    , m_preRollFilled(0)
+    , m_preRollFlushPos(0)
+    , m_preRollFlushRemaining(0)
+    , m_preRollFrozen(false) {
+    resetChannelMeters();
     
     // Calculate gain smoothing coefficient for ~50ms transition time
     // coefficient = 1 - exp(-bufferDuration / smoothingTime)
     // Assuming typical buffer: 1024 samples = ~21ms @ 48kHz
-    const float typicalBufferDuration = 1024.0f / static_cast<float>(m_sampleRate);
+    const float typicalBufferDuration = TYPICAL_BUFFER_FRAMES / static_cast<float>(m_sampleRate);
     const float smoothingTime = 0.05f;  // 50ms target smoothing time
     m_gainSmoothingCoeff = 1.0f - std::exp(-typicalBufferDuration / smoothingTime);
     
@@ -63,6 +81,7 @@ MultichannelRecorder::~MultichannelRecorder() {
     }
     
     // Now it's safe to clean up other resources.
+    closeOverview();
     if (m_wavWriter) {
         // Closing the writer handles the final flush and header update
         m_wavWriter->close();
@@ -97,6 +116,8 @@ bool MultichannelRecorder::startMonitoring(float gainDb) {
     // Reset clip indicator
     m_clipDetected.store(false);
     m_peakLevel.store(0.0f);
+    resetChannelMeters();
+    m_stats.reset();
     
     // Start USB streaming
     if (!m_audioInterface->startStreaming()) {
@@ -127,6 +148,19 @@ bool MultichannelRecorder::startMonitoring(float gainDb) {
     
     LOGI("Starting monitoring (sampleRate=%d Hz, gain=%.1f dB, bufferSize=%zu bytes)", 
          m_sampleRate, gainDb, m_bufferSize);
+
+    // Pre-record history is allocated up front so the audio thread never does
+    const size_t preRollFrames = static_cast<size_t>(m_preRollSeconds * static_cast<float>(m_sampleRate));
+    m_preRoll.assign(preRollFrames * frameSize, 0);
+    m_preRoll.shrink_to_fit();
+    m_preRollWritePos = 0;
+    m_preRollFilled = 0;
+    m_preRollFlushPos = 0;
+    m_preRollFlushRemaining = 0;
+    m_preRollFrozen.store(false, std::memory_order_relaxed);
+    if (!m_preRoll.empty()) {
+        LOGI("Pre-record history: %.1f s (%zu KB)", m_preRollSeconds, m_preRoll.size() / 1024);
+    }
     
     // Start streaming thread (no WAV writer, no ring buffer)
     m_isMonitoring.store(true);
@@ -165,8 +199,8 @@ bool MultichannelRecorder::startRecordingFromMonitoring(const std::string& outpu
     LOGI("Transitioning from monitoring to recording: %s", outputPath.c_str());
     
     // Create and open WAV writer
-    m_wavWriter = new WAVWriter();
-    if (!m_wavWriter->open(outputPath, m_sampleRate, CHANNEL_COUNT, BYTES_PER_SAMPLE * 8)) {
+    m_wavWriter = createWavWriter();
+    if (!m_wavWriter->open(outputPath, m_sampleRate, storedChannelCount(), BYTES_PER_SAMPLE * 8)) {
         LOGE("Failed to open WAV file for recording transition");
         delete m_wavWriter;
         m_wavWriter = nullptr;
@@ -174,7 +208,16 @@ bool MultichannelRecorder::startRecordingFromMonitoring(const std::string& outpu
     }
     
     // Create ring buffer for disk writes
-    m_ringBuffer = new LockFreeRingBuffer(RING_BUFFER_SIZE);
+    m_ringBuffer = createRingBuffer();
+    if (!m_ringBuffer) {
+        LOGE("Failed to allocate recording ring buffer");
+        m_wavWriter->close();
+        delete m_wavWriter;
+        m_wavWriter = nullptr;
+        return false;
+    }
+    m_stats.set(RecordingStats::RingCapacityBytes, static_cast<int64_t>(m_ringBuffer->getCapacity()));
+    openOverview(outputPath);
     
     // Start disk write thread
     m_diskThreadRunning.store(true);
@@ -207,8 +250,8 @@ bool MultichannelRecorder::startRecordingFromMonitoringWithFd(int fd, const std:
     LOGI("Transitioning from monitoring to recording (FD): %s", displayPath.c_str());
     
     // Create and open WAV writer with file descriptor
-    m_wavWriter = new WAVWriter();
-    if (!m_wavWriter->openFromFd(fd, m_sampleRate, CHANNEL_COUNT, BYTES_PER_SAMPLE * 8)) {
+    m_wavWriter = createWavWriter();
+    if (!m_wavWriter->openFromFd(fd, m_sampleRate, storedChannelCount(), BYTES_PER_SAMPLE * 8, displayPath)) {
         LOGE("Failed to open WAV file from FD for recording transition");
         delete m_wavWriter;
         m_wavWriter = nullptr;
@@ -216,7 +259,16 @@ bool MultichannelRecorder::startRecordingFromMonitoringWithFd(int fd, const std:
     }
     
     // Create ring buffer for disk writes
-    m_ringBuffer = new LockFreeRingBuffer(RING_BUFFER_SIZE);
+    m_ringBuffer = createRingBuffer();
+    if (!m_ringBuffer) {
+        LOGE("Failed to allocate recording ring buffer");
+        m_wavWriter->close();
+        delete m_wavWriter;
+        m_wavWriter = nullptr;
+        return false;
+    }
+    m_stats.set(RecordingStats::RingCapacityBytes, static_cast<int64_t>(m_ringBuffer->getCapacity()));
+    openOverview(displayPath);
     
     // Start disk write thread
     m_diskThreadRunning.store(true);
@@ -249,6 +301,9 @@ bool MultichannelRecorder::stopRecording() {
     
     // 1. Stop recording
     m_isRecording.store(false);
+
+    // The live monitor ends with the session, as in stopMonitoring()
+    m_liveMonitor.stop();
     
     // 2. Stop monitoring (this will stop the USB thread)
     m_isMonitoring.store(false);
@@ -272,9 +327,11 @@ bool MultichannelRecorder::stopRecording() {
         m_audioInterface->stopStreaming();
     }
     
-    // 7. Close the WAV file (writes final header)
+    // 7. Close the WAV file (writes final header) and its overview
+    closeOverview();
     if (m_wavWriter) {
         m_wavWriter->close();
+        m_lastSegmentIndex = m_wavWriter->getSegmentIndex();
         delete m_wavWriter;
         m_wavWriter = nullptr;
     }
@@ -290,6 +347,17 @@ bool MultichannelRecorder::stopRecording() {
     return true;
 }
 
+bool MultichannelRecorder::startLiveMonitor(AAssetManager* assets, spcmic::IRPreset preset, bool lowLatency) {
+    if (!m_isMonitoring.load()) {
+        LOGE("Cannot start the live monitor: not monitoring");
+        return false;
+    }
+    if (m_liveMonitor.isActive()) {
+        m_liveMonitor.stop();
+    }
+    return m_liveMonitor.start(assets, preset, m_sampleRate, lowLatency);
+}
+
 bool MultichannelRecorder::stopMonitoring() {
     if (!m_isMonitoring.load()) {
         // Not monitoring, nothing to do
@@ -302,6 +370,8 @@ bool MultichannelRecorder::stopMonitoring() {
     if (m_isRecording.load()) {
         stopRecording();
     }
+
+    m_liveMonitor.stop();
     
     // Stop monitoring thread
     m_isMonitoring.store(false);
@@ -322,55 +392,81 @@ bool MultichannelRecorder::stopMonitoring() {
 
 void MultichannelRecorder::recordingThreadFunction() {
     LOGI("USB reading thread started");
+    thread_config::configureCurrentThread(thread_config::Role::UsbReader);
     
     if (m_bufferSize == 0) {
         m_bufferSize = DEFAULT_BUFFER_SIZE;
     }
 
-    std::vector<uint8_t> buffer(m_bufferSize);
     size_t consecutiveEmptyReads = 0;
     size_t totalBytesRead = 0;
     size_t bufferOverflows = 0;
+
+    // The reap path reports into the session stats only while this thread runs.
+    m_audioInterface->setRecordingStats(&m_stats);
+
+    // Reaped URB payloads arrive here directly. While recording they are
+    // copied once into a reserved ring region and gain-processed there; when
+    // only monitoring they are processed in the URB buffer itself.
+    const USBAudioInterface::FrameSink sink = [&](uint8_t* frames, size_t bytes) {
+        if (!m_isRecording.load(std::memory_order_acquire) || !m_ringBuffer) {
+            processAudioBuffer(frames, bytes);
+            capturePreRoll(frames, bytes);
+            m_liveMonitor.push(frames, bytes);
+            return;
+        }
+
+        // First recording callback: the history ends exactly where live data begins.
+        if (!m_preRollFrozen.load(std::memory_order_relaxed)) {
+            freezePreRoll();
+        }
+
+        const ElasticRingBuffer::WriteRegion region = m_ringBuffer->reserveWrite(bytes);
+        if (region.size() < bytes) {
+            // Ring buffer is full - this is a critical error indicating disk I/O can't keep up.
+            // Drop the whole chunk so the file stays frame aligned.
+            processAudioBuffer(frames, bytes);
+            m_liveMonitor.push(frames, bytes);
+            bufferOverflows++;
+            m_stats.add(RecordingStats::BytesDropped, static_cast<int64_t>(bytes));
+            m_stats.add(RecordingStats::OverflowEvents, 1);
+            if (bufferOverflows % 10 == 1) {  // Log every 10th overflow to avoid spam
+                LOGE("Ring buffer overflow! Disk I/O can't keep up. Lost %zu bytes (space=%zu, overflow #%zu)",
+                     bytes, region.size(), bufferOverflows);
+            }
+            return;
+        }
+
+        if (region.secondSize == 0) {
+            memcpy(region.first, frames, bytes);
+            processAudioBuffer(region.first, bytes);
+            m_liveMonitor.push(region.first, bytes);
+        } else {
+            // Frames straddle the wrap point: process in place, then split the copy.
+            processAudioBuffer(frames, bytes);
+            m_liveMonitor.push(frames, bytes);
+            memcpy(region.first, frames, region.firstSize);
+            memcpy(region.second, frames + region.firstSize, region.secondSize);
+        }
+        m_ringBuffer->commitWrite(bytes);
+        m_stats.raise(RecordingStats::RingHighWaterBytes, static_cast<int64_t>(m_ringBuffer->getRingBytes()));
+    };
     
     while (m_isMonitoring.load()) {  // Changed from m_isRecording
-        // Read audio data from USB interface
-        size_t bytesRead = m_audioInterface->readAudioData(buffer.data(), buffer.size());
-        
-        LOG_FATAL_IF(bytesRead > buffer.size(),
-                     "bytesRead=%zu exceeds staging buffer=%zu", bytesRead, buffer.size());
+        // Reap USB audio straight into the sink (level meters, clip detection,
+        // gain, ring buffer). This ALWAYS happens whether monitoring or recording
+        size_t bytesRead = m_audioInterface->readAudioData(sink, m_bufferSize);
 
         if (bytesRead > 0) {
             consecutiveEmptyReads = 0;
             totalBytesRead += bytesRead;
-            
-            // Process the audio buffer (level meters, clip detection, gain)
-            // This ALWAYS happens whether monitoring or recording
-            processAudioBuffer(buffer.data(), bytesRead);
 
             // Update total samples
             size_t samplesInBuffer = bytesRead / (CHANNEL_COUNT * BYTES_PER_SAMPLE);
             m_totalSamples.fetch_add(static_cast<uint64_t>(samplesInBuffer), std::memory_order_relaxed);
             
-            // Write to ring buffer ONLY if recording (not just monitoring)
+            // Wake up disk write thread if it's waiting
             if (m_isRecording.load() && m_ringBuffer) {
-                const size_t availableSpace = m_ringBuffer->getAvailableSpace();
-                if (bytesRead > availableSpace) {
-                    LOGE("Ring buffer pressure: incoming=%zu, space=%zu (overflow #%zu)",
-                         bytesRead, availableSpace, bufferOverflows + 1);
-                }
-
-                size_t bytesWritten = m_ringBuffer->write(buffer.data(), bytesRead);
-                
-                if (bytesWritten < bytesRead) {
-                    // Ring buffer is full - this is a critical error indicating disk I/O can't keep up
-                    bufferOverflows++;
-                    if (bufferOverflows % 10 == 1) {  // Log every 10th overflow to avoid spam
-                        LOGE("Ring buffer overflow! Disk I/O can't keep up. Lost %zu bytes (overflow #%zu)",
-                             bytesRead - bytesWritten, bufferOverflows);
-                    }
-                }
-                
-                // Wake up disk write thread if it's waiting
                 m_diskThreadCV.notify_one();
             }
         } else {
@@ -381,12 +477,15 @@ void MultichannelRecorder::recordingThreadFunction() {
                 LOGE("Warning: 100 consecutive empty USB reads. Total bytes read so far: %zu", totalBytesRead);
             }
             
-            // Small yield to scheduler - we're ready to read more data immediately
-            // but don't want to completely starve other threads
-            std::this_thread::yield();
+            // readAudioData() already sleeps in poll() while URBs are in
+            // flight; an empty return means a timeout or a stream that is not
+            // ready yet, so back off briefly instead of spinning.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
     }
     
+    m_audioInterface->setRecordingStats(nullptr);
+
     if (bufferOverflows > 0) {
         LOGE("USB reading thread finished. Total buffer overflows: %zu", bufferOverflows);
     } else {
@@ -396,6 +495,7 @@ void MultichannelRecorder::recordingThreadFunction() {
 
 void MultichannelRecorder::diskWriteThreadFunction() {
     LOGI("Disk write thread started");
+    thread_config::configureCurrentThread(thread_config::Role::DiskWriter);
     
     // Use a larger buffer for disk writes to amortize I/O overhead
     const size_t DISK_WRITE_BUFFER_SIZE = 256 * 1024;  // 256 KB (~200ms of audio)
@@ -406,6 +506,15 @@ void MultichannelRecorder::diskWriteThreadFunction() {
     
     while (m_diskThreadRunning.load()) {
         size_t bytesAvailable = m_ringBuffer ? m_ringBuffer->getAvailableBytes() : 0;
+
+        // Checked after the ring: live data is only committed once the history
+        // is frozen, so seeing ring bytes guarantees seeing the freeze too.
+        if (m_preRollFrozen.load(std::memory_order_acquire) && m_preRollFlushRemaining > 0) {
+            // One block per pass: the ring keeps absorbing live audio meanwhile
+            // and grows if the history takes a while to reach the disk.
+            flushPreRoll(DISK_WRITE_BUFFER_SIZE);
+            continue;
+        }
         
         if (bytesAvailable > 0) {
             // Read from ring buffer
@@ -415,13 +524,16 @@ void MultichannelRecorder::diskWriteThreadFunction() {
             if (bytesRead > 0) {
                 // Write to WAV file
                 if (m_wavWriter) {
-                    m_wavWriter->writeData(diskBuffer.data(), bytesRead);
+                    writeTimed(diskBuffer.data(), bytesRead);
                     totalBytesWritten += bytesRead;
                     writeCount++;
                     
+                    m_stats.set(RecordingStats::RingCapacityBytes, static_cast<int64_t>(m_ringBuffer->getCapacity()));
+                    m_stats.set(RecordingStats::SpooledBytes, static_cast<int64_t>(m_ringBuffer->getSpooledBytes()));
+
                     // Periodically log write statistics
                     if (writeCount % 100 == 0) {
-                        size_t bufferFill = m_ringBuffer->getAvailableBytes();
+                        size_t bufferFill = m_ringBuffer->getRingBytes();
                         double fillPercent = (bufferFill * 100.0) / m_ringBuffer->getCapacity();
                         LOGI("Disk write stats: %zu writes, %zu MB written, ring buffer %.1f%% full",
                              writeCount, totalBytesWritten / (1024 * 1024), fillPercent);
@@ -439,6 +551,12 @@ void MultichannelRecorder::diskWriteThreadFunction() {
         }
     }
     
+    // A take shorter than the history flush still gets its history first
+    if (m_preRollFrozen.load(std::memory_order_acquire)) {
+        while (m_preRollFlushRemaining > 0 && flushPreRoll(DISK_WRITE_BUFFER_SIZE) > 0) {
+        }
+    }
+
     // Flush remaining data in ring buffer before exiting
     if (m_ringBuffer) {
         size_t remainingBytes = m_ringBuffer->getAvailableBytes();
@@ -450,7 +568,7 @@ void MultichannelRecorder::diskWriteThreadFunction() {
                 size_t bytesRead = m_ringBuffer->read(diskBuffer.data(), toRead);
                 
                 if (bytesRead > 0 && m_wavWriter) {
-                    m_wavWriter->writeData(diskBuffer.data(), bytesRead);
+                    writeTimed(diskBuffer.data(), bytesRead);
                     totalBytesWritten += bytesRead;
                 }
                 
@@ -463,23 +581,245 @@ void MultichannelRecorder::diskWriteThreadFunction() {
          writeCount, totalBytesWritten / (1024 * 1024));
 }
 
-void MultichannelRecorder::processAudioBuffer(const uint8_t* buffer, size_t bufferSize) {
+void MultichannelRecorder::capturePreRoll(const uint8_t* frames, size_t bytes) {
+    const size_t capacity = m_preRoll.size();
+    if (capacity == 0 || m_preRollFrozen.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Only the newest capacity bytes matter.
+    if (bytes > capacity) {
+        frames += bytes - capacity;
+        m_preRollWritePos = (m_preRollWritePos + bytes - capacity) % capacity;
+        bytes = capacity;
+    }
+
+    const size_t first = std::min(bytes, capacity - m_preRollWritePos);
+    memcpy(m_preRoll.data() + m_preRollWritePos, frames, first);
+    if (first < bytes) {
+        memcpy(m_preRoll.data(), frames + first, bytes - first);
+    }
+    m_preRollWritePos = (m_preRollWritePos + bytes) % capacity;
+    m_preRollFilled = std::min(capacity, m_preRollFilled + bytes);
+}
+
+void MultichannelRecorder::freezePreRoll() {
+    const size_t capacity = m_preRoll.size();
+    if (capacity > 0 && m_preRollFilled > 0) {
+        m_preRollFlushPos = (m_preRollWritePos + capacity - m_preRollFilled) % capacity;
+        m_preRollFlushRemaining = m_preRollFilled;
+        const size_t frameSize = static_cast<size_t>(CHANNEL_COUNT) * BYTES_PER_SAMPLE;
+        m_totalSamples.fetch_add(static_cast<uint64_t>(m_preRollFilled / frameSize), std::memory_order_relaxed);
+        LOGI("Pre-record history frozen: %zu frames", m_preRollFilled / frameSize);
+    }
+    m_preRollFrozen.store(true, std::memory_order_release);
+}
+
+size_t MultichannelRecorder::flushPreRoll(size_t maxBytes) {
+    if (!m_wavWriter || m_preRollFlushRemaining == 0) {
+        m_preRollFlushRemaining = 0;
+        return 0;
+    }
+
+    // Written straight from the history buffer; it is not touched again until the next monitoring session.
+    const size_t capacity = m_preRoll.size();
+    const size_t chunk = std::min({maxBytes, m_preRollFlushRemaining, capacity - m_preRollFlushPos});
+    writeTimed(m_preRoll.data() + m_preRollFlushPos, chunk);
+    m_preRollFlushPos = (m_preRollFlushPos + chunk) % capacity;
+    m_preRollFlushRemaining -= chunk;
+    return chunk;
+}
+
+void MultichannelRecorder::setChannelSubset(const std::vector<int>& channels) {
+    std::vector<uint16_t> subset;
+    for (int channel : channels) {
+        if (channel >= 0 && channel < CHANNEL_COUNT) {
+            subset.push_back(static_cast<uint16_t>(channel));
+        }
+    }
+    std::sort(subset.begin(), subset.end());
+    subset.erase(std::unique(subset.begin(), subset.end()), subset.end());
+    if (subset.size() == static_cast<size_t>(CHANNEL_COUNT)) {
+        subset.clear();
+    }
+    m_channelSubset = std::move(subset);
+    const size_t selected = m_channelSubset.empty() ? static_cast<size_t>(CHANNEL_COUNT) : m_channelSubset.size();
+    LOGI("Recording channel subset: %zu of %d channels", selected, CHANNEL_COUNT);
+}
+
+SegmentedWAVWriter* MultichannelRecorder::createWavWriter() {
+    m_recordChannels = m_channelSubset;
+    m_packCarryBytes = 0;
+    auto* writer = new SegmentedWAVWriter();
+    writer->setSegmentLimits(static_cast<uint64_t>(static_cast<double>(m_segmentMaxSeconds) * m_sampleRate),
+                             m_segmentMaxBytes);
+    writer->setChannelMap(m_recordChannels, CHANNEL_COUNT);
+    writer->setLossless(m_losslessCompression);
+    LOGI("Recording %d channels%s", storedChannelCount(), m_losslessCompression ? ", lossless" : "");
+    return writer;
+}
+
+int MultichannelRecorder::storedChannelCount() const {
+    return m_recordChannels.empty() ? CHANNEL_COUNT : static_cast<int>(m_recordChannels.size());
+}
+
+size_t MultichannelRecorder::packChannels(const uint8_t* frames, size_t bytes) {
+    const size_t frameSize = static_cast<size_t>(CHANNEL_COUNT) * BYTES_PER_SAMPLE;
+    const size_t packedFrameSize = m_recordChannels.size() * BYTES_PER_SAMPLE;
+    const size_t maxFrames = (m_packCarryBytes + bytes) / frameSize;
+    if (m_packed.size() < maxFrames * packedFrameSize) {
+        m_packed.resize(maxFrames * packedFrameSize);
+    }
+
+    uint8_t* dst = m_packed.data();
+    const auto packFrame = [&](const uint8_t* src) {
+        for (uint16_t channel : m_recordChannels) {
+            memcpy(dst, src + static_cast<size_t>(channel) * BYTES_PER_SAMPLE, BYTES_PER_SAMPLE);
+            dst += BYTES_PER_SAMPLE;
+        }
+    };
+
+    // Ring reads need not end on a frame boundary (the spool drains in raw
+    // bytes), so a partial frame waits for the rest.
+    if (m_packCarryBytes > 0) {
+        const size_t take = std::min(bytes, frameSize - m_packCarryBytes);
+        memcpy(m_packCarry + m_packCarryBytes, frames, take);
+        m_packCarryBytes += take;
+        frames += take;
+        bytes -= take;
+        if (m_packCarryBytes < frameSize) {
+            return 0;
+        }
+        packFrame(m_packCarry);
+        m_packCarryBytes = 0;
+    }
+
+    const size_t count = bytes / frameSize;
+    for (size_t frame = 0; frame < count; ++frame) {
+        packFrame(frames + frame * frameSize);
+    }
+    m_packCarryBytes = bytes - count * frameSize;
+    memcpy(m_packCarry, frames + count * frameSize, m_packCarryBytes);
+    return static_cast<size_t>(dst - m_packed.data());
+}
+
+void MultichannelRecorder::setSegmentLimits(float maxSeconds, uint64_t maxBytes) {
+    m_segmentMaxSeconds = std::max(0.0f, maxSeconds);
+    m_segmentMaxBytes = maxBytes;
+    LOGI("Segment limits: %.0f s, %llu bytes", m_segmentMaxSeconds, static_cast<unsigned long long>(maxBytes));
+}
+
+bool MultichannelRecorder::queueNextSegmentFd(int fd, const std::string& displayPath) {
+    if (!m_wavWriter) {
+        LOGE("Cannot queue segment %s: not recording", displayPath.c_str());
+        return false;
+    }
+    return m_wavWriter->queueNextFd(fd, displayPath);
+}
+
+ElasticRingBuffer* MultichannelRecorder::createRingBuffer() const {
+    const double bytesPerSecond = static_cast<double>(m_sampleRate) * CHANNEL_COUNT * BYTES_PER_SAMPLE;
+    const auto segmentsFor = [&](float seconds) {
+        return static_cast<size_t>(std::ceil(bytesPerSecond * seconds / RING_SEGMENT_BYTES));
+    };
+
+    ElasticRingBuffer::Config config;
+    config.segmentBytes = RING_SEGMENT_BYTES;
+    config.initialSegments = segmentsFor(RING_INITIAL_SECONDS);
+    config.maxSegments = segmentsFor(RING_MAX_SECONDS);
+    if (!m_spoolDirectory.empty()) {
+        config.spoolPath = m_spoolDirectory + "/recording_spool.tmp";
+    }
+
+    auto* ring = new ElasticRingBuffer(config);
+    if (!ring->isValid()) {
+        delete ring;
+        return nullptr;
+    }
+    return ring;
+}
+
+bool MultichannelRecorder::writeTimed(const uint8_t* data, size_t size) {
+    if (!m_recordChannels.empty()) {
+        size = packChannels(data, size);
+        data = m_packed.data();
+    }
+
+    const int segment = m_wavWriter->getSegmentIndex();
+    const uint64_t offset = m_wavWriter->getBytesWritten();
+
+    const auto writeStart = std::chrono::steady_clock::now();
+    const bool ok = m_wavWriter->writeData(data, size);
+    m_stats.histogram(RecordingStats::WriteLatency).record(std::chrono::steady_clock::now() - writeStart);
+    m_stats.add(RecordingStats::DiskWrites, 1);
+    if (!ok) {
+        m_stats.add(RecordingStats::DiskWriteErrors, 1);
+    }
+
+    // The overview follows the file: a rollover inside this block starts the next segment's sidecar.
+    if (!m_overviewDirectory.empty() && m_wavWriter->getSegmentIndex() != segment) {
+        const uint64_t segmentStart = std::max(m_wavWriter->getSegmentStartBytes(), offset);
+        const size_t head = static_cast<size_t>(std::min<uint64_t>(size, segmentStart - offset));
+        if (m_overview) {
+            m_overview->append(data, head);
+        }
+        openOverview(m_wavWriter->getSegmentLabel());
+        data += head;
+        size -= head;
+    }
+    if (m_overview) {
+        m_overview->append(data, size);
+    }
+    return ok;
+}
+
+void MultichannelRecorder::openOverview(const std::string& label) {
+    closeOverview();
+    if (m_overviewDirectory.empty() || label.empty()) {
+        return;
+    }
+
+    auto overview = std::make_unique<WaveformIndexWriter>();
+    const std::string path = m_overviewDirectory + "/" + waveform_index::sidecarName(label);
+    if (overview->open(path, m_sampleRate, storedChannelCount())) {
+        m_overview = std::move(overview);
+    }
+}
+
+void MultichannelRecorder::closeOverview() {
+    if (m_overview) {
+        m_overview->close();
+        m_overview.reset();
+    }
+}
+
+void MultichannelRecorder::processAudioBuffer(uint8_t* buffer, size_t bufferSize) {
     // This function processes audio in real-time:
     // 1. Smooth gain transitions (interpolate current gain toward target)
-    // 2. Apply gain to all channels
-    // 3. Track peak level across all channels for metering
+    // 2. Apply gain to all channels, ramping linearly across the buffer
+    // 3. Track peak level across all channels, and per-channel peak/RMS, for metering
     // 4. Modify buffer in-place before it goes to disk
+    //
+    // Chunks arrive per USB packet, so smoothing and meter decay are scaled by
+    // the chunk length to keep their time constants independent of packet size.
     
     if (bufferSize == 0 || buffer == nullptr) {
         return;
     }
+    const auto processStart = std::chrono::steady_clock::now();
+
+    const size_t frameSize = CHANNEL_COUNT * BYTES_PER_SAMPLE;
+    const size_t numFrames = bufferSize / frameSize;
+    const float typicalBuffers = static_cast<float>(numFrames) / TYPICAL_BUFFER_FRAMES;
     
     // Smooth gain interpolation: gradually move current gain toward target
     // This prevents clicks/pops when user adjusts gain during recording
+    const float startGain = m_gainLinear;
     const float targetGain = m_targetGainLinear.load(std::memory_order_relaxed);
     if (std::abs(m_gainLinear - targetGain) > 0.0001f) {
         // Exponential smoothing: move current toward target
-        m_gainLinear += (targetGain - m_gainLinear) * m_gainSmoothingCoeff;
+        const float coeff = 1.0f - std::pow(1.0f - m_gainSmoothingCoeff, typicalBuffers);
+        m_gainLinear += (targetGain - m_gainLinear) * coeff;
         
         // Snap to target when very close to avoid endless tiny updates
         if (std::abs(m_gainLinear - targetGain) < 0.0001f) {
@@ -487,74 +827,94 @@ void MultichannelRecorder::processAudioBuffer(const uint8_t* buffer, size_t buff
         }
     }
     
-    // Process samples in-place (gain application + level detection)
-    const size_t frameSize = CHANNEL_COUNT * BYTES_PER_SAMPLE;
-    const size_t numFrames = bufferSize / frameSize;
-    
-    // Track peak level for this buffer
-    float bufferPeak = 0.0f;
-    
-    // Process each complete frame
-    uint8_t* mutableBuffer = const_cast<uint8_t*>(buffer);
-    for (size_t frame = 0; frame < numFrames; ++frame) {
-        const size_t frameOffset = frame * frameSize;
-        
-        // Process each channel in this frame
-        for (size_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
-            const size_t sampleOffset = frameOffset + (ch * BYTES_PER_SAMPLE);
-            
-            // Extract 24-bit sample
-            int32_t sample = extract24BitSample(mutableBuffer + sampleOffset);
-
-            // Apply gain (multiply by linear gain factor) and detect clipping
-            constexpr float MAX_24BIT = 8388607.0f;   // 2^23 - 1
-            constexpr float MIN_24BIT = -8388608.0f;  // -2^23
-            float processedSample = static_cast<float>(sample) * m_gainLinear;
-
-            const bool clippedAfterGain = (processedSample >= MAX_24BIT) || (processedSample <= MIN_24BIT);
-            if (clippedAfterGain) {
-                m_clipDetected.store(true, std::memory_order_relaxed);
-            }
-
-            if (m_gainLinear != 1.0f || clippedAfterGain) {
-                float clampedSample = std::clamp(processedSample, MIN_24BIT, MAX_24BIT);
-                int32_t quantizedSample = static_cast<int32_t>(clampedSample);
+    // Process samples in-place (gain application + level detection). At unity
+    // gain the kernel only scans the buffer and leaves it untouched.
+    pcm24::ChannelAccumulators channelLevels;
+    channelLevels.peak = m_channelPeakAccum;
+    channelLevels.sumSquares = m_channelSumSquares;
+    const pcm24::GainResult result =
+        pcm24::applyGain(buffer, numFrames, CHANNEL_COUNT, startGain, m_gainLinear, &channelLevels);
 
-                // Write modified sample back to buffer (24-bit little-endian)
-                mutableBuffer[sampleOffset + 0] = static_cast<uint8_t>(quantizedSample & 0xFF);
-                mutableBuffer[sampleOffset + 1] = static_cast<uint8_t>((quantizedSample >> 8) & 0xFF);
-                mutableBuffer[sampleOffset + 2] = static_cast<uint8_t>((quantizedSample >> 16) & 0xFF);
+    m_meterFrames += numFrames;
+    const size_t meterWindow = static_cast<size_t>(std::max(1, m_sampleRate / METER_WINDOWS_PER_SECOND));
+    if (m_meterFrames >= meterWindow) {
+        publishChannelLevels();
+    }
 
-                sample = quantizedSample;  // Use the post-gain value for level metering
-            }
-            
-            // Track peak level (after gain application)
-            float level = normalizeLevel(sample);
-            if (level > bufferPeak) {
-                bufferPeak = level;
-            }
-        }
+    if (result.clipped()) {
+        m_clipDetected.store(true, std::memory_order_relaxed);
     }
     
+    // Track peak level for this buffer (after gain application)
+    const float bufferPeak = normalizeLevel(result.peak());
+    
     // Update peak level atomically (for UI polling)
-    // Use exponential decay: new_peak = max(current_sample_peak, old_peak * 0.95)
+    // Use exponential decay: new_peak = max(current_sample_peak, old_peak * 0.95 per typical buffer)
     // This gives smooth meter falloff
     float currentPeak = m_peakLevel.load(std::memory_order_relaxed);
-    float decayedPeak = currentPeak * 0.95f;
+    float decayedPeak = currentPeak * std::pow(0.95f, typicalBuffers);
     float newPeak = std::max(bufferPeak, decayedPeak);
     m_peakLevel.store(newPeak, std::memory_order_relaxed);
+
+    m_stats.histogram(RecordingStats::ProcessDuration).record(std::chrono::steady_clock::now() - processStart);
 }
 
-int32_t MultichannelRecorder::extract24BitSample(const uint8_t* data) {
-    // Extract 24-bit sample (little-endian) and sign-extend to 32-bit
-    int32_t sample = (data[0]) | (data[1] << 8) | (data[2] << 16);
-    
-    // Sign extend from 24-bit to 32-bit
-    if (sample & 0x800000) {
-        sample |= 0xFF000000;
+void MultichannelRecorder::resetChannelMeters() {
+    std::fill(std::begin(m_channelPeakAccum), std::end(m_channelPeakAccum), 0);
+    std::fill(std::begin(m_channelSumSquares), std::end(m_channelSumSquares), 0.0f);
+    std::fill(std::begin(m_channelPeakHold), std::end(m_channelPeakHold), 0.0f);
+    m_meterFrames = 0;
+    publishChannelLevels();
+}
+
+void MultichannelRecorder::publishChannelLevels() {
+    // Seqlock writer: readers retry if they see an odd or changed sequence.
+    const uint32_t sequence = m_meterSequence.load(std::memory_order_relaxed);
+    m_meterSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const float invFrames = m_meterFrames > 0 ? 1.0f / static_cast<float>(m_meterFrames) : 0.0f;
+    for (int ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        const float windowPeak = normalizeLevel(m_channelPeakAccum[ch]);
+        m_channelPeakHold[ch] = std::max(windowPeak, m_channelPeakHold[ch] * METER_PEAK_DECAY);
+        m_meterPeak[ch].store(m_channelPeakHold[ch], std::memory_order_relaxed);
+        m_meterRms[ch].store(std::sqrt(m_channelSumSquares[ch] * invFrames), std::memory_order_relaxed);
+        m_channelPeakAccum[ch] = 0;
+        m_channelSumSquares[ch] = 0.0f;
+    }
+    m_meterFrames = 0;
+
+    m_meterSequence.store(sequence + 2, std::memory_order_release);
+}
+
+size_t MultichannelRecorder::getChannelLevels(float* peaks, float* rms, size_t maxChannels) const {
+    const size_t count = std::min(maxChannels, static_cast<size_t>(CHANNEL_COUNT));
+    if (count == 0) {
+        return 0;
     }
-    
-    return sample;
+
+    uint32_t before = 0;
+    uint32_t after = 0;
+    do {
+        before = m_meterSequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            std::this_thread::yield();
+            after = before + 1;
+            continue;
+        }
+        for (size_t ch = 0; ch < count; ++ch) {
+            if (peaks) {
+                peaks[ch] = m_meterPeak[ch].load(std::memory_order_relaxed);
+            }
+            if (rms) {
+                rms[ch] = m_meterRms[ch].load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_meterSequence.load(std::memory_order_relaxed);
+    } while (before != after);
+
+    return count;
 }
 
 float MultichannelRecorder::normalizeLevel(int32_t sample) {
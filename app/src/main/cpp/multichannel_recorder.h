@@ -8,9 +8,13 @@
 #include <cstdint>
 #include <functional>
 #include <condition_variable>
+#include <memory>
 #include "usb_audio_interface.h"
-#include "wav_writer.h"
-#include "lock_free_ring_buffer.h"
+#include "segmented_wav_writer.h"
+#include "elastic_ring_buffer.h"
+#include "live_monitor.h"
+#include "recording_stats.h"
+#include "waveform_index.h"
 
 class MultichannelRecorder {
 public:
@@ -38,55 +42,175 @@ public:
     // Gain and level metering
     void setGain(float gainDb);
     float getPeakLevel() const { return m_peakLevel.load(); }
-    
+
+    /**
+     * Copy the latest per-channel meter snapshot (peak with decay, RMS over
+     * the last ~50 ms, both 0.0-1.0). Lock-free and allocation-free; either
+     * pointer may be null. Returns the number of channels copied.
+     */
+    size_t getChannelLevels(float* peaks, float* rms, size_t maxChannels) const;
+    static constexpr int getChannelCount() { return CHANNEL_COUNT; }
+    
+    /**
+     * Roll to a new file every @p maxSeconds of audio or @p maxBytes of data
+     * (0 = no limit), split on a frame boundary. Applies to the next recording.
+     */
+    void setSegmentLimits(float maxSeconds, uint64_t maxBytes);
+    /** Hand over the descriptor for the next segment of an fd-based recording. */
+    bool queueNextSegmentFd(int fd, const std::string& displayPath);
+    /** 1-based segment being written, or the segment count of the last take. */
+    int getSegmentIndex() const { return m_wavWriter ? m_wavWriter->getSegmentIndex() : m_lastSegmentIndex; }
+
+    /**
+     * Keep the last @p seconds of post-gain audio while monitoring and write
+     * it ahead of live data when recording starts (0 = off). Takes effect at
+     * the next startMonitoring().
+     */
+    void setPreRollSeconds(float seconds) { m_preRollSeconds = std::max(0.0f, std::min(seconds, MAX_PRE_ROLL_SECONDS)); }
+
+    /**
+     * Write only source channels @p channels (0-based; empty = all 84). The
+     * file stores them in ascending order with a channel map, and playback
+     * treats the missing capsules as silent. Applies to the next recording.
+     */
+    void setChannelSubset(const std::vector<int>& channels);
+    /** Store the next recordings as lossless compressed blocks, encoded on the disk thread. */
+    void setLosslessCompression(bool enabled) { m_losslessCompression = enabled; }
+
+    /** Directory on internal storage for the ring's overflow spool file; empty disables spilling. */
+    void setSpoolDirectory(const std::string& directory) { m_spoolDirectory = directory; }
+
+    /**
+     * Directory for waveform overview sidecars, one per recorded file (or
+     * segment), built on the disk thread from the data it writes; empty
+     * disables them. Applies to the next recording.
+     */
+    void setOverviewDirectory(const std::string& directory) { m_overviewDirectory = directory; }
+
+    /**
+     * Render the post-gain input through @p preset to the headphone output
+     * while monitoring or recording. Needs an active monitoring session;
+     * stopMonitoring() and stopRecording() end it. The USB thread only copies into a lock-free
+     * tap, which drops data rather than wait for the convolver.
+     */
+    bool startLiveMonitor(AAssetManager* assets, spcmic::IRPreset preset, bool lowLatency);
+    void stopLiveMonitor() { m_liveMonitor.stop(); }
+    bool isLiveMonitorActive() const { return m_liveMonitor.isActive(); }
+    uint64_t getLiveMonitorDroppedFrames() const { return m_liveMonitor.getDroppedFrames(); }
+
+    // Real-time health stats (histograms, ring fill, dropouts); lock-free snapshot
+    size_t getRecordingStats(int64_t* out, size_t count) const { return m_stats.snapshot(out, count); }
+
     // Get recording statistics
     size_t getTotalSamplesRecorded() const { return static_cast<size_t>(m_totalSamples.load(std::memory_order_relaxed)); }
     double getRecordingDuration() const;
     
 private:
     USBAudioInterface* m_audioInterface;
-    WAVWriter* m_wavWriter;
+    SegmentedWAVWriter* m_wavWriter;
+    float m_segmentMaxSeconds;       // split-file limits for the next recording, 0 = off
+    uint64_t m_segmentMaxBytes;
+    int m_lastSegmentIndex;          // segment count of the last finished take
+    std::vector<uint16_t> m_channelSubset;   // for the next recording, ascending; empty = all
+    bool m_losslessCompression;
+    std::vector<uint16_t> m_recordChannels;  // subset of the current take (disk thread once started)
+    std::vector<uint8_t> m_packed;           // subset frames on their way to the writer (disk thread)
     
     std::atomic<bool> m_isMonitoring;  // USB streaming + audio processing active
     std::atomic<bool> m_isRecording;   // File writing active (implies monitoring)
     std::thread m_recordingThread;
     std::thread m_diskWriteThread;
     
-    // Lock-free ring buffer for decoupling USB reads from disk writes
-    LockFreeRingBuffer* m_ringBuffer;
-    static const size_t RING_BUFFER_SIZE = 4 * 1024 * 1024;  // 4 MB ring buffer (~3.3 seconds @ 1.2 MB/s)
+    // Elastic segment ring decoupling USB reads from disk writes, sized by duration
+    ElasticRingBuffer* m_ringBuffer;
+    std::string m_spoolDirectory;   // internal storage for the overflow spool, empty = no spill
+    static constexpr size_t RING_SEGMENT_BYTES = 1024 * 1024;
+    static constexpr float RING_INITIAL_SECONDS = 1.0f;   // resident pool, and the shrink floor
+    static constexpr float RING_MAX_SECONDS = 8.0f;       // RAM ceiling before spilling to the spool
     std::atomic<bool> m_diskThreadRunning;
     std::condition_variable m_diskThreadCV;
     std::mutex m_diskThreadMutex;
+
+    // Waveform overview of the file being written; disk thread while recording
+    std::string m_overviewDirectory;
+    std::unique_ptr<WaveformIndexWriter> m_overview;
     
     // Recording statistics
     std::atomic<uint64_t> m_totalSamples;
     std::chrono::high_resolution_clock::time_point m_startTime;
     int m_sampleRate;
     std::atomic<bool> m_clipDetected;
+    RecordingStats m_stats;
     
     // Gain and level metering
     std::atomic<float> m_peakLevel;
     float m_gainLinear;              // Current gain (smoothly interpolated by audio thread)
     std::atomic<float> m_targetGainLinear;  // Target gain set by UI thread
-    float m_gainSmoothingCoeff;      // Smoothing coefficient (calculated from sample rate)
+    float m_gainSmoothingCoeff;      // Smoothing coefficient per typical buffer (calculated from sample rate)
+    static constexpr float TYPICAL_BUFFER_FRAMES = 1024.0f;
     
     // Recording parameters
     static const size_t DEFAULT_BUFFER_SIZE = 8192;  // Bytes
     static const int CHANNEL_COUNT = 84;
     static const int BYTES_PER_SAMPLE = 3;  // 24-bit
-    
+
+    // Partial source frame left over by the last packChannels() call
+    uint8_t m_packCarry[CHANNEL_COUNT * BYTES_PER_SAMPLE];
+    size_t m_packCarryBytes;
+
+    // Per-channel meter bank. The accumulators and peak hold belong to the
+    // audio thread; the snapshot is published under a seqlock so the UI can
+    // poll it without blocking the USB path.
+    int32_t m_channelPeakAccum[CHANNEL_COUNT];
+    float m_channelSumSquares[CHANNEL_COUNT];
+    float m_channelPeakHold[CHANNEL_COUNT];
+    size_t m_meterFrames;
+    std::atomic<uint32_t> m_meterSequence;  // odd while a snapshot is being written
+    std::atomic<float> m_meterPeak[CHANNEL_COUNT];
+    std::atomic<float> m_meterRms[CHANNEL_COUNT];
+    static constexpr int METER_WINDOWS_PER_SECOND = 20;  // ~50 ms snapshots
+    static constexpr float METER_PEAK_DECAY = 0.85f;     // per snapshot
+    
+    // Pre-record history. The audio thread fills the circular buffer while
+    // monitoring and freezes it on its first recording callback; from then on
+    // the disk thread owns the frozen span and writes it ahead of the ring.
+    float m_preRollSeconds;
+    std::vector<uint8_t> m_preRoll;      // whole frames, 84 ch x 3 bytes each
+    size_t m_preRollWritePos;
+    size_t m_preRollFilled;
+    size_t m_preRollFlushPos;
+    size_t m_preRollFlushRemaining;
+    std::atomic<bool> m_preRollFrozen;
+    static constexpr float MAX_PRE_ROLL_SECONDS = 30.0f;
+
+    // Headphone monitor; the USB thread pushes every processed packet into it
+    LiveMonitor m_liveMonitor;
+
+    void capturePreRoll(const uint8_t* frames, size_t bytes);
+    void freezePreRoll();
+    size_t flushPreRoll(size_t maxBytes);
+
     // Recording thread function
     void recordingThreadFunction();
     
     // Disk write thread function (separate from USB reading)
     void diskWriteThreadFunction();
+    bool writeTimed(const uint8_t* data, size_t size);
+    SegmentedWAVWriter* createWavWriter();
+    int storedChannelCount() const;
+    size_t packChannels(const uint8_t* frames, size_t bytes);
+    void openOverview(const std::string& label);
+    void closeOverview();
+    ElasticRingBuffer* createRingBuffer() const;
     
     // Audio processing
-    void processAudioBuffer(const uint8_t* buffer, size_t bufferSize);
+    void processAudioBuffer(uint8_t* buffer, size_t bufferSize);
     
+    // Meter bank (audio thread, or before it starts)
+    void resetChannelMeters();
+    void publishChannelLevels();
+
     // Utility functions
-    int32_t extract24BitSample(const uint8_t* data);
     float normalizeLevel(int32_t sample);
 
     size_t m_bufferSize;
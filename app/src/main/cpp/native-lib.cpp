@@ -1,11 +1,14 @@
 #include <jni.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <android/log.h>
+#include <android/asset_manager_jni.h>
 #include <mutex>
 
 #include "usb_audio_interface.h"
 #include "multichannel_recorder.h"
+#include "thread_config.h"
 
 #define LOG_TAG "SPCMicRecorder"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -17,6 +20,26 @@ static std::mutex g_nativeMutex;
 static USBAudioInterface* g_usbAudioInterface = nullptr;
 static MultichannelRecorder* g_recorder = nullptr;
 static JavaVM* g_javaVm = nullptr;
+static std::string g_spoolDirectory;  // applied to every new recorder
+static std::string g_overviewDirectory;  // applied to every new recorder
+static int g_segmentMaxSeconds = 0;   // split-file limits, applied to every new recorder
+static int g_segmentMaxMegabytes = 0;
+static float g_preRollSeconds = 0.0f;  // pre-record history, applied to every new recorder
+static std::vector<int> g_recordChannels;  // channel subset (empty = all), applied to every new recorder
+static bool g_losslessRecording = false;
+
+// Creates the recorder with the process-wide settings applied (g_nativeMutex held).
+static MultichannelRecorder* createRecorder() {
+    auto* recorder = new MultichannelRecorder(g_usbAudioInterface);
+    recorder->setSpoolDirectory(g_spoolDirectory);
+    recorder->setOverviewDirectory(g_overviewDirectory);
+    recorder->setSegmentLimits(static_cast<float>(g_segmentMaxSeconds),
+                               static_cast<uint64_t>(g_segmentMaxMegabytes) * 1024 * 1024);
+    recorder->setPreRollSeconds(g_preRollSeconds);
+    recorder->setChannelSubset(g_recordChannels);
+    recorder->setLosslessCompression(g_losslessRecording);
+    return recorder;
+}
 
 
 extern "C" JNIEXPORT jstring JNICALL
@@ -89,7 +112,7 @@ Java_com_spcmic_recorder_USBAudioRecorder_startRecordingNative(
     }
 
     try {
-        g_recorder = new MultichannelRecorder(g_usbAudioInterface);
+        g_recorder = createRecorder();
         
         const char* pathStr = env->GetStringUTFChars(outputPath, nullptr);
         std::string path(pathStr);
@@ -139,7 +162,7 @@ Java_com_spcmic_recorder_USBAudioRecorder_startRecordingNativeWithFd(
     }
 
     try {
-        g_recorder = new MultichannelRecorder(g_usbAudioInterface);
+        g_recorder = createRecorder();
 
         std::string destinationLabel;
         if (locationHint != nullptr) {
@@ -312,6 +335,253 @@ Java_com_spcmic_recorder_USBAudioRecorder_stopRecordingNative(
     return result ? JNI_TRUE : JNI_FALSE;
 }
 
+extern "C" JNIEXPORT jint JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_getChannelLevelsNative(
+        JNIEnv* env,
+        jobject thiz,
+        jfloatArray levels) {
+    // Fills levels with per-channel peaks followed by per-channel RMS values.
+    // The snapshot goes through a stack buffer, so polling never allocates.
+    constexpr int kChannels = MultichannelRecorder::getChannelCount();
+    if (!levels) {
+        return 0;
+    }
+    const jsize length = env->GetArrayLength(levels);
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+
+    if (!g_recorder) {
+        return 0;
+    }
+
+    const size_t channels = std::min(static_cast<size_t>(kChannels), static_cast<size_t>(length / 2));
+    jfloat snapshot[kChannels * 2];
+    const size_t copied = g_recorder->getChannelLevels(snapshot, snapshot + channels, channels);
+    if (copied > 0) {
+        env->SetFloatArrayRegion(levels, 0, static_cast<jsize>(copied * 2), snapshot);
+    }
+    return static_cast<jint>(copied);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_setSpoolDirectoryNative(
+        JNIEnv* env,
+        jobject thiz,
+        jstring directory) {
+    std::string path;
+    if (directory) {
+        const char* chars = env->GetStringUTFChars(directory, nullptr);
+        if (chars) {
+            path.assign(chars);
+            env->ReleaseStringUTFChars(directory, chars);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    g_spoolDirectory = path;
+    if (g_recorder) {
+        g_recorder->setSpoolDirectory(path);
+    }
+    LOGI("Recording spool directory: %s", path.empty() ? "(disabled)" : path.c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_setOverviewDirectoryNative(
+        JNIEnv* env,
+        jobject thiz,
+        jstring directory) {
+    std::string path;
+    if (directory) {
+        const char* chars = env->GetStringUTFChars(directory, nullptr);
+        if (chars) {
+            path.assign(chars);
+            env->ReleaseStringUTFChars(directory, chars);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    g_overviewDirectory = path;
+    if (g_recorder) {
+        g_recorder->setOverviewDirectory(path);
+    }
+    LOGI("Waveform overview directory: %s", path.empty() ? "(disabled)" : path.c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_setRecordingSegmentLimitsNative(
+        JNIEnv* env,
+        jobject thiz,
+        jint maxSeconds,
+        jint maxMegabytes) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    g_segmentMaxSeconds = std::max<jint>(0, maxSeconds);
+    g_segmentMaxMegabytes = std::max<jint>(0, maxMegabytes);
+    if (g_recorder) {
+        g_recorder->setSegmentLimits(static_cast<float>(g_segmentMaxSeconds),
+                                     static_cast<uint64_t>(g_segmentMaxMegabytes) * 1024 * 1024);
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_setRecordingChannelsNative(
+        JNIEnv* env,
+        jobject thiz,
+        jintArray channels) {
+    std::vector<int> subset;
+    const jsize count = channels ? env->GetArrayLength(channels) : 0;
+    if (count > 0) {
+        subset.resize(static_cast<size_t>(count));
+        env->GetIntArrayRegion(channels, 0, count, reinterpret_cast<jint*>(subset.data()));
+    }
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    g_recordChannels = subset;
+    if (g_recorder) {
+        // Takes effect at the next recording
+        g_recorder->setChannelSubset(g_recordChannels);
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_setLosslessRecordingNative(
+        JNIEnv* env,
+        jobject thiz,
+        jboolean enabled) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    g_losslessRecording = enabled == JNI_TRUE;
+    if (g_recorder) {
+        g_recorder->setLosslessCompression(g_losslessRecording);
+    }
+    LOGI("Lossless recording %s", g_losslessRecording ? "on" : "off");
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_setPreRollSecondsNative(
+        JNIEnv* env,
+        jobject thiz,
+        jfloat seconds) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    g_preRollSeconds = std::max(0.0f, static_cast<float>(seconds));
+    if (g_recorder) {
+        // Takes effect at the next startMonitoring()
+        g_recorder->setPreRollSeconds(g_preRollSeconds);
+    }
+    LOGI("Pre-record history set to %.1f s", g_preRollSeconds);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_queueNextSegmentFdNative(
+        JNIEnv* env,
+        jobject thiz,
+        jint fd,
+        jstring displayPath) {
+    std::string label = "parcel_fd";
+    if (displayPath) {
+        const char* chars = env->GetStringUTFChars(displayPath, nullptr);
+        if (chars) {
+            label.assign(chars);
+            env->ReleaseStringUTFChars(displayPath, chars);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    if (!g_recorder) {
+        return JNI_FALSE;
+    }
+    return g_recorder->queueNextSegmentFd(static_cast<int>(fd), label) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_getRecordingSegmentIndexNative(
+        JNIEnv* env,
+        jobject thiz) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    return g_recorder ? static_cast<jint>(g_recorder->getSegmentIndex()) : 0;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_startLiveMonitorNative(
+        JNIEnv* env,
+        jobject thiz,
+        jobject assetManager,
+        jint presetId,
+        jboolean lowLatency) {
+    if (presetId < static_cast<jint>(spcmic::IRPreset::Binaural) ||
+        presetId > static_cast<jint>(spcmic::IRPreset::ThirdOrderAmbisonic)) {
+        LOGE("Unknown live monitor preset %d", presetId);
+        return JNI_FALSE;
+    }
+    AAssetManager* assets = assetManager ? AAssetManager_fromJava(env, assetManager) : nullptr;
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    if (!g_recorder) {
+        LOGE("Cannot start the live monitor: g_recorder is null");
+        return JNI_FALSE;
+    }
+    return g_recorder->startLiveMonitor(assets, static_cast<spcmic::IRPreset>(presetId), lowLatency == JNI_TRUE)
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_stopLiveMonitorNative(
+        JNIEnv* env,
+        jobject thiz) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    if (g_recorder) {
+        g_recorder->stopLiveMonitor();
+    }
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_isLiveMonitorActiveNative(
+        JNIEnv* env,
+        jobject thiz) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    return g_recorder && g_recorder->isLiveMonitorActive() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_getLiveMonitorDroppedFramesNative(
+        JNIEnv* env,
+        jobject thiz) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+    return g_recorder ? static_cast<jlong>(g_recorder->getLiveMonitorDroppedFrames()) : 0;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_getThreadPoliciesNative(
+        JNIEnv* env,
+        jobject thiz) {
+    return env->NewStringUTF(thread_config::describeGrantedPolicies().c_str());
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_getRecordingStatsNative(
+        JNIEnv* env,
+        jobject thiz,
+        jlongArray stats) {
+    // Copies the RecordingStats snapshot into the caller's array through a
+    // stack buffer so QA polling never allocates.
+    if (!stats) {
+        return 0;
+    }
+    const jsize length = env->GetArrayLength(stats);
+
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+
+    if (!g_recorder) {
+        return 0;
+    }
+
+    int64_t values[RecordingStats::kSnapshotSize];
+    const size_t copied = g_recorder->getRecordingStats(values, static_cast<size_t>(std::max<jsize>(0, length)));
+    if (copied > 0) {
+        static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64-bit");
+        env->SetLongArrayRegion(stats, 0, static_cast<jsize>(copied), reinterpret_cast<const jlong*>(values));
+    }
+    return static_cast<jint>(copied);
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_spcmic_recorder_USBAudioRecorder_startMonitoringNative(
         JNIEnv* env,
@@ -332,7 +602,7 @@ Java_com_spcmic_recorder_USBAudioRecorder_startMonitoringNative(
     }
     
     // Create new recorder instance
-    g_recorder = new MultichannelRecorder(g_usbAudioInterface);
+    g_recorder = createRecorder();
     
     // Start monitoring with specified gain
     LOGI("Starting monitoring with gain %.1f dB", gainDb);
@@ -453,6 +723,28 @@ Java_com_spcmic_recorder_USBAudioRecorder_getSupportedSampleRatesNative(
     return result;
 }
 
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_spcmic_recorder_USBAudioRecorder_getUrbStatsNative(
+        JNIEnv* env,
+        jobject thiz) {
+    std::lock_guard<std::mutex> lock(g_nativeMutex);
+
+    if (!g_usbAudioInterface) {
+        return env->NewLongArray(0);
+    }
+
+    int64_t values[USBAudioInterface::kUrbStatCount] = {};
+    const size_t count = g_usbAudioInterface->getUrbStats(values, USBAudioInterface::kUrbStatCount);
+
+    jlongArray result = env->NewLongArray(static_cast<jsize>(count));
+    if (!result) {
+        return nullptr;
+    }
+    static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64-bit");
+    env->SetLongArrayRegion(result, 0, static_cast<jsize>(count), reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_spcmic_recorder_USBAudioRecorder_supportsContinuousSampleRateNative(
         JNIEnv* env,
@@ -0,0 +1,379 @@
+#include "pcm24.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PCM24_HAS_NEON 1
+#endif
+
+namespace pcm24 {
+
+namespace {
+
+constexpr int32_t kMin24 = -8388608;
+constexpr int32_t kMax24 = 8388607;
+constexpr float kFromFloatScale = 8388607.0f; // 2^23 - 1
+
+inline int32_t Unpack(const uint8_t* p) {
+    // Place the sample in the top 24 bits; the arithmetic shift sign-extends.
+    const uint32_t top = (static_cast<uint32_t>(p[0]) << 8) |
+                         (static_cast<uint32_t>(p[1]) << 16) |
+                         (static_cast<uint32_t>(p[2]) << 24);
+    return static_cast<int32_t>(top) >> 8;
+}
+
+inline void Pack(int32_t value, uint8_t* p) {
+    const uint32_t u = static_cast<uint32_t>(std::clamp(value, kMin24, kMax24));
+    p[0] = static_cast<uint8_t>(u & 0xFF);
+    p[1] = static_cast<uint8_t>((u >> 8) & 0xFF);
+    p[2] = static_cast<uint8_t>((u >> 16) & 0xFF);
+}
+
+inline uint32_t XorShift(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/** Difference of two 16-bit uniforms: triangular on (-1, 1) LSB. */
+inline float NextDither(Dither& dither, size_t lane) {
+    const uint32_t x = XorShift(dither.state[lane]);
+    dither.state[lane] = x;
+    const int32_t diff = static_cast<int32_t>(x & 0xFFFFu) - static_cast<int32_t>(x >> 16);
+    return static_cast<float>(diff) * (1.0f / 65536.0f);
+}
+
+inline int32_t QuantizeScalar(float sample, Dither* dither, size_t index) {
+    float scaled = std::clamp(sample, -1.0f, 1.0f) * kFromFloatScale;
+    if (dither) {
+        scaled += NextDither(*dither, index & 3);
+    }
+    return static_cast<int32_t>(std::lrintf(scaled));
+}
+
+inline int32_t ScaleScalar(int32_t sample, float gain) {
+    const float scaled = static_cast<float>(sample) * gain;
+    return static_cast<int32_t>(std::clamp(scaled, static_cast<float>(kMin24), static_cast<float>(kMax24)));
+}
+
+#if PCM24_HAS_NEON
+
+/** 16 packed samples -> four vectors holding each sample in the top 24 bits. */
+inline void LoadTopAligned(const uint8_t* src, int32x4_t out[4]) {
+    const uint8x16x3_t planes = vld3q_u8(src);
+    const uint8x16_t zero = vdupq_n_u8(0);
+
+    // Interleave byte planes into 32-bit lanes [0, b0, b1, b2].
+    const uint8x16x2_t low = vzipq_u8(zero, planes.val[0]);
+    const uint8x16x2_t high = vzipq_u8(planes.val[1], planes.val[2]);
+    const uint16x8x2_t first = vzipq_u16(vreinterpretq_u16_u8(low.val[0]), vreinterpretq_u16_u8(high.val[0]));
+    const uint16x8x2_t second = vzipq_u16(vreinterpretq_u16_u8(low.val[1]), vreinterpretq_u16_u8(high.val[1]));
+
+    out[0] = vreinterpretq_s32_u16(first.val[0]);
+    out[1] = vreinterpretq_s32_u16(first.val[1]);
+    out[2] = vreinterpretq_s32_u16(second.val[0]);
+    out[3] = vreinterpretq_s32_u16(second.val[1]);
+}
+
+/** Saturate four vectors to 24 bits and store them as 16 packed samples. */
+inline void StoreSaturated(int32x4_t v0, int32x4_t v1, int32x4_t v2, int32x4_t v3, uint8_t* dst) {
+    const int32x4_t lo = vdupq_n_s32(kMin24);
+    const int32x4_t hi = vdupq_n_s32(kMax24);
+    v0 = vminq_s32(vmaxq_s32(v0, lo), hi);
+    v1 = vminq_s32(vmaxq_s32(v1, lo), hi);
+    v2 = vminq_s32(vmaxq_s32(v2, lo), hi);
+    v3 = vminq_s32(vmaxq_s32(v3, lo), hi);
+
+    // Two unzips split the little-endian lanes into byte planes 0..3.
+    const uint8x16x2_t a = vuzpq_u8(vreinterpretq_u8_s32(v0), vreinterpretq_u8_s32(v1));
+    const uint8x16x2_t b = vuzpq_u8(vreinterpretq_u8_s32(v2), vreinterpretq_u8_s32(v3));
+    const uint8x16x2_t even = vuzpq_u8(a.val[0], b.val[0]); // bytes 0 and 2
+    const uint8x16x2_t odd = vuzpq_u8(a.val[1], b.val[1]);  // bytes 1 and 3
+
+    uint8x16x3_t planes;
+    planes.val[0] = even.val[0];
+    planes.val[1] = odd.val[0];
+    planes.val[2] = even.val[1];
+    vst3q_u8(dst, planes);
+}
+
+// Byte shuffles between 4 packed samples (12 bytes) and top-aligned lanes;
+// 0xFF selects zero.
+alignas(16) constexpr uint8_t kUnpack4[16] = {0xFF, 0, 1, 2, 0xFF, 3, 4, 5, 0xFF, 6, 7, 8, 0xFF, 9, 10, 11};
+alignas(16) constexpr uint8_t kPack4[16] = {0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0xFF, 0xFF, 0xFF, 0xFF};
+
+inline uint8x16_t Shuffle16(uint8x16_t bytes, const uint8_t* indices) {
+#if defined(__aarch64__)
+    return vqtbl1q_u8(bytes, vld1q_u8(indices));
+#else
+    uint8x8x2_t table;
+    table.val[0] = vget_low_u8(bytes);
+    table.val[1] = vget_high_u8(bytes);
+    return vcombine_u8(vtbl2_u8(table, vld1_u8(indices)), vtbl2_u8(table, vld1_u8(indices + 8)));
+#endif
+}
+
+/** 4 packed samples (one 12-byte channel group) -> top-aligned lanes. */
+inline int32x4_t LoadTopAligned4(const uint8_t* src) {
+    alignas(16) uint8_t bytes[16] = {};
+    std::memcpy(bytes, src, 12);
+    return vreinterpretq_s32_u8(Shuffle16(vld1q_u8(bytes), kUnpack4));
+}
+
+inline void StoreSaturated4(int32x4_t v, uint8_t* dst) {
+    v = vminq_s32(vmaxq_s32(v, vdupq_n_s32(kMin24)), vdupq_n_s32(kMax24));
+    alignas(16) uint8_t bytes[16];
+    vst1q_u8(bytes, Shuffle16(vreinterpretq_u8_s32(v), kPack4));
+    std::memcpy(dst, bytes, 12);
+}
+
+/** Top-aligned samples -> gain applied, truncated and clamped to 24 bits. */
+inline int32x4_t ScaleVector(int32x4_t top, float32x4_t gain) {
+    const float32x4_t scaled = vmulq_f32(vcvtq_n_f32_s32(top, 8), gain);
+    const float32x4_t clamped = vminq_f32(vmaxq_f32(scaled, vdupq_n_f32(static_cast<float>(kMin24))),
+                                          vdupq_n_f32(static_cast<float>(kMax24)));
+    return vcvtq_s32_f32(clamped);
+}
+
+inline int32_t HorizontalMax(int32x4_t v) {
+#if defined(__aarch64__)
+    return vmaxvq_s32(v);
+#else
+    const int32x2_t pair = vpmax_s32(vget_low_s32(v), vget_high_s32(v));
+    return vget_lane_s32(vpmax_s32(pair, pair), 0);
+#endif
+}
+
+inline int32_t HorizontalMin(int32x4_t v) {
+#if defined(__aarch64__)
+    return vminvq_s32(v);
+#else
+    const int32x2_t pair = vpmin_s32(vget_low_s32(v), vget_high_s32(v));
+    return vget_lane_s32(vpmin_s32(pair, pair), 0);
+#endif
+}
+
+inline float32x4_t NextDither(uint32x4_t& state) {
+    state = veorq_u32(state, vshlq_n_u32(state, 13));
+    state = veorq_u32(state, vshrq_n_u32(state, 17));
+    state = veorq_u32(state, vshlq_n_u32(state, 5));
+    const int32x4_t u1 = vreinterpretq_s32_u32(vandq_u32(state, vdupq_n_u32(0xFFFFu)));
+    const int32x4_t u2 = vreinterpretq_s32_u32(vshrq_n_u32(state, 16));
+    return vcvtq_n_f32_s32(vsubq_s32(u1, u2), 16);
+}
+
+inline int32x4_t RoundToInt(float32x4_t v) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(v);
+#else
+    // ARMv7 only converts toward zero: truncate, then round the fraction to
+    // nearest-even so the result matches lrintf() on AArch64 and scalar.
+    const int32x4_t truncated = vcvtq_s32_f32(v);
+    const float32x4_t fraction = vabsq_f32(vsubq_f32(v, vcvtq_f32_s32(truncated)));
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const uint32x4_t odd = vtstq_s32(truncated, vdupq_n_s32(1));
+    const uint32x4_t roundAway = vorrq_u32(vcgtq_f32(fraction, half),
+                                           vandq_u32(vceqq_f32(fraction, half), odd));
+    const int32x4_t step = vbslq_s32(vcltq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_s32(-1), vdupq_n_s32(1));
+    return vaddq_s32(truncated, vandq_s32(step, vreinterpretq_s32_u32(roundAway)));
+#endif
+}
+
+inline int32x4_t QuantizeVector(const float* src, uint32x4_t* ditherState) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+    float32x4_t scaled = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(src), minusOne), one), kFromFloatScale);
+    if (ditherState) {
+        scaled = vaddq_f32(scaled, NextDither(*ditherState));
+    }
+    return RoundToInt(scaled);
+}
+
+#endif
+
+#if PCM24_HAS_NEON
+/** Fold four consecutive channels starting at @p ch into the accumulators. */
+inline void TrackChannels(int32x4_t samples, size_t ch, ChannelAccumulators& acc) {
+    vst1q_s32(acc.peak + ch, vmaxq_s32(vld1q_s32(acc.peak + ch), vabsq_s32(samples)));
+    const float32x4_t level = vcvtq_n_f32_s32(samples, 23);
+    vst1q_f32(acc.sumSquares + ch, vmlaq_f32(vld1q_f32(acc.sumSquares + ch), level, level));
+}
+#endif
+
+template <bool kWriteBack, bool kTrackChannels>
+void GainFrame(uint8_t* frame, size_t channels, float gain, GainResult& result, ChannelAccumulators& acc) {
+    size_t ch = 0;
+#if PCM24_HAS_NEON
+    const float32x4_t gainVector = vdupq_n_f32(gain);
+    int32x4_t maxVector = vdupq_n_s32(result.maxSample);
+    int32x4_t minVector = vdupq_n_s32(result.minSample);
+
+    for (; ch + 16 <= channels; ch += 16) {
+        uint8_t* src = frame + ch * 3;
+        int32x4_t top[4];
+        LoadTopAligned(src, top);
+        int32x4_t samples[4];
+        for (int k = 0; k < 4; ++k) {
+            samples[k] = kWriteBack ? ScaleVector(top[k], gainVector) : vshrq_n_s32(top[k], 8);
+            maxVector = vmaxq_s32(maxVector, samples[k]);
+            minVector = vminq_s32(minVector, samples[k]);
+            if (kTrackChannels) {
+                TrackChannels(samples[k], ch + 4 * k, acc);
+            }
+        }
+        if (kWriteBack) {
+            StoreSaturated(samples[0], samples[1], samples[2], samples[3], src);
+        }
+    }
+
+    for (; ch + 4 <= channels; ch += 4) {
+        uint8_t* src = frame + ch * 3;
+        const int32x4_t top = LoadTopAligned4(src);
+        const int32x4_t samples = kWriteBack ? ScaleVector(top, gainVector) : vshrq_n_s32(top, 8);
+        maxVector = vmaxq_s32(maxVector, samples);
+        minVector = vminq_s32(minVector, samples);
+        if (kTrackChannels) {
+            TrackChannels(samples, ch, acc);
+        }
+        if (kWriteBack) {
+            StoreSaturated4(samples, src);
+        }
+    }
+
+    result.maxSample = HorizontalMax(maxVector);
+    result.minSample = HorizontalMin(minVector);
+#endif
+    constexpr float kLevelScale = 1.0f / 8388608.0f; // 2^23
+    for (; ch < channels; ++ch) {
+        uint8_t* src = frame + ch * 3;
+        int32_t sample = Unpack(src);
+        if (kWriteBack) {
+            sample = ScaleScalar(sample, gain);
+            Pack(sample, src);
+        }
+        result.maxSample = std::max(result.maxSample, sample);
+        result.minSample = std::min(result.minSample, sample);
+        if (kTrackChannels) {
+            acc.peak[ch] = std::max(acc.peak[ch], std::abs(sample));
+            const float level = static_cast<float>(sample) * kLevelScale;
+            acc.sumSquares[ch] += level * level;
+        }
+    }
+}
+
+template <bool kTrackChannels>
+void ApplyGainRamp(uint8_t* data, size_t frames, size_t channels, float startGain, float endGain,
+                   GainResult& result, ChannelAccumulators& acc) {
+    const size_t frameBytes = channels * 3;
+    if (startGain == 1.0f && endGain == 1.0f) {
+        for (size_t f = 0; f < frames; ++f) {
+            GainFrame<false, kTrackChannels>(data + f * frameBytes, channels, 1.0f, result, acc);
+        }
+        return;
+    }
+
+    const float delta = endGain - startGain;
+    const float invFrames = 1.0f / static_cast<float>(frames);
+    for (size_t f = 0; f < frames; ++f) {
+        // The last frame lands exactly on endGain so consecutive ramps join up.
+        const float gain = (f + 1 == frames) ? endGain
+                                             : startGain + delta * (static_cast<float>(f + 1) * invFrames);
+        GainFrame<true, kTrackChannels>(data + f * frameBytes, channels, gain, result, acc);
+    }
+}
+
+} // namespace
+
+void toInt32(const uint8_t* src, int32_t* dst, size_t samples) {
+    size_t i = 0;
+#if PCM24_HAS_NEON
+    for (; i + 16 <= samples; i += 16) {
+        int32x4_t top[4];
+        LoadTopAligned(src + i * 3, top);
+        vst1q_s32(dst + i, vshrq_n_s32(top[0], 8));
+        vst1q_s32(dst + i + 4, vshrq_n_s32(top[1], 8));
+        vst1q_s32(dst + i + 8, vshrq_n_s32(top[2], 8));
+        vst1q_s32(dst + i + 12, vshrq_n_s32(top[3], 8));
+    }
+#endif
+    for (; i < samples; ++i) {
+        dst[i] = Unpack(src + i * 3);
+    }
+}
+
+void toFloat(const uint8_t* src, float* dst, size_t samples) {
+    size_t i = 0;
+#if PCM24_HAS_NEON
+    for (; i + 16 <= samples; i += 16) {
+        int32x4_t top[4];
+        LoadTopAligned(src + i * 3, top);
+        // Top-aligned value / 2^31 == sample / 2^23, exactly.
+        vst1q_f32(dst + i, vcvtq_n_f32_s32(top[0], 31));
+        vst1q_f32(dst + i + 4, vcvtq_n_f32_s32(top[1], 31));
+        vst1q_f32(dst + i + 8, vcvtq_n_f32_s32(top[2], 31));
+        vst1q_f32(dst + i + 12, vcvtq_n_f32_s32(top[3], 31));
+    }
+#endif
+    constexpr float kScale = 1.0f / 8388608.0f; // 2^23
+    for (; i < samples; ++i) {
+        dst[i] = static_cast<float>(Unpack(src + i * 3)) * kScale;
+    }
+}
+
+void fromInt32(const int32_t* src, uint8_t* dst, size_t samples) {
+    size_t i = 0;
+#if PCM24_HAS_NEON
+    for (; i + 16 <= samples; i += 16) {
+        StoreSaturated(vld1q_s32(src + i), vld1q_s32(src + i + 4),
+                       vld1q_s32(src + i + 8), vld1q_s32(src + i + 12), dst + i * 3);
+    }
+#endif
+    for (; i < samples; ++i) {
+        Pack(src[i], dst + i * 3);
+    }
+}
+
+void fromFloat(const float* src, uint8_t* dst, size_t samples, Dither* dither) {
+    size_t i = 0;
+#if PCM24_HAS_NEON
+    if (samples >= 16) {
+        uint32x4_t state = dither ? vld1q_u32(dither->state) : vdupq_n_u32(0);
+        uint32x4_t* ditherState = dither ? &state : nullptr;
+        for (; i + 16 <= samples; i += 16) {
+            const int32x4_t v0 = QuantizeVector(src + i, ditherState);
+            const int32x4_t v1 = QuantizeVector(src + i + 4, ditherState);
+            const int32x4_t v2 = QuantizeVector(src + i + 8, ditherState);
+            const int32x4_t v3 = QuantizeVector(src + i + 12, ditherState);
+            StoreSaturated(v0, v1, v2, v3, dst + i * 3);
+        }
+        if (dither) {
+            vst1q_u32(dither->state, state);
+        }
+    }
+#endif
+    for (; i < samples; ++i) {
+        Pack(QuantizeScalar(src[i], dither, i), dst + i * 3);
+    }
+}
+
+GainResult applyGain(uint8_t* data, size_t frames, size_t channels, float startGain, float endGain,
+                     ChannelAccumulators* accumulators) {
+    GainResult result;
+    if (!data || frames == 0 || channels == 0) {
+        return result;
+    }
+
+    if (accumulators && accumulators->peak && accumulators->sumSquares) {
+        ApplyGainRamp<true>(data, frames, channels, startGain, endGain, result, *accumulators);
+    } else {
+        ChannelAccumulators unused;
+        ApplyGainRamp<false>(data, frames, channels, startGain, endGain, result, unused);
+    }
+    return result;
+}
+
+} // namespace pcm24
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Packed 24-bit little-endian PCM conversion kernels shared by the recorder,
+ * the WAV reader and the pre-render encoder. NEON builds handle 16 samples
+ * per iteration (vld3/vst3 byte planes); other ABIs use the scalar loops.
+ */
+namespace pcm24 {
+
+/**
+ * TPDF dither source: +/-1 LSB triangular noise from four xorshift32 lanes.
+ * NEON and scalar paths consume the lanes in the same order, so a given
+ * seed produces the same output on every ABI.
+ */
+struct Dither {
+    uint32_t state[4] = {0x9E3779B9u, 0x7F4A7C15u, 0x94D049BBu, 0x2545F491u};
+};
+
+/** Sign-extended samples in [-2^23, 2^23). */
+void toInt32(const uint8_t* src, int32_t* dst, size_t samples);
+
+/** Samples scaled by 1/2^23 into [-1, 1). */
+void toFloat(const uint8_t* src, float* dst, size_t samples);
+
+/** Saturate to the 24-bit range and pack. */
+void fromInt32(const int32_t* src, uint8_t* dst, size_t samples);
+
+/**
+ * Scale by 2^23 - 1, round to nearest and saturate. With @p dither, TPDF
+ * noise is added before rounding.
+ */
+void fromFloat(const float* src, uint8_t* dst, size_t samples, Dither* dither = nullptr);
+
+/** Extremes of the samples seen by applyGain(), after gain. */
+struct GainResult {
+    int32_t maxSample = kMinSample;
+    int32_t minSample = kMaxSample;
+
+    static constexpr int32_t kMinSample = -8388608;
+    static constexpr int32_t kMaxSample = 8388607;
+
+    [[nodiscard]] int32_t peak() const { return std::max({0, maxSample, -minSample}); }
+    [[nodiscard]] bool clipped() const { return maxSample >= kMaxSample || minSample <= kMinSample; }
+};
+
+/**
+ * Optional per-channel accumulators for applyGain(), one entry per channel.
+ * They are updated in place, so a caller can accumulate over several
+ * buffers and reset when it publishes.
+ */
+struct ChannelAccumulators {
+    int32_t* peak = nullptr;       // running max |sample| after gain
+    float* sumSquares = nullptr;   // running sum of (sample / 2^23)^2
+};
+
+/**
+ * Apply a linear gain ramp in place to @p frames interleaved frames of
+ * @p channels packed samples: frame f is scaled by
+ * startGain + (endGain - startGain) * (f + 1) / frames, truncated toward
+ * zero and saturated. When both gains are exactly 1 the data is only
+ * scanned, never rewritten. With @p accumulators, per-channel peak and
+ * energy are tracked in the same pass.
+ */
+GainResult applyGain(uint8_t* data, size_t frames, size_t channels, float startGain, float endGain,
+                     ChannelAccumulators* accumulators = nullptr);
+
+} // namespace pcm24
@@ -1,15 +1,37 @@
 #include "audio_output.h"
 #include <android/log.h>
+#include <algorithm>
 #include <cstring>
 
 #define LOG_TAG "AudioOutput"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 namespace spcmic {
 
+namespace {
+
+void floatToInt16(const float* src, int16_t* dst, int32_t samples) {
+    for (int32_t i = 0; i < samples; i++) {
+        float sample = src[i];
+        // Clamp to [-1.0, 1.0]
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        // Convert to int16
+        dst[i] = (int16_t)(sample * 32767.0f);
+    }
+}
+
+} // namespace
+
 AudioOutput::AudioOutput()
-    : engineObject_(nullptr)
+    : aaudioStream_(nullptr)
+    , xRunOffset_(0)
+    , xRunCount_(0)
+    , restartPending_(false)
+    , shuttingDown_(false)
+    , engineObject_(nullptr)
     , engineEngine_(nullptr)
     , outputMixObject_(nullptr)
     , playerObject_(nullptr)
@@ -17,10 +39,12 @@ AudioOutput::AudioOutput()
     , playerBufferQueue_(nullptr)
     , sampleRate_(0)
     , bufferFrames_(0)
+    , framesPerBurst_(0)
+    , backend_(Backend::None)
+    , floatBuffer_(nullptr)
     , currentBuffer_(0)
     , isPlaying_(false)
-    , isInitialized_(false)
-    , floatBuffer_(nullptr) {
+    , isInitialized_(false) {
     
     for (int i = 0; i < NUM_BUFFERS; i++) {
         audioBuffers_[i] = nullptr;
@@ -38,14 +62,99 @@ bool AudioOutput::initialize(int32_t sampleRate, int32_t bufferFrames, AudioCall
     bufferFrames_ = bufferFrames;
     callback_ = callback;
 
+    std::lock_guard<std::mutex> lock(streamMutex_);
+
+    if (openAAudio()) {
+        backend_ = Backend::AAudio;
+    } else {
+        LOGW("AAudio output unavailable, falling back to OpenSL ES");
+        closeAAudio();
+        if (!openOpenSL()) {
+            closeOpenSL();
+            return false;
+        }
+        backend_ = Backend::OpenSL;
+        framesPerBurst_ = bufferFrames_;
+    }
+
+    isInitialized_ = true;
+    LOGD("AudioOutput initialized (%s): %d Hz, %d frames/burst, %d frames max per callback",
+         backend_ == Backend::AAudio ? "AAudio" : "OpenSL ES", sampleRate, framesPerBurst_, bufferFrames);
+    
+    return true;
+}
+
+bool AudioOutput::openAAudio() {
+    AAudioStreamBuilder* builder = nullptr;
+    aaudio_result_t result = AAudio_createStreamBuilder(&builder);
+    if (result != AAUDIO_OK) {
+        LOGW("AAudio_createStreamBuilder failed: %s", AAudio_convertResultToText(result));
+        return false;
+    }
+
+    AAudioStreamBuilder_setDirection(builder, AAUDIO_DIRECTION_OUTPUT);
+    AAudioStreamBuilder_setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+    // Exclusive (MMAP) where the device offers it; AAudio drops to shared otherwise.
+    AAudioStreamBuilder_setSharingMode(builder, AAUDIO_SHARING_MODE_EXCLUSIVE);
+    AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_FLOAT);
+    AAudioStreamBuilder_setChannelCount(builder, 2);
+    AAudioStreamBuilder_setSampleRate(builder, sampleRate_);
+    AAudioStreamBuilder_setUsage(builder, AAUDIO_USAGE_MEDIA);
+    AAudioStreamBuilder_setContentType(builder, AAUDIO_CONTENT_TYPE_MUSIC);
+    // Frames per callback left unspecified so callbacks arrive one burst at a time.
+    AAudioStreamBuilder_setDataCallback(builder, aaudioDataCallback, this);
+    AAudioStreamBuilder_setErrorCallback(builder, aaudioErrorCallback, this);
+
+    result = AAudioStreamBuilder_openStream(builder, &aaudioStream_);
+    AAudioStreamBuilder_delete(builder);
+    if (result != AAUDIO_OK) {
+        LOGW("AAudio openStream failed: %s", AAudio_convertResultToText(result));
+        aaudioStream_ = nullptr;
+        return false;
+    }
+
+    if (AAudioStream_getFormat(aaudioStream_) != AAUDIO_FORMAT_PCM_FLOAT ||
+        AAudioStream_getChannelCount(aaudioStream_) != 2 ||
+        AAudioStream_getSampleRate(aaudioStream_) != sampleRate_) {
+        LOGW("AAudio stream mismatch: format %d, %d ch, %d Hz",
+             AAudioStream_getFormat(aaudioStream_),
+             AAudioStream_getChannelCount(aaudioStream_),
+             AAudioStream_getSampleRate(aaudioStream_));
+        closeAAudio();
+        return false;
+    }
+
+    framesPerBurst_ = std::max<int32_t>(1, AAudioStream_getFramesPerBurst(aaudioStream_));
+    AAudioStream_setBufferSizeInFrames(aaudioStream_, framesPerBurst_ * AAUDIO_INITIAL_BURSTS);
+    xRunOffset_ = AAudioStream_getXRunCount(aaudioStream_);
+    xRunCount_.store(0, std::memory_order_relaxed);
+
+    LOGD("AAudio stream open: burst %d, buffer %d/%d frames, %s, perf mode %d",
+         framesPerBurst_,
+         AAudioStream_getBufferSizeInFrames(aaudioStream_),
+         AAudioStream_getBufferCapacityInFrames(aaudioStream_),
+         AAudioStream_getSharingMode(aaudioStream_) == AAUDIO_SHARING_MODE_EXCLUSIVE ? "exclusive" : "shared",
+         AAudioStream_getPerformanceMode(aaudioStream_));
+    return true;
+}
+
+void AudioOutput::closeAAudio() {
+    if (aaudioStream_) {
+        AAudioStream_requestStop(aaudioStream_);
+        AAudioStream_close(aaudioStream_);
+        aaudioStream_ = nullptr;
+    }
+}
+
+bool AudioOutput::openOpenSL() {
     // Allocate audio buffers (stereo int16 for OpenSL ES)
     for (int i = 0; i < NUM_BUFFERS; i++) {
-        audioBuffers_[i] = new int16_t[bufferFrames * 2];
-        memset(audioBuffers_[i], 0, bufferFrames * 2 * sizeof(int16_t));
+        audioBuffers_[i] = new int16_t[bufferFrames_ * 2];
+        memset(audioBuffers_[i], 0, bufferFrames_ * 2 * sizeof(int16_t));
     }
     
     // Allocate temp float buffer for callback
-    floatBuffer_ = new float[bufferFrames * 2];
+    floatBuffer_ = new float[bufferFrames_ * 2];
 
     // Create OpenSL ES engine
     SLresult result = slCreateEngine(&engineObject_, 0, nullptr, 0, nullptr, nullptr);
@@ -89,7 +198,7 @@ bool AudioOutput::initialize(int32_t sampleRate, int32_t bufferFrames, AudioCall
     SLDataFormat_PCM format_pcm = {
         SL_DATAFORMAT_PCM,
         2,                                          // 2 channels (stereo)
-        static_cast<SLuint32>(sampleRate * 1000),  // Sample rate in milliHz
+        static_cast<SLuint32>(sampleRate_ * 1000),  // Sample rate in milliHz
         SL_PCMSAMPLEFORMAT_FIXED_16,                // 16-bit signed integer PCM
         SL_PCMSAMPLEFORMAT_FIXED_16,
         SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT,
@@ -152,32 +261,74 @@ bool AudioOutput::initialize(int32_t sampleRate, int32_t bufferFrames, AudioCall
         return false;
     }
 
-    isInitialized_ = true;
-    LOGD("AudioOutput initialized: %d Hz, %d frames/buffer", sampleRate, bufferFrames);
-    
     return true;
 }
 
+void AudioOutput::closeOpenSL() {
+    // Destroy player
+    if (playerObject_) {
+        (*playerObject_)->Destroy(playerObject_);
+        playerObject_ = nullptr;
+        playerPlay_ = nullptr;
+        playerBufferQueue_ = nullptr;
+    }
+
+    // Destroy output mix
+    if (outputMixObject_) {
+        (*outputMixObject_)->Destroy(outputMixObject_);
+        outputMixObject_ = nullptr;
+    }
+
+    // Destroy engine
+    if (engineObject_) {
+        (*engineObject_)->Destroy(engineObject_);
+        engineObject_ = nullptr;
+        engineEngine_ = nullptr;
+    }
+
+    // Free buffers
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        if (audioBuffers_[i]) {
+            delete[] audioBuffers_[i];
+            audioBuffers_[i] = nullptr;
+        }
+    }
+    
+    if (floatBuffer_) {
+        delete[] floatBuffer_;
+        floatBuffer_ = nullptr;
+    }
+}
+
 bool AudioOutput::start() {
-    if (!isInitialized_ || isPlaying_) {
+    std::lock_guard<std::mutex> lock(streamMutex_);
+    if (!isInitialized_ || isPlaying_.load(std::memory_order_relaxed)) {
         return false;
     }
 
+    if (backend_ == Backend::AAudio) {
+        if (!aaudioStream_) {
+            LOGE("AAudio stream not available");
+            return false;
+        }
+        // Set before the request so the first callback already renders audio.
+        isPlaying_.store(true, std::memory_order_release);
+        aaudio_result_t result = AAudioStream_requestStart(aaudioStream_);
+        if (result != AAUDIO_OK) {
+            isPlaying_.store(false, std::memory_order_release);
+            LOGE("Failed to start AAudio stream: %s", AAudio_convertResultToText(result));
+            return false;
+        }
+        LOGD("Playback started");
+        return true;
+    }
+
     // Enqueue initial buffers
     for (int i = 0; i < NUM_BUFFERS; i++) {
         if (callback_) {
             // Get float samples from callback
             callback_(floatBuffer_, bufferFrames_);
-            
-            // Convert float to int16
-            for (int32_t j = 0; j < bufferFrames_ * 2; j++) {
-                float sample = floatBuffer_[j];
-                // Clamp to [-1.0, 1.0]
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                // Convert to int16
-                audioBuffers_[i][j] = (int16_t)(sample * 32767.0f);
-            }
+            floatToInt16(floatBuffer_, audioBuffers_[i], bufferFrames_ * 2);
         }
         
         (*playerBufferQueue_)->Enqueue(
@@ -194,71 +345,167 @@ bool AudioOutput::start() {
         return false;
     }
 
-    isPlaying_ = true;
+    isPlaying_.store(true, std::memory_order_release);
     LOGD("Playback started");
     return true;
 }
 
 void AudioOutput::stop() {
-    if (!isInitialized_ || !isPlaying_) {
+    std::lock_guard<std::mutex> lock(streamMutex_);
+    if (!isInitialized_ || !isPlaying_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    isPlaying_.store(false, std::memory_order_release);
+
+    if (backend_ == Backend::AAudio) {
+        if (aaudioStream_) {
+            // Wait for the callback to go quiet so the engine can reset its buffers safely.
+            AAudioStream_requestStop(aaudioStream_);
+            aaudio_stream_state_t next = AAUDIO_STREAM_STATE_STOPPING;
+            AAudioStream_waitForStateChange(aaudioStream_, AAUDIO_STREAM_STATE_STOPPING, &next,
+                                            AAUDIO_STATE_TIMEOUT_NS);
+        }
+        LOGD("Playback stopped");
         return;
     }
 
     (*playerPlay_)->SetPlayState(playerPlay_, SL_PLAYSTATE_STOPPED);
     (*playerBufferQueue_)->Clear(playerBufferQueue_);
     
-    isPlaying_ = false;
     LOGD("Playback stopped");
 }
 
 void AudioOutput::pause() {
-    if (!isInitialized_ || !isPlaying_) {
+    std::lock_guard<std::mutex> lock(streamMutex_);
+    if (!isInitialized_ || !isPlaying_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    isPlaying_.store(false, std::memory_order_release);
+
+    if (backend_ == Backend::AAudio) {
+        if (aaudioStream_) {
+            AAudioStream_requestPause(aaudioStream_);
+            aaudio_stream_state_t next = AAUDIO_STREAM_STATE_PAUSING;
+            AAudioStream_waitForStateChange(aaudioStream_, AAUDIO_STREAM_STATE_PAUSING, &next,
+                                            AAUDIO_STATE_TIMEOUT_NS);
+        }
+        LOGD("Playback paused");
         return;
     }
 
     (*playerPlay_)->SetPlayState(playerPlay_, SL_PLAYSTATE_PAUSED);
-    isPlaying_ = false;
     LOGD("Playback paused");
 }
 
 void AudioOutput::shutdown() {
+    // A disconnect restart in flight must finish before the stream goes away.
+    std::thread restart;
+    {
+        std::lock_guard<std::mutex> lock(restartMutex_);
+        shuttingDown_ = true;
+        restart = std::move(restartThread_);
+    }
+    if (restart.joinable()) {
+        restart.join();
+    }
+
     stop();
 
-    // Destroy player
-    if (playerObject_) {
-        (*playerObject_)->Destroy(playerObject_);
-        playerObject_ = nullptr;
-        playerPlay_ = nullptr;
-        playerBufferQueue_ = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(streamMutex_);
+        closeAAudio();
+        closeOpenSL();
+        backend_ = Backend::None;
+        isInitialized_ = false;
     }
 
-    // Destroy output mix
-    if (outputMixObject_) {
-        (*outputMixObject_)->Destroy(outputMixObject_);
-        outputMixObject_ = nullptr;
+    std::lock_guard<std::mutex> lock(restartMutex_);
+    shuttingDown_ = false;
+    restartPending_ = false;
+}
+
+aaudio_data_callback_result_t AudioOutput::aaudioDataCallback(AAudioStream* stream, void* userData,
+                                                             void* audioData, int32_t numFrames) {
+    AudioOutput* output = static_cast<AudioOutput*>(userData);
+    output->renderAAudio(stream, static_cast<float*>(audioData), numFrames);
+    return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+void AudioOutput::renderAAudio(AAudioStream* stream, float* output, int32_t numFrames) {
+    if (!isPlaying_.load(std::memory_order_acquire) || !callback_) {
+        memset(output, 0, static_cast<size_t>(numFrames) * 2 * sizeof(float));
+        return;
     }
 
-    // Destroy engine
-    if (engineObject_) {
-        (*engineObject_)->Destroy(engineObject_);
-        engineObject_ = nullptr;
-        engineEngine_ = nullptr;
+    // The engine never sees more than bufferFrames_ at once.
+    int32_t done = 0;
+    while (done < numFrames) {
+        const int32_t frames = std::min(numFrames - done, bufferFrames_);
+        callback_(output + static_cast<size_t>(done) * 2, frames);
+        done += frames;
     }
 
-    // Free buffers
-    for (int i = 0; i < NUM_BUFFERS; i++) {
-        if (audioBuffers_[i]) {
-            delete[] audioBuffers_[i];
-            audioBuffers_[i] = nullptr;
+    // Each new underrun buys one more burst of buffering, up to the ceiling.
+    const int32_t xRuns = AAudioStream_getXRunCount(stream);
+    if (xRuns > xRunOffset_) {
+        xRunCount_.fetch_add(xRuns - xRunOffset_, std::memory_order_relaxed);
+        xRunOffset_ = xRuns;
+        const int32_t current = AAudioStream_getBufferSizeInFrames(stream);
+        const int32_t ceiling = std::min(AAudioStream_getBufferCapacityInFrames(stream),
+                                         framesPerBurst_ * AAUDIO_MAX_BURSTS);
+        if (current + framesPerBurst_ <= ceiling) {
+            AAudioStream_setBufferSizeInFrames(stream, current + framesPerBurst_);
         }
     }
-    
-    if (floatBuffer_) {
-        delete[] floatBuffer_;
-        floatBuffer_ = nullptr;
+}
+
+void AudioOutput::aaudioErrorCallback(AAudioStream* /* stream */, void* userData, aaudio_result_t error) {
+    AudioOutput* output = static_cast<AudioOutput*>(userData);
+    if (error != AAUDIO_ERROR_DISCONNECTED) {
+        LOGE("AAudio stream error: %s", AAudio_convertResultToText(error));
+        return;
     }
 
-    isInitialized_ = false;
+    // Closing a stream from its own callback is not allowed; reopen on a helper thread.
+    std::lock_guard<std::mutex> lock(output->restartMutex_);
+    if (output->shuttingDown_ || output->restartPending_) {
+        return;
+    }
+    output->restartPending_ = true;
+    if (output->restartThread_.joinable()) {
+        output->restartThread_.join();  // previous restart has already finished
+    }
+    output->restartThread_ = std::thread(&AudioOutput::restartAAudio, output);
+}
+
+void AudioOutput::restartAAudio() {
+    {
+        std::lock_guard<std::mutex> lock(streamMutex_);
+        const bool wasPlaying = isPlaying_.load(std::memory_order_acquire);
+        LOGW("AAudio stream disconnected, reopening (was %s)", wasPlaying ? "playing" : "idle");
+        closeAAudio();
+
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> restartLock(restartMutex_);
+            stopping = shuttingDown_;
+        }
+
+        if (!stopping) {
+            if (!openAAudio()) {
+                LOGE("Failed to reopen AAudio stream after disconnect");
+                isPlaying_.store(false, std::memory_order_release);
+            } else if (wasPlaying && AAudioStream_requestStart(aaudioStream_) != AAUDIO_OK) {
+                LOGE("Failed to restart AAudio stream after disconnect");
+                isPlaying_.store(false, std::memory_order_release);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(restartMutex_);
+    restartPending_ = false;
 }
 
 void AudioOutput::audioCallback(SLAndroidSimpleBufferQueueItf bq, void* context) {
@@ -267,7 +514,7 @@ void AudioOutput::audioCallback(SLAndroidSimpleBufferQueueItf bq, void* context)
 }
 
 void AudioOutput::processAudio(SLAndroidSimpleBufferQueueItf bq) {
-    if (!isPlaying_ || !callback_) {
+    if (!isPlaying_.load(std::memory_order_acquire) || !callback_) {
         return;
     }
 
@@ -277,16 +524,7 @@ void AudioOutput::processAudio(SLAndroidSimpleBufferQueueItf bq) {
 
     // Fill float buffer with audio data from callback
     callback_(floatBuffer_, bufferFrames_);
-    
-    // Convert float to int16
-    for (int32_t i = 0; i < bufferFrames_ * 2; i++) {
-        float sample = floatBuffer_[i];
-        // Clamp to [-1.0, 1.0]
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        // Convert to int16
-        buffer[i] = (int16_t)(sample * 32767.0f);
-    }
+    floatToInt16(floatBuffer_, buffer, bufferFrames_ * 2);
 
     // Enqueue buffer
     (*bq)->Enqueue(bq, buffer, bufferFrames_ * 2 * sizeof(int16_t));
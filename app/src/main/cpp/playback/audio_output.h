@@ -3,26 +3,39 @@
 
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
+#include <aaudio/AAudio.h>
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 namespace spcmic {
 
 /**
- * Low-latency audio output using OpenSL ES
- * Handles stereo PCM float output
+ * Low-latency stereo float output.
+ * Uses an AAudio low-latency float stream whose callbacks follow the device
+ * burst; falls back to an OpenSL ES int16 buffer queue when AAudio cannot
+ * open a matching stream.
  */
 class AudioOutput {
 public:
     using AudioCallback = std::function<void(float* buffer, int32_t numFrames)>;
 
+    enum class Backend {
+        None,
+        AAudio,
+        OpenSL
+    };
+
     AudioOutput();
     ~AudioOutput();
 
     /**
      * Initialize audio output
      * @param sampleRate Sample rate (48000 or 96000)
-     * @param bufferFrames Frames per buffer (larger = more latency, more stability)
+     * @param bufferFrames Largest request passed to the callback; also the
+     *        OpenSL buffer size (larger = more latency, more stability)
      * @param callback Audio callback to fill buffers
      * @return true if successful
      */
@@ -46,7 +59,22 @@ public:
     /**
      * Check if currently playing
      */
-    bool isPlaying() const { return isPlaying_; }
+    bool isPlaying() const { return isPlaying_.load(std::memory_order_acquire); }
+
+    /**
+     * Backend chosen by the last initialize()
+     */
+    Backend getBackend() const { return backend_; }
+
+    /**
+     * Device burst in frames (AAudio), or the OpenSL buffer size
+     */
+    int32_t getFramesPerBurst() const { return framesPerBurst_; }
+
+    /**
+     * Underruns reported by the AAudio stream since it was opened
+     */
+    int32_t getXRunCount() const { return xRunCount_.load(std::memory_order_relaxed); }
 
     /**
      * Clean up resources
@@ -54,6 +82,23 @@ public:
     void shutdown();
 
 private:
+    static constexpr int32_t AAUDIO_INITIAL_BURSTS = 2;   // buffered bursts at start
+    static constexpr int32_t AAUDIO_MAX_BURSTS = 8;       // ceiling when underruns push the buffer up
+    static constexpr int64_t AAUDIO_STATE_TIMEOUT_NS = 200000000;
+
+    // AAudio backend
+    bool openAAudio();
+    void closeAAudio();
+    void restartAAudio();
+    static aaudio_data_callback_result_t aaudioDataCallback(AAudioStream* stream, void* userData,
+                                                           void* audioData, int32_t numFrames);
+    static void aaudioErrorCallback(AAudioStream* stream, void* userData, aaudio_result_t error);
+    void renderAAudio(AAudioStream* stream, float* output, int32_t numFrames);
+
+    // OpenSL ES backend
+    bool openOpenSL();
+    void closeOpenSL();
+
     /**
      * OpenSL ES callback (static)
      */
@@ -64,6 +109,18 @@ private:
      */
     void processAudio(SLAndroidSimpleBufferQueueItf bq);
 
+    // AAudio objects
+    AAudioStream* aaudioStream_;
+    int32_t xRunOffset_;            // xruns already handled by the buffer-size tuner
+    std::atomic<int32_t> xRunCount_;
+
+    // Disconnect handling: the stream is reopened off the callback thread
+    std::mutex streamMutex_;        // open/close/start/stop
+    std::mutex restartMutex_;       // restartThread_ and the flags below
+    std::thread restartThread_;
+    bool restartPending_;
+    bool shuttingDown_;
+
     // OpenSL ES objects
     SLObjectItf engineObject_;
     SLEngineItf engineEngine_;
@@ -75,15 +132,17 @@ private:
     // Audio parameters
     int32_t sampleRate_;
     int32_t bufferFrames_;
+    int32_t framesPerBurst_;
     AudioCallback callback_;
-    
+    Backend backend_;
+
     // Double buffering (16-bit PCM for OpenSL ES)
     static constexpr int32_t NUM_BUFFERS = 8;
     int16_t* audioBuffers_[NUM_BUFFERS];  // PCM int16 buffers for OpenSL ES
     float* floatBuffer_;                   // Temp float buffer from callback
     int32_t currentBuffer_;
-    
-    bool isPlaying_;
+
+    std::atomic<bool> isPlaying_;
     bool isInitialized_;
 };
 
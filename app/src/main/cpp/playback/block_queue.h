@@ -0,0 +1,46 @@
+#ifndef SPCMIC_BLOCK_QUEUE_H
+#define SPCMIC_BLOCK_QUEUE_H
+
+#include "lock_free_ring_buffer.h"
+
+#include <cstdint>
+
+namespace spcmic {
+
+/**
+ * Bounded single-producer, single-consumer queue of block indices on top of
+ * LockFreeRingBuffer. Stages pass ownership of preallocated blocks by index,
+ * so nothing is allocated or copied per block.
+ */
+class BlockQueue {
+public:
+    explicit BlockQueue(size_t maxEntries)
+        : ring_(maxEntries * sizeof(uint32_t)) {
+    }
+
+    /** Producer side; false when the queue is full. */
+    bool push(uint32_t index) {
+        // Only the consumer frees space, so this check cannot go stale.
+        if (ring_.getAvailableSpace() < sizeof(index)) {
+            return false;
+        }
+        ring_.write(reinterpret_cast<const uint8_t*>(&index), sizeof(index));
+        return true;
+    }
+
+    /** Consumer side; false when the queue is empty. */
+    bool pop(uint32_t& index) {
+        if (ring_.getAvailableBytes() < sizeof(index)) {
+            return false;
+        }
+        ring_.read(reinterpret_cast<uint8_t*>(&index), sizeof(index));
+        return true;
+    }
+
+private:
+    LockFreeRingBuffer ring_;
+};
+
+} // namespace spcmic
+
+#endif // SPCMIC_BLOCK_QUEUE_H
@@ -0,0 +1,557 @@
+#include "offline_renderer.h"
+#include "pcm24.h"
+#include "wav_writer.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+#define LOG_TAG "OfflineRenderer"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace spcmic {
+
+namespace {
+
+// 64 blocks of 2048 frames: ~2.7 s at 48 kHz, small enough to keep a few
+// segments of 3OA output in flight, long enough that the IR pre-roll
+// (at most four blocks) costs only a few percent.
+constexpr int64_t kSegmentBlocks = 64;
+constexpr int kSlotsPerWorker = 2;
+
+// Blocks per pipeline pool: enough to ride out a slow flash write or a
+// readahead miss without the convolver noticing.
+constexpr uint32_t kPipelineBlocks = 8;
+constexpr auto kPollInterval = std::chrono::microseconds(200);
+
+int64_t ElapsedMicros(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+OfflineRenderer::OfflineRenderer(const Request& request)
+    : request_(request)
+    , blockFrames_(0)
+    , inputChannels_(0)
+    , totalOutputChannels_(0)
+    , maxOutputChannels_(0)
+    , sourceFrames_(0)
+    , outputFrames_(0)
+    , preRollFrames_(0)
+    , segmentFrames_(0)
+    , segmentCount_(0)
+    , nextSegment_(0)
+    , nextToWrite_(0)
+    , abort_(false)
+    , framesRendered_(0)
+    , pipelineFailed_(false) {
+}
+
+bool OfflineRenderer::run() {
+    targets_.clear();
+
+    if (!request_.source || !request_.source->isOpen() || request_.targets.empty()) {
+        LOGE("Offline render request is incomplete");
+        return false;
+    }
+
+    blockFrames_ = request_.targets.front().prototype ? request_.targets.front().prototype->blockSize() : 0;
+    inputChannels_ = request_.source->getNumChannels();
+    sourceFrames_ = request_.source->getTotalFrames();
+    totalOutputChannels_ = 0;
+    maxOutputChannels_ = 0;
+    outputFrames_ = 0;
+    preRollFrames_ = 0;
+
+    for (const Target& target : request_.targets) {
+        if (!target.prototype || !target.prototype->isReady() || !target.writer || target.outputChannels <= 0) {
+            LOGE("Offline render target %zu is incomplete", targets_.size());
+            targets_.clear();
+            return false;
+        }
+        if (target.prototype->numOutputChannels() != target.outputChannels) {
+            LOGE("Convolver produces %d channels, writer expects %d",
+                 target.prototype->numOutputChannels(), target.outputChannels);
+            targets_.clear();
+            return false;
+        }
+        if (target.prototype->blockSize() != blockFrames_) {
+            LOGE("Offline render targets use different block sizes (%d, %d)",
+                 target.prototype->blockSize(), blockFrames_);
+            targets_.clear();
+            return false;
+        }
+
+        TargetState state;
+        const int64_t tailFrames = static_cast<int64_t>(target.prototype->tailBlockCount()) * blockFrames_;
+        state.outputFrames = sourceFrames_ + tailFrames;
+        state.sampleOffset = static_cast<size_t>(blockFrames_) * totalOutputChannels_;
+        targets_.push_back(state);
+
+        totalOutputChannels_ += target.outputChannels;
+        maxOutputChannels_ = std::max(maxOutputChannels_, target.outputChannels);
+        outputFrames_ = std::max(outputFrames_, state.outputFrames);
+        preRollFrames_ = std::max(preRollFrames_, tailFrames);
+    }
+    segmentFrames_ = kSegmentBlocks * blockFrames_;
+    segmentCount_ = std::max<int64_t>(1, (sourceFrames_ + segmentFrames_ - 1) / segmentFrames_);
+
+    int workers = static_cast<int>(std::clamp<int64_t>(request_.threads, 1, segmentCount_));
+
+    // Worker 0 uses the caller's reader; the others need their own file position.
+    std::vector<std::unique_ptr<WavFileReader>> extraReaders;
+    std::vector<WavFileReader*> readers{request_.source};
+    for (int i = 1; i < workers; ++i) {
+        auto reader = std::make_unique<WavFileReader>();
+        if (!reader->openDuplicate(*request_.source)) {
+            LOGW("Could not open reader %d; rendering with %d worker(s)", i, i);
+            break;
+        }
+        readers.push_back(reader.get());
+        extraReaders.push_back(std::move(reader));
+    }
+    workers = static_cast<int>(readers.size());
+
+    framesRendered_.store(0, std::memory_order_relaxed);
+    if (workers == 1) {
+        LOGD("Offline render: %lld frames to %zu target(s), pipelined",
+             static_cast<long long>(sourceFrames_), targets_.size());
+        return runPipelined();
+    }
+
+    LOGD("Offline render: %lld frames to %zu target(s) in %lld segment(s) on %d worker(s)",
+         static_cast<long long>(sourceFrames_), targets_.size(),
+         static_cast<long long>(segmentCount_), workers);
+    return runParallel(readers);
+}
+
+int64_t OfflineRenderer::targetFrames(size_t target, int64_t blockStart) const {
+    return std::clamp<int64_t>(targets_[target].outputFrames - blockStart, 0, blockFrames_);
+}
+
+bool OfflineRenderer::configureConvolvers(std::vector<std::unique_ptr<MatrixConvolver>>& convolvers) const {
+    convolvers.clear();
+    for (const Target& target : request_.targets) {
+        auto convolver = std::make_unique<MatrixConvolver>();
+        if (!convolver->configureFrom(*target.prototype)) {
+            return false;
+        }
+        convolvers.push_back(std::move(convolver));
+    }
+    return true;
+}
+
+bool OfflineRenderer::runPipelined() {
+    const int64_t blockCount = (outputFrames_ + blockFrames_ - 1) / blockFrames_;
+
+    std::vector<std::unique_ptr<MatrixConvolver>> convolvers;
+    if (!configureConvolvers(convolvers)) {
+        LOGE("Failed to configure pipeline convolver");
+        return false;
+    }
+
+    if (!request_.source->seek(0)) {
+        LOGE("Failed to rewind source before render");
+        return false;
+    }
+
+    inputBlocks_.assign(kPipelineBlocks, PipelineBlock{});
+    outputBlocks_.assign(kPipelineBlocks, PipelineBlock{});
+    inputFree_ = std::make_unique<BlockQueue>(kPipelineBlocks);
+    inputFilled_ = std::make_unique<BlockQueue>(kPipelineBlocks);
+    outputFree_ = std::make_unique<BlockQueue>(kPipelineBlocks);
+    outputFilled_ = std::make_unique<BlockQueue>(kPipelineBlocks);
+    for (uint32_t i = 0; i < kPipelineBlocks; ++i) {
+        inputBlocks_[i].samples.assign(static_cast<size_t>(blockFrames_) * inputChannels_, 0.0f);
+        outputBlocks_[i].samples.assign(static_cast<size_t>(blockFrames_) * totalOutputChannels_, 0.0f);
+        inputFree_->push(i);
+        outputFree_->push(i);
+    }
+    pipelineFailed_.store(false, std::memory_order_relaxed);
+
+    std::thread readerThread;
+    std::thread writerThread;
+    try {
+        readerThread = std::thread(&OfflineRenderer::pipelineReaderLoop, this, blockCount);
+        writerThread = std::thread(&OfflineRenderer::pipelineWriterLoop, this, blockCount);
+    } catch (const std::system_error& e) {
+        LOGE("Failed to start pipeline thread: %s", e.what());
+        failPipeline();
+    }
+
+    for (int64_t block = 0; block < blockCount && !pipelineFailed_.load(std::memory_order_acquire); ++block) {
+        uint32_t in = 0;
+        uint32_t out = 0;
+        if (!popWaiting(*inputFilled_, in, RenderStage::ConvolverInput) ||
+            !popWaiting(*outputFree_, out, RenderStage::ConvolverOutput)) {
+            break;
+        }
+
+        PipelineBlock& input = inputBlocks_[in];
+        PipelineBlock& output = outputBlocks_[out];
+        for (size_t t = 0; t < targets_.size(); ++t) {
+            // Shorter IRs finish their tail before the longest one.
+            if (targetFrames(t, input.start) > 0) {
+                convolvers[t]->process(input.samples.data(), output.samples.data() + targets_[t].sampleOffset,
+                                       blockFrames_);
+            }
+        }
+        output.start = input.start;
+        output.frames = input.frames;
+
+        // Both queues hold every block of their pool, so these never fail.
+        inputFree_->push(in);
+        outputFilled_->push(out);
+        reportFrames(output.frames);
+    }
+
+    if (readerThread.joinable()) {
+        readerThread.join();
+    }
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+
+    bool ok = !pipelineFailed_.load(std::memory_order_acquire);
+    for (const TargetState& target : targets_) {
+        ok = ok && target.framesWritten == target.outputFrames;
+    }
+
+    inputFree_.reset();
+    inputFilled_.reset();
+    outputFree_.reset();
+    outputFilled_.reset();
+    inputBlocks_.clear();
+    outputBlocks_.clear();
+    return ok;
+}
+
+void OfflineRenderer::pipelineReaderLoop(int64_t blockCount) {
+    WavFileReader& reader = *request_.source;
+    const size_t samplesPerBlock = static_cast<size_t>(blockFrames_) * inputChannels_;
+
+    for (int64_t block = 0; block < blockCount; ++block) {
+        uint32_t index = 0;
+        if (!popWaiting(*inputFree_, index, RenderStage::Reader)) {
+            return;
+        }
+
+        PipelineBlock& input = inputBlocks_[index];
+        const int64_t blockStart = block * blockFrames_;
+        int32_t framesRead = 0;
+        if (blockStart < sourceFrames_) {
+            const int32_t expected = static_cast<int32_t>(
+                std::min<int64_t>(blockFrames_, sourceFrames_ - blockStart));
+            framesRead = reader.read(input.samples.data(), expected);
+            if (framesRead != expected) {
+                LOGE("Short read at frame %lld (%d of %d)", static_cast<long long>(blockStart),
+                     framesRead, expected);
+                failPipeline();
+                return;
+            }
+        }
+        std::fill(input.samples.begin() + static_cast<size_t>(framesRead) * inputChannels_,
+                  input.samples.begin() + samplesPerBlock, 0.0f);
+        input.start = blockStart;
+        input.frames = std::min<int64_t>(blockFrames_, outputFrames_ - blockStart);
+
+        inputFilled_->push(index);
+    }
+}
+
+void OfflineRenderer::pipelineWriterLoop(int64_t blockCount) {
+    // One encoded block per target, so the float block is released before any write.
+    std::vector<std::vector<uint8_t>> pcm(targets_.size());
+    std::vector<size_t> bytes(targets_.size(), 0);
+    for (size_t t = 0; t < targets_.size(); ++t) {
+        pcm[t].resize(static_cast<size_t>(blockFrames_) * request_.targets[t].outputChannels * 3);
+    }
+
+    for (int64_t block = 0; block < blockCount; ++block) {
+        uint32_t index = 0;
+        if (!popWaiting(*outputFilled_, index, RenderStage::Writer)) {
+            return;
+        }
+
+        const PipelineBlock& output = outputBlocks_[index];
+        for (size_t t = 0; t < targets_.size(); ++t) {
+            const int64_t frames = targetFrames(t, output.start);
+            const size_t samples = static_cast<size_t>(frames) * request_.targets[t].outputChannels;
+            pcm24::fromFloat(output.samples.data() + targets_[t].sampleOffset, pcm[t].data(), samples);
+            bytes[t] = samples * 3;
+        }
+        outputFree_->push(index);
+
+        for (size_t t = 0; t < targets_.size(); ++t) {
+            if (bytes[t] == 0) {
+                continue;
+            }
+            if (!request_.targets[t].writer->writeData(pcm[t].data(), bytes[t])) {
+                LOGE("Failed to write block %lld of target %zu", static_cast<long long>(block), t);
+                failPipeline();
+                return;
+            }
+            targets_[t].framesWritten += static_cast<int64_t>(bytes[t] / (request_.targets[t].outputChannels * 3));
+        }
+    }
+}
+
+bool OfflineRenderer::popWaiting(BlockQueue& queue, uint32_t& index, RenderStage stage) {
+    if (queue.pop(index)) {
+        return true;
+    }
+
+    const auto waitStart = std::chrono::steady_clock::now();
+    while (!queue.pop(index)) {
+        if (pipelineFailed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::this_thread::sleep_for(kPollInterval);
+    }
+    recordStall(stage, ElapsedMicros(waitStart));
+    return true;
+}
+
+void OfflineRenderer::failPipeline() {
+    pipelineFailed_.store(true, std::memory_order_release);
+}
+
+void OfflineRenderer::recordStall(RenderStage stage, int64_t micros) {
+    if (!request_.stalls) {
+        return;
+    }
+    const int i = static_cast<int>(stage);
+    request_.stalls->stalls[i].fetch_add(1, std::memory_order_relaxed);
+    request_.stalls->stallMicros[i].fetch_add(micros, std::memory_order_relaxed);
+}
+
+bool OfflineRenderer::runParallel(std::vector<WavFileReader*>& readers) {
+    const int workers = static_cast<int>(readers.size());
+
+    const size_t lastSegmentFrames = static_cast<size_t>(outputFrames_ - (segmentCount_ - 1) * segmentFrames_);
+    const size_t slotFrames = std::max(static_cast<size_t>(segmentFrames_), lastSegmentFrames);
+
+    slots_.assign(static_cast<size_t>(workers) * kSlotsPerWorker, SegmentSlot{});
+    for (auto& slot : slots_) {
+        slot.pcm.resize(targets_.size());
+        slot.bytes.assign(targets_.size(), 0);
+        for (size_t t = 0; t < targets_.size(); ++t) {
+            slot.pcm[t].resize(slotFrames * request_.targets[t].outputChannels * 3);
+        }
+    }
+    nextSegment_ = 0;
+    nextToWrite_ = 0;
+    abort_ = false;
+
+    std::vector<std::thread> threads;
+    try {
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back(&OfflineRenderer::workerLoop, this, readers[static_cast<size_t>(i)]);
+        }
+    } catch (const std::system_error& e) {
+        LOGE("Failed to start render worker: %s", e.what());
+        std::lock_guard<std::mutex> lock(mutex_);
+        abort_ = true;
+    }
+    cv_.notify_all();
+
+    bool ok = !threads.empty();
+    for (int64_t segment = 0; ok && segment < segmentCount_; ++segment) {
+        SegmentSlot& slot = slots_[static_cast<size_t>(segment % static_cast<int64_t>(slots_.size()))];
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto segmentReady = [this, &slot, segment]() {
+                return abort_ || (slot.ready && slot.segment == segment);
+            };
+            if (!segmentReady()) {
+                const auto waitStart = std::chrono::steady_clock::now();
+                cv_.wait(lock, segmentReady);
+                recordStall(RenderStage::Writer, ElapsedMicros(waitStart));
+            }
+            if (abort_ || slot.failed) {
+                ok = false;
+                break;
+            }
+        }
+
+        for (size_t t = 0; ok && t < targets_.size(); ++t) {
+            if (slot.bytes[t] == 0) {
+                continue;
+            }
+            if (!request_.targets[t].writer->writeData(slot.pcm[t].data(), slot.bytes[t])) {
+                LOGE("Failed to write segment %lld of target %zu", static_cast<long long>(segment), t);
+                ok = false;
+                break;
+            }
+            targets_[t].framesWritten +=
+                static_cast<int64_t>(slot.bytes[t] / (request_.targets[t].outputChannels * 3));
+        }
+        if (!ok) {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot.ready = false;
+            slot.segment = -1;
+            ++nextToWrite_;
+        }
+        cv_.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ok) {
+            abort_ = true;
+        }
+    }
+    cv_.notify_all();
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    slots_.clear();
+    return ok;
+}
+
+void OfflineRenderer::workerLoop(WavFileReader* reader) {
+    std::vector<std::unique_ptr<MatrixConvolver>> convolvers;
+    if (!configureConvolvers(convolvers)) {
+        LOGE("Failed to configure segment convolver");
+        std::lock_guard<std::mutex> lock(mutex_);
+        abort_ = true;
+        cv_.notify_all();
+        return;
+    }
+
+    std::vector<float> input(static_cast<size_t>(blockFrames_) * inputChannels_, 0.0f);
+    std::vector<float> output(static_cast<size_t>(blockFrames_) * maxOutputChannels_, 0.0f);
+
+    while (true) {
+        int64_t segment = 0;
+        SegmentSlot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Claim the next segment once its slot has been drained by the writer.
+            auto slotFree = [this]() {
+                return abort_ || nextSegment_ >= segmentCount_ ||
+                       nextSegment_ - nextToWrite_ < static_cast<int64_t>(slots_.size());
+            };
+            if (!slotFree()) {
+                const auto waitStart = std::chrono::steady_clock::now();
+                cv_.wait(lock, slotFree);
+                recordStall(RenderStage::ConvolverOutput, ElapsedMicros(waitStart));
+            }
+            if (abort_ || nextSegment_ >= segmentCount_) {
+                return;
+            }
+            segment = nextSegment_++;
+            slot = &slots_[static_cast<size_t>(segment % static_cast<int64_t>(slots_.size()))];
+        }
+
+        const bool ok = renderSegment(segment, *reader, convolvers, input, output, *slot);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot->segment = segment;
+            slot->ready = true;
+            slot->failed = !ok;
+            if (!ok) {
+                abort_ = true;
+            }
+        }
+        cv_.notify_all();
+
+        if (!ok) {
+            return;
+        }
+    }
+}
+
+bool OfflineRenderer::renderSegment(int64_t segment, WavFileReader& reader,
+                                    std::vector<std::unique_ptr<MatrixConvolver>>& convolvers,
+                                    std::vector<float>& input, std::vector<float>& output,
+                                    SegmentSlot& slot) {
+    const int64_t start = segment * segmentFrames_;
+    const int64_t end = (segment == segmentCount_ - 1) ? outputFrames_ : start + segmentFrames_;
+    // The longest IR sets the pre-roll; shorter ones just see extra history.
+    const int64_t readStart = std::max<int64_t>(0, start - preRollFrames_);
+    const size_t samplesPerBlock = static_cast<size_t>(blockFrames_) * inputChannels_;
+
+    for (auto& convolver : convolvers) {
+        convolver->reset();
+    }
+    if (readStart < sourceFrames_ && !reader.seek(readStart)) {
+        LOGE("Segment %lld: seek to %lld failed", static_cast<long long>(segment),
+             static_cast<long long>(readStart));
+        return false;
+    }
+
+    for (int64_t blockStart = readStart; blockStart < end; blockStart += blockFrames_) {
+        int32_t framesRead = 0;
+        if (blockStart < sourceFrames_) {
+            const int32_t expected = static_cast<int32_t>(
+                std::min<int64_t>(blockFrames_, sourceFrames_ - blockStart));
+            framesRead = reader.read(input.data(), expected);
+            if (framesRead != expected) {
+                LOGE("Segment %lld: short read at frame %lld (%d of %d)",
+                     static_cast<long long>(segment), static_cast<long long>(blockStart),
+                     framesRead, expected);
+                return false;
+            }
+        }
+        std::fill(input.begin() + static_cast<size_t>(framesRead) * inputChannels_,
+                  input.begin() + samplesPerBlock, 0.0f);
+
+        for (size_t t = 0; t < targets_.size(); ++t) {
+            const int64_t frames = std::min(targetFrames(t, blockStart), end - blockStart);
+            if (frames <= 0) {
+                continue;
+            }
+            convolvers[t]->process(input.data(), output.data(), blockFrames_);
+
+            // Pre-roll blocks only rebuild the convolver state.
+            if (blockStart < start) {
+                continue;
+            }
+
+            const int outputs = request_.targets[t].outputChannels;
+            pcm24::fromFloat(output.data(),
+                          slot.pcm[t].data() + static_cast<size_t>(blockStart - start) * outputs * 3,
+                          static_cast<size_t>(frames) * outputs);
+        }
+        if (blockStart >= start) {
+            reportFrames(std::min<int64_t>(blockFrames_, end - blockStart));
+        }
+    }
+
+    for (size_t t = 0; t < targets_.size(); ++t) {
+        const int64_t frames = std::clamp<int64_t>(targets_[t].outputFrames - start, 0, end - start);
+        slot.bytes[t] = static_cast<size_t>(frames) * request_.targets[t].outputChannels * 3;
+    }
+    return true;
+}
+
+void OfflineRenderer::reportFrames(int64_t frames) {
+    const int64_t rendered = framesRendered_.fetch_add(frames, std::memory_order_relaxed) + frames;
+    if (!request_.progress || outputFrames_ <= 0) {
+        return;
+    }
+    const int progress = static_cast<int>(std::clamp<int64_t>((rendered * 100) / outputFrames_, 0, 99));
+    int32_t current = request_.progress->load(std::memory_order_relaxed);
+    while (current < progress &&
+           !request_.progress->compare_exchange_weak(current, progress, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace spcmic
@@ -0,0 +1,160 @@
+#ifndef SPCMIC_OFFLINE_RENDERER_H
+#define SPCMIC_OFFLINE_RENDERER_H
+
+#include "block_queue.h"
+#include "wav_file_reader.h"
+#include "matrix_convolver/matrix_convolver.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class WAVWriter;
+
+namespace spcmic {
+
+/** Render stages that can wait on a neighbour. */
+enum class RenderStage : int {
+    Reader = 0,       // waiting for a free input block (convolver behind)
+    ConvolverInput,   // waiting for decoded input (storage behind)
+    ConvolverOutput,  // waiting for a free output block (writer behind)
+    Writer,           // waiting for convolved output (convolver behind)
+    Count
+};
+
+/** Stall counters per stage; a stall is one wait on an empty or full queue. */
+struct RenderStallCounters {
+    static constexpr int kStageCount = static_cast<int>(RenderStage::Count);
+
+    std::atomic<int64_t> stalls[kStageCount];
+    std::atomic<int64_t> stallMicros[kStageCount];
+
+    RenderStallCounters() { reset(); }
+
+    void reset() {
+        for (int i = 0; i < kStageCount; ++i) {
+            stalls[i].store(0, std::memory_order_relaxed);
+            stallMicros[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Offline (faster than realtime) convolution of a whole multichannel file
+ * into one or more 24-bit WAV/RF64 writers. Every target has its own
+ * convolver (for example one per IR preset); each input block is read and
+ * decoded once and fed to all of them.
+ *
+ * The file is split into fixed-length segments that are convolved in
+ * parallel, each on its own MatrixConvolvers sharing the prototypes' IR
+ * spectra. Every segment starts with one IR length of pre-roll so its
+ * output matches a sequential render, and segments are written in order by
+ * the calling thread.
+ *
+ * With a single worker the render is pipelined instead: a reader thread
+ * decodes blocks, the calling thread convolves them and a writer thread
+ * encodes and writes, connected by BlockQueues of preallocated blocks.
+ */
+class OfflineRenderer {
+public:
+    struct Target {
+        const MatrixConvolver* prototype = nullptr;  // configured convolver to clone
+        WAVWriter* writer = nullptr;                 // open 24-bit writer
+        int outputChannels = 0;
+    };
+
+    struct Request {
+        WavFileReader* source = nullptr;             // open multichannel reader (caller-owned)
+        std::vector<Target> targets;                 // all with the same block size
+        int threads = 1;
+        std::atomic<int32_t>* progress = nullptr;    // updated 0-99 while rendering
+        RenderStallCounters* stalls = nullptr;       // optional, updated live
+    };
+
+    explicit OfflineRenderer(const Request& request);
+
+    /**
+     * Render source frames followed by the IR tail. Returns false on read,
+     * write or setup failure.
+     */
+    bool run();
+
+    /** Frames written to @p target by the last run(), including the IR tail. */
+    [[nodiscard]] int64_t framesWritten(size_t target = 0) const {
+        return target < targets_.size() ? targets_[target].framesWritten : 0;
+    }
+
+private:
+    struct TargetState {
+        int64_t outputFrames = 0;   // source frames plus this target's IR tail
+        size_t sampleOffset = 0;    // start of this target in a pipeline output block
+        int64_t framesWritten = 0;
+    };
+
+    struct SegmentSlot {
+        std::vector<std::vector<uint8_t>> pcm; // [target]
+        std::vector<size_t> bytes;             // [target]
+        int64_t segment = -1;
+        bool ready = false;
+        bool failed = false;
+    };
+
+    struct PipelineBlock {
+        std::vector<float> samples; // input, or every target's output back to back
+        int64_t start = 0;          // first frame of the block
+        int64_t frames = 0;         // frames this block contributes to the longest target
+    };
+
+    [[nodiscard]] int64_t targetFrames(size_t target, int64_t blockStart) const;
+    bool configureConvolvers(std::vector<std::unique_ptr<MatrixConvolver>>& convolvers) const;
+
+    bool runPipelined();
+    void pipelineReaderLoop(int64_t blockCount);
+    void pipelineWriterLoop(int64_t blockCount);
+    bool popWaiting(BlockQueue& queue, uint32_t& index, RenderStage stage);
+    void failPipeline();
+    void recordStall(RenderStage stage, int64_t micros);
+
+    bool runParallel(std::vector<WavFileReader*>& readers);
+    void workerLoop(WavFileReader* reader);
+    bool renderSegment(int64_t segment, WavFileReader& reader,
+                       std::vector<std::unique_ptr<MatrixConvolver>>& convolvers,
+                       std::vector<float>& input, std::vector<float>& output, SegmentSlot& slot);
+    void reportFrames(int64_t frames);
+
+    Request request_;
+    std::vector<TargetState> targets_;
+    int blockFrames_;
+    int inputChannels_;
+    int totalOutputChannels_;
+    int maxOutputChannels_;
+    int64_t sourceFrames_;
+    int64_t outputFrames_;  // longest target
+    int64_t preRollFrames_; // longest IR
+    int64_t segmentFrames_;
+    int64_t segmentCount_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<SegmentSlot> slots_;
+    int64_t nextSegment_;   // next segment a worker may claim
+    int64_t nextToWrite_;   // next segment the writer expects
+    bool abort_;
+
+    std::atomic<int64_t> framesRendered_;
+
+    std::vector<PipelineBlock> inputBlocks_;
+    std::vector<PipelineBlock> outputBlocks_;
+    std::unique_ptr<BlockQueue> inputFree_;
+    std::unique_ptr<BlockQueue> inputFilled_;
+    std::unique_ptr<BlockQueue> outputFree_;
+    std::unique_ptr<BlockQueue> outputFilled_;
+    std::atomic<bool> pipelineFailed_;
+};
+
+} // namespace spcmic
+
+#endif // SPCMIC_OFFLINE_RENDERER_H
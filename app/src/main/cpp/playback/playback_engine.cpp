@@ -11,6 +11,7 @@
 #include <thread>
 
 #include "lock_free_ring_buffer.h"
+#include "thread_config.h"
 
 #define LOG_TAG "PlaybackEngine"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
@@ -22,9 +23,41 @@ namespace spcmic {
 namespace {
 
 constexpr const char* kDefaultCacheFileName = "playback_cache.wav";
+constexpr const char* kSpectraCacheDirName = "ir_spectra";
 constexpr int kDefaultOutputChannels = 2;
-constexpr size_t kRealtimeRingChunks = 6;  // Number of BUFFER_FRAMES blocks queued for realtime playback
-constexpr size_t kRealtimePrimingChunks = 3;  // Minimum chunks queued before playback starts
+constexpr size_t kPrefetchRingChunks = 6;  // Number of BUFFER_FRAMES blocks queued for playback
+constexpr size_t kPrefetchPrimingChunks = 3;  // Minimum chunks queued before playback starts
+constexpr int kPrefetchWakeTimeoutMs = 50;  // Safety net only; the callback wakes the worker
+constexpr int kRingFlushTimeoutMs = 100;
+
+// Low-latency realtime convolution: 128-frame head partitions, 512-frame tail
+// partitions on the convolver's helper thread, and a short queue so the
+// small blocks actually reach the output early.
+constexpr int32_t kLowLatencyHeadFrames = 128;
+constexpr int32_t kLowLatencyTailFrames = 512;
+constexpr size_t kLowLatencyQueuedBlocks = 8;
+constexpr size_t kLowLatencyPrimingBlocks = 4;
+
+constexpr uint32_t PresetBit(IRPreset preset) {
+    return 1u << static_cast<uint32_t>(preset);
+}
+
+// 3OA renders 16 outputs, which makes 128-frame partitions eight times as
+// costly as for the stereo presets, so it stays on the uniform convolver.
+constexpr uint32_t kDefaultLowLatencyPresets =
+    PresetBit(IRPreset::Binaural) | PresetBit(IRPreset::Ortf) | PresetBit(IRPreset::Xy);
+
+// Stereo IRs are rendered 12 dB hot to match the level of the direct channels.
+float PresetOutputGain(int outputChannels) {
+    const float gainDb = (outputChannels == 2) ? 12.0f : 0.0f;
+    return std::pow(10.0f, gainDb / 20.0f);
+}
+
+// Leave half of the cores for the UI, USB and audio threads.
+int DefaultConvolverThreadCount() {
+    const unsigned int cores = std::thread::hardware_concurrency();
+    return std::clamp(static_cast<int>(cores / 2), 1, 4);
+}
 
 std::string JoinPath(const std::string& dir, const std::string& file) {
     if (dir.empty()) {
@@ -63,32 +96,51 @@ PlaybackEngine::PlaybackEngine()
     , playbackConvolved_(false)
     , currentPreset_(IRPreset::Binaural)
     , exportOutputChannels_(kDefaultOutputChannels)
-    , realtimeThreadRunning_(false)
-    , realtimeThreadStopRequested_(false)
-    , realtimeWorkerPrimed_(false)
+    , convolverThreadCount_(DefaultConvolverThreadCount())
+    , lowLatencyPresets_(kDefaultLowLatencyPresets)
+    , prefetchThreadRunning_(false)
+    , prefetchStopRequested_(false)
+    , prefetchPrimed_(false)
+    , prefetchEndOfStream_(false)
+    , ringFlushRequested_(false)
+    , prefetchConvolver_(nullptr)
+    , prefetchChunkFrames_(BUFFER_FRAMES)
+    , prefetchQueueLimitBytes_(0)
+    , prefetchPrimingBytes_(0)
+    , prefetchStartGeneration_(0)
+    , seekTargetFrame_(0)
+    , seekGeneration_(0)
+    , seekAudibleGeneration_(0)
 {
     
     // Allocate input buffer for 84 channels
     inputBuffer_.resize(BUFFER_FRAMES * 84);
+    prefetchRing_ = std::make_unique<LockFreeRingBuffer>(
+        static_cast<size_t>(BUFFER_FRAMES) * 2 * sizeof(float) * kPrefetchRingChunks);
     ensureOutputBufferCapacity(exportOutputChannels_);
     
     // Create audio output
     audioOutput_ = std::make_unique<AudioOutput>();
 
+    matrixConvolver_.setSpectraCache(&IRSpectraCache::shared());
+    monitorConvolver_.setSpectraCache(&IRSpectraCache::shared());
     matrixConvolver_.reset();
 }
 
 PlaybackEngine::~PlaybackEngine() {
     stop();
+    // The output must be gone before the ring it reads from.
+    audioOutput_->shutdown();
 }
 
 bool PlaybackEngine::loadFile(const std::string& filePath) {
     std::lock_guard<std::mutex> loadLock(loadMutex_);
     audioOutput_->stop();
-    stopRealtimeConvolutionWorker();
+    stopPrefetchWorker();
 
     clearPreRenderedState();
     sourceFilePath_ = filePath;
+    openOverview(std::string(), 0, 0, 0);
 
     // Stop current playback outside of the file mutex to avoid deadlocks
     if (state_ != State::IDLE) {
@@ -96,6 +148,7 @@ bool PlaybackEngine::loadFile(const std::string& filePath) {
     }
 
     int32_t numChannels = 0;
+    int32_t storedChannels = 0;
     int32_t sampleRate = 0;
     int32_t bitsPerSample = 0;
     double durationSeconds = 0.0;
@@ -117,6 +170,7 @@ bool PlaybackEngine::loadFile(const std::string& filePath) {
             return false;
         }
 
+        storedChannels = wavReader_.getStoredChannels();
         sampleRate = wavReader_.getSampleRate();
         bitsPerSample = wavReader_.getBitsPerSample();
         durationSeconds = wavReader_.getDurationSeconds();
@@ -131,6 +185,7 @@ bool PlaybackEngine::loadFile(const std::string& filePath) {
     } else {
         impulseResponseLoaded_ = false;
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
     }
     {
         std::lock_guard<std::mutex> lock(fileMutex_);
@@ -159,6 +214,7 @@ bool PlaybackEngine::loadFile(const std::string& filePath) {
 
     playbackCompleted_ = false;
     state_ = State::STOPPED;
+    openOverview(filePath, totalFrames, sampleRate, storedChannels);
 
     LOGD("File loaded successfully");
 
@@ -168,16 +224,18 @@ bool PlaybackEngine::loadFile(const std::string& filePath) {
 bool PlaybackEngine::loadFileFromDescriptor(int fd, const std::string& displayPath) {
     std::lock_guard<std::mutex> loadLock(loadMutex_);
     audioOutput_->stop();
-    stopRealtimeConvolutionWorker();
+    stopPrefetchWorker();
 
     clearPreRenderedState();
     sourceFilePath_ = displayPath;
+    openOverview(std::string(), 0, 0, 0);
 
     if (state_ != State::IDLE) {
         stop();
     }
 
     int32_t numChannels = 0;
+    int32_t storedChannels = 0;
     int32_t sampleRate = 0;
     int32_t bitsPerSample = 0;
     double durationSeconds = 0.0;
@@ -198,6 +256,7 @@ bool PlaybackEngine::loadFileFromDescriptor(int fd, const std::string& displayPa
             return false;
         }
 
+        storedChannels = wavReader_.getStoredChannels();
         sampleRate = wavReader_.getSampleRate();
         bitsPerSample = wavReader_.getBitsPerSample();
         durationSeconds = wavReader_.getDurationSeconds();
@@ -212,6 +271,7 @@ bool PlaybackEngine::loadFileFromDescriptor(int fd, const std::string& displayPa
     } else {
         impulseResponseLoaded_ = false;
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
     }
     {
         std::lock_guard<std::mutex> lock(fileMutex_);
@@ -240,6 +300,7 @@ bool PlaybackEngine::loadFileFromDescriptor(int fd, const std::string& displayPa
 
     playbackCompleted_ = false;
     state_ = State::STOPPED;
+    openOverview(displayPath, totalFrames, sampleRate, storedChannels);
 
     LOGD("Descriptor loaded successfully");
 
@@ -255,6 +316,50 @@ void PlaybackEngine::setPreRenderCacheDirectory(const std::string& path) {
     std::lock_guard<std::mutex> lock(fileMutex_);
     preRenderCacheDir_ = path;
     clearPreRenderedState();
+    IRSpectraCache::shared().setDirectory(path.empty() ? std::string() : JoinPath(path, kSpectraCacheDirName));
+}
+
+void PlaybackEngine::setOverviewDirectory(const std::string& path) {
+    std::lock_guard<std::mutex> lock(overviewMutex_);
+    overviewDir_ = path;
+}
+
+void PlaybackEngine::openOverview(const std::string& displayPath, int64_t totalFrames, int32_t sampleRate,
+                                  int32_t channels) {
+    std::lock_guard<std::mutex> lock(overviewMutex_);
+    overview_.close();
+    if (displayPath.empty() || overviewDir_.empty()) {
+        return;
+    }
+
+    const std::string path = JoinPath(overviewDir_, waveform_index::sidecarName(displayPath));
+    if (!overview_.open(path)) {
+        return;
+    }
+    // Sidecars are keyed by file name; a different take with the same name is ignored.
+    if (static_cast<int64_t>(overview_.getTotalFrames()) != totalFrames ||
+        overview_.getSampleRate() != sampleRate || overview_.getChannels() != channels) {
+        LOGW("Waveform overview %s does not match the loaded file", path.c_str());
+        overview_.close();
+        return;
+    }
+    LOGD("Waveform overview mapped: %s", path.c_str());
+}
+
+bool PlaybackEngine::hasOverview() const {
+    std::lock_guard<std::mutex> lock(overviewMutex_);
+    return overview_.isOpen();
+}
+
+int PlaybackEngine::getOverview(double startSeconds, double endSeconds, int columns, float* out) const {
+    std::lock_guard<std::mutex> lock(overviewMutex_);
+    const int sampleRate = overview_.getSampleRate();
+    if (!overview_.isOpen() || sampleRate <= 0 || endSeconds <= startSeconds) {
+        return 0;
+    }
+    const uint64_t startFrame = static_cast<uint64_t>(std::max(0.0, startSeconds) * sampleRate);
+    const uint64_t endFrame = static_cast<uint64_t>(std::max(0.0, endSeconds) * sampleRate);
+    return overview_.summarize(startFrame, endFrame, columns, out);
 }
 
 void PlaybackEngine::clearPreRenderedState() {
@@ -285,6 +390,7 @@ void PlaybackEngine::configureExportPreset(IRPreset preset,
         cacheFileName_ = resolvedCache;
         impulseResponseLoaded_ = false;
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
         clearPreRenderedState();
     }
 
@@ -298,7 +404,6 @@ bool PlaybackEngine::play() {
     }
 
     const bool useConvolved = playbackConvolved_.load(std::memory_order_relaxed);
-    const bool realtimeConvolution = useConvolved && !usePreRendered_;
 
     if (useConvolved) {
         std::lock_guard<std::mutex> lock(fileMutex_);
@@ -333,35 +438,40 @@ bool PlaybackEngine::play() {
     }
 
     const bool completed = playbackCompleted_.exchange(false);
+    bool rewind = false;
     {
         std::lock_guard<std::mutex> lock(fileMutex_);
-        if (completed || wavReader_.getPosition() >= wavReader_.getTotalFrames()) {
-            wavReader_.seek(0);
-        }
+        rewind = completed || wavReader_.getPosition() >= wavReader_.getTotalFrames();
     }
 
     if (audioOutput_->isPlaying()) {
         audioOutput_->stop();
     }
 
-    if (realtimeConvolution && matrixConvolver_.isReady()) {
-        {
-            std::lock_guard<std::mutex> lock(fileMutex_);
-            matrixConvolver_.reset();
-        }
-        startRealtimeConvolutionWorker();
-        waitForRealtimePriming();
+    if (rewind) {
+        // Drop whatever the last run left queued before starting over.
+        stopPrefetchWorker();
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        wavReader_.seek(0);
     }
 
-    if (audioOutput_->start()) {
+    // Resuming from pause keeps the running worker and its queued audio.
+    startPrefetchWorker();
+    waitForPrefetchPriming();
+
+    bool started = false;
+    {
+        // Held so a paused seek cannot be resetting the ring as the callback starts.
+        std::lock_guard<std::mutex> lock(outputStartMutex_);
+        started = audioOutput_->start();
+    }
+    if (started) {
         state_ = State::PLAYING;
         LOGD("Playback started");
         return true;
     }
 
-    if (realtimeConvolution) {
-        stopRealtimeConvolutionWorker();
-    }
+    stopPrefetchWorker();
 
     LOGE("Audio output failed to start");
     return false;
@@ -379,12 +489,12 @@ void PlaybackEngine::pause() {
 
 void PlaybackEngine::stop() {
     if (state_ == State::IDLE) {
-        stopRealtimeConvolutionWorker();
+        stopPrefetchWorker();
         return;
     }
 
     audioOutput_->stop();
-    stopRealtimeConvolutionWorker();
+    stopPrefetchWorker();
     
     std::lock_guard<std::mutex> lock(fileMutex_);
     wavReader_.seek(0);
@@ -403,39 +513,49 @@ bool PlaybackEngine::seek(double positionSeconds) {
         return false;
     }
 
-    const bool realtimeConvolution = playbackConvolved_.load(std::memory_order_relaxed) &&
-                                     !usePreRendered_ &&
-                                     matrixConvolver_.isReady();
+    const int64_t targetFrame = std::clamp<int64_t>(
+        static_cast<int64_t>(positionSeconds * wavReader_.getSampleRate()), 0, wavReader_.getTotalFrames());
 
-    if (realtimeConvolution) {
-        stopRealtimeConvolutionWorker();
+    // A running worker repositions itself; the lock orders this against its
+    // exit at the end of the file.
+    bool handedOff = false;
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        if (prefetchThreadRunning_.load(std::memory_order_acquire) &&
+            !prefetchStopRequested_.load(std::memory_order_acquire)) {
+            seekTargetFrame_.store(targetFrame, std::memory_order_relaxed);
+            seekGeneration_.fetch_add(1, std::memory_order_acq_rel);
+            handedOff = true;
+        }
+    }
+    if (handedOff) {
+        prefetchSpace_.post();
+        playbackCompleted_.store(false, std::memory_order_relaxed);
+        LOGD("Seek to %.2f seconds (frame %lld) handed to the prefetch worker",
+             positionSeconds, (long long)targetFrame);
+        return true;
     }
 
+    // Queued audio belongs to the old position, in every playback mode.
+    stopPrefetchWorker();
+
     bool success = false;
     {
         std::lock_guard<std::mutex> lock(fileMutex_);
 
-        const int64_t targetFrame = static_cast<int64_t>(positionSeconds * wavReader_.getSampleRate());
-
         if (wavReader_.seek(targetFrame)) {
-            if (realtimeConvolution) {
-                matrixConvolver_.reset();
-            }
+            playbackCompleted_.store(false, std::memory_order_relaxed);
             LOGD("Seeked to %.2f seconds (frame %lld)", positionSeconds, (long long)targetFrame);
             success = true;
         }
     }
 
-    if (!success) {
-        return false;
+    if (state_.load(std::memory_order_relaxed) == State::PLAYING) {
+        startPrefetchWorker();
+        waitForPrefetchPriming();
     }
 
-    if (realtimeConvolution && state_.load(std::memory_order_relaxed) == State::PLAYING) {
-        startRealtimeConvolutionWorker();
-        waitForRealtimePriming();
-    }
-
-    return true;
+    return success;
 }
 
 double PlaybackEngine::getPositionSeconds() const {
@@ -443,7 +563,15 @@ double PlaybackEngine::getPositionSeconds() const {
         return 0.0;
     }
 
-    return (double)wavReader_.getPosition() / (double)wavReader_.getSampleRate();
+    // Until the worker has queued audio from a pending seek, report its target.
+    if (seekAudibleGeneration_.load(std::memory_order_acquire) != seekGeneration_.load(std::memory_order_acquire)) {
+        return (double)seekTargetFrame_.load(std::memory_order_relaxed) / (double)wavReader_.getSampleRate();
+    }
+
+    // The reader runs ahead of the output by whatever the prefetch ring holds.
+    const int64_t queuedFrames = static_cast<int64_t>(prefetchRing_->getAvailableBytes() / (2 * sizeof(float)));
+    const int64_t position = std::max<int64_t>(0, wavReader_.getPosition() - queuedFrames);
+    return (double)position / (double)wavReader_.getSampleRate();
 }
 
 double PlaybackEngine::getDurationSeconds() const {
@@ -451,111 +579,213 @@ double PlaybackEngine::getDurationSeconds() const {
 }
 
 void PlaybackEngine::audioCallback(float* output, int32_t numFrames) {
+    const size_t bytesNeeded = static_cast<size_t>(numFrames) * 2 * sizeof(float);
+    uint8_t* dest = reinterpret_cast<uint8_t*>(output);
+    LockFreeRingBuffer* ring = prefetchRing_.get();
+
+    if (ringFlushRequested_.load(std::memory_order_acquire)) {
+        ring->discard();
+        ringFlushRequested_.store(false, std::memory_order_release);
+        ringFlushed_.post();
+        prefetchSpace_.post();
+    }
+
     if (state_ != State::PLAYING) {
         // Fill with silence
-        memset(output, 0, numFrames * 2 * sizeof(float));
+        memset(output, 0, bytesNeeded);
         return;
     }
 
-    processAudio(output, numFrames);
-}
-
-void PlaybackEngine::processAudio(float* output, int32_t numFrames) {
-    const bool useConvolved = playbackConvolved_.load(std::memory_order_relaxed);
-    const bool realtimeConvolution = useConvolved && !usePreRendered_ && matrixConvolver_.isReady();
+    const size_t totalRead = ring->read(dest, bytesNeeded);
+    if (totalRead > 0) {
+        prefetchSpace_.post();
+    }
 
-    if (realtimeConvolution) {
-        if (realtimeRing_) {
-            fillRealtimeOutput(output, numFrames);
-        } else {
-            memset(output, 0, numFrames * 2 * sizeof(float));
+    // Gain is applied here so level changes are heard without the ring's delay.
+    const float gain = playbackGainLinear_.load(std::memory_order_relaxed);
+    const size_t samplesRead = totalRead / sizeof(float);
+    if (gain != 1.0f) {
+        for (size_t i = 0; i < samplesRead; ++i) {
+            output[i] *= gain;
         }
-        return;
     }
 
-    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (totalRead < bytesNeeded) {
+        memset(dest + totalRead, 0, bytesNeeded - totalRead);
 
-    if (useConvolved && usePreRendered_ && !preRenderedReady_) {
-        memset(output, 0, numFrames * 2 * sizeof(float));
-        return;
+        if (prefetchEndOfStream_.load(std::memory_order_acquire)) {
+            // Everything the worker queued has been played.
+            State expected = State::PLAYING;
+            state_.compare_exchange_strong(expected, State::STOPPED, std::memory_order_acq_rel);
+            playbackCompleted_.store(true, std::memory_order_release);
+            return;
+        }
+
+        static std::atomic<bool> loggedUnderflow{false};
+        bool expected = false;
+        if (loggedUnderflow.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            LOGW("Playback underflow: delivered %zu of %zu bytes", totalRead, bytesNeeded);
+        }
     }
+}
 
-    if (!wavReader_.isOpen()) {
-        memset(output, 0, numFrames * 2 * sizeof(float));
+void PlaybackEngine::startPrefetchWorker() {
+    // Seeks published from here on are applied by the new worker.
+    const uint32_t startGeneration = seekGeneration_.load(std::memory_order_acquire);
+    bool expected = false;
+    if (!prefetchThreadRunning_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
         return;
     }
 
-    const int32_t fileChannels = wavReader_.getNumChannels();
-    int32_t framesRead = wavReader_.read(inputBuffer_.data(), numFrames);
-    const float gain = playbackGainLinear_.load(std::memory_order_relaxed);
-    const bool loopEnabled = loopEnabled_.load(std::memory_order_relaxed);
+    // A worker that ran to the end of the file has exited but not been joined.
+    if (prefetchThread_.joinable()) {
+        prefetchThread_.join();
+    }
 
-    if (framesRead <= 0) {
-        if (loopEnabled) {
-            if (wavReader_.seek(0)) {
-                framesRead = wavReader_.read(inputBuffer_.data(), numFrames);
-                playbackCompleted_.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        if (!wavReader_.isOpen()) {
+            prefetchThreadRunning_.store(false, std::memory_order_release);
+            return;
+        }
+        prefetchConvolver_ = nullptr;
+        prefetchChunkFrames_ = BUFFER_FRAMES;
+        prefetchQueueLimitBytes_ = prefetchRing_->getCapacity();
+        prefetchPrimingBytes_ = static_cast<size_t>(BUFFER_FRAMES) * 2 * sizeof(float) * kPrefetchPrimingChunks;
+
+        if (playbackConvolved_.load(std::memory_order_relaxed) && !usePreRendered_ &&
+            matrixConvolver_.isReady()) {
+            MatrixConvolver* convolver = monitorConvolver_.isReady() ? &monitorConvolver_ : &matrixConvolver_;
+            // Fresh start: no convolution history from before a seek or stop.
+            convolver->setThreadCount(convolverThreadCount_.load(std::memory_order_relaxed));
+            convolver->reset();
+            prefetchConvolver_ = convolver;
+
+            if (convolver == &monitorConvolver_) {
+                const size_t blockBytes = static_cast<size_t>(convolver->blockSize()) * 2 * sizeof(float);
+                prefetchChunkFrames_ = convolver->blockSize();
+                prefetchQueueLimitBytes_ = std::min(prefetchQueueLimitBytes_, blockBytes * kLowLatencyQueuedBlocks);
+                prefetchPrimingBytes_ = blockBytes * kLowLatencyPrimingBlocks;
             }
         }
+    }
 
-        if (framesRead <= 0) {
-            memset(output, 0, numFrames * 2 * sizeof(float));
+    prefetchStartGeneration_ = startGeneration;
+    seekAudibleGeneration_.store(startGeneration, std::memory_order_release);
+    prefetchPrimed_.store(false, std::memory_order_release);
+    prefetchEndOfStream_.store(false, std::memory_order_release);
+    prefetchStopRequested_.store(false, std::memory_order_release);
 
-            if (!loopEnabled) {
-                if (state_ != State::STOPPED) {
-                    state_ = State::STOPPED;
-                }
+    try {
+        prefetchThread_ = std::thread(&PlaybackEngine::prefetchLoop, this);
+    } catch (...) {
+        prefetchThreadRunning_.store(false, std::memory_order_release);
+        throw;
+    }
+}
 
-                if (!playbackCompleted_.exchange(true)) {
-                    LOGD("End of file reached");
-                }
-            }
-            return;
-        }
+void PlaybackEngine::stopPrefetchWorker() {
+    prefetchStopRequested_.store(true, std::memory_order_seq_cst);
+    prefetchSpace_.post();
+    prefetchCv_.notify_all();
+
+    if (prefetchThread_.joinable()) {
+        prefetchThread_.join();
     }
 
-    int32_t totalFramesRead = framesRead;
+    // A seek the worker did not get to still moves the reader.
+    const uint32_t generation = seekGeneration_.load(std::memory_order_acquire);
+    if (seekAudibleGeneration_.load(std::memory_order_acquire) != generation) {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        if (wavReader_.isOpen()) {
+            wavReader_.seek(seekTargetFrame_.load(std::memory_order_relaxed));
+        }
+        seekAudibleGeneration_.store(generation, std::memory_order_release);
+    }
 
-    if (loopEnabled && totalFramesRead < numFrames) {
-        while (totalFramesRead < numFrames) {
-            if (!wavReader_.seek(0)) {
-                break;
-            }
+    prefetchThreadRunning_.store(false, std::memory_order_release);
+    prefetchStopRequested_.store(false, std::memory_order_release);
+    prefetchPrimed_.store(false, std::memory_order_release);
+    prefetchEndOfStream_.store(false, std::memory_order_release);
 
-            const int32_t additional = wavReader_.read(
-                inputBuffer_.data() + static_cast<size_t>(totalFramesRead) * fileChannels,
-                numFrames - totalFramesRead);
+    flushPrefetchRing();
+    prefetchThread_ = std::thread();
+}
 
-            if (additional <= 0) {
-                break;
-            }
+void PlaybackEngine::flushPrefetchRing() {
+    if (requestRingFlush()) {
+        waitForRingFlush();
+    }
+}
 
-            totalFramesRead += additional;
+bool PlaybackEngine::requestRingFlush() {
+    {
+        std::lock_guard<std::mutex> lock(outputStartMutex_);
+        if (!audioOutput_->isPlaying()) {
+            // No callback running, and play() cannot start one while this is held.
+            prefetchRing_->reset();
+            return false;
         }
+    }
 
-        framesRead = totalFramesRead;
-        playbackCompleted_.store(false, std::memory_order_relaxed);
+    ringFlushed_.arm();
+    ringFlushRequested_.store(true, std::memory_order_seq_cst);
+    return true;
+}
+
+void PlaybackEngine::waitForRingFlush() {
+    while (ringFlushRequested_.load(std::memory_order_acquire)) {
+        if (ringFlushed_.wait(kRingFlushTimeoutMs)) {
+            continue;
+        }
+        // Only reset directly once the output has stopped calling back.
+        std::lock_guard<std::mutex> lock(outputStartMutex_);
+        if (audioOutput_->isPlaying()) {
+            LOGW("Output callback did not flush the ring within %d ms", kRingFlushTimeoutMs);
+            continue;
+        }
+        if (ringFlushRequested_.exchange(false, std::memory_order_acq_rel)) {
+            prefetchRing_->reset();
+        }
+        break;
     }
+}
 
-    if (framesRead < numFrames) {
-        std::fill(inputBuffer_.begin() + static_cast<size_t>(framesRead) * fileChannels,
-                  inputBuffer_.begin() + static_cast<size_t>(numFrames) * fileChannels,
-                  0.0f);
+void PlaybackEngine::prefetchLoop() {
+    thread_config::configureCurrentThread(thread_config::Role::Convolver);
 
-        if (!loopEnabled) {
-            if (state_ != State::STOPPED) {
-                state_ = State::STOPPED;
-            }
+    const auto finish = [this]() {
+        prefetchThreadRunning_.store(false, std::memory_order_release);
+        prefetchPrimed_.store(true, std::memory_order_release);
+        prefetchCv_.notify_all();
+    };
 
-            if (!playbackCompleted_.exchange(true)) {
-                LOGD("End of file reached");
-            }
-        }
+    int32_t fileChannels = 0;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        fileChannels = wavReader_.isOpen() ? wavReader_.getNumChannels() : 0;
     }
+    if (fileChannels <= 0 || static_cast<size_t>(fileChannels) * BUFFER_FRAMES > inputBuffer_.size()) {
+        finish();
+        return;
+    }
+
+    // The mode is fixed for the worker's lifetime; every mode change restarts it.
+    const bool useConvolved = playbackConvolved_.load(std::memory_order_relaxed);
+    MatrixConvolver* const convolver = prefetchConvolver_;
+    const bool silent = useConvolved && usePreRendered_ && !preRenderedReady_;
+
+    const int outChannels = std::max(1, exportOutputChannels_);
+    const int32_t chunkFrames = prefetchChunkFrames_;
+    const size_t chunkBytes = static_cast<size_t>(chunkFrames) * 2 * sizeof(float);
+    const size_t queueLimit = prefetchQueueLimitBytes_;
+    const size_t primingThreshold = prefetchPrimingBytes_;
+
+    std::vector<float> convolved(convolver ? static_cast<size_t>(chunkFrames) * outChannels : 0, 0.0f);
+    std::vector<float> stereo(static_cast<size_t>(chunkFrames) * 2, 0.0f);
 
     int32_t leftIndex = 0;
     int32_t rightIndex = std::min(1, std::max(fileChannels - 1, 0));
-
     if (!useConvolved) {
         bool channelFallback = false;
         if (DIRECT_LEFT_CHANNEL_INDEX < fileChannels) {
@@ -573,298 +803,223 @@ void PlaybackEngine::processAudio(float* output, int32_t numFrames) {
         }
 
         if (channelFallback) {
-            static bool loggedFallback = false;
-            if (!loggedFallback) {
-                LOGW("Direct playback fallback: file has %d channels, expected > %d", fileChannels, DIRECT_RIGHT_CHANNEL_INDEX);
-                loggedFallback = true;
-            }
+            LOGW("Direct playback fallback: file has %d channels, expected > %d", fileChannels, DIRECT_RIGHT_CHANNEL_INDEX);
         }
     }
 
-    for (int32_t frame = 0; frame < numFrames; ++frame) {
-        if (frame < framesRead) {
-            const float* frameBase = inputBuffer_.data() + static_cast<size_t>(frame) * fileChannels;
-            float left = frameBase[leftIndex];
-            float right = (fileChannels > rightIndex) ? frameBase[rightIndex] : frameBase[leftIndex];
-            left *= gain;
-            right *= gain;
-            output[frame * 2] = left;
-            output[frame * 2 + 1] = right;
-        } else {
-            output[frame * 2] = 0.0f;
-            output[frame * 2 + 1] = 0.0f;
-        }
-    }
-}
-
-void PlaybackEngine::startRealtimeConvolutionWorker() {
-    if (!playbackConvolved_.load(std::memory_order_relaxed) || usePreRendered_) {
-        return;
-    }
-
-    if (!matrixConvolver_.isReady()) {
-        return;
-    }
-
-    bool expected = false;
-    if (!realtimeThreadRunning_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-        return;
-    }
-
-    const int fileChannels = sourceNumChannels_;
-    if (fileChannels <= 0) {
-        realtimeThreadRunning_.store(false, std::memory_order_release);
-        return;
-    }
+    LockFreeRingBuffer* ring = prefetchRing_.get();
+    const auto queueFull = [ring, chunkBytes, queueLimit]() {
+        return ring->getAvailableSpace() < chunkBytes || ring->getAvailableBytes() + chunkBytes > queueLimit;
+    };
 
-    const size_t chunkFrames = static_cast<size_t>(BUFFER_FRAMES);
-    const int stereoChannels = 2;
-    const size_t chunkBytes = chunkFrames * stereoChannels * sizeof(float);
-    const size_t primingThreshold = chunkBytes * kRealtimePrimingChunks;
-    const size_t capacityBytes = chunkBytes * kRealtimeRingChunks;
+    uint32_t appliedGeneration = prefetchStartGeneration_;
+    bool seekAudible = true;  // the first block from the applied seek has been queued
 
-    try {
-        std::lock_guard<std::mutex> lock(realtimeMutex_);
-        if (!realtimeRing_ || realtimeRing_->getCapacity() != capacityBytes) {
-            realtimeRing_ = std::make_unique<LockFreeRingBuffer>(capacityBytes);
-        } else {
-            realtimeRing_->reset();
+    // At the end of the file the worker exits, unless a seek came in meanwhile.
+    const auto endOfStream = [this, &appliedGeneration]() {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        if (seekGeneration_.load(std::memory_order_acquire) != appliedGeneration) {
+            return false;
         }
-    } catch (...) {
-        realtimeThreadRunning_.store(false, std::memory_order_release);
-        throw;
-    }
-
-    realtimeWorkerPrimed_.store(false, std::memory_order_release);
-    realtimeThreadStopRequested_.store(false, std::memory_order_release);
-
-    try {
-        realtimeThread_ = std::thread(&PlaybackEngine::realtimeConvolutionLoop, this);
-    } catch (...) {
-        realtimeThreadRunning_.store(false, std::memory_order_release);
-        realtimeThreadStopRequested_.store(false, std::memory_order_release);
-        throw;
-    }
-}
-
-void PlaybackEngine::stopRealtimeConvolutionWorker(bool flushRing) {
-    realtimeThreadStopRequested_.store(true, std::memory_order_release);
-    realtimeCv_.notify_all();
-
-    if (realtimeThread_.joinable()) {
-        realtimeThread_.join();
-    }
-
-    realtimeThreadRunning_.store(false, std::memory_order_release);
-    realtimeThreadStopRequested_.store(false, std::memory_order_release);
-    realtimeWorkerPrimed_.store(false, std::memory_order_release);
+        LOGD("Prefetch worker reached end of file");
+        prefetchEndOfStream_.store(true, std::memory_order_release);
+        prefetchThreadRunning_.store(false, std::memory_order_release);
+        return true;
+    };
 
-    if (flushRing) {
-        std::lock_guard<std::mutex> lock(realtimeMutex_);
-        if (realtimeRing_) {
-            realtimeRing_->reset();
+    // Starting mid-file (resume after a stop or seek): rebuild the IR history first.
+    if (convolver && !silent) {
+        int64_t position = 0;
+        {
+            std::lock_guard<std::mutex> lock(fileMutex_);
+            position = wavReader_.getPosition();
+        }
+        warmUpConvolver(*convolver, position, chunkFrames, fileChannels, convolved, appliedGeneration);
+    }
+
+    while (!prefetchStopRequested_.load(std::memory_order_acquire)) {
+        const uint32_t generation = seekGeneration_.load(std::memory_order_acquire);
+        if (generation != appliedGeneration && !silent) {
+            appliedGeneration = generation;
+            const int64_t target = seekTargetFrame_.load(std::memory_order_relaxed);
+            // What primed the ring before is being dropped; play() waits for the new position.
+            prefetchPrimed_.store(false, std::memory_order_release);
+
+            // The callback drops what is queued while the convolver warms up.
+            const bool flushing = requestRingFlush();
+            prefetchEndOfStream_.store(false, std::memory_order_release);
+            if (convolver) {
+                warmUpConvolver(*convolver, target, chunkFrames, fileChannels, convolved, generation);
+            } else {
+                std::lock_guard<std::mutex> lock(fileMutex_);
+                wavReader_.seek(target);
+            }
+            if (flushing) {
+                waitForRingFlush();
+            }
+            playbackCompleted_.store(false, std::memory_order_relaxed);
+            seekAudible = false;
+            continue;  // a newer seek may have interrupted the warm-up
         }
-    }
-
-    realtimeThread_ = std::thread();
-}
-
-void PlaybackEngine::realtimeConvolutionLoop() {
-    const int fileChannels = sourceNumChannels_;
-    if (fileChannels <= 0) {
-        realtimeThreadRunning_.store(false, std::memory_order_release);
-        realtimeWorkerPrimed_.store(true, std::memory_order_release);
-        realtimeCv_.notify_all();
-        return;
-    }
-
-    const int outChannels = std::max(1, exportOutputChannels_);
-    const size_t chunkFrames = static_cast<size_t>(BUFFER_FRAMES);
-    const int stereoChannels = 2;
-    const size_t chunkBytes = chunkFrames * stereoChannels * sizeof(float);
-    const size_t primingThreshold = chunkBytes * kRealtimePrimingChunks;
-
-    std::vector<float> input(static_cast<size_t>(chunkFrames) * fileChannels, 0.0f);
-    std::vector<float> convolved(static_cast<size_t>(chunkFrames) * outChannels, 0.0f);
-    std::vector<float> stereo(static_cast<size_t>(chunkFrames) * stereoChannels, 0.0f);
-
-    LockFreeRingBuffer* ring = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(realtimeMutex_);
-        ring = realtimeRing_.get();
-    }
-
-    if (!ring) {
-        realtimeThreadRunning_.store(false, std::memory_order_release);
-        realtimeWorkerPrimed_.store(true, std::memory_order_release);
-        realtimeCv_.notify_all();
-        return;
-    }
 
-    while (!realtimeThreadStopRequested_.load(std::memory_order_acquire)) {
-        if (ring->getAvailableSpace() < chunkBytes) {
-            realtimeWorkerPrimed_.store(true, std::memory_order_release);
-            realtimeCv_.notify_all();
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (queueFull()) {
+            prefetchPrimed_.store(true, std::memory_order_release);
+            prefetchCv_.notify_all();
+            prefetchSpace_.arm();
+            if (queueFull() && !prefetchStopRequested_.load(std::memory_order_seq_cst)) {
+                prefetchSpace_.wait(kPrefetchWakeTimeoutMs);
+            }
             continue;
         }
 
-        int32_t framesRead = 0;
-        bool finalChunk = false;
         const bool loop = loopEnabled_.load(std::memory_order_relaxed);
-
-        {
+        int32_t framesRead = 0;
+        if (!silent) {
             std::lock_guard<std::mutex> lock(fileMutex_);
-            if (!wavReader_.isOpen()) {
-                framesRead = 0;
-            } else {
-                framesRead = wavReader_.read(input.data(), static_cast<int32_t>(chunkFrames));
-                if (framesRead <= 0 && loop) {
-                    if (wavReader_.seek(0)) {
-                        framesRead = wavReader_.read(input.data(), static_cast<int32_t>(chunkFrames));
-                        playbackCompleted_.store(false, std::memory_order_relaxed);
-                    }
-                }
-
-                if (framesRead < static_cast<int32_t>(chunkFrames) && framesRead > 0) {
-                    std::fill(input.begin() + static_cast<size_t>(framesRead) * fileChannels,
-                              input.end(),
-                              0.0f);
-                    if (!loop) {
-                        finalChunk = true;
+            if (wavReader_.isOpen()) {
+                framesRead = wavReader_.read(inputBuffer_.data(), chunkFrames);
+                // Looping fills the whole block, so the wrap point has no gap.
+                while (loop && framesRead < chunkFrames && wavReader_.seek(0)) {
+                    const int32_t additional = wavReader_.read(
+                        inputBuffer_.data() + static_cast<size_t>(framesRead) * fileChannels,
+                        chunkFrames - framesRead);
+                    if (additional <= 0) {
+                        break;
                     }
+                    framesRead += additional;
+                    playbackCompleted_.store(false, std::memory_order_relaxed);
                 }
             }
         }
 
         if (framesRead <= 0) {
-            if (!loop) {
-                state_ = State::STOPPED;
-                if (!playbackCompleted_.exchange(true)) {
-                    LOGD("Realtime worker reached end of file");
-                }
-                std::fill(stereo.begin(), stereo.end(), 0.0f);
-                size_t written = 0;
-                const uint8_t* zeroBytes = reinterpret_cast<const uint8_t*>(stereo.data());
-                while (written < chunkBytes && !realtimeThreadStopRequested_.load(std::memory_order_acquire)) {
-                    const size_t wrote = ring->write(zeroBytes + written, chunkBytes - written);
-                    if (wrote == 0) {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                        continue;
-                    }
-                    written += wrote;
-                }
+            if (loop && !silent) {
+                // Nothing readable even after rewinding; wait before retrying.
+                prefetchSpace_.arm();
+                prefetchSpace_.wait(kPrefetchWakeTimeoutMs);
+                continue;
+            }
+            if (endOfStream()) {
                 break;
             }
             continue;
         }
 
-        matrixConvolver_.process(input.data(), convolved.data(), static_cast<int32_t>(chunkFrames));
+        const bool finalChunk = framesRead < chunkFrames;
+        int32_t framesOut = framesRead;
 
-        const float gain = playbackGainLinear_.load(std::memory_order_relaxed);
-        for (size_t frame = 0; frame < chunkFrames; ++frame) {
-            const size_t baseIndex = frame * outChannels;
-            const float left = convolved[baseIndex];
-            const float right = (outChannels > 1) ? convolved[baseIndex + 1] : left;
-            stereo[frame * 2] = left * gain;
-            stereo[frame * 2 + 1] = right * gain;
+        if (convolver) {
+            if (finalChunk) {
+                std::fill(inputBuffer_.begin() + static_cast<size_t>(framesRead) * fileChannels,
+                          inputBuffer_.begin() + static_cast<size_t>(chunkFrames) * fileChannels,
+                          0.0f);
+            }
+            convolver->process(inputBuffer_.data(), convolved.data(), chunkFrames);
+            for (int32_t frame = 0; frame < chunkFrames; ++frame) {
+                const size_t baseIndex = static_cast<size_t>(frame) * outChannels;
+                const float left = convolved[baseIndex];
+                const float right = (outChannels > 1) ? convolved[baseIndex + 1] : left;
+                stereo[frame * 2] = left;
+                stereo[frame * 2 + 1] = right;
+            }
+            // The zero-padded last block carries the start of the reverb tail.
+            framesOut = chunkFrames;
+        } else {
+            for (int32_t frame = 0; frame < framesRead; ++frame) {
+                const float* frameBase = inputBuffer_.data() + static_cast<size_t>(frame) * fileChannels;
+                stereo[frame * 2] = frameBase[leftIndex];
+                stereo[frame * 2 + 1] = (fileChannels > rightIndex) ? frameBase[rightIndex] : frameBase[leftIndex];
+            }
         }
 
-        size_t written = 0;
-        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(stereo.data());
-        while (written < chunkBytes && !realtimeThreadStopRequested_.load(std::memory_order_acquire)) {
-            const size_t wrote = ring->write(bytes + written, chunkBytes - written);
-            if (wrote == 0) {
-                realtimeWorkerPrimed_.store(true, std::memory_order_release);
-                realtimeCv_.notify_all();
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                continue;
-            }
-            written += wrote;
+        // Space for a whole block was checked above and only the callback consumes.
+        ring->write(reinterpret_cast<const uint8_t*>(stereo.data()),
+                    static_cast<size_t>(framesOut) * 2 * sizeof(float));
+        if (!seekAudible) {
+            seekAudibleGeneration_.store(appliedGeneration, std::memory_order_release);
+            seekAudible = true;
         }
 
-        if (!realtimeWorkerPrimed_.load(std::memory_order_acquire) &&
+        if (!prefetchPrimed_.load(std::memory_order_acquire) &&
             ring->getAvailableBytes() >= primingThreshold) {
-            realtimeWorkerPrimed_.store(true, std::memory_order_release);
-            realtimeCv_.notify_all();
+            prefetchPrimed_.store(true, std::memory_order_release);
+            prefetchCv_.notify_all();
         }
 
-        if (finalChunk && !loop) {
-            state_ = State::STOPPED;
-            playbackCompleted_.store(true, std::memory_order_relaxed);
+        if (finalChunk && endOfStream()) {
             break;
         }
     }
 
-    realtimeThreadRunning_.store(false, std::memory_order_release);
-    realtimeWorkerPrimed_.store(true, std::memory_order_release);
-    realtimeCv_.notify_all();
+    finish();
 }
 
-void PlaybackEngine::waitForRealtimePriming() {
-    if (!realtimeRing_) {
-        return;
-    }
+bool PlaybackEngine::warmUpConvolver(MatrixConvolver& convolver, int64_t targetFrame, int32_t chunkFrames,
+                                     int32_t fileChannels, std::vector<float>& scratch, uint32_t generation) {
+    convolver.reset();
 
-    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
-    const size_t chunkBytes = static_cast<size_t>(BUFFER_FRAMES) * 2 * sizeof(float);
-    const size_t requiredBytes = chunkBytes * kRealtimePrimingChunks;
-    std::unique_lock<std::mutex> lock(realtimeMutex_);
-    realtimeCv_.wait_until(lock, deadline, [this, requiredBytes]() {
-        if (!realtimeThreadRunning_.load(std::memory_order_acquire)) {
-            return true;
-        }
-        if (realtimeWorkerPrimed_.load(std::memory_order_acquire)) {
-            return true;
+    // One IR length of input, ending exactly at the target; a short first
+    // block is zero-padded at the front, as if that input were silence.
+    const int64_t preRoll = static_cast<int64_t>(convolver.tailBlockCount()) * convolver.blockSize();
+    const int64_t warmFrames = std::min(targetFrame, preRoll);
+    const int64_t blocks = (warmFrames + chunkFrames - 1) / chunkFrames;
+    int32_t padFrames = static_cast<int32_t>(blocks * chunkFrames - warmFrames);
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        if (!wavReader_.isOpen() || !wavReader_.seek(targetFrame - warmFrames)) {
+            return false;
         }
-        if (realtimeRing_) {
-            const size_t bytesAvailable = realtimeRing_->getAvailableBytes();
-            if (bytesAvailable >= requiredBytes) {
-                return true;
-            }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int64_t block = 0; block < blocks; ++block) {
+        if (prefetchStopRequested_.load(std::memory_order_acquire) ||
+            seekGeneration_.load(std::memory_order_acquire) != generation) {
+            return false;
         }
-        return false;
-    });
 
-    if (realtimeRing_) {
-        const size_t bytesAvailable = realtimeRing_->getAvailableBytes();
-        if (bytesAvailable < requiredBytes) {
-            LOGW("Realtime priming timed out with %zu bytes available (need %zu)",
-                 bytesAvailable,
-                 requiredBytes);
+        float* input = inputBuffer_.data();
+        std::fill(input, input + static_cast<size_t>(padFrames) * fileChannels, 0.0f);
+        int32_t framesRead = 0;
+        {
+            std::lock_guard<std::mutex> lock(fileMutex_);
+            framesRead = std::max(0, wavReader_.read(input + static_cast<size_t>(padFrames) * fileChannels,
+                                                     chunkFrames - padFrames));
         }
+        std::fill(input + static_cast<size_t>(padFrames + framesRead) * fileChannels,
+                  input + static_cast<size_t>(chunkFrames) * fileChannels, 0.0f);
+        convolver.process(input, scratch.data(), chunkFrames);
+        padFrames = 0;
     }
-}
-
-void PlaybackEngine::fillRealtimeOutput(float* output, int32_t numFrames) {
-    const size_t bytesNeeded = static_cast<size_t>(numFrames) * 2 * sizeof(float);
-    uint8_t* dest = reinterpret_cast<uint8_t*>(output);
 
-    LockFreeRingBuffer* ring = realtimeRing_.get();
-    if (!ring) {
-        memset(output, 0, bytesNeeded);
-        return;
+    if (blocks > 0) {
+        LOGD("Convolver warm-up: %lld frames before frame %lld in %lld us",
+             static_cast<long long>(warmFrames), static_cast<long long>(targetFrame),
+             static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now() - start).count()));
     }
+    return true;
+}
 
-    size_t totalRead = 0;
-    for (int attempt = 0; attempt < 2 && totalRead < bytesNeeded; ++attempt) {
-        const size_t read = ring->read(dest + totalRead, bytesNeeded - totalRead);
-        if (read == 0) {
-            if (!realtimeThreadRunning_.load(std::memory_order_acquire)) {
-                break;
-            }
-            std::this_thread::yield();
+void PlaybackEngine::waitForPrefetchPriming() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    const size_t requiredBytes = prefetchPrimingBytes_;
+    std::unique_lock<std::mutex> lock(prefetchMutex_);
+    prefetchCv_.wait_until(lock, deadline, [this, requiredBytes]() {
+        if (!prefetchThreadRunning_.load(std::memory_order_acquire)) {
+            return true;
         }
-        totalRead += read;
-    }
-
-    if (totalRead < bytesNeeded) {
-        memset(dest + totalRead, 0, bytesNeeded - totalRead);
-        static std::atomic<bool> loggedUnderflow{false};
-        bool expected = false;
-        if (loggedUnderflow.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-            LOGW("Realtime playback underflow: delivered %zu of %zu bytes", totalRead, bytesNeeded);
+        if (prefetchPrimed_.load(std::memory_order_acquire)) {
+            return true;
         }
+        return prefetchRing_->getAvailableBytes() >= requiredBytes;
+    });
+
+    const size_t bytesAvailable = prefetchRing_->getAvailableBytes();
+    if (bytesAvailable < requiredBytes && prefetchThreadRunning_.load(std::memory_order_acquire)) {
+        LOGW("Prefetch priming timed out with %zu bytes available (need %zu)",
+             bytesAvailable,
+             requiredBytes);
     }
 }
 
@@ -872,22 +1027,26 @@ bool PlaybackEngine::loadImpulseResponse(int32_t sampleRate) {
     if (!assetManager_) {
         LOGW("Asset manager not provided; skipping IR load");
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
         return false;
     }
 
+    // Header only: with cached spectra the samples are never needed.
     MatrixImpulseResponse ir;
-    if (!irLoader_.loadPreset(currentPreset_, sampleRate, ir)) {
+    if (!irLoader_.loadPreset(currentPreset_, sampleRate, ir, false)) {
         LOGE("Failed to load impulse response for preset %d at %d Hz",
              static_cast<int>(currentPreset_), sampleRate);
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
         return false;
     }
 
     impulseResponse_ = std::move(ir);
 
-    if (!impulseResponse_.isValid()) {
+    if (!impulseResponse_.hasShape()) {
         LOGE("Impulse response invalid after load");
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
         return false;
     }
 
@@ -895,6 +1054,7 @@ bool PlaybackEngine::loadImpulseResponse(int32_t sampleRate) {
     if (loadedOutputs <= 0) {
         LOGE("Impulse response reported zero output channels");
         matrixConvolver_.configure(nullptr, 0);
+        monitorConvolver_.configure(nullptr, 0);
         return false;
     }
 
@@ -905,51 +1065,72 @@ bool PlaybackEngine::loadImpulseResponse(int32_t sampleRate) {
         ensureOutputBufferCapacity(exportOutputChannels_);
     }
 
-    constexpr int kMaxPartitions = 1;  // TEMP: keep IR within single FFT partition for performance
-    const int maxIrLength = BUFFER_FRAMES * kMaxPartitions;
-    const int originalIrLength = impulseResponse_.irLength;
-    if (impulseResponse_.irLength > maxIrLength) {
-        LOGW("Trimming IR from %d to %d samples to limit CPU load",
-             impulseResponse_.irLength, maxIrLength);
-        const int numInputs = impulseResponse_.numInputChannels;
-        const int numOutputs = impulseResponse_.numOutputChannels;
-        std::vector<float> trimmed(static_cast<size_t>(numOutputs) * numInputs * maxIrLength);
-
-        for (int outCh = 0; outCh < numOutputs; ++outCh) {
-            for (int inCh = 0; inCh < numInputs; ++inCh) {
-                const size_t srcOffset = (static_cast<size_t>(outCh) * numInputs +
-                                          static_cast<size_t>(inCh)) * impulseResponse_.irLength;
-                const size_t dstOffset = (static_cast<size_t>(outCh) * numInputs +
-                                          static_cast<size_t>(inCh)) * maxIrLength;
-                std::copy_n(impulseResponse_.impulseData.begin() + srcOffset,
-                            maxIrLength,
-                            trimmed.begin() + dstOffset);
-            }
-        }
-
-        impulseResponse_.impulseData = std::move(trimmed);
-        impulseResponse_.irLength = maxIrLength;
-    }
-
-    LOGD("Loaded IR: sampleRate=%d, irLength=%d (original %d), channels=%d",
+    LOGD("Loaded IR: sampleRate=%d, irLength=%d, channels=%d",
         impulseResponse_.sampleRate,
         impulseResponse_.irLength,
-        originalIrLength,
         impulseResponse_.numInputChannels);
 
-    if (!matrixConvolver_.configure(&impulseResponse_, BUFFER_FRAMES)) {
+    bool configured = matrixConvolver_.configure(&impulseResponse_, BUFFER_FRAMES);
+    if (!configured && loadImpulseSamples()) {
+        configured = matrixConvolver_.configure(&impulseResponse_, BUFFER_FRAMES);
+    }
+    if (!configured) {
         LOGE("Matrix convolver configuration failed");
+        monitorConvolver_.configure(nullptr, 0);
         return false;
     }
 
-    const float gainDb = (impulseResponse_.numOutputChannels == 2) ? 12.0f : 0.0f;
-    const float gainFactor = std::pow(10.0f, gainDb / 20.0f);
+    const float gainFactor = PresetOutputGain(impulseResponse_.numOutputChannels);
     matrixConvolver_.setOutputGain(gainFactor);
+    configureMonitorConvolver();
+    // Both convolvers hold their spectra now; a later reconfigure reloads the
+    // samples only if the cache no longer has them.
+    std::vector<float>().swap(impulseResponse_.impulseData);
     ensureOutputBufferCapacity(impulseResponse_.numOutputChannels);
     LOGD("Matrix convolver ready (outputs=%d, gain=%.2f)", impulseResponse_.numOutputChannels, gainFactor);
 
     return true;
 }
+
+bool PlaybackEngine::loadImpulseSamples() {
+    if (impulseResponse_.isValid()) {
+        return true;
+    }
+
+    MatrixImpulseResponse ir;
+    if (!irLoader_.loadPreset(currentPreset_, impulseResponse_.sampleRate, ir) ||
+        ir.irLength != impulseResponse_.irLength ||
+        ir.numInputChannels != impulseResponse_.numInputChannels ||
+        ir.numOutputChannels != impulseResponse_.numOutputChannels) {
+        LOGE("Failed to load impulse response samples for preset %d", static_cast<int>(currentPreset_));
+        return false;
+    }
+    impulseResponse_.impulseData = std::move(ir.impulseData);
+    LOGD("Loaded IR samples to build uncached spectra");
+    return true;
+}
+
+void PlaybackEngine::configureMonitorConvolver() {
+    if (!matrixConvolver_.isReady() || !isLowLatencyConvolution(currentPreset_)) {
+        monitorConvolver_.configure(nullptr, 0);
+        return;
+    }
+
+    bool configured = monitorConvolver_.configureLowLatency(&impulseResponse_, kLowLatencyHeadFrames,
+                                                            kLowLatencyTailFrames);
+    if (!configured && loadImpulseSamples()) {
+        configured = monitorConvolver_.configureLowLatency(&impulseResponse_, kLowLatencyHeadFrames,
+                                                           kLowLatencyTailFrames);
+    }
+    std::vector<float>().swap(impulseResponse_.impulseData);
+    if (!configured) {
+        LOGW("Low-latency convolver unavailable; realtime playback uses %d-frame blocks", BUFFER_FRAMES);
+        return;
+    }
+    monitorConvolver_.setOutputGain(PresetOutputGain(impulseResponse_.numOutputChannels));
+    LOGD("Low-latency realtime convolution: %d-frame blocks", monitorConvolver_.blockSize());
+}
+
 bool PlaybackEngine::preparePreRenderedFile() {
     std::lock_guard<std::mutex> loadLock(loadMutex_);
     if (!impulseResponseLoaded_ || !matrixConvolver_.isReady()) {
@@ -958,7 +1139,7 @@ bool PlaybackEngine::preparePreRenderedFile() {
     }
 
     audioOutput_->stop();
-    stopRealtimeConvolutionWorker();
+    stopPrefetchWorker();
 
     std::lock_guard<std::mutex> lock(fileMutex_);
 
@@ -967,17 +1148,7 @@ bool PlaybackEngine::preparePreRenderedFile() {
         return false;
     }
 
-    // Ensure we are working from the original multichannel file
-    if (!wavReader_.isOpen() || wavReader_.getNumChannels() != sourceNumChannels_) {
-        wavReader_.close();
-        if (!wavReader_.open(sourceFilePath_)) {
-            LOGE("Failed to reopen source file: %s", sourceFilePath_.c_str());
-            return false;
-        }
-    }
-
-    if (!wavReader_.seek(0)) {
-        LOGE("Failed to seek source file before pre-render");
+    if (!openSourceForRender()) {
         return false;
     }
 
@@ -990,6 +1161,7 @@ bool PlaybackEngine::preparePreRenderedFile() {
     }
 
     preRenderProgress_.store(0, std::memory_order_relaxed);
+    preRenderStalls_.reset();
     preRenderInProgress_.store(true, std::memory_order_relaxed);
 
     const std::string tempPath = JoinPath(preRenderCacheDir_, cacheFileName_);
@@ -1007,84 +1179,16 @@ bool PlaybackEngine::preparePreRenderedFile() {
         return false;
     }
 
-    matrixConvolver_.reset();
-
-    int64_t framesProcessed = 0;
-    const int64_t totalFrames = wavReader_.getTotalFrames();
-    bool ok = true;
-
-    auto convertTo24 = [this, outputChannels](int32_t frames) {
-        const float* src = mixBuffer_.data();
-        uint8_t* dst = mix24Buffer_.data();
-
-        constexpr float kScale = 8388607.0f; // 2^23 - 1
-        const size_t stride = static_cast<size_t>(outputChannels);
-        for (int32_t frame = 0; frame < frames; ++frame) {
-            for (int32_t ch = 0; ch < outputChannels; ++ch) {
-                const size_t sampleIndex = static_cast<size_t>(frame) * stride + static_cast<size_t>(ch);
-                float sample = std::clamp(src[sampleIndex], -1.0f, 1.0f);
-                int32_t value = static_cast<int32_t>(std::lrintf(sample * kScale));
-                value = std::clamp(value, -8388608, 8388607);
-
-                const uint32_t uvalue = static_cast<uint32_t>(value);
-                const size_t byteIndex = sampleIndex * 3;
-                dst[byteIndex] = static_cast<uint8_t>(uvalue & 0xFF);
-                dst[byteIndex + 1] = static_cast<uint8_t>((uvalue >> 8) & 0xFF);
-                dst[byteIndex + 2] = static_cast<uint8_t>((uvalue >> 16) & 0xFF);
-            }
-        }
-    };
-
-    while (ok) {
-        int32_t framesRead = wavReader_.read(inputBuffer_.data(), BUFFER_FRAMES);
-        if (framesRead <= 0) {
-            break;
-        }
-
-        if (framesRead < BUFFER_FRAMES) {
-            std::fill(inputBuffer_.begin() + static_cast<size_t>(framesRead) * sourceNumChannels_,
-                      inputBuffer_.begin() + static_cast<size_t>(BUFFER_FRAMES) * sourceNumChannels_,
-                      0.0f);
-        }
-
-        matrixConvolver_.process(inputBuffer_.data(), mixBuffer_.data(), BUFFER_FRAMES);
-
-        framesProcessed += framesRead;
-        if (totalFrames > 0) {
-            int progress = static_cast<int>((framesProcessed * 100) / totalFrames);
-            if (progress > 99) {
-                progress = 99;
-            }
-            if (progress < 0) {
-                progress = 0;
-            }
-            preRenderProgress_.store(progress, std::memory_order_relaxed);
-        }
-
-        const int32_t framesToWrite = framesRead;
-        convertTo24(framesToWrite);
-
-        if (!writer.writeData(mix24Buffer_.data(),
-                              static_cast<size_t>(framesToWrite) * static_cast<size_t>(outputChannels) * 3)) {
-            ok = false;
-            break;
-        }
+    OfflineRenderer::Request request;
+    request.source = &wavReader_;
+    request.targets.push_back({&matrixConvolver_, &writer, outputChannels});
+    request.threads = convolverThreadCount_.load(std::memory_order_relaxed);
+    request.progress = &preRenderProgress_;
+    request.stalls = &preRenderStalls_;
 
-        if (framesRead < BUFFER_FRAMES) {
-            std::fill(inputBuffer_.begin(),
-                      inputBuffer_.begin() + static_cast<size_t>(BUFFER_FRAMES) * sourceNumChannels_,
-                      0.0f);
-            matrixConvolver_.process(inputBuffer_.data(), mixBuffer_.data(), BUFFER_FRAMES);
-
-            convertTo24(BUFFER_FRAMES);
-
-            if (!writer.writeData(mix24Buffer_.data(),
-                                  static_cast<size_t>(BUFFER_FRAMES) * static_cast<size_t>(outputChannels) * 3)) {
-                ok = false;
-            }
-            break;
-        }
-    }
+    OfflineRenderer renderer(request);
+    const bool ok = renderer.run();
+    const int64_t framesProcessed = renderer.framesWritten();
 
     writer.close();
 
@@ -1127,6 +1231,135 @@ bool PlaybackEngine::preparePreRenderedFile() {
     return true;
 }
 
+bool PlaybackEngine::openSourceForRender() {
+    // Ensure we are working from the original multichannel file
+    if (!wavReader_.isOpen() || wavReader_.getNumChannels() != sourceNumChannels_) {
+        wavReader_.close();
+        if (!wavReader_.open(sourceFilePath_)) {
+            LOGE("Failed to reopen source file: %s", sourceFilePath_.c_str());
+            return false;
+        }
+    }
+
+    if (!wavReader_.seek(0)) {
+        LOGE("Failed to seek source file before pre-render");
+        return false;
+    }
+    return true;
+}
+
+bool PlaybackEngine::configureExportConvolver(IRPreset preset, MatrixImpulseResponse& ir,
+                                              MatrixConvolver& convolver) {
+    convolver.setSpectraCache(&IRSpectraCache::shared());
+    bool configured = irLoader_.loadPreset(preset, sourceSampleRate_, ir, false) &&
+                      convolver.configure(&ir, BUFFER_FRAMES);
+    if (!configured) {
+        configured = irLoader_.loadPreset(preset, sourceSampleRate_, ir) &&
+                     convolver.configure(&ir, BUFFER_FRAMES);
+    }
+    std::vector<float>().swap(ir.impulseData);
+    if (!configured) {
+        LOGE("Failed to configure export convolver for preset %d", static_cast<int>(preset));
+        return false;
+    }
+    convolver.setOutputGain(PresetOutputGain(ir.numOutputChannels));
+    return true;
+}
+
+bool PlaybackEngine::exportPresets(const std::vector<IRPreset>& presets,
+                                   const std::vector<std::string>& destinationPaths) {
+    std::lock_guard<std::mutex> loadLock(loadMutex_);
+    if (presets.empty() || presets.size() != destinationPaths.size()) {
+        LOGE("Export needs one destination per preset (%zu presets, %zu destinations)",
+             presets.size(), destinationPaths.size());
+        return false;
+    }
+    if (!assetManager_) {
+        LOGE("Asset manager not provided; cannot export");
+        return false;
+    }
+
+    audioOutput_->stop();
+    stopPrefetchWorker();
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+
+    if (sourceFilePath_.empty()) {
+        LOGE("No source file set for export");
+        return false;
+    }
+    if (!openSourceForRender()) {
+        return false;
+    }
+
+    // The IRs must outlive their convolvers; both outlive the render.
+    std::vector<MatrixImpulseResponse> irs(presets.size());
+    std::vector<std::unique_ptr<MatrixConvolver>> convolvers;
+    std::vector<std::unique_ptr<WAVWriter>> writers;
+    OfflineRenderer::Request request;
+    request.source = &wavReader_;
+    request.threads = convolverThreadCount_.load(std::memory_order_relaxed);
+    request.progress = &preRenderProgress_;
+    request.stalls = &preRenderStalls_;
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < presets.size(); ++i) {
+        auto convolver = std::make_unique<MatrixConvolver>();
+        auto writer = std::make_unique<WAVWriter>();
+        if (!configureExportConvolver(presets[i], irs[i], *convolver)) {
+            ok = false;
+        } else if (!writer->open(destinationPaths[i], sourceSampleRate_, irs[i].numOutputChannels, 24)) {
+            LOGE("Failed to open export target: %s", destinationPaths[i].c_str());
+            ok = false;
+        } else {
+            request.targets.push_back({convolver.get(), writer.get(), irs[i].numOutputChannels});
+        }
+        convolvers.push_back(std::move(convolver));
+        writers.push_back(std::move(writer));
+    }
+
+    if (ok) {
+        preRenderProgress_.store(0, std::memory_order_relaxed);
+        preRenderStalls_.reset();
+        preRenderInProgress_.store(true, std::memory_order_relaxed);
+        LOGD("Exporting %zu preset(s) from %s", presets.size(), sourceFilePath_.c_str());
+
+        OfflineRenderer renderer(request);
+        ok = renderer.run();
+        for (size_t i = 0; i < request.targets.size(); ++i) {
+            LOGD("Export %s: %lld frames", destinationPaths[i].c_str(),
+                 static_cast<long long>(renderer.framesWritten(i)));
+        }
+    }
+
+    for (size_t i = 0; i < writers.size(); ++i) {
+        writers[i]->close();
+        if (!ok) {
+            std::remove(destinationPaths[i].c_str());
+        }
+    }
+    preRenderProgress_.store(ok ? 100 : 0, std::memory_order_relaxed);
+    preRenderInProgress_.store(false, std::memory_order_relaxed);
+
+    // Leave the reader where playback expects it.
+    if (usePreRendered_ && preRenderedReady_) {
+        wavReader_.close();
+        if (!wavReader_.open(preRenderedFilePath_)) {
+            LOGE("Failed to reopen pre-rendered file after export");
+            clearPreRenderedState();
+            wavReader_.open(sourceFilePath_);
+        }
+    }
+    wavReader_.seek(0);
+    playbackCompleted_ = false;
+    state_ = State::STOPPED;
+
+    if (!ok) {
+        LOGE("Export failed");
+    }
+    return ok;
+}
+
 bool PlaybackEngine::exportPreRenderedFile(const std::string& destinationPath) {
     std::lock_guard<std::mutex> lock(fileMutex_);
 
@@ -1171,6 +1404,9 @@ bool PlaybackEngine::useExistingPreRendered(const std::string& sourcePath) {
     }
     cacheStream.close();
 
+    audioOutput_->stop();
+    stopPrefetchWorker();
+
     std::lock_guard<std::mutex> lock(fileMutex_);
 
     wavReader_.close();
@@ -1234,17 +1470,68 @@ int32_t PlaybackEngine::getPreRenderProgress() const {
     return preRenderProgress_.load(std::memory_order_relaxed);
 }
 
+size_t PlaybackEngine::getPreRenderStallStats(int64_t* out, size_t count) const {
+    constexpr size_t kStages = RenderStallCounters::kStageCount;
+    size_t written = 0;
+    for (size_t i = 0; i < kStages && written < count; ++i) {
+        out[written++] = preRenderStalls_.stalls[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kStages && written < count; ++i) {
+        out[written++] = preRenderStalls_.stallMicros[i].load(std::memory_order_relaxed);
+    }
+    return written;
+}
+
 bool PlaybackEngine::isPreRenderInProgress() const {
     return preRenderInProgress_.load(std::memory_order_relaxed);
 }
 
+void PlaybackEngine::setConvolverThreadCount(int threads) {
+    const int clamped = std::max(1, threads);
+    convolverThreadCount_.store(clamped, std::memory_order_relaxed);
+    LOGD("Convolver thread count set to %d", clamped);
+}
+
+void PlaybackEngine::setLowLatencyConvolution(IRPreset preset, bool enabled) {
+    const uint32_t bit = PresetBit(preset);
+    const uint32_t previous = enabled
+        ? lowLatencyPresets_.fetch_or(bit, std::memory_order_relaxed)
+        : lowLatencyPresets_.fetch_and(~bit, std::memory_order_relaxed);
+    if (((previous & bit) != 0) == enabled) {
+        return;
+    }
+    LOGD("Low-latency convolution %s for preset %d", enabled ? "enabled" : "disabled", static_cast<int>(preset));
+
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        if (preset != currentPreset_ || !impulseResponseLoaded_) {
+            return;
+        }
+    }
+
+    // The worker may be inside monitorConvolver_.process().
+    stopPrefetchWorker();
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        configureMonitorConvolver();
+    }
+
+    if (state_.load(std::memory_order_relaxed) == State::PLAYING) {
+        startPrefetchWorker();
+    }
+}
+
+bool PlaybackEngine::isLowLatencyConvolution(IRPreset preset) const {
+    return (lowLatencyPresets_.load(std::memory_order_relaxed) & PresetBit(preset)) != 0;
+}
+
 void PlaybackEngine::setPlaybackConvolved(bool enabled) {
     const bool previous = playbackConvolved_.exchange(enabled, std::memory_order_relaxed);
     if (enabled == previous) {
         return;
     }
 
-    stopRealtimeConvolutionWorker();
+    stopPrefetchWorker();
 
     if (enabled) {
         std::lock_guard<std::mutex> lock(fileMutex_);
@@ -1264,9 +1551,7 @@ void PlaybackEngine::setPlaybackConvolved(bool enabled) {
         if (matrixConvolver_.isReady()) {
             matrixConvolver_.reset();
         }
-        return;
-    }
-    if (!enabled && previous) {
+    } else {
         std::lock_guard<std::mutex> lock(fileMutex_);
         if (usePreRendered_ && !sourceFilePath_.empty()) {
             LOGD("Disabling convolved playback; restoring original multichannel source");
@@ -1282,6 +1567,11 @@ void PlaybackEngine::setPlaybackConvolved(bool enabled) {
         }
         preRenderedReady_ = false;
     }
+
+    // Playback carries on in the new mode from the current position.
+    if (state_.load(std::memory_order_relaxed) == State::PLAYING) {
+        startPrefetchWorker();
+    }
 }
 
 bool PlaybackEngine::isPlaybackConvolved() const {
@@ -7,7 +7,10 @@
 #include "matrix_convolver/ir_loader.h"
 #include "matrix_convolver/ir_data.h"
 #include "matrix_convolver/matrix_convolver.h"
+#include "offline_renderer.h"
 #include "lock_free_ring_buffer.h"
+#include "wake_semaphore.h"
+#include "waveform_index.h"
 struct AAssetManager;
 #include <atomic>
 #include <condition_variable>
@@ -63,6 +66,10 @@ public:
 
     /**
      * Seek to position
+     * While the prefetch worker runs this only publishes the target and
+     * returns; the worker drops the queued audio, warms the convolver up on
+     * the IR-length window before the target and carries on from there, so
+     * repeated seeks (scrubbing) never restart the thread.
      * @param positionSeconds Position in seconds
      */
     bool seek(double positionSeconds);
@@ -97,6 +104,23 @@ public:
      */
     void setPreRenderCacheDirectory(const std::string& path);
 
+    /**
+     * Configure directory holding the recorder's waveform overview sidecars
+     */
+    void setOverviewDirectory(const std::string& path);
+
+    /**
+     * Check if a finished overview matching the loaded file was found
+     */
+    bool hasOverview() const;
+
+    /**
+     * Summarise [startSeconds, endSeconds) of the loaded file into @p columns
+     * (min, max, rms) triples from its mapped overview, without touching the WAV.
+     * @return columns filled, 0 without an overview
+     */
+    int getOverview(double startSeconds, double endSeconds, int columns, float* out) const;
+
     /**
      * Pre-render the currently loaded file to stereo cache
      */
@@ -117,6 +141,14 @@ public:
      */
     bool exportPreRenderedFile(const std::string& destinationPath);
 
+    /**
+     * Render the loaded file through each of @p presets into the matching
+     * @p destinationPaths (24-bit WAV/RF64) in one pass over the source, so
+     * the file is read and decoded once for all of them. Progress and stall
+     * counters are reported as for a pre-render.
+     */
+    bool exportPresets(const std::vector<IRPreset>& presets, const std::vector<std::string>& destinationPaths);
+
     /**
      * Attempt to reuse an existing cached pre-render for the given source
      */
@@ -152,6 +184,13 @@ public:
      */
     int32_t getPreRenderProgress() const;
 
+    /**
+     * Stall counters of the current or last pre-render: for each RenderStage,
+     * the number of waits followed by the microseconds spent waiting.
+     * Writes up to @p count values and returns how many were written.
+     */
+    size_t getPreRenderStallStats(int64_t* out, size_t count) const;
+
     /**
      * Check if a pre-render operation is active
      */
@@ -168,25 +207,60 @@ public:
      */
     bool isPlaybackConvolved() const;
 
+    /**
+     * Threads used by the matrix convolver (including the calling thread).
+     * Takes effect the next time realtime convolution or a pre-render starts.
+     */
+    void setConvolverThreadCount(int threads);
+
+    /**
+     * Choose low-latency realtime convolution (128-frame head partitions) or
+     * the uniform 2048-frame convolver for @p preset. Pre-renders always use
+     * the uniform convolver. Binaural, ORTF and XY default to low latency.
+     */
+    void setLowLatencyConvolution(IRPreset preset, bool enabled);
+    bool isLowLatencyConvolution(IRPreset preset) const;
+
 private:
     /**
-     * Audio callback - fills output buffer
+     * Audio callback - fills output buffer from the prefetch ring (wait-free)
      */
     void audioCallback(float* output, int32_t numFrames);
 
     /**
-     * Read and process audio
+     * Prefetch thread: reads the file, convolves or picks channels, and
+     * queues stereo blocks for the callback. Used by every playback mode.
      */
-    void processAudio(float* output, int32_t numFrames);
+    void startPrefetchWorker();
+    void stopPrefetchWorker();
+    void prefetchLoop();
+    void waitForPrefetchPriming();
 
-    void startRealtimeConvolutionWorker();
-    void stopRealtimeConvolutionWorker(bool flushRing = true);
-    void realtimeConvolutionLoop();
-    void waitForRealtimePriming();
-    void fillRealtimeOutput(float* output, int32_t numFrames);
+    /**
+     * Drop queued audio. With the output running the callback discards it,
+     * so the ring only ever has one consumer. Worker must be stopped.
+     */
+    void flushPrefetchRing();
+    bool requestRingFlush();   // false if the ring was reset directly
+    void waitForRingFlush();
+
+    /**
+     * Feed the IR-length window before @p targetFrame through @p convolver,
+     * discarding the output, so the first block played from the target has
+     * its full reverb context. Leaves the reader at @p targetFrame. Returns
+     * false if a newer seek or a stop interrupted it. Prefetch thread only.
+     */
+    bool warmUpConvolver(MatrixConvolver& convolver, int64_t targetFrame, int32_t chunkFrames,
+                         int32_t fileChannels, std::vector<float>& scratch, uint32_t generation);
 
     bool loadImpulseResponse(int32_t sampleRate);
+    bool loadImpulseSamples();
+    bool configureExportConvolver(IRPreset preset, MatrixImpulseResponse& ir, MatrixConvolver& convolver);
+    bool openSourceForRender();
+    void configureMonitorConvolver();
     void clearPreRenderedState();
+    /** Map the overview sidecar for @p displayPath if it describes the loaded file. */
+    void openOverview(const std::string& displayPath, int64_t totalFrames, int32_t sampleRate, int32_t channels);
     void ensureOutputBufferCapacity(int outputChannels);
 
     WavFileReader wavReader_;
@@ -194,7 +268,8 @@ private:
     std::unique_ptr<AudioOutput> audioOutput_;
     IRLoader irLoader_;
     MatrixImpulseResponse impulseResponse_;
-    MatrixConvolver matrixConvolver_;
+    MatrixConvolver matrixConvolver_;   // uniform BUFFER_FRAMES blocks; pre-render prototype
+    MatrixConvolver monitorConvolver_;  // low-latency mode, realtime playback only
     bool impulseResponseLoaded_;
 
     std::atomic<State> state_;
@@ -202,7 +277,7 @@ private:
     std::mutex fileMutex_;
 
     // Processing buffers
-    std::vector<float> inputBuffer_;    // Multichannel buffer (max 84 channels)
+    std::vector<float> inputBuffer_;    // Multichannel buffer (max 84 channels), prefetch thread
     std::vector<float> mixBuffer_;      // Output buffer sized per preset
     std::vector<uint8_t> mix24Buffer_;  // 24-bit buffer sized per preset
 
@@ -210,6 +285,9 @@ private:
     std::string sourceFilePath_;
     std::string preRenderedFilePath_;
     std::string preRenderCacheDir_;
+    std::string overviewDir_;
+    mutable std::mutex overviewMutex_;       // overview_ is swapped by loads, read by the UI
+    WaveformIndexReader overview_;
     std::string preRenderedSourcePath_;
     std::string cacheFileName_;
     bool preRenderedReady_;
@@ -220,21 +298,41 @@ private:
     std::atomic<float> playbackGainLinear_;
     std::atomic<bool> loopEnabled_;
     std::atomic<int32_t> preRenderProgress_;
+    RenderStallCounters preRenderStalls_;
     std::atomic<bool> preRenderInProgress_;
     std::atomic<bool> playbackConvolved_;
     IRPreset currentPreset_;
     int exportOutputChannels_;
-
-    // Realtime convolution worker state
-    std::unique_ptr<LockFreeRingBuffer> realtimeRing_;
-    std::thread realtimeThread_;
-    std::atomic<bool> realtimeThreadRunning_;
-    std::atomic<bool> realtimeThreadStopRequested_;
-    std::atomic<bool> realtimeWorkerPrimed_;
-    std::mutex realtimeMutex_;
-    std::condition_variable realtimeCv_;
+    std::atomic<int> convolverThreadCount_;
+    std::atomic<uint32_t> lowLatencyPresets_;  // bit per IRPreset
+
+    // Prefetch worker state
+    std::unique_ptr<LockFreeRingBuffer> prefetchRing_;  // stereo float, allocated once
+    std::thread prefetchThread_;
+    std::atomic<bool> prefetchThreadRunning_;
+    std::atomic<bool> prefetchStopRequested_;
+    std::atomic<bool> prefetchPrimed_;
+    std::atomic<bool> prefetchEndOfStream_;  // last block queued; the callback stops once the ring drains
+    std::atomic<bool> ringFlushRequested_;   // callback discards queued audio, then clears this
+    WakeSemaphore prefetchSpace_;            // posted by the callback after it frees ring space
+    WakeSemaphore ringFlushed_;              // posted by the callback after a flush
+    std::mutex outputStartMutex_;            // orders output starts against direct ring resets
+    std::mutex prefetchMutex_;
+    std::condition_variable prefetchCv_;
+    // Chosen by startPrefetchWorker() before the thread starts
+    MatrixConvolver* prefetchConvolver_;     // null unless convolving in realtime
+    int32_t prefetchChunkFrames_;
+    size_t prefetchQueueLimitBytes_;         // the worker stops filling the ring here
+    size_t prefetchPrimingBytes_;
+    uint32_t prefetchStartGeneration_;             // seekGeneration_ the worker starts from
+
+    // Seeks while the worker runs: seek() stores the target, then bumps the
+    // generation; the worker applies the newest target it sees.
+    std::atomic<int64_t> seekTargetFrame_;
+    std::atomic<uint32_t> seekGeneration_;
+    std::atomic<uint32_t> seekAudibleGeneration_;  // first block from that seek is queued
     
-    static constexpr int32_t BUFFER_FRAMES = 2048;  // Smaller processing chunks; overall latency controlled by buffer queue
+    static constexpr int32_t BUFFER_FRAMES = 2048;  // Prefetch block; callbacks read the ring at device burst size
     static constexpr int32_t DIRECT_LEFT_CHANNEL_INDEX = 24;  // channel 25 (1-based)
     static constexpr int32_t DIRECT_RIGHT_CHANNEL_INDEX = 52; // channel 53 (1-based)
 
@@ -0,0 +1,68 @@
+#ifndef SPCMIC_WAKE_SEMAPHORE_H
+#define SPCMIC_WAKE_SEMAPHORE_H
+
+#include <atomic>
+#include <cerrno>
+#include <ctime>
+#include <semaphore.h>
+
+namespace spcmic {
+
+/**
+ * One-waiter wakeup for SPSC hand-offs. The waiter arms, re-checks its
+ * condition and then waits; the other side calls post() after changing the
+ * condition. post() is a single atomic exchange unless a waiter is armed,
+ * so it is safe to call from the audio callback.
+ */
+class WakeSemaphore {
+public:
+    WakeSemaphore() { sem_init(&sem_, 0, 0); }
+    ~WakeSemaphore() { sem_destroy(&sem_); }
+
+    WakeSemaphore(const WakeSemaphore&) = delete;
+    WakeSemaphore& operator=(const WakeSemaphore&) = delete;
+
+    /** Announce a wait; the caller must re-check its condition afterwards. */
+    void arm() {
+        armed_.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in post(): either the waiter sees the new
+        // condition, or post() sees the arm.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    /** Wake the armed waiter, if any. */
+    void post() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (armed_.exchange(false, std::memory_order_acq_rel)) {
+            sem_post(&sem_);
+        }
+    }
+
+    /** Block until post() or @p timeoutMs elapses; false on timeout. */
+    bool wait(int timeoutMs) {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += static_cast<long>(timeoutMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        while (sem_timedwait(&sem_, &deadline) != 0) {
+            if (errno != EINTR) {
+                armed_.store(false, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    sem_t sem_;
+    std::atomic<bool> armed_{false};
+};
+
+} // namespace spcmic
+
+#endif // SPCMIC_WAKE_SEMAPHORE_H
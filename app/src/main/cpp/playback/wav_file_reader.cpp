@@ -1,4 +1,5 @@
 #include "wav_file_reader.h"
+#include "pcm24.h"
 #include <android/log.h>
 #include <cstring>
 #include <algorithm>
@@ -6,6 +7,10 @@
 #include <limits>
 #include <unistd.h>
 #include <errno.h>
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #define LOG_TAG "WavFileReader"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
@@ -13,6 +18,25 @@
 
 namespace {
 
+// 32 MB windows keep the address-space footprint bounded on 32-bit ABIs
+// while remapping only every few seconds of 84-channel audio.
+constexpr size_t kMapWindowBytes = 32u * 1024u * 1024u;
+constexpr int64_t kReadaheadBytes = 4 * 1024 * 1024;
+constexpr float kInt24Scale = 1.0f / 8388608.0f;  // same scaling as pcm24::toFloat
+
+void* MapRegion(int fd, int64_t offset, size_t length) {
+#if defined(__LP64__)
+    return mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(offset));
+#else
+    return mmap64(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off64_t>(offset));
+#endif
+}
+
+int64_t PageSize() {
+    static const int64_t pageSize = std::max<long>(sysconf(_SC_PAGESIZE), 4096);
+    return pageSize;
+}
+
 inline uint64_t readUint64LE(const uint8_t* data) {
     uint64_t value = 0;
     for (int i = 7; i >= 0; --i) {
@@ -21,6 +45,15 @@ inline uint64_t readUint64LE(const uint8_t* data) {
     return value;
 }
 
+inline uint32_t readUint32LE(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+inline uint16_t readUint16LE(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
 }
 
 namespace spcmic {
@@ -34,7 +67,18 @@ WavFileReader::WavFileReader()
     , numChannels_(0)
     , sampleRate_(0)
     , bitsPerSample_(0)
-    , bytesPerFrame_(0) {
+    , bytesPerFrame_(0)
+    , storedChannels_(0)
+    , lossless_(false)
+    , blockFrames_(0)
+    , cachedBlock_(-1)
+    , cachedBlockFrames_(0)
+    , mmapEnabled_(false)
+    , dataEndOffset_(0)
+    , mapBase_(nullptr)
+    , mapOffset_(0)
+    , mapLength_(0)
+    , readaheadEnd_(0) {
 }
 
 WavFileReader::~WavFileReader() {
@@ -55,6 +99,7 @@ bool WavFileReader::open(const std::string& filePath) {
         close();
         return false;
     }
+    initMapping();
 
     LOGD("Opened WAV file: %d channels, %d Hz, %d-bit, %lld frames (%.2f seconds)",
          numChannels_, sampleRate_, bitsPerSample_, (long long)totalFrames_, getDurationSeconds());
@@ -88,6 +133,7 @@ bool WavFileReader::openFromFd(int fd, const std::string& displayPath) {
         close();
         return false;
     }
+    initMapping();
 
     LOGD("Opened WAV descriptor %s: %d channels, %d Hz, %d-bit, %lld frames (%.2f seconds)",
          displayPath.c_str(), numChannels_, sampleRate_, bitsPerSample_, (long long)totalFrames_, getDurationSeconds());
@@ -95,12 +141,42 @@ bool WavFileReader::openFromFd(int fd, const std::string& displayPath) {
     return true;
 }
 
+bool WavFileReader::openDuplicate(const WavFileReader& source) {
+    close();
+
+    if (!source.fileHandle_) {
+        return false;
+    }
+
+    // Re-open through procfs so the new handle gets its own file offset
+    // (dup() would share it with the source reader).
+    char procPath[64];
+    snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", fileno(source.fileHandle_));
+    fileHandle_ = fopen(procPath, "rb");
+    if (!fileHandle_) {
+        LOGE("Failed to reopen %s: %s", procPath, strerror(errno));
+        return false;
+    }
+
+    if (!readHeader()) {
+        LOGE("Invalid WAV file format for duplicated reader");
+        close();
+        return false;
+    }
+    initMapping();
+
+    return true;
+}
+
 void WavFileReader::close() {
+    unmapWindow();
+    mmapEnabled_ = false;
     if (fileHandle_) {
         fclose(fileHandle_);
         fileHandle_ = nullptr;
     }
     currentFrame_ = 0;
+    cachedBlock_ = -1;
 }
 
 bool WavFileReader::readHeader() {
@@ -123,20 +199,15 @@ bool WavFileReader::readHeader() {
 
     uint64_t ds64DataSize = 0;
     uint64_t ds64SampleCount = 0;
+    uint64_t factSampleCount = 0;
     bool hasDs64 = false;
     bool fmtFound = false;
+    std::vector<uint8_t> channelMap;
 
-    auto readUint16LE = [](const uint8_t* data) {
-        return static_cast<uint16_t>(data[0] | (data[1] << 8));
-    };
-
-    auto readUint32LE = [](const uint8_t* data) {
-        return static_cast<uint32_t>(
-            (static_cast<uint32_t>(data[0])      ) |
-            (static_cast<uint32_t>(data[1]) <<  8) |
-            (static_cast<uint32_t>(data[2]) << 16) |
-            (static_cast<uint32_t>(data[3]) << 24));
-    };
+    lossless_ = false;
+    channelMap_.clear();
+    blockOffsets_.clear();
+    cachedBlock_ = -1;
 
     // Find data chunk (skip other chunks)
     char chunkId[4];
@@ -170,11 +241,17 @@ bool WavFileReader::readHeader() {
             (void)byteRate;      // not currently used
             (void)blockAlign;    // not currently used
 
-            if (audioFormat != 1 && audioFormat != 3) {
+            lossless_ = (audioFormat == lossless::kFormatTag);
+            if (audioFormat != 1 && audioFormat != 3 && !lossless_) {
                 LOGE("Unsupported audio format: %u (only PCM/float supported)", audioFormat);
                 return false;
             }
+            if (lossless_ && bitsPerSample_ != 24) {
+                LOGE("Lossless data must be 24-bit, got %d", bitsPerSample_);
+                return false;
+            }
 
+            storedChannels_ = numChannels_;
             bytesPerFrame_ = numChannels_ * std::max<int32_t>(1, bitsPerSample_ / 8);
             fmtFound = true;
 
@@ -212,6 +289,21 @@ bool WavFileReader::readHeader() {
             continue;
         }
 
+        if (strncmp(chunkId, "chmp", 4) == 0 || strncmp(chunkId, "fact", 4) == 0) {
+            std::vector<uint8_t> buffer(chunkSize + (chunkSize & 1));
+            if (fread(buffer.data(), 1, buffer.size(), fileHandle_) != buffer.size()) {
+                LOGE("Failed to read %.4s chunk", chunkId);
+                return false;
+            }
+            if (chunkId[0] == 'c') {
+                buffer.resize(chunkSize);
+                channelMap = std::move(buffer);
+            } else if (chunkSize >= 4) {
+                factSampleCount = readUint32LE(buffer.data());
+            }
+            continue;
+        }
+
         if (strncmp(chunkId, "data", 4) == 0) {
             if (!fmtFound) {
                 LOGE("Encountered data chunk before fmt chunk");
@@ -233,14 +325,25 @@ bool WavFileReader::readHeader() {
 
             dataSize_ = static_cast<int64_t>(dataSize64);
 
+            if (!channelMap.empty() && !applyChannelMap(channelMap)) {
+                return false;
+            }
+
             uint64_t frames64 = 0;
             if (hasDs64 && ds64SampleCount > 0) {
                 frames64 = ds64SampleCount;
-            } else if (bytesPerFrame_ > 0) {
+            } else if (factSampleCount > 0) {
+                frames64 = factSampleCount;
+            } else if (bytesPerFrame_ > 0 && !lossless_) {
                 frames64 = dataSize64 / static_cast<uint64_t>(bytesPerFrame_);
             }
             totalFrames_ = static_cast<int64_t>(std::min<uint64_t>(frames64, static_cast<uint64_t>(std::numeric_limits<int64_t>::max())));
 
+            // The block table sets (or corrects) the length of compressed data.
+            if (lossless_ && !buildBlockIndex()) {
+                return false;
+            }
+
             // Allocate read buffer (8KB worth of frames)
             int32_t clampedBytesPerFrame = std::max(bytesPerFrame_, 1);
             int32_t bufferFrames = std::max(8192 / clampedBytesPerFrame, 256);
@@ -267,11 +370,152 @@ bool WavFileReader::readHeader() {
     return false;
 }
 
+bool WavFileReader::applyChannelMap(const std::vector<uint8_t>& payload) {
+    // uint16 source channel count, uint16 count, uint16 source channel per stored channel
+    const size_t count = payload.size() >= 4 ? readUint16LE(payload.data() + 2) : 0;
+    const int32_t sourceChannels = payload.size() >= 4 ? readUint16LE(payload.data()) : 0;
+    if (count != static_cast<size_t>(storedChannels_) || payload.size() < 4 + 2 * count) {
+        LOGE("Channel map does not match the %d stored channels", storedChannels_);
+        return false;
+    }
+
+    channelMap_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        channelMap_[i] = readUint16LE(payload.data() + 4 + 2 * i);
+        if (channelMap_[i] >= sourceChannels) {
+            LOGE("Channel map entry %d out of range (%d source channels)", channelMap_[i], sourceChannels);
+            return false;
+        }
+    }
+    numChannels_ = sourceChannels;
+    LOGD("Channel subset file: %d of %d channels stored", storedChannels_, numChannels_);
+    return true;
+}
+
+bool WavFileReader::buildBlockIndex() {
+    struct stat st;
+    if (fstat(fileno(fileHandle_), &st) != 0 || !S_ISREG(st.st_mode)) {
+        LOGE("Lossless files need a seekable regular file");
+        return false;
+    }
+    const int64_t fileSize = static_cast<int64_t>(st.st_size);
+    const int64_t available = std::max<int64_t>(0, fileSize - dataStartOffset_);
+    if (dataSize_ <= 0 || dataSize_ > available) {
+        // Header never finalized (interrupted recording): take whatever blocks made it to disk.
+        dataSize_ = available;
+    }
+
+    const int64_t trailer = dataStartOffset_ + dataSize_ + (dataSize_ & 1);
+    if (!readBlockTable(trailer, fileSize)) {
+        LOGD("No block table; scanning block headers");
+        blockOffsets_.clear();
+        blockFrames_ = lossless::kBlockFrames;
+        uint64_t offset = 0;
+        uint8_t raw[lossless::kBlockHeaderBytes];
+        lossless::BlockHeader header;
+        while (offset + lossless::kBlockHeaderBytes <= static_cast<uint64_t>(dataSize_) &&
+               readFully(dataStartOffset_ + static_cast<int64_t>(offset), raw, sizeof(raw)) &&
+               lossless::readBlockHeader(raw, sizeof(raw), header) &&
+               header.channels == static_cast<uint32_t>(storedChannels_) &&
+               offset + lossless::kBlockHeaderBytes + header.payloadBytes <= static_cast<uint64_t>(dataSize_)) {
+            blockOffsets_.push_back(offset);
+            offset += lossless::kBlockHeaderBytes + header.payloadBytes;
+            if (header.frames != blockFrames_) {
+                break;  // only the last block may be short
+            }
+        }
+        blockOffsets_.push_back(offset);
+        dataSize_ = static_cast<int64_t>(offset);
+    }
+
+    // Every block but the last is full; the last one's header gives the exact length.
+    const size_t blocks = blockOffsets_.size() - 1;
+    int64_t frames = 0;
+    if (blocks > 0) {
+        uint8_t raw[lossless::kBlockHeaderBytes];
+        lossless::BlockHeader header;
+        if (!readFully(dataStartOffset_ + static_cast<int64_t>(blockOffsets_[blocks - 1]), raw, sizeof(raw)) ||
+            !lossless::readBlockHeader(raw, sizeof(raw), header)) {
+            LOGE("Unreadable final lossless block");
+            return false;
+        }
+        frames = static_cast<int64_t>(blocks - 1) * blockFrames_ + header.frames;
+    }
+    if (totalFrames_ != frames) {
+        LOGD("Lossless length from block table: %lld frames (header said %lld)",
+             (long long)frames, (long long)totalFrames_);
+        totalFrames_ = frames;
+    }
+    LOGD("Lossless data: %zu blocks of %u frames, %lld bytes", blocks, blockFrames_, (long long)dataSize_);
+    return true;
+}
+
+bool WavFileReader::readBlockTable(int64_t offset, int64_t fileSize) {
+    // "spix": uint32 block frames, uint32 count, uint64 data-relative offset per block
+    while (offset + 8 <= fileSize) {
+        uint8_t chunk[16];
+        if (!readFully(offset, chunk, 8)) {
+            return false;
+        }
+        const uint32_t chunkSize = readUint32LE(chunk + 4);
+        if (memcmp(chunk, "spix", 4) != 0) {
+            offset += 8 + static_cast<int64_t>(chunkSize) + (chunkSize & 1);
+            continue;
+        }
+        if (chunkSize < 8 || offset + 8 + chunkSize > fileSize || !readFully(offset + 8, chunk + 8, 8)) {
+            return false;
+        }
+        const uint32_t blockFrames = readUint32LE(chunk + 8);
+        const uint32_t count = readUint32LE(chunk + 12);
+        if (blockFrames == 0 || blockFrames > lossless::kMaxBlockFrames || chunkSize < 8 + 8ull * count) {
+            return false;
+        }
+
+        std::vector<uint8_t> table(8ull * count);
+        if (!table.empty() && !readFully(offset + 16, table.data(), table.size())) {
+            return false;
+        }
+        blockOffsets_.resize(count + 1);
+        for (uint32_t i = 0; i < count; ++i) {
+            blockOffsets_[i] = readUint64LE(table.data() + 8ull * i);
+            if (blockOffsets_[i] >= static_cast<uint64_t>(dataSize_) || (i > 0 && blockOffsets_[i] <= blockOffsets_[i - 1])) {
+                return false;
+            }
+        }
+        blockOffsets_[count] = static_cast<uint64_t>(dataSize_);
+        blockFrames_ = blockFrames;
+        return true;
+    }
+    return false;
+}
+
+bool WavFileReader::readFully(int64_t offset, uint8_t* dst, size_t bytes) {
+    const int fd = fileno(fileHandle_);
+    while (bytes > 0) {
+        const ssize_t got = pread(fd, dst, bytes, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        dst += got;
+        bytes -= static_cast<size_t>(got);
+        offset += got;
+    }
+    return true;
+}
+
 int32_t WavFileReader::read(float* buffer, int32_t numFrames) {
     if (!fileHandle_ || currentFrame_ >= totalFrames_) {
         return 0;
     }
 
+    if (bitsPerSample_ != 16 && bitsPerSample_ != 24 && bitsPerSample_ != 32) {
+        LOGE("Unsupported bit depth: %d", bitsPerSample_);
+        return 0;
+    }
+
     // Clamp to available frames
     int32_t framesToRead = std::min(numFrames, (int32_t)(totalFrames_ - currentFrame_));
 
@@ -279,57 +523,257 @@ int32_t WavFileReader::read(float* buffer, int32_t numFrames) {
         return 0;
     }
 
-    int32_t bytesToRead = framesToRead * bytesPerFrame_;
+    if (lossless_) {
+        return readLossless(buffer, framesToRead);
+    }
+    return mmapEnabled_ ? readMapped(buffer, framesToRead) : readBuffered(buffer, framesToRead);
+}
+
+int32_t WavFileReader::readLossless(float* buffer, int32_t numFrames) {
+    int32_t framesRead = 0;
+    while (framesRead < numFrames) {
+        const int64_t block = currentFrame_ / blockFrames_;
+        if (block != cachedBlock_ && !decodeBlock(block)) {
+            break;
+        }
+
+        const int32_t offset = static_cast<int32_t>(currentFrame_ - block * blockFrames_);
+        const int32_t count = std::min(numFrames - framesRead, cachedBlockFrames_ - offset);
+        if (count <= 0) {
+            break;
+        }
+        const float* src = blockFloats_.data() + static_cast<size_t>(offset) * storedChannels_;
+        float* dst = buffer + static_cast<size_t>(framesRead) * numChannels_;
+        if (channelMap_.empty()) {
+            std::memcpy(dst, src, static_cast<size_t>(count) * storedChannels_ * sizeof(float));
+        } else {
+            scatterChannels(src, dst, count);
+        }
+        framesRead += count;
+        currentFrame_ += count;
+    }
+    return framesRead;
+}
+
+bool WavFileReader::decodeBlock(int64_t block) {
+    if (block < 0 || block + 1 >= static_cast<int64_t>(blockOffsets_.size())) {
+        return false;
+    }
+
+    const uint64_t start = blockOffsets_[block];
+    const size_t bytes = static_cast<size_t>(blockOffsets_[block + 1] - start);
+    if (blockBytes_.size() < bytes) {
+        blockBytes_.resize(bytes);
+    }
+    lossless::BlockHeader header;
+    if (!readFully(dataStartOffset_ + static_cast<int64_t>(start), blockBytes_.data(), bytes) ||
+        !lossless::readBlockHeader(blockBytes_.data(), bytes, header) ||
+        header.channels != static_cast<uint32_t>(storedChannels_) || header.frames > blockFrames_) {
+        LOGE("Unreadable lossless block %lld", (long long)block);
+        return false;
+    }
+
+    const size_t samples = static_cast<size_t>(header.frames) * header.channels;
+    if (blockSamples_.size() < samples) {
+        blockSamples_.resize(samples);
+        blockFloats_.resize(samples);
+    }
+    if (!decoder_.decode(blockBytes_.data(), bytes, blockSamples_.data())) {
+        LOGE("Corrupt lossless block %lld", (long long)block);
+        return false;
+    }
+    for (size_t i = 0; i < samples; ++i) {
+        blockFloats_[i] = static_cast<float>(blockSamples_[i]) * kInt24Scale;
+    }
+    cachedBlock_ = block;
+    cachedBlockFrames_ = static_cast<int32_t>(header.frames);
+    return true;
+}
+
+int32_t WavFileReader::readBuffered(float* buffer, int32_t numFrames) {
+    int32_t bytesToRead = numFrames * bytesPerFrame_;
     if (readBuffer_.size() < static_cast<size_t>(bytesToRead)) {
         readBuffer_.resize(bytesToRead);
     }
 
-    if (bitsPerSample_ == 24) {
-        // Read 24-bit data
-        int32_t bytesRead = fread(readBuffer_.data(), 1, bytesToRead, fileHandle_);
-        int32_t framesRead = bytesRead / bytesPerFrame_;
+    int32_t bytesRead = fread(readBuffer_.data(), 1, bytesToRead, fileHandle_);
+    int32_t framesRead = bytesRead / bytesPerFrame_;
 
-        if (framesRead > 0) {
-            convert24BitToFloat(readBuffer_.data(), buffer, framesRead * numChannels_);
-            currentFrame_ += framesRead;
-        }
-        return framesRead;
+    if (framesRead > 0) {
+        convertFrames(readBuffer_.data(), buffer, framesRead);
+        currentFrame_ += framesRead;
+    }
+    return framesRead;
+}
 
-    } else if (bitsPerSample_ == 32) {
-        // Read 32-bit data
-        int32_t bytesRead = fread(readBuffer_.data(), 1, bytesToRead, fileHandle_);
-        int32_t framesRead = bytesRead / bytesPerFrame_;
+int32_t WavFileReader::readMapped(float* buffer, int32_t numFrames) {
+    const int64_t byteOffset = dataStartOffset_ + currentFrame_ * static_cast<int64_t>(bytesPerFrame_);
+    const int64_t available = std::max<int64_t>(0, dataEndOffset_ - byteOffset) / bytesPerFrame_;
+    const int32_t framesRead = static_cast<int32_t>(std::min<int64_t>(numFrames, available));
+    if (framesRead <= 0) {
+        return 0;
+    }
 
-        if (framesRead > 0) {
-            convert32BitToFloat(reinterpret_cast<int32_t*>(readBuffer_.data()), buffer, framesRead * numChannels_);
-            currentFrame_ += framesRead;
+    const size_t bytes = static_cast<size_t>(framesRead) * static_cast<size_t>(bytesPerFrame_);
+    if (!mapWindow(byteOffset, bytes)) {
+        // Out of address space or mapping refused: continue with stdio.
+        mmapEnabled_ = false;
+        if (fseeko(fileHandle_, static_cast<off_t>(byteOffset), SEEK_SET) != 0) {
+            LOGE("Fallback seek failed at frame %lld", (long long)currentFrame_);
+            return 0;
         }
-        return framesRead;
+        return readBuffered(buffer, numFrames);
+    }
+
+    convertFrames(mapBase_ + (byteOffset - mapOffset_), buffer, framesRead);
+    currentFrame_ += framesRead;
+    adviseReadahead(byteOffset + static_cast<int64_t>(bytes));
+    return framesRead;
+}
 
-    } else if (bitsPerSample_ == 16) {
-        int32_t bytesRead = fread(readBuffer_.data(), 1, bytesToRead, fileHandle_);
-        int32_t framesRead = bytesRead / bytesPerFrame_;
+void WavFileReader::convertFrames(const uint8_t* src, float* dst, int32_t numFrames) {
+    const size_t samples = static_cast<size_t>(numFrames) * static_cast<size_t>(storedChannels_);
+    if (channelMap_.empty()) {
+        convertToFloat(src, dst, static_cast<int32_t>(samples));
+        return;
+    }
+    if (scatterBuffer_.size() < samples) {
+        scatterBuffer_.resize(samples);
+    }
+    convertToFloat(src, scatterBuffer_.data(), static_cast<int32_t>(samples));
+    scatterChannels(scatterBuffer_.data(), dst, numFrames);
+}
 
-        if (framesRead > 0) {
-            convert16BitToFloat(reinterpret_cast<int16_t*>(readBuffer_.data()), buffer, framesRead * numChannels_);
-            currentFrame_ += framesRead;
+void WavFileReader::scatterChannels(const float* src, float* dst, int32_t numFrames) {
+    // Capsules that were not recorded play back as silence.
+    const size_t stored = static_cast<size_t>(storedChannels_);
+    for (int32_t frame = 0; frame < numFrames; ++frame) {
+        float* out = dst + static_cast<size_t>(frame) * numChannels_;
+        std::fill(out, out + numChannels_, 0.0f);
+        for (size_t i = 0; i < stored; ++i) {
+            out[channelMap_[i]] = src[i];
         }
-        return framesRead;
+        src += stored;
+    }
+}
 
+void WavFileReader::convertToFloat(const uint8_t* src, float* dst, int32_t numSamples) {
+    if (bitsPerSample_ == 24) {
+        pcm24::toFloat(src, dst, static_cast<size_t>(numSamples));
+    } else if (bitsPerSample_ == 32) {
+        convert32BitToFloat(reinterpret_cast<const int32_t*>(src), dst, numSamples);
     } else {
-        LOGE("Unsupported bit depth: %d", bitsPerSample_);
-        return 0;
+        convert16BitToFloat(reinterpret_cast<const int16_t*>(src), dst, numSamples);
     }
 }
 
+bool WavFileReader::initMapping() {
+    mmapEnabled_ = false;
+    if (lossless_) {
+        return false;  // compressed blocks are read with pread
+    }
+
+    struct stat st;
+    const int fd = fileno(fileHandle_);
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        LOGD("Source is not a regular file; using buffered reads");
+        return false;
+    }
+
+    // Never map past the end of the file, even if the header claims more data.
+    dataEndOffset_ = std::min<int64_t>(dataStartOffset_ + dataSize_, static_cast<int64_t>(st.st_size));
+    mapOffset_ = 0;
+    mapLength_ = 0;
+    readaheadEnd_ = 0;
+    mmapEnabled_ = true;
+
+    if (!mapWindow(dataStartOffset_, 0)) {
+        mmapEnabled_ = false;
+        LOGD("mmap unavailable for source; using buffered reads");
+        return false;
+    }
+
+    LOGD("Using memory-mapped reads (%zu byte window)", mapLength_);
+    return true;
+}
+
+bool WavFileReader::mapWindow(int64_t byteOffset, size_t bytes) {
+    if (mapBase_ && byteOffset >= mapOffset_ &&
+        byteOffset + static_cast<int64_t>(bytes) <= mapOffset_ + static_cast<int64_t>(mapLength_)) {
+        return true;
+    }
+
+    unmapWindow();
+
+    const int64_t pageSize = PageSize();
+    const int64_t start = (byteOffset / pageSize) * pageSize;
+    const int64_t wanted = std::max<int64_t>(kMapWindowBytes, byteOffset - start + static_cast<int64_t>(bytes));
+    const int64_t length = std::min<int64_t>(wanted, dataEndOffset_ - start);
+    if (length <= 0) {
+        // Nothing left to map (empty data chunk or position at the end).
+        return bytes == 0;
+    }
+
+    void* base = MapRegion(fileno(fileHandle_), start, static_cast<size_t>(length));
+    if (base == MAP_FAILED) {
+        LOGE("mmap of %lld bytes at %lld failed: %s", (long long)length, (long long)start, strerror(errno));
+        return false;
+    }
+
+    mapBase_ = static_cast<uint8_t*>(base);
+    mapOffset_ = start;
+    mapLength_ = static_cast<size_t>(length);
+    madvise(mapBase_, mapLength_, MADV_SEQUENTIAL);
+    readaheadEnd_ = start;
+    return true;
+}
+
+void WavFileReader::unmapWindow() {
+    if (mapBase_) {
+        munmap(mapBase_, mapLength_);
+        mapBase_ = nullptr;
+    }
+    mapOffset_ = 0;
+    mapLength_ = 0;
+    readaheadEnd_ = 0;
+}
+
+void WavFileReader::adviseReadahead(int64_t byteOffset) {
+    // Re-issue WILLNEED once the reader is half way through the last window.
+    if (byteOffset + kReadaheadBytes / 2 < readaheadEnd_) {
+        return;
+    }
+
+    const int64_t pageSize = PageSize();
+    const int64_t mapEnd = mapOffset_ + static_cast<int64_t>(mapLength_);
+    const int64_t start = std::max(readaheadEnd_, (byteOffset / pageSize) * pageSize);
+    const int64_t end = std::min(mapEnd, byteOffset + kReadaheadBytes);
+    if (end > start) {
+        madvise(mapBase_ + (start - mapOffset_), static_cast<size_t>(end - start), MADV_WILLNEED);
+    }
+    readaheadEnd_ = std::max(readaheadEnd_, end);
+}
+
 bool WavFileReader::seek(int64_t framePosition) {
     if (!fileHandle_) {
         return false;
     }
 
     framePosition = std::max(static_cast<int64_t>(0), std::min(framePosition, totalFrames_));
+    if (lossless_) {
+        // The next read decodes the block holding this frame.
+        currentFrame_ = framePosition;
+        return true;
+    }
     int64_t byteOffset = dataStartOffset_ + (framePosition * static_cast<int64_t>(bytesPerFrame_));
 
+    if (mmapEnabled_) {
+        // No I/O needed; the next read maps (if necessary) and prefetches from here.
+        currentFrame_ = framePosition;
+        readaheadEnd_ = std::min(readaheadEnd_, byteOffset);
+        return true;
+    }
+
     if (fseeko(fileHandle_, static_cast<off_t>(byteOffset), SEEK_SET) != 0) {
         LOGE("Seek failed to frame %lld", (long long)framePosition);
         return false;
@@ -344,37 +788,6 @@ double WavFileReader::getDurationSeconds() const {
     return (double)totalFrames_ / (double)sampleRate_;
 }
 
-void WavFileReader::convert24BitToFloat(const uint8_t* src, float* dst, int32_t numSamples) {
-    const float scale = 1.0f / 8388608.0f; // 2^23
-    
-    // Log first few samples for debugging
-    static bool logged = false;
-    
-    for (int32_t i = 0; i < numSamples; i++) {
-        // Read 3 bytes as little-endian 24-bit signed integer
-        int32_t sample = (src[2] << 16) | (src[1] << 8) | src[0];
-        
-        // Sign extend from 24-bit to 32-bit
-        if (sample & 0x800000) {
-            sample |= 0xFF000000;
-        }
-        
-        dst[i] = (float)sample * scale;
-        
-        // Log first 10 samples once
-        if (!logged && i < 10) {
-            LOGD("Sample %d: bytes[%02X %02X %02X] -> int32=%d -> float=%.6f", 
-                 i, src[0], src[1], src[2], sample, dst[i]);
-        }
-        
-        src += 3;
-    }
-    
-    if (!logged) {
-        logged = true;
-    }
-}
-
 void WavFileReader::convert32BitToFloat(const int32_t* src, float* dst, int32_t numSamples) {
     const float scale = 1.0f / 2147483648.0f; // 2^31
     
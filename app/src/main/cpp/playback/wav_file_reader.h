@@ -5,6 +5,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include "lossless_codec.h"
 
 namespace spcmic {
 
@@ -37,7 +38,17 @@ struct WavDataChunk {
 
 /**
  * 84-channel WAV file reader for SPCMic recordings
- * Supports streaming playback with buffered reading
+ * Supports streaming playback with buffered reading.
+ *
+ * Regular files are read through a sliding mmap window (sequential advice
+ * plus readahead ahead of the read position), converting straight from the
+ * mapped pages. Descriptors that cannot be mapped fall back to stdio.
+ *
+ * Reduced recordings read like full ones: a file with a channel map
+ * ("chmp") reports its source channel count and returns silence for the
+ * channels it does not hold, and lossless files (lossless_codec blocks)
+ * are decoded one block at a time with pread, located through the "spix"
+ * block table or, for an unfinished file, by walking the block headers.
  */
 class WavFileReader {
 public:
@@ -52,6 +63,12 @@ public:
     bool open(const std::string& filePath);
     bool openFromFd(int fd, const std::string& displayPath);
 
+    /**
+     * Open a second reader on the file behind @p source with its own file
+     * position, e.g. for parallel segment rendering.
+     */
+    bool openDuplicate(const WavFileReader& source);
+
     /**
      * Close the current file
      */
@@ -94,17 +111,36 @@ public:
     int32_t getSampleRate() const { return sampleRate_; }
     int32_t getBitsPerSample() const { return bitsPerSample_; }
     bool isOpen() const { return fileHandle_ != nullptr; }
+    bool isMemoryMapped() const { return mmapEnabled_; }
+    /** Channels actually stored; below getNumChannels() for a channel-subset recording. */
+    int32_t getStoredChannels() const { return storedChannels_; }
+    bool isLossless() const { return lossless_; }
 
 private:
     /**
      * Read and validate WAV header
      */
     bool readHeader();
-
-    /**
-     * Convert 24-bit packed samples to float
-     */
-    void convert24BitToFloat(const uint8_t* src, float* dst, int32_t numSamples);
+    bool applyChannelMap(const std::vector<uint8_t>& payload);
+    bool buildBlockIndex();
+    bool readBlockTable(int64_t offset, int64_t fileSize);
+
+    /** Switch to the mmap backend if the open file is a mappable regular file. */
+    bool initMapping();
+
+    /** Make sure the mapped window covers [byteOffset, byteOffset + bytes). */
+    bool mapWindow(int64_t byteOffset, size_t bytes);
+    void unmapWindow();
+    void adviseReadahead(int64_t byteOffset);
+
+    int32_t readMapped(float* buffer, int32_t numFrames);
+    int32_t readBuffered(float* buffer, int32_t numFrames);
+    int32_t readLossless(float* buffer, int32_t numFrames);
+    bool decodeBlock(int64_t block);
+    bool readFully(int64_t offset, uint8_t* dst, size_t bytes);
+    void convertFrames(const uint8_t* src, float* dst, int32_t numFrames);
+    void scatterChannels(const float* src, float* dst, int32_t numFrames);
+    void convertToFloat(const uint8_t* src, float* dst, int32_t numSamples);
 
     /**
      * Convert 32-bit int samples to float
@@ -121,10 +157,32 @@ private:
     int32_t numChannels_;
     int32_t sampleRate_;
     int32_t bitsPerSample_;
-    int32_t bytesPerFrame_;
+    int32_t bytesPerFrame_;     // stored frame
+    int32_t storedChannels_;
+    std::vector<int32_t> channelMap_;  // source channel per stored channel; empty = all stored
+    std::vector<float> scatterBuffer_;
+
+    // Lossless backend
+    bool lossless_;
+    uint32_t blockFrames_;
+    std::vector<uint64_t> blockOffsets_;  // data-relative block starts, plus the end of the last block
+    int64_t cachedBlock_;
+    int32_t cachedBlockFrames_;
+    std::vector<uint8_t> blockBytes_;
+    std::vector<int32_t> blockSamples_;
+    std::vector<float> blockFloats_;      // decoded block, stored channels
+    lossless::Decoder decoder_;
     
-    // Read buffer for raw file data
+    // Read buffer for raw file data (stdio backend)
     std::vector<uint8_t> readBuffer_;
+
+    // mmap backend
+    bool mmapEnabled_;
+    int64_t dataEndOffset_;  // end of readable sample data within the file
+    uint8_t* mapBase_;
+    int64_t mapOffset_;      // file offset of mapBase_ (page aligned)
+    size_t mapLength_;
+    int64_t readaheadEnd_;   // file offset up to which WILLNEED was issued
 };
 
 } // namespace spcmic
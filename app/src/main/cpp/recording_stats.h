@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * Lock-free latency histogram with power-of-two microsecond buckets.
+ * Any thread may record; readers see relaxed but self-consistent-enough
+ * values for diagnostics (each field is individually atomic).
+ */
+class LatencyHistogram {
+public:
+    /** Bucket 0 holds < 1 us, bucket i holds [2^(i-1), 2^i) us, the last one everything above. */
+    static constexpr size_t kBuckets = 24;
+
+    /** count, sum, max, p50, p90, p99, p99.9, then the buckets. */
+    static constexpr size_t kSnapshotFields = 7 + kBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    void record(int64_t micros) {
+        micros = std::max<int64_t>(0, micros);
+        m_buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+        m_sumMicros.fetch_add(micros, std::memory_order_relaxed);
+
+        int64_t currentMax = m_maxMicros.load(std::memory_order_relaxed);
+        while (micros > currentMax &&
+               !m_maxMicros.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed)) {
+        }
+    }
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+
+    void reset() {
+        for (auto& bucket : m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_sumMicros.store(0, std::memory_order_relaxed);
+        m_maxMicros.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Upper edge (in us) of the bucket holding the @p fraction quantile, or
+     * the recorded maximum if that is lower. 0 when nothing was recorded.
+     */
+    int64_t percentile(const int64_t* buckets, int64_t count, double fraction) const {
+        if (count <= 0) {
+            return 0;
+        }
+        const int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(fraction * static_cast<double>(count) + 0.5));
+        int64_t cumulative = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            cumulative += buckets[i];
+            if (cumulative >= rank) {
+                return std::min(upperEdge(i), m_maxMicros.load(std::memory_order_relaxed));
+            }
+        }
+        return m_maxMicros.load(std::memory_order_relaxed);
+    }
+
+    /** Fill @p out (kSnapshotFields values). */
+    void snapshot(int64_t* out) const {
+        int64_t buckets[kBuckets];
+        int64_t count = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+            count += buckets[i];
+        }
+        out[0] = count;
+        out[1] = m_sumMicros.load(std::memory_order_relaxed);
+        out[2] = m_maxMicros.load(std::memory_order_relaxed);
+        out[3] = percentile(buckets, count, 0.50);
+        out[4] = percentile(buckets, count, 0.90);
+        out[5] = percentile(buckets, count, 0.99);
+        out[6] = percentile(buckets, count, 0.999);
+        std::copy(buckets, buckets + kBuckets, out + 7);
+    }
+
+private:
+    static size_t bucketFor(int64_t micros) {
+        size_t bucket = 0;
+        while (micros > 0 && bucket + 1 < kBuckets) {
+            micros >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    static int64_t upperEdge(size_t bucket) {
+        return bucket == 0 ? 1 : (int64_t{1} << bucket);
+    }
+
+    std::atomic<int64_t> m_buckets[kBuckets];
+    std::atomic<int64_t> m_sumMicros;
+    std::atomic<int64_t> m_maxMicros;
+};
+
+/**
+ * Real-time health counters for a recording session, written lock-free by
+ * the USB and disk threads and read by the UI/QA harness via snapshot().
+ */
+class RecordingStats {
+public:
+    /** Scalar fields at the start of snapshot(), followed by the histograms. */
+    enum Field : size_t {
+        RingCapacityBytes,
+        RingHighWaterBytes,   // highest ring fill seen after a producer commit
+        BytesDropped,         // audio discarded because the ring was full
+        OverflowEvents,
+        CarriedFrames,        // frames split across USB packets and completed in the carry buffer
+        CarriedBytes,         // partial-frame bytes staged at packet boundaries
+        DiskWrites,
+        DiskWriteErrors,
+        SpooledBytes,         // audio parked in the overflow spool file while the ring was at its ceiling
+        ScalarCount
+    };
+
+    /** Histogram order after the scalars. */
+    enum Histogram : size_t {
+        ReapInterval,         // time between consecutive URB reaps
+        ProcessDuration,      // processAudioBuffer() wall time per chunk
+        WriteLatency,         // WAV writer call per disk-thread block
+        HistogramCount
+    };
+
+    static constexpr size_t kSnapshotSize =
+        ScalarCount + HistogramCount * LatencyHistogram::kSnapshotFields;
+
+    RecordingStats() { reset(); }
+
+    /** Not synchronized with writers; call while no session threads are running. */
+    void reset() {
+        for (auto& value : m_scalars) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        for (auto& histogram : m_histograms) {
+            histogram.reset();
+        }
+    }
+
+    void add(Field field, int64_t delta) {
+        m_scalars[field].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    void set(Field field, int64_t value) {
+        m_scalars[field].store(value, std::memory_order_relaxed);
+    }
+
+    /** Raise @p field to @p value if it is higher (single writer per field). */
+    void raise(Field field, int64_t value) {
+        if (value > m_scalars[field].load(std::memory_order_relaxed)) {
+            m_scalars[field].store(value, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram& histogram(Histogram which) { return m_histograms[which]; }
+
+    /** Copy up to @p count values in the documented order; returns the number copied. */
+    size_t snapshot(int64_t* out, size_t count) const {
+        if (!out) {
+            return 0;
+        }
+        int64_t values[kSnapshotSize];
+        for (size_t i = 0; i < ScalarCount; ++i) {
+            values[i] = m_scalars[i].load(std::memory_order_relaxed);
+        }
+        for (size_t h = 0; h < HistogramCount; ++h) {
+            m_histograms[h].snapshot(values + ScalarCount + h * LatencyHistogram::kSnapshotFields);
+        }
+        const size_t copied = std::min(count, kSnapshotSize);
+        std::copy(values, values + copied, out);
+        return copied;
+    }
+
+private:
+    std::atomic<int64_t> m_scalars[ScalarCount];
+    LatencyHistogram m_histograms[HistogramCount];
+};
@@ -0,0 +1,330 @@
+#include "segmented_wav_writer.h"
+#include "thread_config.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define LOG_TAG "SegmentedWAVWriter"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+SegmentedWAVWriter::SegmentedWAVWriter()
+    : m_segmentBytes(0)
+    , m_segmentLimitBytes(0)
+    , m_currentLimitBytes(0)
+    , m_totalBytes(0)
+    , m_maxFrames(0)
+    , m_maxBytes(0)
+    , m_segmentIndex(0)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_bitsPerSample(0)
+    , m_blockAlign(0)
+    , m_sourceChannelCount(0)
+    , m_lossless(false)
+    , m_stopHelper(false)
+    , m_nextPathIndex(2) {}
+
+SegmentedWAVWriter::~SegmentedWAVWriter() {
+    close();
+}
+
+void SegmentedWAVWriter::setSegmentLimits(uint64_t maxFrames, uint64_t maxBytes) {
+    m_maxFrames = maxFrames;
+    m_maxBytes = maxBytes;
+}
+
+void SegmentedWAVWriter::setChannelMap(const std::vector<uint16_t>& sourceChannels, int sourceChannelCount) {
+    m_channelMap = sourceChannels;
+    m_sourceChannelCount = sourceChannelCount;
+}
+
+std::unique_ptr<WAVWriter> SegmentedWAVWriter::createWriter() const {
+    auto writer = std::make_unique<WAVWriter>();
+    writer->setChannelMap(m_channelMap, m_sourceChannelCount);
+    writer->setLossless(m_lossless);
+    return writer;
+}
+
+std::string SegmentedWAVWriter::segmentPath(const std::string& basePath, int index) {
+    if (index <= 1) {
+        return basePath;
+    }
+
+    const size_t slash = basePath.find_last_of('/');
+    const size_t dot = basePath.find_last_of('.');
+    const bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    const std::string stem = hasExtension ? basePath.substr(0, dot) : basePath;
+    const std::string extension = hasExtension ? basePath.substr(dot) : std::string(".wav");
+
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "_%03d", index);
+    return stem + suffix + extension;
+}
+
+bool SegmentedWAVWriter::open(const std::string& filename, int sampleRate, int channels, int bitsPerSample) {
+    if (isOpen()) {
+        LOGE("Segmented writer already open");
+        return false;
+    }
+
+    auto writer = createWriter();
+    if (!writer->open(filename, sampleRate, channels, bitsPerSample)) {
+        return false;
+    }
+
+    m_current = std::move(writer);
+    m_currentLabel = filename;
+    m_basePath = filename;
+    m_nextPathIndex = 2;
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_bitsPerSample = bitsPerSample;
+    return startSession();
+}
+
+bool SegmentedWAVWriter::openFromFd(int fd, int sampleRate, int channels, int bitsPerSample,
+                                    const std::string& label) {
+    if (isOpen()) {
+        LOGE("Segmented writer already open");
+        return false;
+    }
+
+    auto writer = createWriter();
+    if (!writer->openFromFd(fd, sampleRate, channels, bitsPerSample)) {
+        return false;
+    }
+
+    m_current = std::move(writer);
+    m_currentLabel = label;
+    m_basePath.clear();
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_bitsPerSample = bitsPerSample;
+    return startSession();
+}
+
+bool SegmentedWAVWriter::startSession() {
+    m_blockAlign = static_cast<size_t>(m_channels) * static_cast<size_t>(m_bitsPerSample / 8);
+    m_segmentBytes = 0;
+    m_totalBytes = 0;
+    m_segmentIndex.store(1, std::memory_order_release);
+
+    // Limits are rounded down to whole frames so every boundary is sample accurate.
+    uint64_t limit = 0;
+    if (m_maxFrames > 0) {
+        limit = m_maxFrames * m_blockAlign;
+    }
+    if (m_maxBytes > 0) {
+        const uint64_t bytesLimit = m_maxBytes / m_blockAlign * m_blockAlign;
+        limit = limit > 0 ? std::min(limit, bytesLimit) : bytesLimit;
+    }
+    if (m_blockAlign == 0) {
+        limit = 0;
+    } else if (limit > 0) {
+        limit = std::max<uint64_t>(limit, m_blockAlign);
+    }
+    m_segmentLimitBytes = limit;
+    m_currentLimitBytes = limit;
+
+    if (m_segmentLimitBytes == 0) {
+        return true;
+    }
+
+    LOGI("Segmented recording: rolling every %llu bytes (%.1f s)",
+         static_cast<unsigned long long>(m_segmentLimitBytes),
+         static_cast<double>(m_segmentLimitBytes / m_blockAlign) / std::max(1, m_sampleRate));
+
+    m_stopHelper = false;
+    m_helper = std::thread(&SegmentedWAVWriter::helperLoop, this);
+    return true;
+}
+
+bool SegmentedWAVWriter::queueNextFd(int fd, const std::string& label) {
+    int dupFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupFd < 0) {
+        LOGE("Failed to dup segment descriptor: %s", strerror(errno));
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingFds.emplace_back(dupFd, label);
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+bool SegmentedWAVWriter::writeData(const uint8_t* data, size_t size) {
+    if (!m_current) {
+        LOGE("Segmented writer not open");
+        return false;
+    }
+
+    if (m_segmentLimitBytes == 0) {
+        const bool ok = m_current->writeData(data, size);
+        if (ok) {
+            m_totalBytes += size;
+        }
+        return ok;
+    }
+
+    while (size > 0) {
+        if (m_segmentBytes >= m_currentLimitBytes && !rollover()) {
+            // Next segment not ready: keep going in this file for another
+            // whole-frame stretch rather than blocking the disk thread.
+            const uint64_t retryBytes = static_cast<uint64_t>(ROLLOVER_RETRY_SECONDS) *
+                                        static_cast<uint64_t>(std::max(1, m_sampleRate)) * m_blockAlign;
+            m_currentLimitBytes += retryBytes;
+            LOGW("Segment %d not ready, extending current file by %d s", m_segmentIndex.load() + 1,
+                 ROLLOVER_RETRY_SECONDS);
+        }
+
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, m_currentLimitBytes - m_segmentBytes));
+        if (!m_current->writeData(data, chunk)) {
+            return false;
+        }
+        m_segmentBytes += chunk;
+        m_totalBytes += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool SegmentedWAVWriter::rollover() {
+    std::unique_ptr<WAVWriter> next;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_next) {
+            return false;
+        }
+        next = std::move(m_next);
+        m_currentLabel = std::move(m_nextLabel);
+        m_nextLabel.clear();
+        m_nextPath.clear();
+        // The helper finalizes the old file, so the header patch and close stay off this thread.
+        m_retired.push_back(std::move(m_current));
+    }
+    m_cv.notify_one();
+
+    m_current = std::move(next);
+    m_segmentBytes = 0;
+    m_currentLimitBytes = m_segmentLimitBytes;
+    const int index = m_segmentIndex.fetch_add(1, std::memory_order_acq_rel) + 1;
+    LOGI("Rolled over to segment %d after %llu bytes", index, static_cast<unsigned long long>(m_totalBytes));
+    return true;
+}
+
+bool SegmentedWAVWriter::hasTargetLocked() const {
+    return !m_basePath.empty() || !m_pendingFds.empty();
+}
+
+void SegmentedWAVWriter::helperLoop() {
+    thread_config::configureCurrentThread(thread_config::Role::Background);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this]() {
+            return m_stopHelper || !m_retired.empty() || (!m_next && hasTargetLocked());
+        });
+
+        if (!m_retired.empty()) {
+            std::vector<std::unique_ptr<WAVWriter>> retired;
+            retired.swap(m_retired);
+            lock.unlock();
+            for (auto& writer : retired) {
+                writer->close();
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (m_stopHelper) {
+            break;
+        }
+
+        // Open the next segment outside the lock: open, header staging and
+        // the first fallocate extent all happen here, not on the disk thread.
+        std::string path;
+        int fd = -1;
+        std::string label;
+        if (!m_basePath.empty()) {
+            path = segmentPath(m_basePath, m_nextPathIndex);
+        } else {
+            fd = m_pendingFds.front().first;
+            label = m_pendingFds.front().second;
+            m_pendingFds.pop_front();
+        }
+        lock.unlock();
+
+        auto writer = createWriter();
+        bool ok;
+        if (fd >= 0) {
+            ok = writer->openFromFd(fd, m_sampleRate, m_channels, m_bitsPerSample);
+            ::close(fd);
+        } else {
+            ok = writer->open(path, m_sampleRate, m_channels, m_bitsPerSample);
+        }
+
+        lock.lock();
+        if (ok) {
+            LOGI("Next segment ready: %s", fd >= 0 ? label.c_str() : path.c_str());
+            m_next = std::move(writer);
+            m_nextPath = path;
+            m_nextLabel = (fd >= 0) ? label : path;
+            if (!path.empty()) {
+                ++m_nextPathIndex;
+            }
+        } else {
+            LOGE("Failed to prepare next segment %s", fd >= 0 ? label.c_str() : path.c_str());
+            if (!path.empty()) {
+                // Retry later rather than spinning on a failing path.
+                m_cv.wait_for(lock, std::chrono::seconds(1), [this]() { return m_stopHelper; });
+            }
+        }
+    }
+}
+
+void SegmentedWAVWriter::close() {
+    if (!m_current) {
+        return;
+    }
+
+    if (m_helper.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopHelper = true;
+        }
+        m_cv.notify_one();
+        m_helper.join();
+    }
+
+    m_current->close();
+    m_current.reset();
+
+    // A prepared segment that never received audio is removed again.
+    if (m_next) {
+        m_next->close();
+        m_next.reset();
+        if (!m_nextPath.empty()) {
+            unlink(m_nextPath.c_str());
+        }
+    }
+    m_nextPath.clear();
+    m_nextLabel.clear();
+
+    for (auto& pending : m_pendingFds) {
+        ::close(pending.first);
+    }
+    m_pendingFds.clear();
+    m_retired.clear();
+
+    LOGI("Segmented recording closed: %d segment(s), %llu bytes", m_segmentIndex.load(),
+         static_cast<unsigned long long>(m_totalBytes));
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "wav_writer.h"
+
+/**
+ * WAVWriter front end for long sessions: rolls to a new file every
+ * duration/size limit, splitting exactly on a frame boundary so the
+ * segments concatenate back into the original stream.
+ *
+ * A helper thread opens (and preallocates) the next segment ahead of
+ * time and closes finished ones, so the disk thread only swaps pointers
+ * at the boundary. Path-based sessions name their segments
+ * <stem>_002.wav, <stem>_003.wav, ...; descriptor-based sessions roll
+ * onto descriptors handed in with queueNextFd(). Without limits it
+ * behaves exactly like a single WAVWriter.
+ */
+class SegmentedWAVWriter {
+public:
+    SegmentedWAVWriter();
+    ~SegmentedWAVWriter();
+
+    SegmentedWAVWriter(const SegmentedWAVWriter&) = delete;
+    SegmentedWAVWriter& operator=(const SegmentedWAVWriter&) = delete;
+
+    /** Roll after @p maxFrames frames or @p maxBytes data bytes, whichever comes first; 0 = no limit. Call before open. */
+    void setSegmentLimits(uint64_t maxFrames, uint64_t maxBytes);
+
+    /**
+     * Layout options applied to every segment (see WAVWriter). Call before
+     * open. Segment limits keep counting PCM bytes, so lossless segments
+     * come out smaller than @p maxBytes.
+     */
+    void setChannelMap(const std::vector<uint16_t>& sourceChannels, int sourceChannelCount);
+    void setLossless(bool enabled) { m_lossless = enabled; }
+
+    bool open(const std::string& filename, int sampleRate, int channels, int bitsPerSample);
+    /** @p label names the first segment (e.g. its display path) for getSegmentLabel(). */
+    bool openFromFd(int fd, int sampleRate, int channels, int bitsPerSample, const std::string& label = std::string());
+
+    /** Supply the descriptor for a future segment of an fd-based session. The fd is duplicated. */
+    bool queueNextFd(int fd, const std::string& label);
+
+    bool writeData(const uint8_t* data, size_t size);
+    void close();
+
+    bool isOpen() const { return m_current != nullptr; }
+    uint64_t getBytesWritten() const { return m_totalBytes; }
+
+    /** 1-based index of the segment currently being written. */
+    int getSegmentIndex() const { return m_segmentIndex.load(std::memory_order_acquire); }
+
+    /** Path or queued label of the current segment, and the stream offset it starts at (disk thread). */
+    const std::string& getSegmentLabel() const { return m_currentLabel; }
+    uint64_t getSegmentStartBytes() const { return m_totalBytes - m_segmentBytes; }
+
+    /** Path of segment @p index for a session started on @p basePath. */
+    static std::string segmentPath(const std::string& basePath, int index);
+
+private:
+    static constexpr int ROLLOVER_RETRY_SECONDS = 1;  // extension when the next segment is not ready
+
+    bool startSession();
+    bool rollover();
+    void helperLoop();
+    bool hasTargetLocked() const;
+    std::unique_ptr<WAVWriter> createWriter() const;
+
+    std::unique_ptr<WAVWriter> m_current;   // disk thread
+    std::string m_currentLabel;
+    uint64_t m_segmentBytes;                // data bytes in m_current
+    uint64_t m_segmentLimitBytes;           // 0 = unlimited
+    uint64_t m_currentLimitBytes;           // limit for m_current, including retry extensions
+    uint64_t m_totalBytes;
+    uint64_t m_maxFrames;
+    uint64_t m_maxBytes;
+    std::atomic<int> m_segmentIndex;
+
+    int m_sampleRate;
+    int m_channels;
+    int m_bitsPerSample;
+    size_t m_blockAlign;
+    std::vector<uint16_t> m_channelMap;
+    int m_sourceChannelCount;
+    bool m_lossless;
+
+    // Shared with the helper thread
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_helper;
+    bool m_stopHelper;
+    std::string m_basePath;                              // empty for fd sessions
+    int m_nextPathIndex;                                 // next index to open in path mode
+    std::deque<std::pair<int, std::string>> m_pendingFds;
+    std::unique_ptr<WAVWriter> m_next;
+    std::string m_nextPath;                              // path of m_next (path mode), for cleanup
+    std::string m_nextLabel;                             // path or queued label of m_next
+    std::vector<std::unique_ptr<WAVWriter>> m_retired;
+};
@@ -0,0 +1,227 @@
+#include "thread_config.h"
+
+#include <android/log.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "ThreadConfig"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace thread_config {
+
+namespace {
+
+enum class Cluster { Any, Performance, Efficiency };
+
+struct RolePolicy {
+    const char* name;
+    int fifoPriority;   // 0 = do not ask for SCHED_FIFO
+    int niceValue;      // fallback (or only) nice value
+    Cluster cluster;
+};
+
+// FIFO priorities stay at the bottom of the RT range, below the audio HAL and
+// AAudio MMAP threads. Nice values mirror THREAD_PRIORITY_URGENT_AUDIO (-19),
+// THREAD_PRIORITY_AUDIO (-16) and THREAD_PRIORITY_FOREGROUND (-2).
+constexpr RolePolicy kPolicies[] = {
+    {"usb", 2, -19, Cluster::Performance},
+    {"convolver", 1, -16, Cluster::Performance},
+    {"disk", 0, -2, Cluster::Efficiency},
+    {"background", 0, 0, Cluster::Efficiency},
+};
+static_assert(sizeof(kPolicies) / sizeof(kPolicies[0]) == static_cast<size_t>(Role::Count),
+              "one policy per role");
+
+struct Topology {
+    std::vector<int> performance;   // every CPU above the slowest cluster
+    std::vector<int> efficiency;    // the slowest cluster
+};
+
+long readMaxFrequency(int cpu) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    long khz = -1;
+    if (fscanf(file, "%ld", &khz) != 1) {
+        khz = -1;
+    }
+    fclose(file);
+    return khz;
+}
+
+Topology detectTopology() {
+    Topology topology;
+    const long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpuCount <= 1 || cpuCount > CPU_SETSIZE) {
+        return topology;
+    }
+
+    std::vector<long> frequencies(static_cast<size_t>(cpuCount), -1);
+    long minFrequency = -1;
+    long maxFrequency = -1;
+    for (int cpu = 0; cpu < cpuCount; ++cpu) {
+        const long khz = readMaxFrequency(cpu);
+        frequencies[cpu] = khz;
+        if (khz <= 0) {
+            continue;
+        }
+        if (minFrequency < 0 || khz < minFrequency) minFrequency = khz;
+        if (khz > maxFrequency) maxFrequency = khz;
+    }
+
+    // Symmetric (or unreadable) topologies are left to the scheduler.
+    if (minFrequency <= 0 || minFrequency == maxFrequency) {
+        return topology;
+    }
+
+    for (int cpu = 0; cpu < cpuCount; ++cpu) {
+        if (frequencies[cpu] <= 0) {
+            continue;
+        }
+        (frequencies[cpu] > minFrequency ? topology.performance : topology.efficiency).push_back(cpu);
+    }
+
+    LOGI("CPU topology: %zu performance core(s) (cpu%d..), %zu efficiency core(s), %ld/%ld kHz",
+         topology.performance.size(), topology.performance.empty() ? -1 : topology.performance.front(),
+         topology.efficiency.size(), maxFrequency, minFrequency);
+    return topology;
+}
+
+const Topology& topology() {
+    static const Topology instance = detectTopology();
+    return instance;
+}
+
+std::mutex g_resultsMutex;
+Result g_results[static_cast<size_t>(Role::Count)];
+
+bool applyAffinity(Cluster cluster, Result& result) {
+    if (cluster == Cluster::Any) {
+        return false;
+    }
+    const std::vector<int>& cpus =
+        cluster == Cluster::Performance ? topology().performance : topology().efficiency;
+    if (cpus.empty()) {
+        return false;
+    }
+
+    // Stay inside the cpuset the framework gave us; a background app's set may
+    // not include the big cores at all.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return false;
+    }
+
+    cpu_set_t wanted;
+    CPU_ZERO(&wanted);
+    int first = -1;
+    int last = -1;
+    for (int cpu : cpus) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            CPU_SET(cpu, &wanted);
+            if (first < 0) first = cpu;
+            last = cpu;
+        }
+    }
+    if (first < 0) {
+        return false;
+    }
+
+    if (sched_setaffinity(0, sizeof(wanted), &wanted) != 0) {
+        LOGW("sched_setaffinity failed: %s", strerror(errno));
+        return false;
+    }
+    result.firstCpu = first;
+    result.lastCpu = last;
+    return true;
+}
+
+}  // namespace
+
+Result configureCurrentThread(Role role) {
+    const size_t index = static_cast<size_t>(role);
+    if (index >= static_cast<size_t>(Role::Count)) {
+        return Result();
+    }
+    const RolePolicy& policy = kPolicies[index];
+
+    Result result;
+    result.configured = true;
+
+    if (policy.fifoPriority > 0) {
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = policy.fifoPriority;
+        // pid 0 = the calling thread on Linux.
+        if (sched_setscheduler(0, SCHED_FIFO, &param) == 0) {
+            result.realtime = true;
+            result.priority = policy.fifoPriority;
+        }
+    }
+
+    if (!result.realtime) {
+        const pid_t tid = gettid();
+        if (policy.niceValue != 0 && setpriority(PRIO_PROCESS, tid, policy.niceValue) != 0) {
+            LOGW("%s: setpriority(%d) failed: %s", policy.name, policy.niceValue, strerror(errno));
+        }
+        errno = 0;
+        const int nice = getpriority(PRIO_PROCESS, tid);
+        result.priority = errno == 0 ? nice : 0;
+    }
+
+    result.pinned = applyAffinity(policy.cluster, result);
+
+    if (result.pinned) {
+        LOGI("%s thread: %s %d, cpus %d-%d", policy.name, result.realtime ? "SCHED_FIFO" : "nice",
+             result.priority, result.firstCpu, result.lastCpu);
+    } else {
+        LOGI("%s thread: %s %d, unpinned", policy.name, result.realtime ? "SCHED_FIFO" : "nice",
+             result.priority);
+    }
+
+    std::lock_guard<std::mutex> lock(g_resultsMutex);
+    g_results[index] = result;
+    return result;
+}
+
+Result lastResult(Role role) {
+    const size_t index = static_cast<size_t>(role);
+    if (index >= static_cast<size_t>(Role::Count)) {
+        return Result();
+    }
+    std::lock_guard<std::mutex> lock(g_resultsMutex);
+    return g_results[index];
+}
+
+std::string describeGrantedPolicies() {
+    std::string description;
+    for (size_t index = 0; index < static_cast<size_t>(Role::Count); ++index) {
+        const Result result = lastResult(static_cast<Role>(index));
+        if (!result.configured) {
+            continue;
+        }
+        char line[96];
+        if (result.pinned) {
+            snprintf(line, sizeof(line), "%s: %s %d, cpus %d-%d\n", kPolicies[index].name,
+                     result.realtime ? "SCHED_FIFO" : "nice", result.priority, result.firstCpu, result.lastCpu);
+        } else {
+            snprintf(line, sizeof(line), "%s: %s %d, unpinned\n", kPolicies[index].name,
+                     result.realtime ? "SCHED_FIFO" : "nice", result.priority);
+        }
+        description += line;
+    }
+    return description;
+}
+
+}  // namespace thread_config
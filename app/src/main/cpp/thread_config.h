@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Scheduling and CPU placement for the native worker threads. Each thread
+ * calls configureCurrentThread() once when it starts; the layer asks for
+ * SCHED_FIFO where the role warrants it, falls back to a raised nice value
+ * when the kernel refuses, and pins the thread to the big or little cluster
+ * when the SoC has more than one. What was actually granted is logged and
+ * kept per role for describeGrantedPolicies().
+ */
+namespace thread_config {
+
+enum class Role {
+    UsbReader,    // isochronous transfer reaping, FIFO + performance cores
+    Convolver,    // realtime monitor/playback convolution and its worker pool, FIFO + performance cores
+    DiskWriter,   // ring drain and WAV writes, mildly raised nice + efficiency cores
+    Background,   // housekeeping helpers, default priority + efficiency cores
+    Count
+};
+
+struct Result {
+    bool configured = false;
+    bool realtime = false;      // SCHED_FIFO granted
+    int priority = 0;           // FIFO priority when realtime, nice value otherwise
+    bool pinned = false;        // affinity applied
+    int firstCpu = -1;          // CPU range the thread was pinned to
+    int lastCpu = -1;
+};
+
+/** Apply the policy for @p role to the calling thread and record the outcome. */
+Result configureCurrentThread(Role role);
+
+/** Outcome of the last configureCurrentThread() call for @p role. */
+Result lastResult(Role role);
+
+/**
+ * One line per configured role, e.g. "usb: SCHED_FIFO 2, cpus 4-7". The
+ * convolver line also covers the WorkerPool helper threads.
+ */
+std::string describeGrantedPolicies();
+
+}  // namespace thread_config
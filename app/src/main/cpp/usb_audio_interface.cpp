@@ -1,7 +1,9 @@
 #include "usb_audio_interface.h"
+#include "recording_stats.h"
 #include <android/log.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <linux/usbdevice_fs.h>
 #include <cstring>
 #include <cmath>
@@ -191,6 +193,7 @@ USBAudioInterface::USBAudioInterface()
     , m_controlEndpoint(0x00)
     , m_nextSubmitIndex(0)
     , m_totalSubmitted(0)
+    , m_queuePrimed(false)
     , m_callCount(0)
     , m_attemptCount(0)
     , m_submitErrorCount(0)
@@ -208,8 +211,23 @@ USBAudioInterface::USBAudioInterface()
     , m_wasStreaming(false)
     , m_notStreamingCount(0)
     , m_noFramesCount(0)
-    , m_pendingData()
-    , m_pendingReadOffset(0)
+    , m_carryFrame()
+    , m_carryBytes(0)
+    , m_numUrbs(DEFAULT_URBS)
+    , m_allocatedUrbs(0)
+    , m_urbsInFlight(0)
+    , m_parkedUrbs()
+    , m_minPacketsPerUrb(0)
+    , m_maxPacketsPerUrb(0)
+    , m_learnedPacketsPerUrb(0)
+    , m_lastReapTime()
+    , m_windowStart()
+    , m_haveLastReap(false)
+    , m_windowMaxGapUs(0)
+    , m_windowReaps(0)
+    , m_windowTroubleEvents(0)
+    , m_cleanWindows(0)
+    , m_recordingStats(nullptr)
     , m_currentFrameNumber(0)
     , m_frameNumberInitialized(false)
     , m_streamInterfaceNumber(-1)
@@ -237,6 +255,7 @@ USBAudioInterface::USBAudioInterface()
     , m_supportsContinuousSampleRate(false)
     , m_minContinuousSampleRate(0)
     , m_maxContinuousSampleRate(0) {
+    resetUrbStats();
 }
 
 USBAudioInterface::~USBAudioInterface() {
@@ -733,6 +752,9 @@ bool USBAudioInterface::parseStreamingEndpoint(const std::vector<uint8_t>& descr
     m_endpointInfoReady = false;
     m_isHighSpeed = false;
     m_isSuperSpeed = false;
+    m_numUrbs = DEFAULT_URBS;
+    m_learnedPacketsPerUrb = 0;
+    resetUrbStats();
     m_controlInterfaceNumber = -1;
     m_clockSourceId = -1;
     m_clockFrequencyProgrammable = false;
@@ -1469,7 +1491,7 @@ void USBAudioInterface::releaseUrbResources() {
     if (m_urbs) {
         if (m_deviceFd >= 0) {
             // Request cancellation for every URB that might still be owned by the kernel.
-            for (int i = 0; i < NUM_URBS; ++i) {
+            for (int i = 0; i < MAX_URBS; ++i) {
                 if (!m_urbs[i]) {
                     continue;
                 }
@@ -1488,7 +1510,7 @@ void USBAudioInterface::releaseUrbResources() {
             }
         }
 
-        for (int i = 0; i < NUM_URBS; ++i) {
+        for (int i = 0; i < MAX_URBS; ++i) {
             if (m_urbs[i]) {
                 free(m_urbs[i]);
                 m_urbs[i] = nullptr;
@@ -1499,7 +1521,7 @@ void USBAudioInterface::releaseUrbResources() {
     }
 
     if (m_urbBuffers) {
-        for (int i = 0; i < NUM_URBS; ++i) {
+        for (int i = 0; i < MAX_URBS; ++i) {
             if (m_urbBuffers[i]) {
                 free(m_urbBuffers[i]);
                 m_urbBuffers[i] = nullptr;
@@ -1510,9 +1532,13 @@ void USBAudioInterface::releaseUrbResources() {
     }
 
     m_urbsInitialized = false;
+    m_allocatedUrbs = 0;
+    m_urbsInFlight = 0;
+    m_parkedUrbs.clear();
     m_packetsPerUrb = 0;
     m_urbBufferSize = 0;
     m_totalSubmitted = 0;
+    m_queuePrimed = false;
     m_nextSubmitIndex = 0;
 }
 
@@ -1534,21 +1560,24 @@ bool USBAudioInterface::ensureUrbResources() {
     size_t packetsPerService = std::max<size_t>(1, m_packetsPerServiceInterval);
     size_t targetPackets = packetsPerService * 8; // Aim for ~8 service intervals per URB
     size_t maxPackets = std::max<size_t>(1, MAX_URB_BUFFER_BYTES / m_isoPacketSize);
-    m_packetsPerUrb = std::max<size_t>(1, std::min(targetPackets, maxPackets));
-    m_urbBufferSize = m_isoPacketSize * m_packetsPerUrb;
 
-    size_t urbStructSize = sizeof(struct usbdevfs_urb);
-    if (m_packetsPerUrb > 1) {
-        urbStructSize += (m_packetsPerUrb - 1) * sizeof(struct usbdevfs_iso_packet_desc);
-    }
-
-    m_urbs = static_cast<struct usbdevfs_urb**>(calloc(NUM_URBS, sizeof(struct usbdevfs_urb*)));
+    // The scheduler may move packets per URB between a quarter and twice the
+    // derived geometry; every URB is allocated for the upper bound so the
+    // count can change on resubmission without reallocating.
+    m_maxPacketsPerUrb = std::max<size_t>(1, std::min(targetPackets * 2, maxPackets));
+    m_minPacketsPerUrb = std::max<size_t>(1, std::min(packetsPerService * 2, m_maxPacketsPerUrb));
+    const size_t initialPackets = m_learnedPacketsPerUrb > 0 ? m_learnedPacketsPerUrb : targetPackets;
+    m_packetsPerUrb = std::max(m_minPacketsPerUrb, std::min(initialPackets, m_maxPacketsPerUrb));
+    m_urbBufferSize = m_isoPacketSize * m_maxPacketsPerUrb;
+    m_numUrbs = std::max(MIN_URBS, std::min(m_numUrbs, MAX_URBS));
+
+    m_urbs = static_cast<struct usbdevfs_urb**>(calloc(MAX_URBS, sizeof(struct usbdevfs_urb*)));
     if (!m_urbs) {
         LOGE("Failed to allocate URB pointer array");
         return false;
     }
 
-    m_urbBuffers = static_cast<uint8_t**>(calloc(NUM_URBS, sizeof(uint8_t*)));
+    m_urbBuffers = static_cast<uint8_t**>(calloc(MAX_URBS, sizeof(uint8_t*)));
     if (!m_urbBuffers) {
         LOGE("Failed to allocate URB buffer pointer array");
         free(m_urbs);
@@ -1556,52 +1585,33 @@ bool USBAudioInterface::ensureUrbResources() {
         return false;
     }
 
-    for (int i = 0; i < NUM_URBS; ++i) {
-        void* bufferPtr = nullptr;
-        if (posix_memalign(&bufferPtr, 64, m_urbBufferSize) != 0) {
-            bufferPtr = malloc(m_urbBufferSize);
-        }
-        if (!bufferPtr) {
-            LOGE("Failed to allocate URB buffer %d (%zu bytes)", i, m_urbBufferSize);
-            releaseUrbResources();
-            return false;
-        }
-        memset(bufferPtr, 0, m_urbBufferSize);
-        m_urbBuffers[i] = static_cast<uint8_t*>(bufferPtr);
-
-        m_urbs[i] = static_cast<struct usbdevfs_urb*>(calloc(1, urbStructSize));
-        if (!m_urbs[i]) {
-            LOGE("Failed to allocate URB structure %d", i);
+    m_parkedUrbs.clear();
+    m_parkedUrbs.reserve(MAX_URBS);
+    m_allocatedUrbs = 0;
+    m_urbsInFlight = 0;
+    for (int i = 0; i < m_numUrbs; ++i) {
+        if (!allocateUrb(i)) {
             releaseUrbResources();
             return false;
         }
-
-        m_urbs[i]->type = USBDEVFS_URB_TYPE_ISO;
-        m_urbs[i]->endpoint = m_audioInEndpoint;
-        m_urbs[i]->status = 0;
-        m_urbs[i]->flags = USBDEVFS_URB_ISO_ASAP;
-        m_urbs[i]->buffer = m_urbBuffers[i];
-        m_urbs[i]->buffer_length = m_urbBufferSize;
-        m_urbs[i]->actual_length = 0;
-        m_urbs[i]->start_frame = 0;
-        m_urbs[i]->number_of_packets = static_cast<unsigned>(m_packetsPerUrb);
-        m_urbs[i]->error_count = 0;
-        m_urbs[i]->signr = 0;
-        m_urbs[i]->usercontext = reinterpret_cast<void*>(static_cast<intptr_t>(i));
-
-        for (size_t pkt = 0; pkt < m_packetsPerUrb; ++pkt) {
-            m_urbs[i]->iso_frame_desc[pkt].length = static_cast<unsigned int>(m_isoPacketSize);
-            m_urbs[i]->iso_frame_desc[pkt].actual_length = 0;
-            m_urbs[i]->iso_frame_desc[pkt].status = 0;
-        }
     }
 
+    m_haveLastReap = false;
+    m_windowStart = std::chrono::steady_clock::now();
+    m_windowMaxGapUs = 0;
+    m_windowReaps = 0;
+    m_windowTroubleEvents = 0;
+    m_cleanWindows = 0;
+    setUrbStat(UrbStat::QueueDepth, m_numUrbs);
+    setUrbStat(UrbStat::PacketsPerUrb, static_cast<int64_t>(m_packetsPerUrb));
+
     m_urbsInitialized = true;
     m_totalSubmitted = 0;
+    m_queuePrimed = false;
     m_nextSubmitIndex = 0;
 
-    LOGI("Initialized %d isochronous URBs: packetsPerUrb=%zu, bufferSize=%zu bytes, isoPacket=%zu", 
-         NUM_URBS, m_packetsPerUrb, m_urbBufferSize, m_isoPacketSize);
+    LOGI("Initialized %d isochronous URBs: packetsPerUrb=%zu (bounds %zu-%zu), bufferSize=%zu bytes, isoPacket=%zu", 
+         m_numUrbs, m_packetsPerUrb, m_minPacketsPerUrb, m_maxPacketsPerUrb, m_urbBufferSize, m_isoPacketSize);
 
     // Clear endpoint halt condition before starting streaming
     // This is critical - Linux USB audio driver does this to clear stale errors
@@ -1616,6 +1626,207 @@ bool USBAudioInterface::ensureUrbResources() {
     return true;
 }
 
+bool USBAudioInterface::allocateUrb(int index) {
+    if (index < 0 || index >= MAX_URBS || !m_urbs || !m_urbBuffers) {
+        return false;
+    }
+
+    void* bufferPtr = nullptr;
+    if (posix_memalign(&bufferPtr, 64, m_urbBufferSize) != 0) {
+        bufferPtr = malloc(m_urbBufferSize);
+    }
+    if (!bufferPtr) {
+        LOGE("Failed to allocate URB buffer %d (%zu bytes)", index, m_urbBufferSize);
+        return false;
+    }
+    memset(bufferPtr, 0, m_urbBufferSize);
+
+    size_t urbStructSize = sizeof(struct usbdevfs_urb);
+    if (m_maxPacketsPerUrb > 1) {
+        urbStructSize += (m_maxPacketsPerUrb - 1) * sizeof(struct usbdevfs_iso_packet_desc);
+    }
+    struct usbdevfs_urb* urb = static_cast<struct usbdevfs_urb*>(calloc(1, urbStructSize));
+    if (!urb) {
+        LOGE("Failed to allocate URB structure %d", index);
+        free(bufferPtr);
+        return false;
+    }
+
+    urb->type = USBDEVFS_URB_TYPE_ISO;
+    urb->endpoint = m_audioInEndpoint;
+    urb->status = 0;
+    urb->flags = USBDEVFS_URB_ISO_ASAP;
+    urb->buffer = bufferPtr;
+    urb->buffer_length = static_cast<int>(m_isoPacketSize * m_packetsPerUrb);
+    urb->actual_length = 0;
+    urb->start_frame = 0;
+    urb->number_of_packets = static_cast<unsigned>(m_packetsPerUrb);
+    urb->error_count = 0;
+    urb->signr = 0;
+    urb->usercontext = reinterpret_cast<void*>(static_cast<intptr_t>(index));
+
+    for (size_t pkt = 0; pkt < m_maxPacketsPerUrb; ++pkt) {
+        urb->iso_frame_desc[pkt].length = static_cast<unsigned int>(m_isoPacketSize);
+        urb->iso_frame_desc[pkt].actual_length = 0;
+        urb->iso_frame_desc[pkt].status = 0;
+    }
+
+    m_urbBuffers[index] = static_cast<uint8_t*>(bufferPtr);
+    m_urbs[index] = urb;
+    m_allocatedUrbs = std::max(m_allocatedUrbs, index + 1);
+    return true;
+}
+
+bool USBAudioInterface::submitUrb(struct usbdevfs_urb* urb) {
+    // Resubmissions pick up the current packets-per-URB setting.
+    for (size_t pkt = 0; pkt < m_packetsPerUrb; ++pkt) {
+        urb->iso_frame_desc[pkt].actual_length = 0;
+        urb->iso_frame_desc[pkt].status = 0;
+    }
+    urb->buffer_length = static_cast<int>(m_isoPacketSize * m_packetsPerUrb);
+    urb->number_of_packets = static_cast<unsigned>(m_packetsPerUrb);
+
+    if (ioctl(m_deviceFd, USBDEVFS_SUBMITURB, urb) < 0) {
+        return false;
+    }
+    m_urbsInFlight++;
+    return true;
+}
+
+void USBAudioInterface::growUrbQueue(int targetDepth) {
+    targetDepth = std::min(targetDepth, MAX_URBS);
+    while (m_urbsInFlight < targetDepth) {
+        int index;
+        if (!m_parkedUrbs.empty()) {
+            index = m_parkedUrbs.back();
+            m_parkedUrbs.pop_back();
+        } else if (m_allocatedUrbs < MAX_URBS && allocateUrb(m_allocatedUrbs)) {
+            index = m_allocatedUrbs - 1;
+        } else {
+            break;
+        }
+
+        if (!submitUrb(m_urbs[index])) {
+            LOGE("Failed to submit added URB[%d]: %s (errno %d)", index, strerror(errno), errno);
+            m_parkedUrbs.push_back(index);
+            break;
+        }
+    }
+}
+
+double USBAudioInterface::urbDurationUs(size_t packets) const {
+    // One iso packet per service interval; (micro)frames are 125 us on
+    // high/super speed and 1 ms on full speed.
+    const double intervalUs = ((m_isHighSpeed || m_isSuperSpeed) ? 125.0 : 1000.0)
+                              * static_cast<double>(std::max<size_t>(1, m_packetsPerServiceInterval));
+    return intervalUs * static_cast<double>(packets);
+}
+
+void USBAudioInterface::updateUrbScheduler(int errorPackets, int emptyPackets, int shortPackets) {
+    const auto now = std::chrono::steady_clock::now();
+    const double urbUs = urbDurationUs(m_packetsPerUrb);
+    const double queuedUs = urbUs * static_cast<double>(m_numUrbs);
+
+    addUrbStat(UrbStat::Reaps, 1);
+    if (errorPackets > 0) {
+        addUrbStat(UrbStat::PacketErrors, errorPackets);
+    }
+    if (emptyPackets > 0) {
+        addUrbStat(UrbStat::EmptyPackets, emptyPackets);
+    }
+    if (shortPackets > 0) {
+        addUrbStat(UrbStat::ShortPackets, shortPackets);
+    }
+    m_windowTroubleEvents += errorPackets + emptyPackets;
+
+    if (m_haveLastReap) {
+        const int64_t gapUs = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastReapTime).count();
+        m_windowMaxGapUs = std::max(m_windowMaxGapUs, gapUs);
+        if (m_recordingStats) {
+            m_recordingStats->histogram(RecordingStats::ReapInterval).record(gapUs);
+        }
+        if (gapUs > static_cast<int64_t>(m_urbStats[static_cast<size_t>(UrbStat::MaxReapGapUs)].load(std::memory_order_relaxed))) {
+            setUrbStat(UrbStat::MaxReapGapUs, gapUs);
+        }
+        // Reaping this late means the kernel was within half a queue of running dry.
+        if (static_cast<double>(gapUs) > queuedUs * 0.5) {
+            addUrbStat(UrbStat::LateReaps, 1);
+            m_windowTroubleEvents++;
+        }
+    }
+    m_lastReapTime = now;
+    m_haveLastReap = true;
+    m_windowReaps++;
+
+    const int64_t windowUs = std::chrono::duration_cast<std::chrono::microseconds>(now - m_windowStart).count();
+    if (windowUs < SCHEDULER_WINDOW_US) {
+        return;
+    }
+
+    const double maxGapUs = static_cast<double>(m_windowMaxGapUs);
+    const size_t packetStep = std::max<size_t>(1, m_packetsPerServiceInterval);
+    if (m_windowTroubleEvents > 0) {
+        // Lost or late data: deepen the queue, and if the thread wakes up
+        // late relative to one URB, use fewer, larger URBs.
+        m_cleanWindows = 0;
+        if (m_numUrbs < MAX_URBS) {
+            m_numUrbs = std::min(MAX_URBS, m_numUrbs + std::max(4, m_numUrbs / 4));
+            addUrbStat(UrbStat::DepthIncreases, 1);
+        }
+        if (maxGapUs > urbUs * 2.0 && m_packetsPerUrb < m_maxPacketsPerUrb) {
+            m_packetsPerUrb = std::min(m_maxPacketsPerUrb, m_packetsPerUrb + packetStep);
+            addUrbStat(UrbStat::PacketIncreases, 1);
+        }
+        LOGI("URB scheduler: %d trouble events in window (maxGap=%lld us) -> depth=%d, packetsPerUrb=%zu",
+             m_windowTroubleEvents, static_cast<long long>(m_windowMaxGapUs), m_numUrbs, m_packetsPerUrb);
+        growUrbQueue(m_numUrbs);
+    } else if (++m_cleanWindows >= SHRINK_AFTER_CLEAN_WINDOWS) {
+        // Sustained clean streaming: give back latency a step at a time.
+        m_cleanWindows = 0;
+        bool changed = false;
+        if (maxGapUs < queuedUs / 8.0 && m_numUrbs > MIN_URBS) {
+            m_numUrbs = std::max(MIN_URBS, m_numUrbs - std::max(1, m_numUrbs / 8));
+            addUrbStat(UrbStat::DepthDecreases, 1);
+            changed = true;
+        }
+        if (maxGapUs < urbUs && m_packetsPerUrb > m_minPacketsPerUrb) {
+            m_packetsPerUrb = std::max(m_minPacketsPerUrb, m_packetsPerUrb - std::min(packetStep, m_packetsPerUrb));
+            addUrbStat(UrbStat::PacketDecreases, 1);
+            changed = true;
+        }
+        if (changed) {
+            LOGI("URB scheduler: clean for %d windows (maxGap=%lld us) -> depth=%d, packetsPerUrb=%zu",
+                 SHRINK_AFTER_CLEAN_WINDOWS, static_cast<long long>(m_windowMaxGapUs), m_numUrbs, m_packetsPerUrb);
+        }
+    }
+
+    m_learnedPacketsPerUrb = m_packetsPerUrb;
+    setUrbStat(UrbStat::QueueDepth, m_numUrbs);
+    setUrbStat(UrbStat::PacketsPerUrb, static_cast<int64_t>(m_packetsPerUrb));
+    setUrbStat(UrbStat::WindowMaxGapUs, m_windowMaxGapUs);
+    m_windowStart = now;
+    m_windowMaxGapUs = 0;
+    m_windowReaps = 0;
+    m_windowTroubleEvents = 0;
+}
+
+void USBAudioInterface::resetUrbStats() {
+    for (auto& stat : m_urbStats) {
+        stat.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t USBAudioInterface::getUrbStats(int64_t* out, size_t count) const {
+    if (!out) {
+        return 0;
+    }
+    const size_t copied = std::min(count, kUrbStatCount);
+    for (size_t i = 0; i < copied; ++i) {
+        out[i] = m_urbStats[i].load(std::memory_order_relaxed);
+    }
+    return copied;
+}
+
 void USBAudioInterface::resetStreamingState() {
     m_wasStreaming = false;
     m_lastReapedUrbAddress = nullptr;
@@ -1631,9 +1842,10 @@ void USBAudioInterface::resetStreamingState() {
     m_reapAttemptCount = 0;
     m_notStreamingCount = 0;
     m_noFramesCount = 0;
-    m_pendingData.clear();
-    m_pendingReadOffset = 0;
+    m_carryFrame.assign(static_cast<size_t>(std::max(0, m_channelCount * m_bytesPerSample)), 0);
+    m_carryBytes = 0;
     m_totalSubmitted = 0;
+    m_queuePrimed = false;
     m_nextSubmitIndex = 0;
     m_currentFrameNumber = 0;
     m_frameNumberInitialized = false;
@@ -1664,7 +1876,7 @@ bool USBAudioInterface::flushIsochronousEndpoint() {
     // Best-effort cancel of any URBs that might still be owned by the kernel for this fd.
     if (m_urbs && m_urbsInitialized) {
         int cancelled = 0;
-        for (int i = 0; i < NUM_URBS; ++i) {
+        for (int i = 0; i < m_allocatedUrbs; ++i) {
             if (!m_urbs[i]) {
                 continue;
             }
@@ -1756,7 +1968,7 @@ bool USBAudioInterface::stopStreaming() {
         // Cancel any pending URBs before disabling the interface
         if (m_urbs && m_deviceFd >= 0) {
             int cancelledCount = 0;
-            for (int i = 0; i < NUM_URBS; i++) {
+            for (int i = 0; i < m_allocatedUrbs; i++) {
                 if (m_urbs[i]) {
                     int result = ioctl(m_deviceFd, USBDEVFS_DISCARDURB, m_urbs[i]);
                     if (result == 0) {
@@ -1859,7 +2071,7 @@ bool USBAudioInterface::enableAudioStreaming() {
     return true;
 }
 
-size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
+size_t USBAudioInterface::readAudioData(const FrameSink& sink, size_t maxBytes) {
     if (!m_isStreaming || m_deviceFd < 0) {
         if (++m_notStreamingCount <= 5) {
             LOGE("readAudioData returning 0: isStreaming=%d, fd=%d", m_isStreaming, m_deviceFd);
@@ -1869,13 +2081,13 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
     
     // Calculate expected frame size for 84 channels at 24-bit
     const size_t frameSize = m_channelCount * m_bytesPerSample; // 84 * 3 = 252 bytes
-    const size_t maxFrames = bufferSize / frameSize;
+    const size_t maxFrames = maxBytes / frameSize;
     
-    if (maxFrames == 0) {
+    if (maxFrames == 0 || !sink) {
         static int noFramesCount = 0;
         if (++noFramesCount <= 5) {
-            LOGE("readAudioData returning 0: maxFrames=0, bufferSize=%zu, frameSize=%zu", 
-                 bufferSize, frameSize);
+            LOGE("readAudioData returning 0: maxFrames=0, maxBytes=%zu, frameSize=%zu", 
+                 maxBytes, frameSize);
         }
         return 0;
     }
@@ -1903,120 +2115,86 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
 
     // Log first few calls with state information
     if (m_callCount <= 5 || m_callCount % 1000 == 0) {
-        LOGI("readAudioData called (count=%d): bufferSize=%zu, isStreaming=%d, m_wasStreaming=%d, urbsInit=%d, totalSub=%d, fd=%d", 
-             m_callCount, bufferSize, m_isStreaming, m_wasStreaming, m_urbsInitialized, m_totalSubmitted, m_deviceFd);
+        LOGI("readAudioData called (count=%d): maxBytes=%zu, isStreaming=%d, m_wasStreaming=%d, urbsInit=%d, totalSub=%d, fd=%d", 
+             m_callCount, maxBytes, m_isStreaming, m_wasStreaming, m_urbsInitialized, m_totalSubmitted, m_deviceFd);
     }
     
     if (!m_urbsInitialized && !ensureUrbResources()) {
         return 0;
     }
     
-    // First, submit initial m_urbs if we haven't submitted all of them yet
-    // This ensures we prime the queue before trying to reap
-    if (m_totalSubmitted < NUM_URBS) {
-        // Prime the queue by submitting all m_urbs initially
+    // Prime the queue with every URB in one batch before trying to reap, so
+    // streaming starts with the full queue depth instead of one URB per call.
+    if (!m_queuePrimed) {
         m_attemptCount++;
+        const int alreadySubmitted = m_totalSubmitted;
+
+        while (m_totalSubmitted < m_numUrbs) {
+            if (!submitUrb(m_urbs[m_nextSubmitIndex])) {
+                m_submitErrorCount++;
+                if (m_submitErrorCount <= 20 || m_submitErrorCount % 100 == 0) {
+                    LOGE("Failed to submit URB[%d] (attempt %d, %d/%d queued): %s (errno %d)",
+                         m_nextSubmitIndex, m_submitErrorCount, m_totalSubmitted, m_numUrbs,
+                         strerror(errno), errno);
+                }
+                return 0;  // Keep what was queued and submit the rest on the next call
+            }
 
-        if (m_attemptCount <= 20 || m_attemptCount % 100 == 0) {
-            LOGI("Attempting to submit URB[%d] (attempt=%d, totalSub=%d/%d)",
-                 m_nextSubmitIndex, m_attemptCount, m_totalSubmitted, NUM_URBS);
+            m_totalSubmitted++;
+            m_nextSubmitIndex = (m_nextSubmitIndex + 1) % m_numUrbs;
         }
 
-        int result = ioctl(m_deviceFd, USBDEVFS_SUBMITURB, m_urbs[m_nextSubmitIndex]);
-        if (result >= 0) {
-            m_totalSubmitted++;
-            if (m_totalSubmitted <= NUM_URBS) {
-                LOGI("Submitted initial URB[%d] (%d/%d, %zu packets)",
-                     m_nextSubmitIndex, m_totalSubmitted, NUM_URBS, m_packetsPerUrb);
-            }
+        m_queuePrimed = true;
+        LOGI("Primed URB queue: submitted %d URBs in batch (attempt=%d, %d/%d, %zu packets each)",
+             m_totalSubmitted - alreadySubmitted, m_attemptCount, m_totalSubmitted, m_numUrbs, m_packetsPerUrb);
+    }
 
-            m_nextSubmitIndex = (m_nextSubmitIndex + 1) % NUM_URBS;
+    size_t total_bytes_accumulated = 0;
 
-            // If we haven't submitted all m_urbs yet, return and submit more on next call
-            if (m_totalSubmitted < NUM_URBS) {
-                return 0;
+    // Only hand off complete 84-channel frames; a frame split across packets is
+    // completed in the carry buffer so no partial frame ever reaches the sink.
+    auto deliverPacket = [&](uint8_t* data, size_t length) {
+        if (m_carryBytes > 0) {
+            const size_t fill = std::min(length, frameSize - m_carryBytes);
+            memcpy(m_carryFrame.data() + m_carryBytes, data, fill);
+            m_carryBytes += fill;
+            data += fill;
+            length -= fill;
+            if (m_carryBytes < frameSize) {
+                return;
             }
-        } else {
-            m_submitErrorCount++;
-            if (m_submitErrorCount <= 20 || m_submitErrorCount % 100 == 0) {
-                LOGE("Failed to submit URB[%d] (attempt %d): %s (errno %d)",
-                     m_nextSubmitIndex, m_submitErrorCount, strerror(errno), errno);
+            sink(m_carryFrame.data(), frameSize);
+            total_bytes_accumulated += frameSize;
+            m_carryBytes = 0;
+            if (m_recordingStats) {
+                m_recordingStats->add(RecordingStats::CarriedFrames, 1);
             }
-            return 0;  // Return and try again on next call
-        }
-    }
-
-    // Only hand off complete 84-channel frames; leaving partial frames staged avoids audible artifacts.
-    auto drainPendingData = [&](uint8_t* dest, size_t capacity) -> size_t {
-        if (frameSize == 0 || capacity < frameSize || m_pendingData.empty()) {
-            return 0;
-        }
-
-        const size_t available = m_pendingData.size() - m_pendingReadOffset;
-        if (available < frameSize) {
-            return 0;
-        }
-
-        const size_t maxFramesByCapacity = capacity / frameSize;
-        if (maxFramesByCapacity == 0) {
-            return 0;
-        }
-
-        const size_t availableFrames = available / frameSize;
-        const size_t framesToCopy = std::min(maxFramesByCapacity, availableFrames);
-        if (framesToCopy == 0) {
-            return 0;
-        }
-
-        const size_t bytesToCopy = framesToCopy * frameSize;
-        memcpy(dest, m_pendingData.data() + m_pendingReadOffset, bytesToCopy);
-        m_pendingReadOffset += bytesToCopy;
-        if (m_pendingReadOffset >= m_pendingData.size()) {
-            m_pendingData.clear();
-            m_pendingReadOffset = 0;
         }
-        return bytesToCopy;
-    };
 
-    auto appendPendingData = [&](const uint8_t* src, size_t length) {
-        if (length == 0) {
-            return;
+        const size_t wholeBytes = length - (length % frameSize);
+        if (wholeBytes > 0) {
+            sink(data, wholeBytes);
+            total_bytes_accumulated += wholeBytes;
         }
 
-        if (!m_pendingData.empty() && m_pendingReadOffset > 0) {
-            if (m_pendingReadOffset >= m_pendingData.size()) {
-                m_pendingData.clear();
-            } else {
-                const size_t unread = m_pendingData.size() - m_pendingReadOffset;
-                memmove(m_pendingData.data(),
-                        m_pendingData.data() + m_pendingReadOffset,
-                        unread);
-                m_pendingData.resize(unread);
+        const size_t residue = length - wholeBytes;
+        if (residue > 0) {
+            memcpy(m_carryFrame.data(), data + wholeBytes, residue);
+            m_carryBytes = residue;
+            if (m_recordingStats) {
+                m_recordingStats->add(RecordingStats::CarriedBytes, static_cast<int64_t>(residue));
             }
-            m_pendingReadOffset = 0;
-        }
-
-        const size_t currentSize = m_pendingData.size();
-        m_pendingData.resize(currentSize + length);
-        memcpy(m_pendingData.data() + currentSize, src, length);
-
-        if (m_pendingData.size() > MAX_PENDING_BUFFER_BYTES) {
-            LOGE("Pending staging buffer exceeded %zu bytes (current=%zu). Downstream consumer is not keeping up.",
-                 static_cast<size_t>(MAX_PENDING_BUFFER_BYTES), m_pendingData.size());
         }
     };
 
-    size_t total_bytes_accumulated = drainPendingData(buffer, bufferSize);
-    if (total_bytes_accumulated >= bufferSize) {
-        return total_bytes_accumulated;
-    }
-
     int urbs_reaped_this_call = 0;
     const int MAX_REAPS_PER_CALL = 32; // Safety limit
     bool resetTriggered = false;
 
     auto handleCompletedUrb = [&](struct usbdevfs_urb* completed_urb, int loopIndex) {
         int urb_index = static_cast<int>(reinterpret_cast<intptr_t>(completed_urb->usercontext));
+        const size_t urbPackets = std::min<size_t>(completed_urb->number_of_packets, m_maxPacketsPerUrb);
+        m_urbsInFlight--;
         urbs_reaped_this_call++;
         m_reapCount++;
 
@@ -2040,7 +2218,7 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
                      m_lastReapedUrbAddress, m_consecutiveSameUrbCount);
 
                 // Cancel all URBs to break the stuck pattern
-                for (int i = 0; i < NUM_URBS; i++) {
+                for (int i = 0; i < m_allocatedUrbs; i++) {
                     if (m_urbs[i]) {
                         ioctl(m_deviceFd, USBDEVFS_DISCARDURB, m_urbs[i]);
                     }
@@ -2061,8 +2239,16 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
         // Collect data from all packets in this URB and check for errors
         size_t total_actual = 0;
         int error_count = 0;
-        for (size_t pkt = 0; pkt < m_packetsPerUrb; ++pkt) {
-            total_actual += completed_urb->iso_frame_desc[pkt].actual_length;
+        int empty_count = 0;
+        int short_count = 0;
+        for (size_t pkt = 0; pkt < urbPackets; ++pkt) {
+            const unsigned int actual = completed_urb->iso_frame_desc[pkt].actual_length;
+            total_actual += actual;
+            if (actual == 0) {
+                empty_count++;
+            } else if (actual + frameSize < m_isoPacketSize) {
+                short_count++;
+            }
             if (completed_urb->iso_frame_desc[pkt].status != 0) {
                 error_count++;
                 if (m_reapCount <= 50 || (m_reapCount % 1000 == 0 && error_count <= 2)) {
@@ -2073,13 +2259,15 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
             }
         }
 
-        if (total_actual > 0 && total_bytes_accumulated < bufferSize) {
+        if (total_actual > 0) {
             uint8_t* urbData = static_cast<uint8_t*>(completed_urb->buffer);
             LOG_FATAL_IF(urbData == nullptr, "URB[%d] buffer is null", urb_index);
             LOG_FATAL_IF(m_urbBufferSize == 0, "URB[%d] buffer size is zero", urb_index);
+            LOG_FATAL_IF(m_carryFrame.size() != frameSize,
+                         "Carry frame is %zu bytes, expected %zu", m_carryFrame.size(), frameSize);
 
             size_t packetOffset = 0;
-            for (size_t pkt = 0; pkt < m_packetsPerUrb; ++pkt) {
+            for (size_t pkt = 0; pkt < urbPackets; ++pkt) {
                 unsigned int packetLength = completed_urb->iso_frame_desc[pkt].actual_length;
                 if (packetLength > 0) {
                     LOG_FATAL_IF(packetOffset >= m_urbBufferSize,
@@ -2093,29 +2281,9 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
                                                               static_cast<unsigned int>(m_urbBufferSize - packetOffset));
                     }
 
-                    size_t bytesToCopy = 0;
-                    if (total_bytes_accumulated < bufferSize) {
-                        const size_t remainingDest = bufferSize - total_bytes_accumulated;
-                        const size_t remainingFrames = frameSize > 0 ? (remainingDest / frameSize) : 0;
-                        const size_t copyCapacity = remainingFrames * frameSize;
-                        bytesToCopy = std::min(static_cast<size_t>(packetLength), copyCapacity);
-                        LOG_FATAL_IF(packetOffset + bytesToCopy > m_urbBufferSize,
-                                     "URB[%d] copy range exceeds source bounds (offset=%zu, copy=%zu, size=%zu)",
-                                     urb_index, packetOffset, bytesToCopy, m_urbBufferSize);
-
-                        if (bytesToCopy > 0) {
-                            memcpy(buffer + total_bytes_accumulated, urbData + packetOffset, bytesToCopy);
-                            total_bytes_accumulated += bytesToCopy;
-                        }
-                    }
-
-                    const size_t spillover = static_cast<size_t>(packetLength) - bytesToCopy;
-                    if (spillover > 0) {
-                        LOG_FATAL_IF(packetOffset + bytesToCopy + spillover > m_urbBufferSize,
-                                     "URB[%d] spillover range exceeds source bounds (offset=%zu, copy=%zu, spill=%zu, size=%zu)",
-                                     urb_index, packetOffset, bytesToCopy, spillover, m_urbBufferSize);
-                        appendPendingData(urbData + packetOffset + bytesToCopy, spillover);
-                    }
+                    // The URB is resubmitted only after this, so the sink may
+                    // process the payload in place.
+                    deliverPacket(urbData + packetOffset, packetLength);
                 }
                 packetOffset += m_isoPacketSize;
             }
@@ -2128,34 +2296,33 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
             }
         }
 
-        for (size_t pkt = 0; pkt < m_packetsPerUrb; ++pkt) {
-            completed_urb->iso_frame_desc[pkt].actual_length = 0;
-            completed_urb->iso_frame_desc[pkt].status = 0;
+        // May change queue depth or packets per URB for the resubmission below.
+        updateUrbScheduler(error_count, empty_count, short_count);
+
+        if (m_urbsInFlight >= m_numUrbs) {
+            // The scheduler trimmed the queue: retire this URB until it is needed again.
+            m_parkedUrbs.push_back(urb_index);
+            return;
         }
-        completed_urb->buffer_length = m_urbBufferSize;
-        completed_urb->number_of_packets = static_cast<unsigned>(m_packetsPerUrb);
 
-        int submit_result = ioctl(m_deviceFd, USBDEVFS_SUBMITURB, completed_urb);
-        if (submit_result < 0) {
+        if (!submitUrb(completed_urb)) {
             LOGE("Failed to re-submit URB[%d]: %s (errno %d)", urb_index, strerror(errno), errno);
         } else if (m_reapCount <= 20) {
             LOGI("Re-submitted URB[%d] successfully", urb_index);
         }
     };
 
-    auto reapCompletions = [&](bool blocking) {
+    auto reapCompletions = [&]() {
         bool reapedAny = false;
-        int loops = blocking ? 1 : MAX_REAPS_PER_CALL;
-        for (int reap_loop = 0; reap_loop < loops; ++reap_loop) {
+        for (int reap_loop = 0; reap_loop < MAX_REAPS_PER_CALL; ++reap_loop) {
             struct usbdevfs_urb* completed_urb = nullptr;
-            int command = blocking ? USBDEVFS_REAPURB : USBDEVFS_REAPURBNDELAY;
-            int reap_result = ioctl(m_deviceFd, command, &completed_urb);
+            int reap_result = ioctl(m_deviceFd, USBDEVFS_REAPURBNDELAY, &completed_urb);
             int saved_errno = errno;
 
             m_reapAttemptCount++;
 
             if (reap_result < 0) {
-                if (!blocking && saved_errno == EAGAIN) {
+                if (saved_errno == EAGAIN) {
                     if (reap_loop == 0) {
                         if (++m_eagainCount <= 20 || m_eagainCount % 1000 == 0) {
                             LOGD("No URB ready (EAGAIN, count=%d), totalSub=%d", m_eagainCount, m_totalSubmitted);
@@ -2169,8 +2336,7 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
                 }
 
                 if (++m_reapErrorCount <= 20) {
-                    LOGE("URB reap error (cmd=%s, result=%d, errno=%d: %s)",
-                         blocking ? "REAPURB" : "REAPURBNDELAY",
+                    LOGE("URB reap error (cmd=REAPURBNDELAY, result=%d, errno=%d: %s)",
                          reap_result, saved_errno, strerror(saved_errno));
                 }
                 break;
@@ -2181,35 +2347,36 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
             }
 
             reapedAny = true;
-            handleCompletedUrb(completed_urb, blocking ? -1 : reap_loop);
+            handleCompletedUrb(completed_urb, reap_loop);
 
             if (resetTriggered) {
                 break;
             }
 
-            if (!blocking && total_bytes_accumulated >= bufferSize) {
+            if (total_bytes_accumulated >= maxBytes) {
                 break;
             }
         }
         return reapedAny;
     };
 
-    reapCompletions(false);
+    reapCompletions();
 
     if (resetTriggered) {
         return total_bytes_accumulated;
     }
 
+    // Nothing was ready: sleep in poll() until the kernel has a completed URB
+    // rather than spinning. The timeout lets the caller notice a stop request.
     if (total_bytes_accumulated == 0 && m_isStreaming) {
         auto waitStart = std::chrono::steady_clock::now();
-        bool reapedAfterWait = reapCompletions(true);
-        if (reapedAfterWait) {
+        if (waitForUrbCompletion(URB_WAIT_TIMEOUT_MS)) {
             auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
                 std::chrono::steady_clock::now() - waitStart);
             if (waited.count() > 0 && (m_reapCount <= 20 || m_reapCount % 1000 == 0)) {
-                LOGD("Blocking wait for URB completed in %lld us", static_cast<long long>(waited.count()));
+                LOGD("Waited %lld us for URB completion", static_cast<long long>(waited.count()));
             }
-            reapCompletions(false);
+            reapCompletions();
         }
     }
 
@@ -2222,20 +2389,37 @@ size_t USBAudioInterface::readAudioData(uint8_t* buffer, size_t bufferSize) {
              urbs_reaped_this_call, m_reapCount, total_bytes_accumulated);
     }
 
-    if (total_bytes_accumulated < bufferSize) {
-        total_bytes_accumulated += drainPendingData(buffer + total_bytes_accumulated,
-                                                   bufferSize - total_bytes_accumulated);
-    }
+    return total_bytes_accumulated;
+}
+
+bool USBAudioInterface::waitForUrbCompletion(int timeoutMs) {
+    // usbdevfs reports POLLOUT once a completed URB is waiting to be reaped.
+    struct pollfd pfd;
+    pfd.fd = m_deviceFd;
+    pfd.events = POLLOUT | POLLWRNORM;
+    pfd.revents = 0;
 
-    if (frameSize > 0) {
-        const size_t remainder = total_bytes_accumulated % frameSize;
-        if (remainder != 0) {
-            appendPendingData(buffer + (total_bytes_accumulated - remainder), remainder);
-            total_bytes_accumulated -= remainder;
+    int result;
+    do {
+        result = poll(&pfd, 1, timeoutMs);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0) {
+        if (++m_reapErrorCount <= 20) {
+            LOGE("poll() on usbdevfs failed: %s (errno %d)", strerror(errno), errno);
         }
+        return false;
     }
-
-    return total_bytes_accumulated;
+    if (result == 0) {
+        return false;  // Timed out
+    }
+    if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        if (++m_reapErrorCount <= 20) {
+            LOGE("usbdevfs poll reported revents=0x%x (device gone?)", pfd.revents);
+        }
+        return false;
+    }
+    return (pfd.revents & (POLLOUT | POLLWRNORM)) != 0;
 }
 
 bool USBAudioInterface::setTargetSampleRate(int sampleRate) {
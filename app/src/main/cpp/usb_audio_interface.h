@@ -1,10 +1,15 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 
+class RecordingStats;
+
 class USBAudioInterface {
 public:
     USBAudioInterface();
@@ -15,8 +20,19 @@ public:
     bool stopStreaming();
     void release();
     
-    // Read audio data from USB device
-    size_t readAudioData(uint8_t* buffer, size_t bufferSize);
+    /**
+     * Receives whole frames straight from a reaped URB buffer (or the carry
+     * frame). The data may be modified in place; it is only valid for the
+     * duration of the call.
+     */
+    using FrameSink = std::function<void(uint8_t* frames, size_t bytes)>;
+
+    /**
+     * Reap completed URBs and hand their payload to @p sink without staging.
+     * Stops reaping once at least @p maxBytes were delivered.
+     * @return Number of bytes delivered (always whole frames)
+     */
+    size_t readAudioData(const FrameSink& sink, size_t maxBytes);
 
     // Buffer sizing helpers
     size_t getRecommendedBufferSize() const;
@@ -35,6 +51,35 @@ public:
     int getChannelCount() const { return m_channelCount; }
     int getBytesPerSample() const { return m_bytesPerSample; }
     
+    /**
+     * URB scheduler telemetry. Gauges (queue depth, packets per URB, gaps)
+     * reflect the latest state; the rest are counts since the endpoint was
+     * configured.
+     */
+    enum class UrbStat : size_t {
+        QueueDepth,         // URBs kept in flight
+        PacketsPerUrb,
+        Reaps,
+        PacketErrors,       // iso packets completed with a non-zero status
+        EmptyPackets,       // zero-length packets (missed service intervals)
+        ShortPackets,       // packets more than one frame below the endpoint size
+        LateReaps,          // reaps that came after half the queued time elapsed
+        DepthIncreases,
+        DepthDecreases,
+        PacketIncreases,
+        PacketDecreases,
+        MaxReapGapUs,       // worst gap between consecutive reaps
+        WindowMaxGapUs,     // worst gap in the last scheduler window
+        Count
+    };
+    static constexpr size_t kUrbStatCount = static_cast<size_t>(UrbStat::Count);
+
+    /** Copy up to @p count stats in UrbStat order; returns the number copied. */
+    size_t getUrbStats(int64_t* out, size_t count) const;
+
+    /** Session stats block fed from the reap path (reap intervals, carry); may be null. */
+    void setRecordingStats(RecordingStats* stats) { m_recordingStats = stats; }
+
     // USB Audio Class specific
     bool enableAudioStreaming();
     bool setInterface(int interfaceNum, int altSetting);
@@ -70,6 +115,7 @@ private:
     // URB management counters (member variables to avoid static variable memory corruption)
     int m_nextSubmitIndex;
     int m_totalSubmitted;
+    bool m_queuePrimed;      // initial batch submitted; later depth changes go through growUrbQueue()
     int m_callCount;
     int m_attemptCount;
     int m_submitErrorCount;
@@ -85,7 +131,11 @@ private:
     bool m_stuckUrbDetected;
     static const int STUCK_URB_THRESHOLD = 50; // Consider URB stuck after 50 consecutive reaps
     static const int CHECK_INTERVAL = 100; // Check for stuck URBs every 100 reaps
-    static const int NUM_URBS = 64;  // Increased from 32 for better buffering against USB scheduling jitter
+    // URB queue depth is tuned at runtime between these bounds (see updateUrbScheduler)
+    static const int MIN_URBS = 16;
+    static const int DEFAULT_URBS = 64;  // Starting depth; was the fixed depth before runtime tuning
+    static const int MAX_URBS = 128;
+    static const int URB_WAIT_TIMEOUT_MS = 20;  // Upper bound on one poll() wait for a completion
 
     // URB management - converted from static to prevent memory corruption
     struct usbdevfs_urb** m_urbs;
@@ -94,8 +144,28 @@ private:
     bool m_wasStreaming;
     int m_notStreamingCount;
     int m_noFramesCount;
-    std::vector<uint8_t> m_pendingData;
-    size_t m_pendingReadOffset;
+    // Partial frame left at the end of a packet, completed by the next one
+    std::vector<uint8_t> m_carryFrame;  // sized to one frame, never grows
+    size_t m_carryBytes;
+
+    // Runtime URB scheduler. Slots [0, m_allocatedUrbs) hold URBs; at most
+    // m_numUrbs are in flight, the rest wait in m_parkedUrbs.
+    int m_numUrbs;
+    int m_allocatedUrbs;
+    int m_urbsInFlight;
+    std::vector<int> m_parkedUrbs;   // reserved to MAX_URBS, never reallocates
+    size_t m_minPacketsPerUrb;
+    size_t m_maxPacketsPerUrb;       // capacity every URB is allocated for
+    size_t m_learnedPacketsPerUrb;   // carried across stream restarts on the same endpoint
+    std::chrono::steady_clock::time_point m_lastReapTime;
+    std::chrono::steady_clock::time_point m_windowStart;
+    bool m_haveLastReap;
+    int64_t m_windowMaxGapUs;
+    int m_windowReaps;
+    int m_windowTroubleEvents;
+    int m_cleanWindows;
+    std::atomic<int64_t> m_urbStats[kUrbStatCount];
+    RecordingStats* m_recordingStats;
 
     // Explicit frame scheduling for isochronous transfers
     int m_currentFrameNumber;
@@ -110,11 +180,24 @@ private:
     bool parseStreamingEndpoint(const std::vector<uint8_t>& descriptor);
     void releaseUrbResources();
     bool ensureUrbResources();
+    bool allocateUrb(int index);
+    bool submitUrb(struct usbdevfs_urb* urb);
+    void growUrbQueue(int targetDepth);
+    void updateUrbScheduler(int errorPackets, int emptyPackets, int shortPackets);
+    double urbDurationUs(size_t packets) const;
+    void resetUrbStats();
+    void setUrbStat(UrbStat stat, int64_t value) {
+        m_urbStats[static_cast<size_t>(stat)].store(value, std::memory_order_relaxed);
+    }
+    void addUrbStat(UrbStat stat, int64_t delta) {
+        m_urbStats[static_cast<size_t>(stat)].fetch_add(delta, std::memory_order_relaxed);
+    }
     void updateEffectiveSampleRate();
     bool readSampleRateFromClock(uint32_t& outRate);
     bool readSampleRateFromEndpoint(uint32_t& outRate);
     bool queryCurrentSampleRate(uint32_t& outRate, const char** sourceName);
     void resetStreamingState();
+    bool waitForUrbCompletion(int timeoutMs);
     bool flushIsochronousEndpoint();
     bool resolveAndApplyClockSelection(bool validate = true);
     int resolveClockEntity(int entityId, bool validate, std::unordered_set<int>& visited);
@@ -158,5 +241,6 @@ private:
     uint32_t m_maxContinuousSampleRate;
 
     static constexpr size_t MAX_URB_BUFFER_BYTES = 128 * 1024;  // Increased from 64KB for lower overhead
-    static constexpr size_t MAX_PENDING_BUFFER_BYTES = 512 * 1024;  // Diagnostic threshold for staged packet spillover
+    static constexpr int64_t SCHEDULER_WINDOW_US = 1000000;     // Re-evaluate URB geometry once per second
+    static const int SHRINK_AFTER_CLEAN_WINDOWS = 10;           // Clean windows required before trimming latency
 };
\ No newline at end of file
@@ -1,104 +1,175 @@
 #include "wav_writer.h"
 
 #include <android/log.h>
+#include <algorithm>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #define LOG_TAG "WAVWriter"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+namespace {
+
+void putLittleEndian(uint8_t* dst, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        dst[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+} // namespace
+
 WAVWriter::WAVWriter()
-    : m_file(nullptr)
-    , m_ownedFd(-1)
+    : m_fd(-1)
+    , m_directFd(-1)
     , m_sampleRate(0)
     , m_channels(0)
     , m_bitsPerSample(0)
     , m_bytesPerSample(0)
     , m_blockAlign(0)
     , m_byteRate(0)
+    , m_sourceChannelCount(0)
+    , m_lossless(false)
     , m_dataSize(0)
+    , m_pcmBytes(0)
     , m_totalFrames(0)
+    , m_trailerBytes(0)
+    , m_factPos(0)
     , m_dataSizePos(0)
     , m_ds64ChunkPos(0)
     , m_ds64SizePos(0)
-    , m_ds64DataPos(0) {}
+    , m_ds64DataPos(0)
+    , m_dataStartPos(0)
+    , m_stage(nullptr)
+    , m_stageUsed(0)
+    , m_stageFileOffset(0)
+    , m_preallocatedEnd(0)
+    , m_writebackStart(0)
+    , m_writebackEnd(0)
+    , m_preallocate(false)
+    , m_blockPcmUsed(0) {}
 
 WAVWriter::~WAVWriter() {
     close();
 }
 
+void WAVWriter::setChannelMap(const std::vector<uint16_t>& sourceChannels, int sourceChannelCount) {
+    m_channelMap = sourceChannels;
+    m_sourceChannelCount = sourceChannels.empty() ? 0 : sourceChannelCount;
+}
+
 bool WAVWriter::open(const std::string& filename, int sampleRate, int channels, int bitsPerSample) {
-    if (m_file != nullptr) {
+    if (isOpen()) {
         LOGE("WAV file already open");
         return false;
     }
 
     LOGI("Opening WAV file: %s (%dHz, %dch, %dbit)", filename.c_str(), sampleRate, channels, bitsPerSample);
 
-    m_filename = filename;
-    m_ownedFd = -1;
-    initializeFormat(sampleRate, channels, bitsPerSample);
-
-    m_file = fopen(filename.c_str(), "w+b");
-    if (!m_file) {
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
         LOGE("Failed to open WAV file: %s (%s)", filename.c_str(), strerror(errno));
         resetState();
         return false;
     }
 
-    if (!writeHeader()) {
+    m_filename = filename;
+    initializeFormat(sampleRate, channels, bitsPerSample);
+
+    if (!openDescriptor(fd, filename)) {
         LOGE("Failed to write WAV header");
-        fclose(m_file);
-        m_file = nullptr;
+        releaseDescriptors();
         resetState();
         return false;
     }
 
-    LOGI("WAV file opened successfully");
+    LOGI("WAV file opened successfully (direct I/O %s%s)", m_directFd >= 0 ? "on" : "off",
+         m_lossless ? ", lossless" : "");
     return true;
 }
 
 bool WAVWriter::openFromFd(int fd, int sampleRate, int channels, int bitsPerSample) {
-    if (m_file != nullptr) {
+    if (isOpen()) {
         LOGE("WAV file already open");
         return false;
     }
 
-    int dupFd = dup(fd);
+    int dupFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
     if (dupFd < 0) {
         LOGE("Failed to dup file descriptor: %s", strerror(errno));
         resetState();
         return false;
     }
 
-    m_file = fdopen(dupFd, "w+b");
-    if (!m_file) {
-        LOGE("Failed to fdopen descriptor: %s", strerror(errno));
-        ::close(dupFd);
-        resetState();
-        return false;
-    }
-
-    m_ownedFd = dupFd;
     m_filename = "/proc/self/fd/" + std::to_string(dupFd);
     initializeFormat(sampleRate, channels, bitsPerSample);
 
-    if (!writeHeader()) {
+    if (!openDescriptor(dupFd, m_filename)) {
         LOGE("Failed to write WAV header via fd");
-        fclose(m_file);
-        m_file = nullptr;
+        releaseDescriptors();
         resetState();
         return false;
     }
 
-    LOGI("WAV writer opened from fd=%d", dupFd);
+    LOGI("WAV writer opened from fd=%d (direct I/O %s%s)", dupFd, m_directFd >= 0 ? "on" : "off",
+         m_lossless ? ", lossless" : "");
     return true;
 }
 
+bool WAVWriter::openDescriptor(int fd, const std::string& directPath) {
+    m_fd = fd;
+
+    if (m_lossless) {
+        if (m_bitsPerSample != 24) {
+            LOGE("Lossless mode needs 24-bit samples, got %d", m_bitsPerSample);
+            return false;
+        }
+        m_blockPcm.resize(static_cast<size_t>(lossless::kBlockFrames) * static_cast<size_t>(m_blockAlign));
+        m_blockEncoded.resize(lossless::maxBlockBytes(lossless::kBlockFrames, static_cast<uint32_t>(m_channels)));
+        if (!m_encoder) {
+            m_encoder = std::make_unique<lossless::Encoder>();
+        }
+    }
+
+    void* stage = nullptr;
+    if (posix_memalign(&stage, IO_ALIGNMENT, WRITE_BLOCK_BYTES) != 0) {
+        LOGE("Failed to allocate %zu byte write block", WRITE_BLOCK_BYTES);
+        return false;
+    }
+    m_stage = static_cast<uint8_t*>(stage);
+    m_stageUsed = 0;
+    m_stageFileOffset = 0;
+    m_preallocatedEnd = 0;
+    m_writebackStart = 0;
+    m_writebackEnd = 0;
+
+    // Preallocation and O_DIRECT only make sense for regular files; a second
+    // descriptor is needed because O_DIRECT cannot be toggled for the header
+    // and tail writes, which are not block sized.
+    struct stat st {};
+    const bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    m_preallocate = regular;
+    if (regular) {
+        m_directFd = ::open(directPath.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+        if (m_directFd < 0) {
+            LOGI("O_DIRECT unavailable for %s (%s), using buffered writes", directPath.c_str(), strerror(errno));
+        }
+        // Reserve the first extent now, so whoever opens the file (possibly
+        // a helper thread) pays for it rather than the first block write.
+        preallocate(static_cast<off_t>(WRITE_BLOCK_BYTES));
+    }
+
+    return writeHeader();
+}
+
 bool WAVWriter::writeData(const uint8_t* data, size_t size) {
-    if (!m_file) {
+    if (!isOpen()) {
         LOGE("WAV file not open");
         return false;
     }
@@ -107,49 +178,257 @@ bool WAVWriter::writeData(const uint8_t* data, size_t size) {
         return true;
     }
 
-    size_t written = fwrite(reinterpret_cast<const char*>(data), 1, size, m_file);
-    if (written != size) {
-        LOGE("Failed to write audio data: wrote %zu of %zu (%s)", written, size, strerror(errno));
-        return false;
+    bool ok = true;
+    if (m_lossless) {
+        // Collect whole codec blocks; each is encoded and staged as soon as it fills.
+        size_t remaining = size;
+        while (remaining > 0) {
+            const size_t chunk = std::min(remaining, m_blockPcm.size() - m_blockPcmUsed);
+            memcpy(m_blockPcm.data() + m_blockPcmUsed, data, chunk);
+            m_blockPcmUsed += chunk;
+            m_pcmBytes += static_cast<uint64_t>(chunk);
+            data += chunk;
+            remaining -= chunk;
+            if (m_blockPcmUsed == m_blockPcm.size() && !encodeBlock()) {
+                ok = false;
+                break;
+            }
+        }
+    } else {
+        const size_t staged = stageBytes(data, size);
+        m_dataSize += static_cast<uint64_t>(staged);
+        m_pcmBytes += static_cast<uint64_t>(staged);
+        if (staged < size) {
+            LOGE("Failed to write audio data: %zu of %zu bytes staged", staged, size);
+            ok = false;
+        }
     }
 
-    m_dataSize += static_cast<uint64_t>(size);
     if (m_blockAlign > 0) {
-        m_totalFrames = m_dataSize / static_cast<uint64_t>(m_blockAlign);
+        m_totalFrames = m_pcmBytes / static_cast<uint64_t>(m_blockAlign);
+    }
+    return ok;
+}
+
+size_t WAVWriter::stageBytes(const uint8_t* data, size_t size) {
+    size_t staged = 0;
+    while (staged < size) {
+        // A block that failed to flush stays staged, so the next call retries it.
+        if (m_stageUsed == WRITE_BLOCK_BYTES && !flushStage(false)) {
+            break;
+        }
+
+        const size_t chunk = std::min(size - staged, WRITE_BLOCK_BYTES - m_stageUsed);
+        memcpy(m_stage + m_stageUsed, data + staged, chunk);
+        m_stageUsed += chunk;
+        staged += chunk;
+    }
+    return staged;
+}
+
+bool WAVWriter::encodeBlock() {
+    const uint32_t frames = static_cast<uint32_t>(m_blockPcmUsed / static_cast<size_t>(m_blockAlign));
+    if (frames == 0) {
+        if (m_blockPcmUsed > 0) {
+            LOGW("Dropping %zu bytes of an incomplete frame", m_blockPcmUsed);
+        }
+        m_blockPcmUsed = 0;
+        return true;
+    }
+
+    const size_t bytes = m_encoder->encode(m_blockPcm.data(), frames, static_cast<uint32_t>(m_channels),
+                                           m_blockEncoded.data());
+    m_blockPcmUsed = 0;
+    m_blockOffsets.push_back(m_dataSize);
+    const size_t staged = stageBytes(m_blockEncoded.data(), bytes);
+    m_dataSize += static_cast<uint64_t>(staged);
+    if (staged < bytes) {
+        LOGE("Failed to write compressed block: %zu of %zu bytes staged", staged, bytes);
+        return false;
     }
     return true;
 }
 
+bool WAVWriter::writeTrailer() {
+    // Pad byte for an odd data chunk, then the block table as a "spix" chunk:
+    // uint32 block frames, uint32 count, uint64 data-relative offsets.
+    std::vector<uint8_t> trailer;
+    if (m_dataSize & 1) {
+        trailer.push_back(0);
+    }
+    const size_t chunkStart = trailer.size();
+    const uint64_t count = m_blockOffsets.size();
+    trailer.resize(chunkStart + 16 + 8 * count);
+    uint8_t* chunk = trailer.data() + chunkStart;
+    memcpy(chunk, "spix", 4);
+    putLittleEndian(chunk + 4, 8 + 8 * count, 4);
+    putLittleEndian(chunk + 8, lossless::kBlockFrames, 4);
+    putLittleEndian(chunk + 12, count, 4);
+    for (uint64_t i = 0; i < count; ++i) {
+        putLittleEndian(chunk + 16 + 8 * i, m_blockOffsets[i], 8);
+    }
+
+    const size_t staged = stageBytes(trailer.data(), trailer.size());
+    m_trailerBytes = staged;
+    return staged == trailer.size();
+}
+
 void WAVWriter::close() {
-    if (!m_file) {
+    if (!isOpen()) {
         return;
     }
 
     const std::string filenameLog = m_filename;
     LOGI("Closing WAV file: %s (wrote %llu bytes)", filenameLog.c_str(), static_cast<unsigned long long>(m_dataSize));
 
-    if (!updateHeader()) {
-        LOGE("Failed to finalize WAV header");
+    if (m_lossless) {
+        if (!encodeBlock()) {
+            LOGE("Failed to write final compressed block");
+        }
+        if (!writeTrailer()) {
+            LOGE("Failed to write block index");
+        }
+        LOGI("Lossless: %llu PCM bytes stored in %llu bytes (%.1f%%)",
+             static_cast<unsigned long long>(m_pcmBytes), static_cast<unsigned long long>(m_dataSize),
+             m_pcmBytes > 0 ? 100.0 * static_cast<double>(m_dataSize) / static_cast<double>(m_pcmBytes) : 0.0);
     }
 
-    fflush(m_file);
-    fclose(m_file);
-    m_file = nullptr;
+    if (!flushStage(true)) {
+        LOGE("Failed to write final audio block");
+    }
 
-    if (m_ownedFd >= 0) {
-        // fclose already closes the duplicated fd
-        m_ownedFd = -1;
+    // Drop any preallocated space past the last sample.
+    if (ftruncate(m_fd, m_stageFileOffset) != 0) {
+        LOGW("Failed to trim WAV file to %lld bytes: %s",
+             static_cast<long long>(m_stageFileOffset), strerror(errno));
     }
 
+    if (!updateHeader()) {
+        LOGE("Failed to finalize WAV header");
+    }
+
+    releaseDescriptors();
     resetState();
     LOGI("WAV file closed successfully");
 }
 
+bool WAVWriter::flushStage(bool finalBlock) {
+    if (m_stageUsed == 0) {
+        return true;
+    }
+
+    const off_t end = m_stageFileOffset + static_cast<off_t>(m_stageUsed);
+    preallocate(end);
+
+    bool buffered = true;
+    if (!finalBlock && m_directFd >= 0) {
+        if (writeFully(m_directFd, m_stage, m_stageUsed, m_stageFileOffset)) {
+            buffered = false;
+        } else {
+            // Some FUSE/sdcardfs mounts accept O_DIRECT at open but reject the writes.
+            LOGW("Direct write at %lld failed (%s), switching to buffered writes",
+                 static_cast<long long>(m_stageFileOffset), strerror(errno));
+            ::close(m_directFd);
+            m_directFd = -1;
+        }
+    }
+
+    if (buffered) {
+        if (!writeFully(m_fd, m_stage, m_stageUsed, m_stageFileOffset)) {
+            LOGE("Failed to write %zu bytes at %lld: %s", m_stageUsed,
+                 static_cast<long long>(m_stageFileOffset), strerror(errno));
+            return false;
+        }
+        if (!finalBlock) {
+            startWriteback(end);
+        }
+    }
+
+    m_stageFileOffset = end;
+    m_stageUsed = 0;
+    return true;
+}
+
+bool WAVWriter::writeFully(int fd, const uint8_t* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (written == 0) {
+            errno = EIO;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+void WAVWriter::preallocate(off_t end) {
+    if (!m_preallocate || end <= m_preallocatedEnd) {
+        return;
+    }
+
+    off_t target = m_preallocatedEnd;
+    while (target < end) {
+        target += PREALLOCATE_BYTES;
+    }
+
+    // KEEP_SIZE leaves st_size alone, so a crash never exposes unwritten extents as audio.
+    if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, m_preallocatedEnd, target - m_preallocatedEnd) != 0) {
+        LOGI("Preallocation unavailable (%s), continuing without it", strerror(errno));
+        m_preallocate = false;
+        return;
+    }
+    m_preallocatedEnd = target;
+}
+
+void WAVWriter::startWriteback(off_t end) {
+    if (end - m_writebackEnd < SYNC_INTERVAL_BYTES) {
+        return;
+    }
+
+    // Wait for the previous window (normally long done), drop it from the
+    // page cache, then start writeback of the new one without blocking.
+    if (m_writebackEnd > m_writebackStart) {
+        const off_t length = m_writebackEnd - m_writebackStart;
+        sync_file_range(m_fd, m_writebackStart, length,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(m_fd, m_writebackStart, length, POSIX_FADV_DONTNEED);
+    }
+    sync_file_range(m_fd, m_writebackEnd, end - m_writebackEnd, SYNC_FILE_RANGE_WRITE);
+
+    m_writebackStart = m_writebackEnd;
+    m_writebackEnd = end;
+}
+
+void WAVWriter::releaseDescriptors() {
+    if (m_directFd >= 0) {
+        ::close(m_directFd);
+        m_directFd = -1;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    free(m_stage);
+    m_stage = nullptr;
+    m_stageUsed = 0;
+}
+
 bool WAVWriter::writeHeader() {
-    if (!m_file) {
+    if (!isOpen() || !m_stage) {
         return false;
     }
 
+    // The header is staged as the start of the first block and reaches the
+    // file with it.
+
     // RIFF header
     if (!writeFourCC("RIFF")) {
         LOGE("Failed to write RIFF tag");
@@ -165,29 +444,17 @@ bool WAVWriter::writeHeader() {
     }
 
     // Reserve space for optional ds64 chunk by writing a JUNK chunk immediately after the header.
-    m_ds64ChunkPos = ftello(m_file);
-    if (m_ds64ChunkPos < 0) {
-        LOGE("Failed to get JUNK chunk position: %s", strerror(errno));
-        return false;
-    }
+    m_ds64ChunkPos = static_cast<off_t>(m_stageUsed);
     if (!writeFourCC("JUNK")) {
         LOGE("Failed to write JUNK placeholder");
         return false;
     }
-    m_ds64SizePos = ftello(m_file);
-    if (m_ds64SizePos < 0) {
-        LOGE("Failed to track JUNK size position: %s", strerror(errno));
-        return false;
-    }
+    m_ds64SizePos = static_cast<off_t>(m_stageUsed);
     if (!writeUint32(DS64_CHUNK_SIZE)) {
         LOGE("Failed to set JUNK size");
         return false;
     }
-    m_ds64DataPos = ftello(m_file);
-    if (m_ds64DataPos < 0) {
-        LOGE("Failed to track JUNK data position: %s", strerror(errno));
-        return false;
-    }
+    m_ds64DataPos = static_cast<off_t>(m_stageUsed);
     if (!writeZeros(DS64_CHUNK_SIZE)) {
         LOGE("Failed to reserve JUNK data");
         return false;
@@ -202,7 +469,7 @@ bool WAVWriter::writeHeader() {
         LOGE("Failed to write fmt chunk size");
         return false;
     }
-    if (!writeUint16(static_cast<uint16_t>(1))) { // PCM
+    if (!writeUint16(m_lossless ? lossless::kFormatTag : static_cast<uint16_t>(1))) { // PCM
         LOGE("Failed to write audio format");
         return false;
     }
@@ -227,126 +494,109 @@ bool WAVWriter::writeHeader() {
         return false;
     }
 
+    // Channel map: uint16 source channel count, uint16 count, uint16 source index per stored channel
+    if (!m_channelMap.empty()) {
+        const size_t count = m_channelMap.size();
+        if (count != static_cast<size_t>(m_channels) || !writeFourCC("chmp") ||
+            !writeUint32(static_cast<uint32_t>(4 + 2 * count)) ||
+            !writeUint16(static_cast<uint16_t>(m_sourceChannelCount)) ||
+            !writeUint16(static_cast<uint16_t>(count))) {
+            LOGE("Failed to write channel map (%zu entries for %d channels)", count, m_channels);
+            return false;
+        }
+        for (uint16_t channel : m_channelMap) {
+            if (!writeUint16(channel)) {
+                LOGE("Failed to write channel map");
+                return false;
+            }
+        }
+    }
+
+    // Compressed data needs its frame count spelled out
+    if (m_lossless) {
+        if (!writeFourCC("fact") || !writeUint32(4)) {
+            LOGE("Failed to write fact chunk");
+            return false;
+        }
+        m_factPos = static_cast<off_t>(m_stageUsed);
+        if (!writeUint32(0)) {
+            LOGE("Failed to reserve fact sample count");
+            return false;
+        }
+    }
+
     // data chunk header
     if (!writeFourCC("data")) {
         LOGE("Failed to write data tag");
         return false;
     }
-    m_dataSizePos = ftello(m_file);
-    if (m_dataSizePos < 0) {
-        LOGE("Failed to get data size position: %s", strerror(errno));
-        return false;
-    }
+    m_dataSizePos = static_cast<off_t>(m_stageUsed);
     if (!writeUint32(0)) {
         LOGE("Failed to reserve data size");
         return false;
     }
 
-    fflush(m_file);
+    m_dataStartPos = static_cast<off_t>(m_stageUsed);
     return true;
 }
 
 bool WAVWriter::updateHeader() {
-    if (!m_file) {
+    if (!isOpen()) {
         return false;
     }
 
-    off_t currentPos = ftello(m_file);
-    if (currentPos == -1) {
-        LOGE("Failed to get current position: %s", strerror(errno));
+    uint64_t fileSize = static_cast<uint64_t>(m_dataStartPos) + m_dataSize + m_trailerBytes;
+    uint64_t riffSize64 = (fileSize >= 8) ? (fileSize - 8) : 0;
+    uint64_t sampleFrames = m_totalFrames;
+
+    if (m_factPos > 0 && !patchUint32(m_factPos, static_cast<uint32_t>(std::min<uint64_t>(sampleFrames, MAX_UINT32)))) {
+        LOGE("Failed to write fact sample count: %s", strerror(errno));
         return false;
     }
 
-    uint64_t fileSize = static_cast<uint64_t>(currentPos);
-    uint64_t riffSize64 = (fileSize >= 8) ? (fileSize - 8) : 0;
-    uint64_t sampleFrames = (m_blockAlign > 0) ? (m_dataSize / static_cast<uint64_t>(m_blockAlign)) : 0;
-
     const bool needsRf64 = (m_dataSize > MAX_UINT32) || (riffSize64 > MAX_UINT32);
 
     if (needsRf64) {
-        // Update chunk ID to RF64
-        if (fseeko(m_file, 0, SEEK_SET) != 0) {
-            LOGE("Failed to seek to RIFF tag: %s", strerror(errno));
+        // Update chunk ID to RF64, RIFF size placeholder set to max 32-bit
+        if (!patchFourCC(0, "RF64")) {
+            LOGE("Failed to write RF64 tag: %s", strerror(errno));
             return false;
         }
-        if (!writeFourCC("RF64")) {
-            LOGE("Failed to write RF64 tag");
-            return false;
-        }
-
-        // RIFF size placeholder set to max 32-bit
-        if (!writeUint32(MAX_UINT32)) {
-            LOGE("Failed to set RF64 chunk size");
+        if (!patchUint32(4, MAX_UINT32)) {
+            LOGE("Failed to set RF64 chunk size: %s", strerror(errno));
             return false;
         }
 
         // Overwrite JUNK placeholder with ds64 chunk
-        if (fseeko(m_file, m_ds64ChunkPos, SEEK_SET) != 0) {
-            LOGE("Failed to seek to ds64 chunk: %s", strerror(errno));
-            return false;
-        }
-        if (!writeFourCC("ds64")) {
-            LOGE("Failed to write ds64 tag");
-            return false;
-        }
-        if (!writeUint32(DS64_CHUNK_SIZE)) {
-            LOGE("Failed to write ds64 size");
-            return false;
-        }
-        if (!writeUint64(riffSize64)) {
-            LOGE("Failed to write ds64 riff size");
-            return false;
-        }
-        if (!writeUint64(m_dataSize)) {
-            LOGE("Failed to write ds64 data size");
-            return false;
-        }
-        if (!writeUint64(sampleFrames)) {
-            LOGE("Failed to write ds64 sample count");
-            return false;
-        }
-        if (!writeUint32(0)) { // table length
-            LOGE("Failed to write ds64 table length");
+        uint8_t ds64[8 + DS64_CHUNK_SIZE];
+        memcpy(ds64, "ds64", 4);
+        putLittleEndian(ds64 + 4, DS64_CHUNK_SIZE, 4);
+        putLittleEndian(ds64 + 8, riffSize64, 8);
+        putLittleEndian(ds64 + 16, m_dataSize, 8);
+        putLittleEndian(ds64 + 24, sampleFrames, 8);
+        putLittleEndian(ds64 + 32, 0, 4); // table length
+        if (!patchBytes(m_ds64ChunkPos, ds64, sizeof(ds64))) {
+            LOGE("Failed to write ds64 chunk: %s", strerror(errno));
             return false;
         }
 
         // Set data chunk size to max 32-bit
-        if (fseeko(m_file, m_dataSizePos, SEEK_SET) != 0) {
-            LOGE("Failed to seek to data size for RF64: %s", strerror(errno));
-            return false;
-        }
-        if (!writeUint32(MAX_UINT32)) {
-            LOGE("Failed to write RF64 data size placeholder");
+        if (!patchUint32(m_dataSizePos, MAX_UINT32)) {
+            LOGE("Failed to write RF64 data size placeholder: %s", strerror(errno));
             return false;
         }
     } else {
         // Standard RIFF update
-        if (fseeko(m_file, 4, SEEK_SET) != 0) {
-            LOGE("Failed to seek to RIFF size: %s", strerror(errno));
-            return false;
-        }
-        if (!writeUint32(static_cast<uint32_t>(riffSize64))) {
-            LOGE("Failed to write RIFF size");
-            return false;
-        }
-
-        if (fseeko(m_file, m_dataSizePos, SEEK_SET) != 0) {
-            LOGE("Failed to seek to data size: %s", strerror(errno));
+        if (!patchUint32(4, static_cast<uint32_t>(riffSize64))) {
+            LOGE("Failed to write RIFF size: %s", strerror(errno));
             return false;
         }
-        if (!writeUint32(static_cast<uint32_t>(m_dataSize))) {
-            LOGE("Failed to write data size");
+        if (!patchUint32(m_dataSizePos, static_cast<uint32_t>(m_dataSize))) {
+            LOGE("Failed to write data size: %s", strerror(errno));
             return false;
         }
     }
 
-    // Restore file position
-    if (fseeko(m_file, currentPos, SEEK_SET) != 0) {
-        LOGE("Failed to restore position: %s", strerror(errno));
-        return false;
-    }
-
-    fflush(m_file);
     return true;
 }
 
@@ -358,16 +608,21 @@ void WAVWriter::initializeFormat(int sampleRate, int channels, int bitsPerSample
     m_blockAlign = m_channels * m_bytesPerSample;
     m_byteRate = m_sampleRate * m_blockAlign;
     m_dataSize = 0;
+    m_pcmBytes = 0;
     m_totalFrames = 0;
+    m_trailerBytes = 0;
+    m_factPos = 0;
+    m_blockPcmUsed = 0;
+    m_blockOffsets.clear();
     m_dataSizePos = 0;
     m_ds64ChunkPos = 0;
     m_ds64SizePos = 0;
     m_ds64DataPos = 0;
+    m_dataStartPos = 0;
 }
 
 void WAVWriter::resetState() {
     m_filename.clear();
-    m_ownedFd = -1;
     m_sampleRate = 0;
     m_channels = 0;
     m_bitsPerSample = 0;
@@ -375,54 +630,72 @@ void WAVWriter::resetState() {
     m_blockAlign = 0;
     m_byteRate = 0;
     m_dataSize = 0;
+    m_pcmBytes = 0;
     m_totalFrames = 0;
+    m_trailerBytes = 0;
+    m_factPos = 0;
     m_dataSizePos = 0;
     m_ds64ChunkPos = 0;
     m_ds64SizePos = 0;
     m_ds64DataPos = 0;
+    m_dataStartPos = 0;
+    m_stageFileOffset = 0;
+    m_preallocatedEnd = 0;
+    m_writebackStart = 0;
+    m_writebackEnd = 0;
+    m_preallocate = false;
+    m_blockPcmUsed = 0;
+    std::vector<uint8_t>().swap(m_blockPcm);
+    std::vector<uint8_t>().swap(m_blockEncoded);
+    std::vector<uint64_t>().swap(m_blockOffsets);
 }
 
 bool WAVWriter::writeFourCC(const char* fourcc) {
-    return fwrite(fourcc, 1, 4, m_file) == 4;
+    if (m_stageUsed + 4 > WRITE_BLOCK_BYTES) {
+        return false;
+    }
+    memcpy(m_stage + m_stageUsed, fourcc, 4);
+    m_stageUsed += 4;
+    return true;
 }
 
 bool WAVWriter::writeUint16(uint16_t value) {
-    uint8_t bytes[2] = {
-        static_cast<uint8_t>(value & 0xFF),
-        static_cast<uint8_t>((value >> 8) & 0xFF)
-    };
-    return fwrite(bytes, 1, 2, m_file) == 2;
+    if (m_stageUsed + 2 > WRITE_BLOCK_BYTES) {
+        return false;
+    }
+    putLittleEndian(m_stage + m_stageUsed, value, 2);
+    m_stageUsed += 2;
+    return true;
 }
 
 bool WAVWriter::writeUint32(uint32_t value) {
-    uint8_t bytes[4] = {
-        static_cast<uint8_t>(value & 0xFF),
-        static_cast<uint8_t>((value >> 8) & 0xFF),
-        static_cast<uint8_t>((value >> 16) & 0xFF),
-        static_cast<uint8_t>((value >> 24) & 0xFF)
-    };
-    return fwrite(bytes, 1, 4, m_file) == 4;
-}
-
-bool WAVWriter::writeUint64(uint64_t value) {
-    uint8_t bytes[8];
-    for (int i = 0; i < 8; ++i) {
-        bytes[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    if (m_stageUsed + 4 > WRITE_BLOCK_BYTES) {
+        return false;
     }
-    return fwrite(bytes, 1, 8, m_file) == 8;
+    putLittleEndian(m_stage + m_stageUsed, value, 4);
+    m_stageUsed += 4;
+    return true;
 }
 
 bool WAVWriter::writeZeros(size_t count) {
-    static constexpr size_t BUFFER_SIZE = 64;
-    uint8_t zeros[BUFFER_SIZE] = {0};
-
-    size_t remaining = count;
-    while (remaining > 0) {
-        size_t chunk = remaining < BUFFER_SIZE ? remaining : BUFFER_SIZE;
-        if (fwrite(zeros, 1, chunk, m_file) != chunk) {
-            return false;
-        }
-        remaining -= chunk;
+    if (m_stageUsed + count > WRITE_BLOCK_BYTES) {
+        return false;
     }
+    memset(m_stage + m_stageUsed, 0, count);
+    m_stageUsed += count;
     return true;
-}
\ No newline at end of file
+}
+
+bool WAVWriter::patchBytes(off_t offset, const uint8_t* bytes, size_t size) {
+    return writeFully(m_fd, bytes, size, offset);
+}
+
+bool WAVWriter::patchFourCC(off_t offset, const char* fourcc) {
+    return patchBytes(offset, reinterpret_cast<const uint8_t*>(fourcc), 4);
+}
+
+bool WAVWriter::patchUint32(off_t offset, uint32_t value) {
+    uint8_t bytes[4];
+    putLittleEndian(bytes, value, 4);
+    return patchBytes(offset, bytes, sizeof(bytes));
+}
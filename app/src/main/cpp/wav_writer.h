@@ -2,29 +2,61 @@
 
 #include <string>
 #include <cstdint>
-#include <cstdio>
 #include <cstddef>
+#include <memory>
+#include <vector>
 #include <sys/types.h>
+#include "lossless_codec.h"
 
+/**
+ * Streaming WAV/RF64 writer.
+ *
+ * Audio is staged into an aligned block buffer and written with pwrite in
+ * WRITE_BLOCK_BYTES blocks, through an O_DIRECT descriptor when the file
+ * system accepts one. The file is preallocated ahead of the write position
+ * and buffered writeback is kicked with sync_file_range so dirty pages never
+ * pile up. Header sizes are patched in place on close.
+ *
+ * Two optional layouts trade compatibility for bandwidth. A channel map
+ * records which source channels a reduced file holds (a "chmp" chunk after
+ * fmt). Lossless mode stores the data chunk as lossless_codec blocks under
+ * fmt tag lossless::kFormatTag, with the frame count in a "fact" chunk and
+ * a block offset table in a "spix" chunk after the data.
+ */
 class WAVWriter {
 public:
     WAVWriter();
     ~WAVWriter();
-    
+
+    /**
+     * Mark the file as holding source channels @p sourceChannels (ascending)
+     * of a @p sourceChannelCount-channel stream; empty writes no map. Call
+     * before open; kept across files.
+     */
+    void setChannelMap(const std::vector<uint16_t>& sourceChannels, int sourceChannelCount);
+    /** Compress 24-bit data losslessly; call before open, kept across files. */
+    void setLossless(bool enabled) { m_lossless = enabled; }
+
     bool open(const std::string& filename, int sampleRate, int channels, int bitsPerSample);
     bool openFromFd(int fd, int sampleRate, int channels, int bitsPerSample);
     bool writeData(const uint8_t* data, size_t size);
     void close();
-    
-    bool isOpen() const { return m_file != nullptr; }
-    size_t getBytesWritten() const { return m_dataSize; }
-    
+
+    bool isOpen() const { return m_fd >= 0; }
+    /** PCM bytes accepted so far; the data chunk is smaller in lossless mode. */
+    uint64_t getBytesWritten() const { return m_pcmBytes; }
+
 private:
     static constexpr uint32_t MAX_UINT32 = 0xFFFFFFFFu;
     static constexpr uint32_t DS64_CHUNK_SIZE = 28u;
 
-    FILE* m_file;
-    int m_ownedFd;
+    static constexpr size_t IO_ALIGNMENT = 4096;                     // O_DIRECT buffer/offset/length alignment
+    static constexpr size_t WRITE_BLOCK_BYTES = 2 * 1024 * 1024;     // one pwrite per staged block
+    static constexpr off_t PREALLOCATE_BYTES = 64 * 1024 * 1024;     // fallocate extent size
+    static constexpr off_t SYNC_INTERVAL_BYTES = 8 * 1024 * 1024;    // buffered writeback window
+
+    int m_fd;            // buffered descriptor: header, tail block, truncate
+    int m_directFd;      // O_DIRECT descriptor for full blocks, -1 if unavailable
     std::string m_filename;
 
     // WAV format parameters
@@ -35,22 +67,58 @@ private:
     int m_blockAlign;
     int m_byteRate;
 
+    // Optional layouts
+    std::vector<uint16_t> m_channelMap;
+    int m_sourceChannelCount;
+    bool m_lossless;
+
     // File tracking
-    uint64_t m_dataSize;
+    uint64_t m_dataSize;         // data chunk payload bytes
+    uint64_t m_pcmBytes;         // PCM bytes handed to writeData
     uint64_t m_totalFrames;
+    uint64_t m_trailerBytes;     // chunks staged after the data chunk
+    off_t m_factPos;             // fact sample count, 0 if none
     off_t m_dataSizePos;
     off_t m_ds64ChunkPos;
     off_t m_ds64SizePos;
     off_t m_ds64DataPos;
+    off_t m_dataStartPos;
+
+    // Block staging: m_stage mirrors the file from m_stageFileOffset onward
+    uint8_t* m_stage;
+    size_t m_stageUsed;
+    off_t m_stageFileOffset;
+    off_t m_preallocatedEnd;
+    off_t m_writebackStart;      // last window handed to sync_file_range
+    off_t m_writebackEnd;
+    bool m_preallocate;
+
+    // Lossless mode: PCM of the block being collected, its encoding, block offsets in the data chunk
+    std::vector<uint8_t> m_blockPcm;
+    size_t m_blockPcmUsed;
+    std::vector<uint8_t> m_blockEncoded;
+    std::vector<uint64_t> m_blockOffsets;
+    std::unique_ptr<lossless::Encoder> m_encoder;
 
+    bool openDescriptor(int fd, const std::string& directPath);
     bool writeHeader();
     bool updateHeader();
+    bool flushStage(bool finalBlock);
+    size_t stageBytes(const uint8_t* data, size_t size);  // returns the bytes staged
+    bool encodeBlock();
+    bool writeTrailer();
+    bool writeFully(int fd, const uint8_t* data, size_t size, off_t offset);
+    void preallocate(off_t end);
+    void startWriteback(off_t end);
+    void releaseDescriptors();
     void initializeFormat(int sampleRate, int channels, int bitsPerSample);
     void resetState();
 
     bool writeFourCC(const char* fourcc);
     bool writeUint16(uint16_t value);
     bool writeUint32(uint32_t value);
-    bool writeUint64(uint64_t value);
     bool writeZeros(size_t count);
-};
\ No newline at end of file
+    bool patchBytes(off_t offset, const uint8_t* bytes, size_t size);
+    bool patchFourCC(off_t offset, const char* fourcc);
+    bool patchUint32(off_t offset, uint32_t value);
+};
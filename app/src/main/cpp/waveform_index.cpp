@@ -0,0 +1,451 @@
+#include "waveform_index.h"
+#include "pcm24.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "WaveformIndex"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'P', 'C', 'W', 'F', 'I', 'D', 'X'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr int kBytesPerSample = 3;
+constexpr size_t kDecodeFrames = 256;          // one finest block per decode pass
+constexpr size_t kPendingRecords = 512;        // finest-level records per write (4 KB)
+constexpr double kSampleScale = 1.0 / 8388608.0;  // 2^-23
+
+struct LevelHeader {
+    uint32_t blockFrames;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t count;
+};
+
+/** 128-byte header; the records that follow stay 8-byte aligned when mapped. */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t levelCount;
+    uint32_t complete;     // 0 until close() has written the coarse levels
+    uint64_t totalFrames;
+    LevelHeader levels[waveform_index::kLevelCount];
+    uint8_t reserved[16];
+};
+static_assert(sizeof(FileHeader) == 128, "waveform index header must stay 128 bytes");
+
+int16_t ToRecordSample(int32_t sample) {
+    return static_cast<int16_t>(std::clamp(sample >> 8, -32767, 32767));
+}
+
+uint16_t ToRecordLevel(double rms) {
+    return static_cast<uint16_t>(std::clamp(std::lround(rms * 32767.0), 0L, 32767L));
+}
+
+} // namespace
+
+namespace waveform_index {
+
+std::string sidecarName(const std::string& displayPath) {
+    // Last path component; document URIs encode the separators as %2F.
+    size_t start = displayPath.find_last_of('/');
+    start = (start == std::string::npos) ? 0 : start + 1;
+    for (size_t pos = start; pos + 3 <= displayPath.size(); ++pos) {
+        if (displayPath[pos] == '%' && displayPath[pos + 1] == '2' &&
+            std::toupper(static_cast<unsigned char>(displayPath[pos + 2])) == 'F') {
+            start = pos + 3;
+        }
+    }
+    std::string name = displayPath.substr(start);
+
+    if (name.size() > 4) {
+        std::string extension = name.substr(name.size() - 4);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension == ".wav") {
+            name.resize(name.size() - 4);
+        }
+    }
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '_' && c != '-') {
+            c = '_';
+        }
+    }
+    if (name.empty()) {
+        name = "recording";
+    }
+    return name + ".wfi";
+}
+
+} // namespace waveform_index
+
+WaveformIndexWriter::WaveformIndexWriter()
+    : m_file(nullptr)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_totalFrames(0)
+    , m_fineRecordCount(0)
+    , m_partialBytes(0)
+    , m_failed(false) {
+}
+
+WaveformIndexWriter::~WaveformIndexWriter() {
+    close();
+}
+
+bool WaveformIndexWriter::open(const std::string& path, int sampleRate, int channels) {
+    close();
+    if (channels <= 0) {
+        return false;
+    }
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        LOGW("Cannot create waveform index %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    m_path = path;
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_totalFrames = 0;
+    m_fineRecordCount = 0;
+    m_partialBytes = 0;
+    m_failed = false;
+    m_partialFrame.assign(static_cast<size_t>(channels) * kBytesPerSample, 0);
+    m_samples.assign(kDecodeFrames * static_cast<size_t>(channels), 0);
+    m_pending.clear();
+    m_pending.reserve(kPendingRecords);
+    for (int level = 0; level < waveform_index::kLevelCount; ++level) {
+        m_levels[level].sumSquares.assign(static_cast<size_t>(channels), 0.0);
+        resetAccumulator(m_levels[level]);
+        m_coarse[level].clear();
+    }
+
+    // Placeholder header: an interrupted recording leaves an index readers reject.
+    FileHeader header {};
+    if (std::fwrite(&header, sizeof(header), 1, m_file) != 1) {
+        LOGW("Failed to write waveform index header to %s", path.c_str());
+        m_failed = true;
+    }
+    return true;
+}
+
+void WaveformIndexWriter::resetAccumulator(Accumulator& level) {
+    level.min = INT32_MAX;
+    level.max = INT32_MIN;
+    level.frames = 0;
+    std::fill(level.sumSquares.begin(), level.sumSquares.end(), 0.0);
+}
+
+void WaveformIndexWriter::append(const uint8_t* frames, size_t bytes) {
+    if (!m_file || m_failed || !frames) {
+        return;
+    }
+
+    const size_t frameBytes = static_cast<size_t>(m_channels) * kBytesPerSample;
+    const size_t channels = static_cast<size_t>(m_channels);
+
+    // Complete a frame split across two writes first.
+    if (m_partialBytes > 0) {
+        const size_t take = std::min(bytes, frameBytes - m_partialBytes);
+        std::memcpy(m_partialFrame.data() + m_partialBytes, frames, take);
+        m_partialBytes += take;
+        frames += take;
+        bytes -= take;
+        if (m_partialBytes < frameBytes) {
+            return;
+        }
+        m_partialBytes = 0;
+        append(m_partialFrame.data(), frameBytes);
+    }
+
+    Accumulator& fine = m_levels[0];
+    size_t remaining = bytes / frameBytes;
+    while (remaining > 0) {
+        const size_t count = std::min<size_t>(remaining, waveform_index::kLevelBlockFrames[0] - fine.frames);
+        pcm24::toInt32(frames, m_samples.data(), count * channels);
+
+        int32_t minSample = fine.min;
+        int32_t maxSample = fine.max;
+        double* sums = fine.sumSquares.data();
+        for (size_t frame = 0; frame < count; ++frame) {
+            const int32_t* sample = m_samples.data() + frame * channels;
+            for (size_t ch = 0; ch < channels; ++ch) {
+                const int32_t value = sample[ch];
+                minSample = std::min(minSample, value);
+                maxSample = std::max(maxSample, value);
+                const double scaled = static_cast<double>(value) * kSampleScale;
+                sums[ch] += scaled * scaled;
+            }
+        }
+        fine.min = minSample;
+        fine.max = maxSample;
+        fine.frames += static_cast<uint32_t>(count);
+        m_totalFrames += count;
+
+        if (fine.frames >= waveform_index::kLevelBlockFrames[0]) {
+            finishBlock(0);
+        }
+        frames += count * frameBytes;
+        remaining -= count;
+    }
+
+    const size_t tail = bytes % frameBytes;
+    if (tail > 0) {
+        std::memcpy(m_partialFrame.data(), frames, tail);
+        m_partialBytes = tail;
+    }
+}
+
+void WaveformIndexWriter::finishBlock(int level) {
+    Accumulator& block = m_levels[level];
+    if (block.frames == 0) {
+        return;
+    }
+
+    size_t loudest = 0;
+    for (size_t ch = 1; ch < block.sumSquares.size(); ++ch) {
+        if (block.sumSquares[ch] > block.sumSquares[loudest]) {
+            loudest = ch;
+        }
+    }
+
+    waveform_index::Record record;
+    record.min = ToRecordSample(block.min);
+    record.max = ToRecordSample(block.max);
+    record.rms = ToRecordLevel(std::sqrt(block.sumSquares[loudest] / block.frames));
+    record.loudestChannel = static_cast<uint16_t>(loudest);
+
+    if (level == 0) {
+        m_pending.push_back(record);
+        ++m_fineRecordCount;
+        if (m_pending.size() >= kPendingRecords) {
+            flushFineRecords();
+        }
+    } else {
+        m_coarse[level].push_back(record);
+    }
+
+    // Fold into the next level before clearing.
+    if (level + 1 < waveform_index::kLevelCount) {
+        Accumulator& parent = m_levels[level + 1];
+        parent.min = std::min(parent.min, block.min);
+        parent.max = std::max(parent.max, block.max);
+        parent.frames += block.frames;
+        for (size_t ch = 0; ch < block.sumSquares.size(); ++ch) {
+            parent.sumSquares[ch] += block.sumSquares[ch];
+        }
+        resetAccumulator(block);
+        if (parent.frames >= waveform_index::kLevelBlockFrames[level + 1]) {
+            finishBlock(level + 1);
+        }
+    } else {
+        resetAccumulator(block);
+    }
+}
+
+bool WaveformIndexWriter::flushFineRecords() {
+    if (m_pending.empty()) {
+        return true;
+    }
+    if (!m_failed && std::fwrite(m_pending.data(), sizeof(waveform_index::Record), m_pending.size(), m_file) !=
+                         m_pending.size()) {
+        LOGW("Failed to write waveform index %s: %s", m_path.c_str(), std::strerror(errno));
+        m_failed = true;
+    }
+    m_pending.clear();
+    return !m_failed;
+}
+
+bool WaveformIndexWriter::close() {
+    if (!m_file) {
+        return false;
+    }
+
+    // Partial blocks at the end still get a record at every level.
+    for (int level = 0; level < waveform_index::kLevelCount; ++level) {
+        finishBlock(level);
+    }
+    flushFineRecords();
+
+    FileHeader header {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.headerBytes = sizeof(FileHeader);
+    header.sampleRate = static_cast<uint32_t>(m_sampleRate);
+    header.channels = static_cast<uint32_t>(m_channels);
+    header.levelCount = waveform_index::kLevelCount;
+    header.complete = 1;
+    header.totalFrames = m_totalFrames;
+
+    uint64_t offset = sizeof(FileHeader);
+    for (int level = 0; level < waveform_index::kLevelCount; ++level) {
+        const uint64_t count = (level == 0) ? m_fineRecordCount : m_coarse[level].size();
+        header.levels[level].blockFrames = waveform_index::kLevelBlockFrames[level];
+        header.levels[level].offset = offset;
+        header.levels[level].count = count;
+        offset += count * sizeof(waveform_index::Record);
+    }
+
+    bool ok = !m_failed;
+    for (int level = 1; ok && level < waveform_index::kLevelCount; ++level) {
+        const std::vector<waveform_index::Record>& records = m_coarse[level];
+        ok = std::fwrite(records.data(), sizeof(waveform_index::Record), records.size(), m_file) == records.size();
+    }
+    ok = ok && std::fseek(m_file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, m_file) == 1;
+    ok = (std::fclose(m_file) == 0) && ok;
+    m_file = nullptr;
+
+    if (!ok) {
+        LOGW("Waveform index %s is incomplete; removing it", m_path.c_str());
+        unlink(m_path.c_str());
+    } else {
+        LOGI("Waveform index written: %s (%llu frames, %llu bytes)", m_path.c_str(),
+             static_cast<unsigned long long>(m_totalFrames), static_cast<unsigned long long>(offset));
+    }
+    for (auto& records : m_coarse) {
+        std::vector<waveform_index::Record>().swap(records);
+    }
+    return ok;
+}
+
+WaveformIndexReader::WaveformIndexReader()
+    : m_mapping(nullptr)
+    , m_mappingBytes(0)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_totalFrames(0) {
+}
+
+WaveformIndexReader::~WaveformIndexReader() {
+    close();
+}
+
+bool WaveformIndexReader::open(const std::string& path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info {};
+    FileHeader header {};
+    const bool readable = fstat(fd, &info) == 0 &&
+                          static_cast<size_t>(info.st_size) >= sizeof(FileHeader) &&
+                          pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    const size_t fileBytes = readable ? static_cast<size_t>(info.st_size) : 0;
+    bool valid = readable &&
+                 std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header.version == kFormatVersion &&
+                 header.headerBytes == sizeof(FileHeader) &&
+                 header.complete == 1 &&
+                 header.levelCount == waveform_index::kLevelCount;
+    for (int level = 0; valid && level < waveform_index::kLevelCount; ++level) {
+        const LevelHeader& entry = header.levels[level];
+        valid = entry.blockFrames == waveform_index::kLevelBlockFrames[level] &&
+                entry.offset % alignof(waveform_index::Record) == 0 &&
+                entry.offset <= fileBytes &&
+                entry.count <= (fileBytes - entry.offset) / sizeof(waveform_index::Record);
+    }
+    if (!valid) {
+        ::close(fd);
+        if (readable) {
+            LOGW("Ignoring unfinished or malformed waveform index %s", path.c_str());
+        }
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOGE("Failed to map %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingBytes = fileBytes;
+    m_sampleRate = static_cast<int>(header.sampleRate);
+    m_channels = static_cast<int>(header.channels);
+    m_totalFrames = header.totalFrames;
+    for (int level = 0; level < waveform_index::kLevelCount; ++level) {
+        m_levels[level].blockFrames = header.levels[level].blockFrames;
+        m_levels[level].count = header.levels[level].count;
+        m_levels[level].records = reinterpret_cast<const waveform_index::Record*>(
+            static_cast<const uint8_t*>(mapping) + header.levels[level].offset);
+    }
+    return true;
+}
+
+void WaveformIndexReader::close() {
+    if (m_mapping) {
+        munmap(m_mapping, m_mappingBytes);
+    }
+    m_mapping = nullptr;
+    m_mappingBytes = 0;
+    m_sampleRate = 0;
+    m_channels = 0;
+    m_totalFrames = 0;
+    for (Level& level : m_levels) {
+        level = Level();
+    }
+}
+
+int WaveformIndexReader::summarize(uint64_t startFrame, uint64_t endFrame, int columns, float* out) const {
+    endFrame = std::min(endFrame, m_totalFrames);
+    if (!isOpen() || !out || columns <= 0 || startFrame >= endFrame) {
+        return 0;
+    }
+
+    const uint64_t span = endFrame - startFrame;
+    const uint64_t framesPerColumn = std::max<uint64_t>(1, span / static_cast<uint64_t>(columns));
+    int chosen = 0;
+    for (int index = waveform_index::kLevelCount - 1; index > 0; --index) {
+        if (framesPerColumn >= m_levels[index].blockFrames) {
+            chosen = index;
+            break;
+        }
+    }
+    const Level& level = m_levels[chosen];
+    if (level.count == 0) {
+        return 0;
+    }
+
+    for (int column = 0; column < columns; ++column) {
+        const uint64_t from = startFrame + span * static_cast<uint64_t>(column) / static_cast<uint64_t>(columns);
+        const uint64_t to = startFrame + span * static_cast<uint64_t>(column + 1) / static_cast<uint64_t>(columns);
+        uint64_t first = std::min(from / level.blockFrames, level.count - 1);
+        uint64_t last = std::min((to + level.blockFrames - 1) / level.blockFrames, level.count);
+        last = std::max(last, first + 1);
+
+        int minValue = 32767;
+        int maxValue = -32767;
+        double sumSquares = 0.0;
+        for (uint64_t block = first; block < last; ++block) {
+            const waveform_index::Record& record = level.records[block];
+            minValue = std::min<int>(minValue, record.min);
+            maxValue = std::max<int>(maxValue, record.max);
+            const double rms = static_cast<double>(record.rms);
+            sumSquares += rms * rms;
+        }
+        out[column * 3] = static_cast<float>(minValue) / 32767.0f;
+        out[column * 3 + 1] = static_cast<float>(maxValue) / 32767.0f;
+        out[column * 3 + 2] = static_cast<float>(std::sqrt(sumSquares / static_cast<double>(last - first)) / 32767.0);
+    }
+    return columns;
+}
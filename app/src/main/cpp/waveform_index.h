@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Waveform overview sidecar: a min/max/RMS pyramid of one recording, written
+ * while the audio goes to disk so playback never has to scan the WAV.
+ *
+ * Every level summarises fixed blocks (256, 4096 and 65536 frames) across all
+ * channels: min and max over every channel, RMS of the loudest channel in the
+ * block, and which channel that was. The file is a 128-byte header followed
+ * by the levels, finest first, so a reader can map it and index any level
+ * directly. The finest level streams to disk during recording; the coarser
+ * ones are small enough to keep in memory until close().
+ */
+namespace waveform_index {
+
+constexpr int kLevelCount = 3;
+constexpr uint32_t kLevelBlockFrames[kLevelCount] = {256, 4096, 65536};
+
+struct Record {
+    int16_t min;           // full scale = +/-32767
+    int16_t max;
+    uint16_t rms;          // loudest channel, full scale = 32767
+    uint16_t loudestChannel;
+};
+static_assert(sizeof(Record) == 8, "waveform records must stay 8 bytes");
+
+/** Sidecar file name for the recording at @p displayPath (file path or document URI). */
+std::string sidecarName(const std::string& displayPath);
+
+} // namespace waveform_index
+
+/** Disk-thread writer; append() takes exactly the packed 24-bit frames written to the WAV. */
+class WaveformIndexWriter {
+public:
+    WaveformIndexWriter();
+    ~WaveformIndexWriter();
+
+    WaveformIndexWriter(const WaveformIndexWriter&) = delete;
+    WaveformIndexWriter& operator=(const WaveformIndexWriter&) = delete;
+
+    bool open(const std::string& path, int sampleRate, int channels);
+    void append(const uint8_t* frames, size_t bytes);
+    /** Flush partial blocks, append the coarse levels and mark the file complete. */
+    bool close();
+
+    bool isOpen() const { return m_file != nullptr; }
+
+private:
+    struct Accumulator {
+        int32_t min;
+        int32_t max;
+        uint32_t frames;
+        std::vector<double> sumSquares;  // per channel
+    };
+
+    void resetAccumulator(Accumulator& level);
+    void finishBlock(int level);
+    bool flushFineRecords();
+
+    FILE* m_file;
+    std::string m_path;
+    int m_sampleRate;
+    int m_channels;
+    uint64_t m_totalFrames;
+    Accumulator m_levels[waveform_index::kLevelCount];
+    uint64_t m_fineRecordCount;                    // level 0 records written or pending
+    std::vector<waveform_index::Record> m_pending;  // level 0 records not yet written
+    std::vector<waveform_index::Record> m_coarse[waveform_index::kLevelCount];
+    std::vector<int32_t> m_samples;                 // decode scratch
+    size_t m_partialBytes;                          // bytes of an incomplete frame carried over
+    std::vector<uint8_t> m_partialFrame;
+    bool m_failed;
+};
+
+/** Read-only mapping of a finished sidecar. */
+class WaveformIndexReader {
+public:
+    struct Level {
+        uint32_t blockFrames = 0;
+        uint64_t count = 0;
+        const waveform_index::Record* records = nullptr;
+    };
+
+    WaveformIndexReader();
+    ~WaveformIndexReader();
+
+    WaveformIndexReader(const WaveformIndexReader&) = delete;
+    WaveformIndexReader& operator=(const WaveformIndexReader&) = delete;
+
+    /** Map @p path; false if missing, unfinished or malformed. */
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_mapping != nullptr; }
+    int getSampleRate() const { return m_sampleRate; }
+    int getChannels() const { return m_channels; }
+    uint64_t getTotalFrames() const { return m_totalFrames; }
+    const Level& level(int index) const { return m_levels[index]; }
+
+    /**
+     * Summarise [@p startFrame, @p endFrame) into @p columns columns of
+     * (min, max, rms) in [-1, 1], from the coarsest level that still gives
+     * every column at least one block. Returns the columns filled.
+     */
+    int summarize(uint64_t startFrame, uint64_t endFrame, int columns, float* out) const;
+
+private:
+    void* m_mapping;
+    size_t m_mappingBytes;
+    int m_sampleRate;
+    int m_channels;
+    uint64_t m_totalFrames;
+    Level m_levels[waveform_index::kLevelCount];
+};
@@ -29,6 +29,13 @@ class USBAudioRecorder(
     private var targetSampleRate = DEFAULT_SAMPLE_RATE
     private var isNativeInitialized = false
     private var activeRecordingPfd: ParcelFileDescriptor? = null
+    private var segmentMaxSeconds = 0
+    private var segmentMaxMegabytes = 0
+    private var preRollSeconds = 0f
+    private var recordChannels = IntArray(0)
+    private var losslessRecording = false
+    private var segmentJob: Job? = null
+    @Volatile private var queuedSegment: Pair<Int, android.net.Uri?>? = null
     
     private val ACTION_USB_PERMISSION = "com.spcmic.recorder.USB_PERMISSION"
     private val usbReceiver = object : BroadcastReceiver() {
@@ -73,12 +80,55 @@ class USBAudioRecorder(
     external fun supportsContinuousSampleRateNative(): Boolean
     external fun getContinuousSampleRateRangeNative(): IntArray?
     external fun getEffectiveSampleRateNative(): Int
+    /**
+     * URB scheduler telemetry in native UrbStat order: queue depth, packets per URB, reaps,
+     * packet errors, empty packets, short packets, late reaps, depth increases/decreases,
+     * packet increases/decreases, max reap gap (us), last-window max gap (us).
+     */
+    external fun getUrbStatsNative(): LongArray?
     external fun setTargetSampleRateNative(sampleRate: Int): Boolean
     external fun setInterfaceNative(interfaceNum: Int, altSetting: Int): Boolean
     external fun hasClippedNative(): Boolean
     external fun resetClipIndicatorNative()
     external fun setGainNative(gainDb: Float)
     external fun getPeakLevelNative(): Float
+    /**
+     * Fills [levels] with the latest per-channel meter snapshot: peaks in the first
+     * half, RMS in the second (168 floats for all 84 channels). Returns the channel count.
+     */
+    external fun getChannelLevelsNative(levels: FloatArray): Int
+    /**
+     * Fills [stats] with the native RecordingStats snapshot (see recording_stats.h):
+     * ring capacity, ring high-water, bytes dropped, overflow events, carried frames,
+     * carried bytes, disk writes, disk write errors, spooled bytes; then for the reap-interval,
+     * processAudioBuffer and disk-write histograms: count, sum, max, p50, p90, p99,
+     * p99.9 (all in us) and 24 power-of-two buckets. Returns the number of values written.
+     */
+    external fun getRecordingStatsNative(stats: LongArray): Int
+    /** Directory on internal storage where the recording ring may spill when the disk stalls. */
+    external fun setSpoolDirectoryNative(directory: String)
+    /** Directory where each recorded file gets a waveform overview sidecar; empty disables them. */
+    external fun setOverviewDirectoryNative(directory: String)
+    /** Split recordings every [maxSeconds] of audio or [maxMegabytes] of data (0 = no limit); applies to the next take. */
+    external fun setRecordingSegmentLimitsNative(maxSeconds: Int, maxMegabytes: Int)
+    /** Hands native code the descriptor for the next segment of an SAF recording; it is duplicated. */
+    external fun queueNextSegmentFdNative(fd: Int, displayPath: String): Boolean
+    /** 1-based segment being written, or the number of segments of the last take. */
+    external fun getRecordingSegmentIndexNative(): Int
+    /** Seconds of monitored audio kept and written ahead of each recording (0 = off); applies from the next monitoring start. */
+    external fun setPreRollSecondsNative(seconds: Float)
+    /** Record only these 0-based capsules (empty = all 84); applies to the next take. */
+    external fun setRecordingChannelsNative(channels: IntArray)
+    /** Write the next takes as losslessly compressed WAV blocks (playable in this app only). */
+    external fun setLosslessRecordingNative(enabled: Boolean)
+    /** Scheduling policy and CPU placement actually granted to the USB, disk and helper threads, one line per role. */
+    external fun getThreadPoliciesNative(): String
+    /** Convolve the live input through IR preset [presetId] to the headphones; needs an active monitoring session. */
+    external fun startLiveMonitorNative(assetManager: android.content.res.AssetManager, presetId: Int, lowLatency: Boolean): Boolean
+    external fun stopLiveMonitorNative()
+    external fun isLiveMonitorActiveNative(): Boolean
+    /** Input frames the live monitor dropped because its convolver fell behind. */
+    external fun getLiveMonitorDroppedFramesNative(): Long
     external fun startMonitoringNative(gainDb: Float): Boolean
     external fun stopMonitoringNative(): Boolean
     external fun isMonitoringNative(): Boolean
@@ -86,6 +136,10 @@ class USBAudioRecorder(
     
     companion object {
         private const val DEFAULT_SAMPLE_RATE = 48000
+        /** Mirrors RecordingStats::kSnapshotSize: 9 scalars + 3 histograms of 31 values. */
+        const val RECORDING_STATS_SIZE = 9 + 3 * 31
+        /** Under filesDir; shared with playback, which maps the overviews from here. */
+        const val WAVEFORM_DIRECTORY_NAME = "waveforms"
         init {
             try {
             try {
@@ -254,6 +308,14 @@ class USBAudioRecorder(
         val success = initializeNativeAudio(deviceFd, 48000, channelCount)
         if (success) {
             isNativeInitialized = true
+            setSpoolDirectoryNative(context.noBackupFilesDir.absolutePath)
+            val overviewDir = File(context.filesDir, WAVEFORM_DIRECTORY_NAME)
+            overviewDir.mkdirs()
+            setOverviewDirectoryNative(if (overviewDir.isDirectory) overviewDir.absolutePath else "")
+            setRecordingSegmentLimitsNative(segmentMaxSeconds, segmentMaxMegabytes)
+            setPreRollSecondsNative(preRollSeconds)
+            setRecordingChannelsNative(recordChannels)
+            setLosslessRecordingNative(losslessRecording)
             android.util.Log.i("USBAudioRecorder", "Native audio initialized: ${stringFromJNI()}")
             
             // Small delay to let device stabilize
@@ -371,6 +433,11 @@ class USBAudioRecorder(
                 resetClipIndicatorNative()
                 viewModel.setRecordingFileName(fileName)
                 android.util.Log.i("USBAudioRecorder", "Started recording to: ${target.displayLocation}")
+
+                // SAF segments need a document per file; path recordings name their own
+                if (target.parcelFileDescriptor != null && (segmentMaxSeconds > 0 || segmentMaxMegabytes > 0)) {
+                    startSegmentProvisioning(fileName)
+                }
                 
                 // Start recording monitoring job with high priority (only if not already monitoring)
                 if (!inMonitoringMode) {
@@ -403,6 +470,41 @@ class USBAudioRecorder(
         }
     }
     
+    /**
+     * Keeps one SAF document queued ahead of the native writer so it can roll over
+     * without waiting: whenever native code starts writing the queued segment, the
+     * next one is created and handed over.
+     */
+    private fun startSegmentProvisioning(fileName: String) {
+        segmentJob?.cancel()
+        segmentJob = CoroutineScope(Dispatchers.IO).launch {
+            var queuedIndex = 1
+            while (isActive && isRecording) {
+                if (getRecordingSegmentIndexNative() >= queuedIndex) {
+                    val nextIndex = queuedIndex + 1
+                    val target = StorageLocationManager.prepareRecordingTarget(context, segmentFileName(fileName, nextIndex))
+                    val pfd = target?.parcelFileDescriptor
+                    if (pfd != null && queueNextSegmentFdNative(pfd.fd, target.displayLocation)) {
+                        queuedIndex = nextIndex
+                        queuedSegment = nextIndex to target.documentUri
+                    } else {
+                        android.util.Log.w("USBAudioRecorder", "Could not prepare recording segment $nextIndex")
+                        target?.documentUri?.let { uri ->
+                            runCatching { DocumentFile.fromSingleUri(context, uri)?.delete() }
+                        }
+                    }
+                    pfd?.closeSafely()
+                }
+                delay(1000)
+            }
+        }
+    }
+
+    /** Mirrors SegmentedWAVWriter::segmentPath(): segment 2 of name.wav is name_002.wav. */
+    private fun segmentFileName(fileName: String, index: Int): String {
+        return String.format(Locale.US, "%s_%03d.wav", fileName.removeSuffix(".wav"), index)
+    }
+
     private suspend fun monitorRecording() {
         while (isRecording) {
             val clipped = hasClippedNative()
@@ -472,10 +574,21 @@ class USBAudioRecorder(
         isRecording = false
         recordingJob?.cancel()
         
+        segmentJob?.cancel()
+        segmentJob = null
+
         // Stop native recording
         stopRecordingNative()
         activeRecordingPfd?.closeSafely()
         activeRecordingPfd = null
+
+        // A segment document created ahead of time but never rolled onto is removed
+        queuedSegment?.let { (index, uri) ->
+            if (uri != null && getRecordingSegmentIndexNative() < index) {
+                runCatching { DocumentFile.fromSingleUri(context, uri)?.delete() }
+            }
+        }
+        queuedSegment = null
         
         android.util.Log.i("USBAudioRecorder", "Recording stopped")
     }
@@ -504,6 +617,87 @@ class USBAudioRecorder(
         }
     }
 
+    fun getUrbStats(): LongArray {
+        return if (isNativeInitialized) {
+            getUrbStatsNative() ?: LongArray(0)
+        } else {
+            LongArray(0)
+        }
+    }
+
+    fun getRecordingStats(stats: LongArray = LongArray(RECORDING_STATS_SIZE)): LongArray {
+        if (isNativeInitialized) {
+            getRecordingStatsNative(stats)
+        }
+        return stats
+    }
+
+    /** Split future recordings into files of at most [maxSeconds] / [maxMegabytes] each; 0 disables a limit. */
+    fun setRecordingSegmentLimits(maxSeconds: Int, maxMegabytes: Int = 0) {
+        segmentMaxSeconds = maxSeconds.coerceAtLeast(0)
+        segmentMaxMegabytes = maxMegabytes.coerceAtLeast(0)
+        if (isNativeInitialized) {
+            setRecordingSegmentLimitsNative(segmentMaxSeconds, segmentMaxMegabytes)
+        }
+    }
+
+    /** Capture [seconds] of audio from before the record button is pressed; 0 disables the history. */
+    fun setPreRollSeconds(seconds: Float) {
+        preRollSeconds = seconds.coerceIn(0f, 30f)
+        if (isNativeInitialized) {
+            setPreRollSecondsNative(preRollSeconds)
+        }
+    }
+
+    /**
+     * Reduce the recording bandwidth: keep only [channels] (0-based capsules, empty = all 84)
+     * and optionally store the data losslessly compressed. Skipped capsules play back silent.
+     */
+    fun setRecordingReduction(channels: IntArray, lossless: Boolean) {
+        recordChannels = channels.filter { it in 0 until channelCount }.distinct().sorted().toIntArray()
+        losslessRecording = lossless
+        if (isNativeInitialized) {
+            setRecordingChannelsNative(recordChannels)
+            setLosslessRecordingNative(losslessRecording)
+        }
+    }
+
+    /**
+     * Hear the microphone through a binaural/stereo/ambisonic preset while monitoring or
+     * recording. [lowLatency] uses 128-frame convolution blocks instead of 2048.
+     * The monitor never holds up the recording: it drops input when it can't keep up.
+     */
+    fun startLiveMonitor(presetId: Int, lowLatency: Boolean = true): Boolean {
+        return isNativeInitialized && startLiveMonitorNative(context.assets, presetId, lowLatency)
+    }
+
+    fun stopLiveMonitor() {
+        if (isNativeInitialized) {
+            stopLiveMonitorNative()
+        }
+    }
+
+    fun isLiveMonitorActive(): Boolean {
+        return isNativeInitialized && isLiveMonitorActiveNative()
+    }
+
+    fun getLiveMonitorDroppedFrames(): Long {
+        return if (isNativeInitialized) getLiveMonitorDroppedFramesNative() else 0L
+    }
+
+    /** Which realtime/nice priority and cores the native threads ended up with; empty before the first start. */
+    fun getThreadPolicies(): String {
+        return if (isNativeInitialized) getThreadPoliciesNative() else ""
+    }
+
+    fun getChannelLevels(levels: FloatArray): Int {
+        return if (isNativeInitialized) {
+            getChannelLevelsNative(levels)
+        } else {
+            0
+        }
+    }
+
     fun startMonitoring(gainDb: Float = 0f): Boolean {
         if (!isNativeInitialized) {
             android.util.Log.e("USBAudioRecorder", "Cannot start monitoring - native audio not initialized")
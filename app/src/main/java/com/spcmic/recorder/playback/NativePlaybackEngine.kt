@@ -51,6 +51,22 @@ class NativePlaybackEngine {
         nativeSetCacheDirectory(engineHandle, cacheDir)
     }
 
+    /**
+     * Directory holding the waveform overview sidecars written while recording.
+     */
+    fun setOverviewDirectory(overviewDir: String) {
+        nativeSetOverviewDirectory(engineHandle, overviewDir)
+    }
+
+    /**
+     * Waveform of the loaded file between [startSeconds] and [endSeconds] as
+     * [columns] (min, max, rms) triples in -1..1, read from its overview
+     * sidecar; null when the recording has none.
+     */
+    fun getOverview(startSeconds: Double, endSeconds: Double, columns: Int): FloatArray? {
+        return nativeGetOverview(engineHandle, startSeconds, endSeconds, columns)
+    }
+
     fun useCachedPreRender(sourcePath: String): Boolean {
         return nativeUseCachedPreRender(engineHandle, sourcePath)
     }
@@ -125,6 +141,15 @@ class NativePlaybackEngine {
         return nativeGetPreRenderProgress(engineHandle)
     }
 
+    /**
+     * Pre-render stall counters: wait counts for the reader, convolver input,
+     * convolver output and writer stages, followed by the microseconds each
+     * stage spent waiting.
+     */
+    fun getPreRenderStallStats(): LongArray {
+        return nativeGetPreRenderStallStats(engineHandle) ?: LongArray(0)
+    }
+
     fun setPlaybackGain(gainDb: Float) {
         nativeSetPlaybackGain(engineHandle, gainDb)
     }
@@ -149,6 +174,27 @@ class NativePlaybackEngine {
         return nativeIsPlaybackConvolved(engineHandle)
     }
 
+    fun setConvolverThreadCount(threads: Int) {
+        nativeSetConvolverThreadCount(engineHandle, threads)
+    }
+
+    /**
+     * Use 128-frame low-latency convolution for realtime playback of [presetId]
+     * instead of 2048-frame blocks. Binaural, ORTF and XY default to on.
+     */
+    fun setLowLatencyConvolution(presetId: Int, enabled: Boolean) {
+        nativeSetLowLatencyConvolution(engineHandle, presetId, enabled)
+    }
+
+    fun isLowLatencyConvolution(presetId: Int): Boolean {
+        return nativeIsLowLatencyConvolution(engineHandle, presetId)
+    }
+
+    /** Scheduling policy and CPU placement granted to the realtime convolution thread. */
+    fun getThreadPolicies(): String {
+        return nativeGetThreadPolicies()
+    }
+
     fun configureExportPreset(presetId: Int, outputChannels: Int, cacheFileName: String) {
         nativeConfigureExportPreset(engineHandle, presetId, outputChannels, cacheFileName)
     }
@@ -157,6 +203,16 @@ class NativePlaybackEngine {
         return nativeExportPreRendered(engineHandle, destinationPath)
     }
 
+    /**
+     * Render the loaded file through every preset in [presetIds] into the
+     * matching [destinationPaths] in a single pass over the source. Blocks
+     * until done; progress is reported through [getPreRenderProgress].
+     */
+    fun exportPresets(presetIds: IntArray, destinationPaths: Array<String>): Boolean {
+        require(presetIds.size == destinationPaths.size) { "One destination per preset" }
+        return nativeExportPresets(engineHandle, presetIds, destinationPaths)
+    }
+
     /**
      * Release native resources
      */
@@ -186,16 +242,24 @@ class NativePlaybackEngine {
     private external fun nativeIsFileLoaded(engineHandle: Long): Boolean
     private external fun nativeSetAssetManager(engineHandle: Long, assetManager: AssetManager)
     private external fun nativeSetCacheDirectory(engineHandle: Long, cacheDir: String)
+    private external fun nativeSetOverviewDirectory(engineHandle: Long, overviewDir: String)
+    private external fun nativeGetOverview(engineHandle: Long, startSeconds: Double, endSeconds: Double, columns: Int): FloatArray?
     private external fun nativeUseCachedPreRender(engineHandle: Long, sourcePath: String): Boolean
     private external fun nativePreparePreRender(engineHandle: Long): Boolean
     private external fun nativeIsPreRenderReady(engineHandle: Long): Boolean
     private external fun nativeGetPreRenderProgress(engineHandle: Long): Int
+    private external fun nativeGetPreRenderStallStats(engineHandle: Long): LongArray?
     private external fun nativeSetPlaybackGain(engineHandle: Long, gainDb: Float)
     private external fun nativeGetPlaybackGain(engineHandle: Long): Float
     private external fun nativeSetLooping(engineHandle: Long, enabled: Boolean)
     private external fun nativeIsLooping(engineHandle: Long): Boolean
     private external fun nativeExportPreRendered(engineHandle: Long, destinationPath: String): Boolean
+    private external fun nativeExportPresets(engineHandle: Long, presetIds: IntArray, destinationPaths: Array<String>): Boolean
     private external fun nativeSetPlaybackConvolved(engineHandle: Long, enabled: Boolean)
     private external fun nativeIsPlaybackConvolved(engineHandle: Long): Boolean
+    private external fun nativeSetConvolverThreadCount(engineHandle: Long, threads: Int)
+    private external fun nativeSetLowLatencyConvolution(engineHandle: Long, presetId: Int, enabled: Boolean)
+    private external fun nativeIsLowLatencyConvolution(engineHandle: Long, presetId: Int): Boolean
+    private external fun nativeGetThreadPolicies(): String
     private external fun nativeConfigureExportPreset(engineHandle: Long, presetId: Int, outputChannels: Int, cacheFileName: String)
 }
@@ -16,6 +16,7 @@ import androidx.lifecycle.ViewModelProvider
 import androidx.recyclerview.widget.LinearLayoutManager
 import com.spcmic.recorder.R
 import com.spcmic.recorder.StorageLocationManager
+import com.spcmic.recorder.USBAudioRecorder
 import com.spcmic.recorder.databinding.FragmentPlaybackBinding
 import java.io.File
 import kotlin.math.abs
@@ -55,6 +56,12 @@ class PlaybackFragment : Fragment() {
         }
         viewModel.setCacheDirectory(cacheDir.absolutePath)
 
+        val overviewDir = File(requireContext().filesDir, USBAudioRecorder.WAVEFORM_DIRECTORY_NAME)
+        if (!overviewDir.exists()) {
+            overviewDir.mkdirs()
+        }
+        viewModel.setOverviewDirectory(overviewDir.absolutePath)
+
         refreshStorageAndScan()
         setupRecyclerView()
         setupPlayerControls()
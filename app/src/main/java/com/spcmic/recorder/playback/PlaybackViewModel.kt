@@ -90,6 +90,7 @@ class PlaybackViewModel : ViewModel() {
     private var positionUpdateJob: Job? = null
     private var assetManager: AssetManager? = null
     private var cacheDirectory: String? = null
+    private var overviewDirectory: String? = null
     private var preferences: SharedPreferences? = null
     private var preferenceListenerRegistered = false
     private val preprocessMutex = Mutex()
@@ -121,6 +122,19 @@ class PlaybackViewModel : ViewModel() {
         playbackEngine?.setCacheDirectory(path)
     }
 
+    fun setOverviewDirectory(path: String) {
+        overviewDirectory = path
+        playbackEngine?.setOverviewDirectory(path)
+    }
+
+    /**
+     * Waveform of the selected recording as (min, max, rms) triples per
+     * column, or null if it was recorded without an overview.
+     */
+    fun getWaveformOverview(startSeconds: Double, endSeconds: Double, columns: Int): FloatArray? {
+        return playbackEngine?.getOverview(startSeconds, endSeconds, columns)
+    }
+
     fun setPreferences(prefs: SharedPreferences) {
         preferences?.let { existing ->
             if (preferenceListenerRegistered) {
@@ -280,6 +294,7 @@ class PlaybackViewModel : ViewModel() {
                 val engine = playbackEngine ?: NativePlaybackEngine().also { playbackEngine = it }
                 assetManager?.let { engine.setAssetManager(it) }
                 cacheDirectory?.let { engine.setCacheDirectory(it) }
+                overviewDirectory?.let { engine.setOverviewDirectory(it) }
                 engine.setPlaybackConvolved(playbackConvolvedEnabled)
                 engine.setPlaybackGain(_playbackGainDb.value ?: 0f)
                 engine.setLooping(_isLooping.value ?: false)
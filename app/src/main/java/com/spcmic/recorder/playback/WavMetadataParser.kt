@@ -63,6 +63,8 @@ object WavMetadataParser {
                 var dataChunkOffset = -1L
                 var ds64DataSize: Long? = null
                 var ds64SampleCount: Long? = null
+                var factSampleCount: Long? = null
+                var sourceChannels: Int? = null
                 
                 while (raf.filePointer < raf.length()) {
                     val chunkHeader = ByteArray(8)
@@ -94,6 +96,22 @@ object WavMetadataParser {
                             dataChunkOffset = raf.filePointer
                             break // We have all we need
                         }
+                        "fact" -> {
+                            // Sample frames of compressed (lossless) data
+                            val factData = ByteArray(chunkSize.toInt())
+                            raf.readFully(factData)
+                            if (factData.size >= 4) {
+                                factSampleCount = ByteBuffer.wrap(factData).order(ByteOrder.LITTLE_ENDIAN).int.toLong() and 0xFFFFFFFFL
+                            }
+                        }
+                        "chmp" -> {
+                            // Channel-subset recording: the first field is the source channel count
+                            val mapData = ByteArray(chunkSize.toInt())
+                            raf.readFully(mapData)
+                            if (mapData.size >= 2) {
+                                sourceChannels = ByteBuffer.wrap(mapData).order(ByteOrder.LITTLE_ENDIAN).short.toInt() and 0xFFFF
+                            }
+                        }
                         "ds64" -> {
                             if (chunkSize > Int.MAX_VALUE) {
                                 Log.e(TAG, "ds64 chunk too large to process: $chunkSize bytes")
@@ -148,12 +166,15 @@ object WavMetadataParser {
                     frameSize > 0 -> dataSize / frameSize
                     else -> 0L
                 }
-                val resolvedSampleCount = ds64SampleCount?.takeIf { it > 0L } ?: totalFrames.takeIf { it > 0L }
-                val durationMs = if (sampleRate > 0 && totalFrames > 0) (totalFrames * 1000L) / sampleRate else 0L
+                val resolvedSampleCount = ds64SampleCount?.takeIf { it > 0L }
+                    ?: factSampleCount?.takeIf { it > 0L }
+                    ?: totalFrames.takeIf { it > 0L }
+                val durationFrames = factSampleCount?.takeIf { it > 0L } ?: totalFrames
+                val durationMs = if (sampleRate > 0 && durationFrames > 0) (durationFrames * 1000L) / sampleRate else 0L
                 
                 return WavMetadata(
                     sampleRate = sampleRate,
-                    channels = channels,
+                    channels = sourceChannels ?: channels,
                     bitsPerSample = bitsPerSample,
                     headerDataSize = headerDataSize,
                     dataOffset = dataChunkOffset,
@@ -213,6 +234,8 @@ object WavMetadataParser {
         var bytesConsumed = 12L
         var ds64DataSize: Long? = null
         var ds64SampleCount: Long? = null
+        var factSampleCount: Long? = null
+        var sourceChannels: Int? = null
 
         val chunkHeader = ByteArray(8)
 
@@ -240,6 +263,26 @@ object WavMetadataParser {
                     buffer.short // block align
                     bitsPerSample = buffer.short.toInt()
                 }
+                "fact" -> {
+                    val factData = ByteArray(chunkSize.toInt())
+                    if (!stream.readFully(factData)) {
+                        return null
+                    }
+                    bytesConsumed += chunkSize
+                    if (factData.size >= 4) {
+                        factSampleCount = ByteBuffer.wrap(factData).order(ByteOrder.LITTLE_ENDIAN).int.toLong() and 0xFFFFFFFFL
+                    }
+                }
+                "chmp" -> {
+                    val mapData = ByteArray(chunkSize.toInt())
+                    if (!stream.readFully(mapData)) {
+                        return null
+                    }
+                    bytesConsumed += chunkSize
+                    if (mapData.size >= 2) {
+                        sourceChannels = ByteBuffer.wrap(mapData).order(ByteOrder.LITTLE_ENDIAN).short.toInt() and 0xFFFF
+                    }
+                }
                 "ds64" -> {
                     if (chunkSize > Int.MAX_VALUE) {
                         return null
@@ -289,12 +332,12 @@ object WavMetadataParser {
             return null
         }
         val dataSize = ds64DataSize?.takeIf { it > 0L } ?: headerDataSize
-        val resolvedSampleCount = ds64SampleCount?.takeIf { it > 0L }
+        val resolvedSampleCount = ds64SampleCount?.takeIf { it > 0L } ?: factSampleCount?.takeIf { it > 0L }
         val durationMs = if (sampleRate > 0 && resolvedSampleCount != null) (resolvedSampleCount * 1000L) / sampleRate else 0L
 
         return WavMetadata(
             sampleRate = sampleRate,
-            channels = channels,
+            channels = sourceChannels ?: channels,
             bitsPerSample = bitsPerSample,
             headerDataSize = headerDataSize,
             dataOffset = dataOffset,